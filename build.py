@@ -197,12 +197,15 @@ CTX.INPUT['common'] = """
  CompactingStringPool.cpp
  CompactingStringStorage.cpp
  FatalException.cpp
+ LargePages.cpp
  ThreadLocalPool.cpp
  SegvException.cpp
  SerializableEEException.cpp
  SQLException.cpp
+ StringDictionary.cpp
  StringRef.cpp
  tabletuple.cpp
+ TraceRing.cpp
  TupleSchema.cpp
  types.cpp
  UndoLog.cpp
@@ -282,6 +285,7 @@ CTX.INPUT['indexes'] = """
  tableindex.cpp
  tableindexfactory.cpp
  IndexStats.cpp
+ IndexBuilder.cpp
 """
 
 CTX.INPUT['storage'] = """
@@ -301,10 +305,18 @@ CTX.INPUT['storage'] = """
  tableutil.cpp
  temptable.cpp
  TempTableLimits.cpp
+ TempTableSpill.cpp
+ TempBlockPool.cpp
  TupleStreamWrapper.cpp
  RecoveryContext.cpp
  TupleBlock.cpp
  ColdStorageXML.cpp
+ AntiCacheDB.cpp
+ EvictedTupleIterator.cpp
+ ColdStorageStats.cpp
+ TempBlockPoolStats.cpp
+ TableImage.cpp
+ MinipageLayout.cpp
 """
 
 CTX.INPUT['stats'] = """
@@ -370,8 +382,10 @@ if whichtests in ("${eetestsuite}", "common"):
      valuearray_test
      nvalue_test
      pool_test
+     LargePagesTest
      tabletuple_test
      elastic_hashinator_test
+     trace_ring_test
     """
 
 if whichtests in ("${eetestsuite}", "execution"):
@@ -381,6 +395,11 @@ if whichtests in ("${eetestsuite}", "execution"):
      FragmentManagerTest
     """
 
+if whichtests in ("${eetestsuite}", "executors"):
+    CTX.TESTS['executors'] = """
+     NestLoopIndexExecutorTest
+    """
+
 if whichtests in ("${eetestsuite}", "expressions"):
     CTX.TESTS['expressions'] = """
      expression_test
@@ -392,22 +411,30 @@ if whichtests in ("${eetestsuite}", "indexes"):
      index_scripted_test
      index_test
      compacting_hash_index
+     IndexBuilderTest
     """
 
 if whichtests in ("${eetestsuite}", "storage"):
     CTX.TESTS['storage'] = """
+     AntiCacheTest
+     BulkLoadTest
      CompactionTest
      CopyOnWriteTest
      constraint_test
      filter_test
+     MinipageTest
      persistent_table_log_test
      PersistentTableMemStatsTest
      serialize_test
      StreamedTable_test
+     StringDictionaryTest
      table_and_indexes_test
      table_test
      tabletuple_export_test
+     TableImageTest
+     TempBlockPoolTest
      TempTableLimitsTest
+     TempTableSpillTest
      TupleStreamWrapper_test
     """
 
@@ -415,6 +442,8 @@ if whichtests in ("${eetestsuite}", "structures"):
     CTX.TESTS['structures'] = """
      CompactingMapTest
      CompactingMapIndexCountTest
+     CompactingBTreeTest
+     AdaptiveRadixTreeTest
      CompactingHashTest
      CompactingPoolTest
     """
@@ -0,0 +1,209 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/LargePages.h"
+#include "common/FatalException.hpp"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace voltdb {
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+
+// From linux/mempolicy.h, which numaif.h would otherwise have to provide
+static const int NUMA_MPOL_PREFERRED = 1;
+
+static bool s_enabled = false;
+// Shared by every site of the process
+static int64_t s_mappedBytes = 0;
+static int64_t s_fallbackCount = 0;
+
+static inline size_t roundUp(size_t size, size_t multiple) {
+    return (size + multiple - 1) & ~(multiple - 1);
+}
+
+/*
+ * Map length bytes aligned to alignment by mapping alignment - pageSize
+ * more and unmapping what sticks out on either side.
+ */
+static char* mapAligned(size_t length, size_t alignment, size_t pageSize, int flags) {
+    const size_t slack = alignment > pageSize ? alignment - pageSize : 0;
+    void *mapping = ::mmap(NULL, length + slack, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+    char *start = static_cast<char*>(mapping);
+    char *aligned = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(start) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    if (aligned != start) {
+        ::munmap(start, aligned - start);
+    }
+    const size_t tail = static_cast<size_t>(start + length + slack - (aligned + length));
+    if (tail != 0) {
+        ::munmap(aligned + length, tail);
+    }
+    return aligned;
+}
+
+void LargePages::setEnabled(bool enabled) {
+    s_enabled = enabled;
+}
+
+bool LargePages::enabled() {
+    return s_enabled;
+}
+
+char* LargePages::allocate(size_t size, size_t alignment) {
+    if (alignment < HUGE_PAGE_SIZE) {
+        alignment = HUGE_PAGE_SIZE;
+    }
+    const size_t length = roundUp(size, HUGE_PAGE_SIZE);
+    char *memory = mapAligned(length, alignment, HUGE_PAGE_SIZE, MAP_HUGETLB);
+    if (memory != NULL) {
+        __sync_fetch_and_add(&s_mappedBytes, static_cast<int64_t>(length));
+        return memory;
+    }
+
+    // No reserved huge pages left: ask for transparent ones instead
+    memory = mapAligned(length, alignment, static_cast<size_t>(::sysconf(_SC_PAGESIZE)), 0);
+    if (memory == NULL) {
+        throwFatalException("Failed to map %jd bytes: %s", (intmax_t)length, strerror(errno));
+    }
+    ::madvise(memory, length, MADV_HUGEPAGE);
+    __sync_fetch_and_add(&s_mappedBytes, static_cast<int64_t>(length));
+    __sync_fetch_and_add(&s_fallbackCount, 1);
+    return memory;
+}
+
+void LargePages::free(char *memory, size_t size) {
+    const size_t length = roundUp(size, HUGE_PAGE_SIZE);
+    if (::munmap(memory, length) != 0) {
+        throwFatalException("Failed munmap: %s", strerror(errno));
+    }
+    __sync_fetch_and_sub(&s_mappedBytes, static_cast<int64_t>(length));
+}
+
+static int numaNodeCount() {
+    int count = 0;
+    char path[64];
+    for (;; ++count) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", count);
+        if (::access(path, F_OK) != 0) {
+            return count;
+        }
+    }
+}
+
+/*
+ * Read the CPUs of node from its cpulist, which holds ranges such as
+ * "0-7,16-23".
+ */
+static bool readNodeCPUs(int node, cpu_set_t *cpus) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *file = ::fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+    char line[4096];
+    const bool read = ::fgets(line, sizeof(line), file) != NULL;
+    ::fclose(file);
+    if (!read) {
+        return false;
+    }
+
+    CPU_ZERO(cpus);
+    char *position = line;
+    while (*position != '\0' && *position != '\n') {
+        char *end;
+        const long first = ::strtol(position, &end, 10);
+        if (end == position) {
+            return false;
+        }
+        long last = first;
+        if (*end == '-') {
+            position = end + 1;
+            last = ::strtol(position, &end, 10);
+            if (end == position) {
+                return false;
+            }
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, cpus);
+        }
+        position = *end == ',' ? end + 1 : end;
+    }
+    return CPU_COUNT(cpus) > 0;
+}
+
+/*
+ * The thread is pinned before the policy is set, so the scheduler can't
+ * move it off the node its memory is preferred on.
+ */
+int LargePages::bindToNode(int32_t siteIndex) {
+    const int nodes = numaNodeCount();
+    if (nodes == 0) {
+        return -1;
+    }
+    const int node = static_cast<int>((siteIndex % nodes + nodes) % nodes);
+    cpu_set_t cpus;
+    if (!readNodeCPUs(node, &cpus)) {
+        return -1;
+    }
+    cpu_set_t previous;
+    if (::sched_getaffinity(0, sizeof(previous), &previous) != 0 ||
+        ::sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+        return -1;
+    }
+
+    const unsigned long bitsPerWord = sizeof(unsigned long) * 8;
+    unsigned long mask[16];
+    if (static_cast<unsigned long>(node) >= bitsPerWord * 16) {
+        ::sched_setaffinity(0, sizeof(previous), &previous);
+        return -1;
+    }
+    ::memset(mask, 0, sizeof(mask));
+    mask[node / bitsPerWord] = 1UL << (node % bitsPerWord);
+    if (::syscall(SYS_set_mempolicy, NUMA_MPOL_PREFERRED, mask, bitsPerWord * 16) != 0) {
+        ::sched_setaffinity(0, sizeof(previous), &previous);
+        return -1;
+    }
+    return node;
+}
+
+int64_t LargePages::mappedBytes() {
+    return s_mappedBytes;
+}
+
+int64_t LargePages::fallbackCount() {
+    return s_fallbackCount;
+}
+
+}
@@ -0,0 +1,83 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LARGEPAGES_H_
+#define LARGEPAGES_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * Optional huge page backing for the big, long lived allocations of the
+ * EE: tuple blocks, Pool chunks and the buffers of ContiguousAllocator
+ * (the node arenas of the compacting indexes and the compacting string
+ * pools). Random index probes over a large heap of 4K pages spend much of
+ * their time on TLB misses; 2 MB pages cut the number of entries needed
+ * by a factor of 512.
+ *
+ * allocate() first asks for explicit huge pages (MAP_HUGETLB, which needs
+ * pages reserved through vm.nr_hugepages) and falls back to a 2 MB aligned
+ * anonymous mapping marked for transparent huge pages, which the kernel
+ * backs with huge pages when it can. The mode is process wide and off
+ * unless the deployment file turns it on (see VoltDBEngine::setLargePages()).
+ */
+class LargePages {
+  public:
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    static void setEnabled(bool enabled);
+    static bool enabled();
+
+    /**
+     * Should an allocation of size bytes come from allocate()? Only when
+     * the mode is on and it fills at least one huge page.
+     */
+    static bool useFor(size_t size) {
+        return enabled() && size >= HUGE_PAGE_SIZE;
+    }
+
+    /**
+     * Map size bytes, rounded up to whole huge pages and aligned to
+     * alignment (a power of two), backed by huge pages where possible.
+     * Throws a FatalException if the memory can't be had.
+     */
+    static char* allocate(size_t size, size_t alignment = HUGE_PAGE_SIZE);
+
+    /** Release memory returned by allocate(size, ...) */
+    static void free(char *memory, size_t size);
+
+    /**
+     * Pin this thread to the CPUs of a NUMA node and make the memory it
+     * touches from now on come from that node, falling back to other
+     * nodes when it is full. Sites spread over the nodes by siteIndex
+     * modulo the number of nodes. Returns the node, or -1 if the thread
+     * could not be bound (a kernel without NUMA support, for one), in
+     * which case neither its CPUs nor its memory policy changed.
+     */
+    static int bindToNode(int32_t siteIndex);
+
+    /** Bytes currently held by allocate() callers */
+    static int64_t mappedBytes();
+    /** Allocations that had to settle for transparent huge pages */
+    static int64_t fallbackCount();
+};
+
+}
+
+#endif /* LARGEPAGES_H_ */
@@ -1502,6 +1502,12 @@ class NValue {
     int compareDoubleValue (const NValue rhs) const {
         switch (rhs.getValueType()) {
           case VALUE_TYPE_DOUBLE: {
+              // every double at or below DOUBLE_NULL, -inf included, is NULL and sorts first
+              if (isNull()) {
+                  return rhs.isNull() ? VALUE_COMPARE_EQUAL : VALUE_COMPARE_LESSTHAN;
+              } else if (rhs.isNull()) {
+                  return VALUE_COMPARE_GREATERTHAN;
+              }
               const double lhsValue = getDouble();
               const double rhsValue = rhs.getDouble();
               if (lhsValue == rhsValue) {
@@ -1573,6 +1579,11 @@ class NValue {
         } else if (rhs.isNull()) {
             return VALUE_COMPARE_GREATERTHAN;
         }
+        if (!m_sourceInlined && !rhs.m_sourceInlined &&
+            *reinterpret_cast<void* const*>(m_data) == *reinterpret_cast<void* const*>(rhs.m_data)) {
+            // the same StringRef, typically one shared through a StringDictionary
+            return VALUE_COMPARE_EQUAL;
+        }
         const int32_t leftLength = getObjectLength();
         const int32_t rightLength = rhs.getObjectLength();
         const int result = ::strncmp(left, right, std::min(leftLength, rightLength));
@@ -1615,6 +1626,11 @@ class NValue {
         } else if (rhs.isNull()) {
             return VALUE_COMPARE_GREATERTHAN;
         }
+        if (!m_sourceInlined && !rhs.m_sourceInlined &&
+            *reinterpret_cast<void* const*>(m_data) == *reinterpret_cast<void* const*>(rhs.m_data)) {
+            // the same StringRef, typically one shared through a StringDictionary
+            return VALUE_COMPARE_EQUAL;
+        }
         const int32_t leftLength = getObjectLength();
         const int32_t rightLength = rhs.getObjectLength();
         const int result = ::memcmp(left, right, std::min(leftLength, rightLength));
@@ -2824,7 +2840,8 @@ inline void NValue::hashCombine(std::size_t &seed) const {
       case VALUE_TYPE_TIMESTAMP:
         boost::hash_combine( seed, getBigInt()); break;
       case VALUE_TYPE_DOUBLE:
-        boost::hash_combine( seed, getDouble()); break;
+        // NULLs compare equal, so they hash alike
+        boost::hash_combine( seed, isNull() ? DOUBLE_NULL : getDouble()); break;
       case VALUE_TYPE_VARCHAR: {
         if (getObjectValue() == NULL) {
             boost::hash_combine( seed, std::string(""));
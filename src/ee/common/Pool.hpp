@@ -25,6 +25,7 @@
 #include <climits>
 #include <string.h>
 #include "common/FatalException.hpp"
+#include "common/LargePages.h"
 
 namespace voltdb {
 #ifndef MEMCHECK
@@ -76,18 +77,10 @@ class Pool {
 public:
 
     Pool() :
-        m_allocationSize(262144), m_maxChunkCount(1), m_currentChunkIndex(0)
+        m_allocationSize(262144), m_maxChunkCount(1), m_currentChunkIndex(0),
+        m_largePages(LargePages::useFor(m_allocationSize))
     {
-#ifdef USE_MMAP
-        char *storage =
-                static_cast<char*>(::mmap( 0, m_allocationSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 ));
-        if (storage == MAP_FAILED) {
-            std::cout << strerror( errno ) << std::endl;
-            throwFatalException("Failed mmap");
-        }
-#else
-        char *storage = new char[m_allocationSize];
-#endif
+        char *storage = allocateChunkStorage();
         m_chunks.push_back(Chunk(m_allocationSize, storage));
     }
 
@@ -98,31 +91,16 @@ public:
         m_allocationSize(allocationSize),
 #endif
         m_maxChunkCount(static_cast<std::size_t>(maxChunkCount)),
-        m_currentChunkIndex(0)
+        m_currentChunkIndex(0),
+        m_largePages(LargePages::useFor(m_allocationSize))
     {
-#ifdef USE_MMAP
-        char *storage =
-                static_cast<char*>(::mmap( 0, m_allocationSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 ));
-        if (storage == MAP_FAILED) {
-            std::cout << strerror( errno ) << std::endl;
-            throwFatalException("Failed mmap");
-        }
-#else
-        char *storage = new char[m_allocationSize];
-#endif
+        char *storage = allocateChunkStorage();
         m_chunks.push_back(Chunk(allocationSize, storage));
     }
 
     ~Pool() {
         for (std::size_t ii = 0; ii < m_chunks.size(); ii++) {
-#ifdef USE_MMAP
-            if (::munmap( m_chunks[ii].m_chunkData, m_chunks[ii].m_size) != 0) {
-                std::cout << strerror( errno ) << std::endl;
-                throwFatalException("Failed munmap");
-            }
-#else
-            delete [] m_chunks[ii].m_chunkData;
-#endif
+            freeChunkStorage(m_chunks[ii]);
         }
         for (std::size_t ii = 0; ii < m_oversizeChunks.size(); ii++) {
 #ifdef USE_MMAP
@@ -184,16 +162,7 @@ public:
 //                  "from a performance perspective. If you see this we need to look "
 //                  "into structuring our pool sizes and allocations so the this doesn't "
 //                  "happen frequently" << std::endl;
-#ifdef USE_MMAP
-                char *storage =
-                        static_cast<char*>(::mmap( 0, m_allocationSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 ));
-                if (storage == MAP_FAILED) {
-                    std::cout << strerror( errno ) << std::endl;
-                    throwFatalException("Failed mmap");
-                }
-#else
-                char *storage = new char[m_allocationSize];
-#endif
+                char *storage = allocateChunkStorage();
                 m_chunks.push_back(Chunk(m_allocationSize, storage));
                 Chunk &newChunk = m_chunks.back();
                 newChunk.m_offset = size;
@@ -250,14 +219,7 @@ public:
          */
         if (numChunks > m_maxChunkCount) {
             for (std::size_t ii = m_maxChunkCount; ii < numChunks; ii++) {
-#ifdef USE_MMAP
-                if (::munmap( m_chunks[ii].m_chunkData, m_chunks[ii].m_size) != 0) {
-                    std::cout << strerror( errno ) << std::endl;
-                    throwFatalException("Failed munmap");
-                }
-#else
-                delete []m_chunks[ii].m_chunkData;
-#endif
+                freeChunkStorage(m_chunks[ii]);
             }
             m_chunks.resize(m_maxChunkCount);
         }
@@ -280,9 +242,46 @@ public:
     }
 
 private:
+    /*
+     * Storage for a regular (not oversize) chunk. Chunks that fill whole
+     * huge pages come from LargePages when it is enabled.
+     */
+    char *allocateChunkStorage() {
+        if (m_largePages) {
+            return LargePages::allocate(m_allocationSize);
+        }
+#ifdef USE_MMAP
+        char *storage =
+                static_cast<char*>(::mmap( 0, m_allocationSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 ));
+        if (storage == MAP_FAILED) {
+            std::cout << strerror( errno ) << std::endl;
+            throwFatalException("Failed mmap");
+        }
+        return storage;
+#else
+        return new char[m_allocationSize];
+#endif
+    }
+
+    void freeChunkStorage(Chunk &chunk) {
+        if (m_largePages) {
+            LargePages::free(chunk.m_chunkData, m_allocationSize);
+            return;
+        }
+#ifdef USE_MMAP
+        if (::munmap( chunk.m_chunkData, chunk.m_size) != 0) {
+            std::cout << strerror( errno ) << std::endl;
+            throwFatalException("Failed munmap");
+        }
+#else
+        delete [] chunk.m_chunkData;
+#endif
+    }
+
     const uint64_t m_allocationSize;
     std::size_t m_maxChunkCount;
     std::size_t m_currentChunkIndex;
+    const bool m_largePages;
     std::vector<Chunk> m_chunks;
     /*
      * Oversize chunks that will be freed and not reused.
@@ -0,0 +1,132 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/StringDictionary.h"
+#include "common/NValue.hpp"
+#include "common/StringRef.h"
+#include "common/ValuePeeker.hpp"
+
+#include <cassert>
+
+namespace voltdb {
+
+StringDictionary::StringDictionary(size_t maxEntries, int64_t &memoryUsed) :
+    m_maxEntries(maxEntries),
+    m_memoryUsed(memoryUsed),
+    m_missesUntilSweep(0)
+{
+}
+
+StringDictionary::~StringDictionary()
+{
+    while (!m_entries.empty()) {
+        assert(m_entries.begin()->second->m_refCount == 1);
+        freeEntry(m_entries.begin());
+    }
+}
+
+std::string StringDictionary::keyOf(const NValue &value)
+{
+    return std::string(static_cast<const char*>(ValuePeeker::peekObjectValue(value)),
+                       ValuePeeker::peekObjectLength(value));
+}
+
+bool StringDictionary::share(const NValue &value, int32_t maxLength, char *storage)
+{
+    assert(!value.isNull());
+    const std::string key = keyOf(value);
+    StringRef *sref;
+    EntryMap::iterator found = m_entries.find(key);
+    if (found != m_entries.end()) {
+        sref = found->second;
+    } else {
+        if (!makeRoom()) {
+            return false;
+        }
+        value.serializeToTupleStorageAllocateForObjects(&sref, false, maxLength, NULL);
+        addEntry(key, sref);
+    }
+    ++sref->m_refCount;
+    *reinterpret_cast<StringRef**>(storage) = sref;
+    return true;
+}
+
+void StringDictionary::shareStored(const NValue &stored, char *storage)
+{
+    StringRef *owned = *reinterpret_cast<StringRef**>(storage);
+    if (owned == NULL || owned->isShared()) {
+        return;
+    }
+    const std::string key = keyOf(stored);
+    EntryMap::iterator found = m_entries.find(key);
+    if (found != m_entries.end()) {
+        ++found->second->m_refCount;
+        *reinterpret_cast<StringRef**>(storage) = found->second;
+        StringRef::destroy(owned);
+    } else if (makeRoom()) {
+        addEntry(key, owned);
+        ++owned->m_refCount;
+    }
+}
+
+void StringDictionary::sweep()
+{
+    EntryMap::iterator entry = m_entries.begin();
+    while (entry != m_entries.end()) {
+        if (entry->second->m_refCount == 1) {
+            freeEntry(entry++);
+        } else {
+            ++entry;
+        }
+    }
+}
+
+bool StringDictionary::makeRoom()
+{
+    if (m_entries.size() < m_maxEntries) {
+        return true;
+    }
+    if (m_missesUntilSweep > 0) {
+        --m_missesUntilSweep;
+        return false;
+    }
+    sweep();
+    if (m_entries.size() < m_maxEntries) {
+        return true;
+    }
+    m_missesUntilSweep = m_maxEntries / 4;
+    return false;
+}
+
+void StringDictionary::addEntry(const std::string &key, StringRef *sref)
+{
+    // the dictionary's own reference
+    sref->m_refCount = 1;
+    m_entries[key] = sref;
+    m_memoryUsed += StringRef::computeStringMemoryUsed(key.size());
+}
+
+void StringDictionary::freeEntry(EntryMap::iterator entry)
+{
+    StringRef *sref = entry->second;
+    m_memoryUsed -= StringRef::computeStringMemoryUsed(entry->first.size());
+    sref->m_refCount = 0;
+    StringRef::destroy(sref);
+    m_entries.erase(entry);
+}
+
+}
@@ -0,0 +1,103 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STRINGDICTIONARY_H_
+#define STRINGDICTIONARY_H_
+
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
+namespace voltdb {
+
+class NValue;
+class StringRef;
+
+/**
+ * Dictionary encoding for one non-inlined VARCHAR or VARBINARY column of a
+ * PersistentTable. Each distinct value is stored once, in a StringRef that
+ * counts the tuples referring to it, and tuples hold a pointer to that
+ * shared copy in place of a copy of their own. The pointer serves as the
+ * value's code: two tuples of the column hold equal values exactly when
+ * they hold the same pointer, which NValue's comparisons check first.
+ *
+ * Tuples release their reference through StringRef::destroy() like any
+ * other string. Entries no tuple refers to any more are freed by sweep(),
+ * which runs whenever a full dictionary meets a new value. Values that
+ * don't fit in a full dictionary are stored unshared, as they would be
+ * without one, so a column may mix shared and unshared strings.
+ */
+class StringDictionary {
+  public:
+    /** Distinct values a dictionary holds unless told otherwise */
+    static const size_t DEFAULT_MAX_ENTRIES = 65536;
+
+    /**
+     * memoryUsed is the owning table's count of non-inlined bytes. The
+     * dictionary charges its entries to it, and tuples don't count the
+     * shared strings they refer to.
+     */
+    StringDictionary(size_t maxEntries, int64_t &memoryUsed);
+    /** Frees all entries. No tuple may refer to one any more. */
+    ~StringDictionary();
+
+    /**
+     * Store a reference to the shared copy of the non-NULL value in the
+     * tuple slot at storage, creating the copy if the value is new.
+     * Returns false, leaving the slot alone, if the value is new and the
+     * dictionary is full.
+     */
+    bool share(const NValue &value, int32_t maxLength, char *storage);
+
+    /**
+     * Replace the unshared string held by the tuple slot at storage, whose
+     * value is stored, with a reference to its shared copy. If the value
+     * is new the string itself becomes the shared copy, room permitting.
+     * Used for tuples that were deserialized rather than inserted.
+     */
+    void shareStored(const NValue &stored, char *storage);
+
+    /** Free the entries no tuple refers to */
+    void sweep();
+
+    size_t entryCount() const { return m_entries.size(); }
+    size_t maxEntries() const { return m_maxEntries; }
+
+  private:
+    // no copy, no assignment
+    StringDictionary(StringDictionary const&);
+    StringDictionary operator=(StringDictionary const&);
+
+    typedef boost::unordered_map<std::string, StringRef*> EntryMap;
+
+    static std::string keyOf(const NValue &value);
+    bool makeRoom();
+    void addEntry(const std::string &key, StringRef *sref);
+    void freeEntry(EntryMap::iterator entry);
+
+    const size_t m_maxEntries;
+    int64_t &m_memoryUsed;
+    EntryMap m_entries;
+    // A sweep of a full dictionary that freed nothing isn't repeated
+    // until this many more new values have been turned away
+    size_t m_missesUntilSweep;
+};
+
+}
+
+#endif /* STRINGDICTIONARY_H_ */
@@ -67,6 +67,11 @@ StringRef::create(size_t size, Pool* dataPool)
 void
 StringRef::destroy(StringRef* sref)
 {
+    if (sref->m_refCount != 0)
+    {
+        --sref->m_refCount;
+        return;
+    }
 #ifdef MEMCHECK
     delete sref;
 #else
@@ -83,6 +88,7 @@ StringRef::StringRef(size_t size)
 {
     m_size = size + sizeof(StringRef*);
     m_tempPool = false;
+    m_refCount = 0;
 #ifdef MEMCHECK
     m_stringPtr = new char[m_size];
 #else
@@ -94,7 +100,9 @@ StringRef::StringRef(size_t size)
 
 StringRef::StringRef(std::size_t size, Pool* dataPool)
 {
+    m_size = size + sizeof(StringRef*);
     m_tempPool = true;
+    m_refCount = 0;
     m_stringPtr =
         reinterpret_cast<char*>(dataPool->allocate(size + sizeof(StringRef*)));
     setBackPtr();
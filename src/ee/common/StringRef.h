@@ -19,6 +19,7 @@
 #define STRINGREF_H
 
 #include <cstddef>
+#include <stdint.h>
 
 namespace voltdb
 {
@@ -40,6 +41,7 @@ namespace voltdb
         static std::size_t computeStringMemoryUsed(std::size_t length);
 
         friend class CompactingStringPool;
+        friend class StringDictionary;
         /// Create and return a new StringRef object which points to an
         /// allocated memory block of the requested size.  The caller
         /// may provide an optional Pool from which the memory (and
@@ -53,12 +55,17 @@ namespace voltdb
         /// any, allocated from pools to store the object.
         /// sref must have been allocated and returned by a call to
         /// StringRef::create() and must not have been created in a
-        /// temporary Pool
+        /// temporary Pool.  A string shared through a StringDictionary
+        /// only loses a reference; the dictionary frees it.
         static void destroy(StringRef* sref);
 
         char* get();
         const char* get() const;
 
+        /// True if this string is a StringDictionary entry that tuples
+        /// refer to by pointer rather than owning a copy each.
+        bool isShared() const { return m_refCount != 0; }
+
     private:
         StringRef(std::size_t size);
         StringRef(std::size_t size, Pool* dataPool);
@@ -72,6 +79,9 @@ namespace voltdb
 
         std::size_t m_size;
         bool m_tempPool;
+        /// 0 for strings owned by one tuple, otherwise one reference for
+        /// the owning StringDictionary plus one per referring tuple
+        uint32_t m_refCount;
         char* m_stringPtr;
     };
 }
@@ -20,6 +20,7 @@
 #include "common/FatalException.hpp"
 #include <iostream>
 #include "common/SQLException.h"
+#include "storage/TempBlockPool.h"
 
 // This needs to be >= the VoltType.MAX_VALUE_LENGTH defined in java, currently 1048576.
 // The rationale for making it any larger would be to allow calculating wider "temp" values
@@ -32,6 +33,7 @@ namespace voltdb {
  */
 static pthread_key_t m_key;
 static pthread_key_t m_stringKey;
+static pthread_key_t m_tempBlockKey;
 /**
  * Thread local key for storing integer value of amount of memory allocated
  */
@@ -46,6 +48,7 @@ typedef PairType* PairTypePtr;
 static void createThreadLocalKey() {
     (void)pthread_key_create( &m_key, NULL);
     (void)pthread_key_create( &m_stringKey, NULL);
+    (void)pthread_key_create( &m_tempBlockKey, NULL);
     (void)pthread_key_create( &m_keyAllocated, NULL);
 }
 
@@ -57,6 +60,7 @@ ThreadLocalPool::ThreadLocalPool() {
                 new PairType(
                         1, new MapType())));
         pthread_setspecific(m_stringKey, static_cast<const void*>(new CompactingStringStorage()));
+        pthread_setspecific(m_tempBlockKey, static_cast<const void*>(new TempBlockPool()));
     } else {
         PairTypePtr p =
                 static_cast<PairTypePtr>(pthread_getspecific(m_key));
@@ -75,6 +79,8 @@ ThreadLocalPool::~ThreadLocalPool() {
             pthread_setspecific( m_key, NULL);
             delete static_cast<CompactingStringStorage*>(pthread_getspecific(m_stringKey));
             pthread_setspecific(m_stringKey, NULL);
+            delete static_cast<TempBlockPool*>(pthread_getspecific(m_tempBlockKey));
+            pthread_setspecific(m_tempBlockKey, NULL);
             delete static_cast<std::size_t*>(pthread_getspecific(m_keyAllocated));
             pthread_setspecific( m_keyAllocated, NULL);
         } else {
@@ -177,6 +183,12 @@ ThreadLocalPool::getStringPool()
     return static_cast<CompactingStringStorage*>(pthread_getspecific(m_stringKey));
 }
 
+TempBlockPool*
+ThreadLocalPool::getTempBlockPool()
+{
+    return static_cast<TempBlockPool*>(pthread_getspecific(m_tempBlockKey));
+}
+
 boost::shared_ptr<boost::pool<voltdb_pool_allocator_new_delete> > ThreadLocalPool::get(std::size_t size) {
     size_t alloc_size = getAllocationSizeForObject(size);
     if (alloc_size == 0)
@@ -25,6 +25,8 @@
 
 namespace voltdb {
 
+class TempBlockPool;
+
 struct voltdb_pool_allocator_new_delete
 {
   typedef std::size_t size_type;
@@ -66,6 +68,12 @@ public:
     static std::size_t getPoolAllocationSize();
 
     static CompactingStringStorage* getStringPool();
+
+    /**
+     * The free list of temp table block storage shared by all fragments
+     * run on this thread, or NULL once the last ThreadLocalPool is gone.
+     */
+    static TempBlockPool* getTempBlockPool();
 };
 }
 
@@ -0,0 +1,77 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/TraceRing.h"
+
+#include <cstring>
+
+namespace voltdb {
+
+TraceRing::TraceRing() : m_enabled(false), m_next(0) {
+    ::memset(m_events, 0, sizeof(m_events));
+}
+
+void TraceRing::snapshot(std::vector<TraceEvent> &events) const {
+    events.clear();
+    const uint64_t last = m_next;
+    const uint64_t first = last > TRACE_RING_CAPACITY ? last - TRACE_RING_CAPACITY + 1 : 1;
+    events.reserve(static_cast<size_t>(last - first + 1));
+    for (uint64_t sequence = first; sequence <= last; ++sequence) {
+        const TraceEvent &slot = m_events[sequence & (TRACE_RING_CAPACITY - 1)];
+        if (slot.m_sequence != sequence) {
+            // still being written, or already reused for a later record
+            continue;
+        }
+        TraceEvent copy = slot;
+        __sync_synchronize();
+        if (slot.m_sequence == sequence) {
+            events.push_back(copy);
+        }
+    }
+}
+
+void TraceRing::clear() {
+    ::memset(m_events, 0, sizeof(m_events));
+    m_next = 0;
+}
+
+const char* TraceRing::eventName(int32_t code) {
+    switch (code) {
+      case TRACE_EVENT_FRAGMENT_BEGIN:
+        return "FRAGMENT_BEGIN";
+      case TRACE_EVENT_FRAGMENT_END:
+        return "FRAGMENT_END";
+      case TRACE_EVENT_FRAGMENT_RERUN:
+        return "FRAGMENT_RERUN";
+      case TRACE_EVENT_CSI_ON_KEY_TUPLE:
+        return "CSI_ON_KEY_TUPLE";
+      case TRACE_EVENT_COLD_STORAGE_EVICT:
+        return "COLD_STORAGE_EVICT";
+      case TRACE_EVENT_COLD_STORAGE_FETCH:
+        return "COLD_STORAGE_FETCH";
+      case TRACE_EVENT_COLD_STORAGE_FETCH_BATCH:
+        return "COLD_STORAGE_FETCH_BATCH";
+      case TRACE_EVENT_COLD_STORAGE_AGING:
+        return "COLD_STORAGE_AGING";
+      case TRACE_EVENT_TICK:
+        return "TICK";
+      default:
+        return "INVALID";
+    }
+}
+
+}
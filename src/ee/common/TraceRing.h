@@ -0,0 +1,137 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACERING_H_
+#define TRACERING_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <sys/time.h>
+#include <vector>
+
+/**
+ * Binary event trace for the EE hot path. Instead of printing, code
+ * on the execution path drops a fixed-size record (event code plus two
+ * integer arguments) into a per-engine ring, which can be dumped on
+ * demand through the stats interface. Recording is compiled in unless
+ * VOLT_TRACE_RING is set to 0, and costs one branch on a flag until
+ * the ring is switched on at runtime.
+ */
+#ifndef VOLT_TRACE_RING
+    #define VOLT_TRACE_RING 1
+#endif
+
+#if VOLT_TRACE_RING
+    #define VOLT_TRACE_EVENT(ring, code, arg0, arg1) (ring).record((code), (arg0), (arg1))
+#else
+    #define VOLT_TRACE_EVENT(ring, code, arg0, arg1) ((void)0)
+#endif
+
+namespace voltdb {
+
+// Number of records the ring holds; must be a power of two
+const uint32_t TRACE_RING_CAPACITY = 1024;
+
+enum TraceEventCode {
+    TRACE_EVENT_INVALID = 0,
+    // arg0: plan fragment id, arg1: parameter count
+    TRACE_EVENT_FRAGMENT_BEGIN = 1,
+    // arg0: plan fragment id, arg1: tuples modified
+    TRACE_EVENT_FRAGMENT_END = 2,
+    // arg0: plan fragment id, arg1: anti-cache blocks fetched before the re-run
+    TRACE_EVENT_FRAGMENT_RERUN = 3,
+    // arg0: tuple address, arg1: the counter value that was dropped
+    TRACE_EVENT_CSI_ON_KEY_TUPLE = 4,
+    // arg0: anti-cache block id, arg1: tuples in the block
+    TRACE_EVENT_COLD_STORAGE_EVICT = 5,
+    // arg0: anti-cache block id, arg1: tuples in the block
+    TRACE_EVENT_COLD_STORAGE_FETCH = 6,
+    // arg0: blocks fetched, arg1: microseconds the batch took
+    TRACE_EVENT_COLD_STORAGE_FETCH_BATCH = 7,
+    // arg0: blocks aged, arg1: blocks of the aging budget left
+    TRACE_EVENT_COLD_STORAGE_AGING = 8,
+    // arg0: tick time in milliseconds, arg1: unused
+    TRACE_EVENT_TICK = 9
+};
+
+struct TraceEvent {
+    // 1-based position in the event stream, 0 while the record is being written
+    uint64_t m_sequence;
+    int64_t m_timestamp;
+    int64_t m_arg0;
+    int64_t m_arg1;
+    int32_t m_code;
+    int32_t m_unused;
+};
+
+/**
+ * Fixed-size ring of TraceEvents. Writers claim a slot with an atomic
+ * increment and publish it by storing its sequence number last, so
+ * record() never blocks and a snapshot taken from another thread skips
+ * records that are half written or were overwritten while it copied.
+ */
+class TraceRing {
+  public:
+    TraceRing();
+
+    bool enabled() const {
+        return m_enabled;
+    }
+
+    void setEnabled(bool enabled) {
+        m_enabled = enabled;
+    }
+
+    inline void record(TraceEventCode code, int64_t arg0, int64_t arg1) {
+        if (!m_enabled) {
+            return;
+        }
+        const uint64_t sequence = __sync_fetch_and_add(&m_next, 1) + 1;
+        TraceEvent &event = m_events[sequence & (TRACE_RING_CAPACITY - 1)];
+        event.m_sequence = 0;
+        __sync_synchronize();
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        event.m_timestamp = static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+        event.m_arg0 = arg0;
+        event.m_arg1 = arg1;
+        event.m_code = code;
+        __sync_synchronize();
+        event.m_sequence = sequence;
+    }
+
+    /** Total number of records written, including those overwritten since */
+    uint64_t recorded() const {
+        return m_next;
+    }
+
+    /** Copy the records still in the ring into events, oldest first */
+    void snapshot(std::vector<TraceEvent> &events) const;
+
+    void clear();
+
+    static const char* eventName(int32_t code);
+
+  private:
+    volatile bool m_enabled;
+    volatile uint64_t m_next;
+    TraceEvent m_events[TRACE_RING_CAPACITY];
+};
+
+}
+
+#endif /* TRACERING_H_ */
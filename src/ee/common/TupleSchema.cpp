@@ -71,6 +71,7 @@ TupleSchema* TupleSchema::createTupleSchema(const TupleSchema *schema) {
 
     // clear all the offset values
     memcpy(retval, schema, memSize);
+    retval->m_columnDictionaries = NULL;
 
     return retval;
 }
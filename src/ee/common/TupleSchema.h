@@ -31,6 +31,8 @@
 
 namespace voltdb {
 
+class StringDictionary;
+
 /**
  * Represents the shcema of a tuple or table row. Used to define table rows, as
  * well as index keys. Note: due to arbitrary size embedded array data, this class
@@ -110,6 +112,17 @@ public:
 
     bool equals(const TupleSchema *other) const;
 
+    /** The dictionary sharing the values of a non-inlined column, or NULL. */
+    inline StringDictionary *columnDictionary(int index) const;
+    /**
+     * Only set on a PersistentTable's own schema, by
+     * PersistentTable::setDictionaryColumns(). Copies of the schema don't
+     * inherit the dictionaries.
+     */
+    void setColumnDictionaries(StringDictionary * const *dictionaries) {
+        m_columnDictionaries = dictionaries;
+    }
+
 private:
     // holds per column info
     struct ColumnInfo {
@@ -154,6 +167,8 @@ private:
     // number of columns
     uint16_t m_columnCount;
     uint16_t m_uninlinedObjectColumnCount;
+    // one entry per column, or NULL if no column is dictionary encoded
+    StringDictionary * const *m_columnDictionaries;
 
     /*
      * Data storage for column info and for indices of string columns
@@ -187,6 +202,14 @@ inline bool TupleSchema::columnIsInlined(const int index) const {
     return columnInfo->inlined;
 }
 
+inline StringDictionary *TupleSchema::columnDictionary(int index) const {
+    assert(index < m_columnCount);
+    if (m_columnDictionaries == NULL) {
+        return NULL;
+    }
+    return m_columnDictionaries[index];
+}
+
 inline uint32_t TupleSchema::columnOffset(int index) const {
     assert(index < m_columnCount);
     const ColumnInfo *columnInfo = getColumnInfo(index);
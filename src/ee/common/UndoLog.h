@@ -145,6 +145,11 @@ namespace voltdb
             }
         }
 
+        /** True if there are no undo quanta waiting to be undone or released. */
+        bool isEmpty() const {
+            return m_undoQuantums.empty();
+        }
+
         int64_t getSize() const
         {
             int64_t total = 0;
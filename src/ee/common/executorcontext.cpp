@@ -17,6 +17,8 @@
 #include "common/executorcontext.hpp"
 
 #include "common/debuglog.h"
+#include "storage/AntiCacheDB.h"
+#include "storage/persistenttable.h"
 
 #include <pthread.h>
 
@@ -41,6 +43,8 @@ ExecutorContext::ExecutorContext(int64_t siteId,
                 CatalogId hostId) :
     m_topEnd(topend), m_tempStringPool(tempStringPool),
     m_undoQuantum(undoQuantum), m_spHandle(0),
+    m_coldStorageEnabled(false), m_coldStoragePolicy(COLD_STORAGE_POLICY_TUPLE),
+    m_coldStorageAgingRequested(false), m_blockAccessCountdown(COLD_STORAGE_BLOCK_SAMPLE_PERIOD),
     m_lastCommittedSpHandle(0),
     m_siteId(siteId), m_partitionId(partitionId),
     m_hostname(hostname), m_hostId(hostId),
@@ -69,6 +73,20 @@ ExecutorContext::~ExecutorContext() {
     pthread_setspecific( static_key, NULL);
 }
 
+void ExecutorContext::sampleBlockAccess(PersistentTable *table, const TableTuple &tuple) {
+    table->recordBlockAccess(tuple);
+}
+
+void ExecutorContext::recordEvictedAccess(PersistentTable *table, const TableTuple &tombstone) {
+    assert(tombstone.isEvicted());
+    const EvictedTupleTombstone *evicted = reinterpret_cast<const EvictedTupleTombstone*>(tombstone.address());
+    m_evictedAccesses[table].insert(evicted->m_blockId);
+}
+
+void ExecutorContext::recordEvictedTable(PersistentTable *table) {
+    table->collectEvictedBlockIds(m_evictedAccesses[table]);
+}
+
 ExecutorContext* ExecutorContext::getExecutorContext() {
     (void)pthread_once(&static_keyOnce, createThreadLocalKey);
     return static_cast<ExecutorContext*>(pthread_getspecific( static_key));
@@ -20,9 +20,19 @@
 
 #include "Topend.h"
 #include "common/UndoQuantum.h"
+#include "common/tabletuple.h"
+#include "common/TraceRing.h"
+
+#include <map>
+#include <set>
 
 namespace voltdb {
 
+class PersistentTable;
+
+// Cold Storage block policy: one tuple access in this many reaches the block
+const uint32_t COLD_STORAGE_BLOCK_SAMPLE_PERIOD = 8;
+
 /*
  * EE site global data required by executors at runtime.
  *
@@ -121,6 +131,83 @@ class ExecutorContext {
         return m_lastCommittedSpHandle;
     }
 
+    /** Cold Storage: is tuple or block access tracked? */
+    bool coldStorageEnabled() const {
+        return m_coldStorageEnabled;
+    }
+
+    void setColdStorageEnabled(bool enabled) {
+        m_coldStorageEnabled = enabled;
+    }
+
+    ColdStoragePolicy coldStoragePolicy() const {
+        return m_coldStoragePolicy;
+    }
+
+    void setColdStoragePolicy(ColdStoragePolicy policy) {
+        m_coldStoragePolicy = policy;
+    }
+
+    /**
+     * Cold Storage: count one access to a persistent tuple that the
+     * current fragment read or wrote. Only executors that actually
+     * touch a tuple call this, so the cost is proportional to the
+     * rows a fragment visits rather than to the size of the table.
+     * Tuples of temp tables (table == NULL) are not tracked.
+     *
+     * Under the tuple policy a counter that saturates requests an
+     * aging pass, which the engine runs once the fragment has
+     * finished. Under the block policy only one access in
+     * COLD_STORAGE_BLOCK_SAMPLE_PERIOD is passed on to the tuple's
+     * block, so most rows cost a decrement.
+     */
+    inline void recordTupleAccess(PersistentTable *table, TableTuple &tuple) {
+        if (!m_coldStorageEnabled || table == NULL) {
+            return;
+        }
+        if (m_coldStoragePolicy == COLD_STORAGE_POLICY_TUPLE) {
+            if (tuple.incrementCSI()) {
+                m_coldStorageAgingRequested = true;
+            }
+        } else if (--m_blockAccessCountdown == 0) {
+            m_blockAccessCountdown = COLD_STORAGE_BLOCK_SAMPLE_PERIOD;
+            sampleBlockAccess(table, tuple);
+        }
+    }
+
+    /** Returns true (once) if an access counter saturated since the last call */
+    bool takeColdStorageAgingRequest() {
+        const bool requested = m_coldStorageAgingRequested;
+        m_coldStorageAgingRequested = false;
+        return requested;
+    }
+
+    /**
+     * Cold Storage: executors call this when an index hands them the
+     * tombstone of an evicted tuple, and then skip it. Once the executor
+     * returns, the engine fetches every recorded block back from the
+     * anti-cache in one batched read and runs the fragment again.
+     */
+    void recordEvictedAccess(PersistentTable *table, const TableTuple &tombstone);
+
+    /** Like recordEvictedAccess, for a scan that needs all of a table's evicted tuples */
+    void recordEvictedTable(PersistentTable *table);
+
+    bool hasEvictedAccesses() const {
+        return ! m_evictedAccesses.empty();
+    }
+
+    /** Hand over the blocks recorded since the last call, by table */
+    void takeEvictedAccesses(std::map<PersistentTable*, std::set<int32_t> > &accesses) {
+        accesses.clear();
+        accesses.swap(m_evictedAccesses);
+    }
+
+    /** This engine's event trace; see VOLT_TRACE_EVENT */
+    TraceRing& traceRing() {
+        return m_traceRing;
+    }
+
     static ExecutorContext* getExecutorContext();
 
     static Pool* getTempStringPool() {
@@ -131,12 +218,20 @@ class ExecutorContext {
     }
 
   private:
+    void sampleBlockAccess(PersistentTable *table, const TableTuple &tuple);
+
     Topend *m_topEnd;
     Pool *m_tempStringPool;
     UndoQuantum *m_undoQuantum;
     int64_t m_spHandle;
     int64_t m_uniqueId;
     int64_t m_currentTxnTimestamp;
+    bool m_coldStorageEnabled;
+    ColdStoragePolicy m_coldStoragePolicy;
+    bool m_coldStorageAgingRequested;
+    uint32_t m_blockAccessCountdown;
+    std::map<PersistentTable*, std::set<int32_t> > m_evictedAccesses;
+    TraceRing m_traceRing;
   public:
     int64_t m_lastCommittedSpHandle;
     int64_t m_siteId;
@@ -50,10 +50,11 @@
 #include "common/common.h"
 #include "common/debuglog.h"
 #include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
 
 namespace voltdb {
 
-std::string TableTuple::debug(const std::string& tableName) { // ) const
+std::string TableTuple::debug(const std::string& tableName) const {
     assert(m_schema);
     assert(m_data);
 
@@ -63,14 +64,7 @@ std::string TableTuple::debug(const std::string& tableName) { // ) const
     } else {
         buffer << "TableTuple(" << tableName << ") ->";
     }
-    
-    
-	//if( isTuple ) {
-    //      setCSI(1);
-    // }
-    
-  	
- 	      
+
     if (isActive() == false) {
         buffer << " <DELETED>";
     } else {
@@ -147,21 +141,33 @@ bool TableTuple::compatibleForCopy(const TableTuple &source) {
 
 void TableTuple::setCSI(int newCSI) {
 	if( isTuple ) {
-		m_CSI = newCSI;
-		m_data[1] = static_cast<char>(m_CSI);
-		//std::cout << "Ustawiono nowa wartosc CSI:" << m_CSI << std::endl;
+		if (newCSI < 0) {
+			newCSI = 0;
+		} else if (newCSI > TUPLE_CSI_MAX) {
+			newCSI = TUPLE_CSI_MAX;
+		}
+		m_data[TUPLE_HEADER_CSI_OFFSET] = static_cast<char>(newCSI);
 	} else {
-		std::cout << "To nie tuple, a wolaja setCSI" << std::endl;
+		// key tuples have no header; record the misuse instead of writing into the key
+		ExecutorContext *context = ExecutorContext::getExecutorContext();
+		if (context != NULL) {
+			VOLT_TRACE_EVENT(context->traceRing(), TRACE_EVENT_CSI_ON_KEY_TUPLE,
+			                 reinterpret_cast<intptr_t>(m_data), newCSI);
+		}
 	}
- 
 }
-int TableTuple::getCSI() {
-	return (int) m_data[1];
+int TableTuple::getCSI() const {
+	return (int) m_data[TUPLE_HEADER_CSI_OFFSET];
 }	
 
-void TableTuple::incrementCSI() {
-	int current = (int) m_data[1];
+bool TableTuple::incrementCSI() {
+	int current = (int) m_data[TUPLE_HEADER_CSI_OFFSET];
+	if (current >= TUPLE_CSI_MAX) {
+		// saturated: leave the counter where it is until aging lowers it
+		return true;
+	}
 	setCSI( current + 1 );
+	return false;
 }
 
 
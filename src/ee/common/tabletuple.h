@@ -49,6 +49,8 @@
 #include "common/common.h"
 #include "common/TupleSchema.h"
 #include "common/Pool.hpp"
+#include "common/StringDictionary.h"
+#include "common/StringRef.h"
 #include "common/ValuePeeker.hpp"
 #include "common/FatalException.hpp"
 #include "common/ExportSerializeIo.h"
@@ -61,12 +63,22 @@ class CopyOnWriteTest_TestTableTupleFlags;
 
 namespace voltdb {
 
-#define TUPLE_HEADER_SIZE 100
+/*
+ * Every tuple in a table's backing store is prefixed by a packed header:
+ *   byte 0: the status flags (the *_MASK bits below)
+ *   byte 1: the Cold Storage access counter (CSI), 0 to TUPLE_CSI_MAX
+ * Index keys are stored without the header (see moveNoHeader()).
+ */
+#define TUPLE_HEADER_FLAGS_OFFSET 0
+#define TUPLE_HEADER_CSI_OFFSET 1
+#define TUPLE_HEADER_SIZE 2
+#define TUPLE_CSI_MAX 127
 
 #define ACTIVE_MASK 1
 #define DIRTY_MASK 2
 #define PENDING_DELETE_MASK 4
 #define PENDING_DELETE_ON_UNDO_RELEASE_MASK 8
+#define EVICTED_MASK 16
 
 class TableColumn;
 
@@ -77,6 +89,7 @@ class TableTuple {
     friend class PersistentTable;
     friend class CopyOnWriteIterator;
     friend class CopyOnWriteContext;
+    friend class EvictedTupleIterator;
     friend class ::CopyOnWriteTest_TestTableTupleFlags;
 
 public:
@@ -84,18 +97,16 @@ public:
     explicit TableTuple();
     
     
-    // ###
-    int m_CSI; // mamy miejsce bo zmielismy TUPLE_HEADER_SIZE 1->100.
+    /** Cold Storage access counter kept in the tuple header */
     void setCSI(int newCSI);
-    int getCSI(); 
-	bool isTuple; // na wypadek jesli tuple to index key 
-	bool checkIfTuple() {
-		return isTuple;
-	}
-	void incrementCSI();
-
-
-
+    int getCSI() const;
+    /** False when wrapping an index key, which has no header to hold a CSI */
+    bool isTuple;
+    bool checkIfTuple() {
+        return isTuple;
+    }
+    /** Bump the access counter; returns true if it is saturated and needs aging */
+    bool incrementCSI();
 
     /** Setup the tuple given a table */
     TableTuple(const TableTuple &rhs);
@@ -120,7 +131,7 @@ public:
 
     inline void moveNoHeader(void *address) {
         assert(m_schema);
-        isTuple = false; // ###
+        isTuple = false;
         // isActive() and all the other methods expect a header
         m_data = reinterpret_cast<char*> (address) - TUPLE_HEADER_SIZE;
     }
@@ -130,7 +141,7 @@ public:
     inline void moveToReadOnlyTuple(const void *address) {
         assert(m_schema);
         assert(address);
-        isTuple = false; // ###
+        isTuple = false;
         //Necessary to move the pointer back TUPLE_HEADER_SIZE
         // artificially because Tuples used as keys for indexes do not
         // have the header.
@@ -207,7 +218,10 @@ public:
                 if (((getType(i) == VALUE_TYPE_VARCHAR) || (getType(i) == VALUE_TYPE_VARBINARY)) &&
                     !m_schema->columnIsInlined(i))
                 {
-                    if (!getNValue(i).isNull())
+                    // strings shared through a StringDictionary are
+                    // charged to the dictionary
+                    const StringRef *sref = *reinterpret_cast<StringRef* const*>(getDataPtr(i));
+                    if (!getNValue(i).isNull() && !sref->isShared())
                     {
                         bytes +=
                             StringRef::
@@ -240,20 +254,28 @@ public:
 
     /** Is the tuple deleted or active? */
     inline bool isActive() const {
-        return (*(reinterpret_cast<const char*> (m_data)) & ACTIVE_MASK) ? true : false;
+        return (m_data[TUPLE_HEADER_FLAGS_OFFSET] & ACTIVE_MASK) ? true : false;
     }
 
     /** Is the tuple deleted or active? */
     inline bool isDirty() const {
-        return (*(reinterpret_cast<const char*> (m_data)) & DIRTY_MASK) ? true : false;
+        return (m_data[TUPLE_HEADER_FLAGS_OFFSET] & DIRTY_MASK) ? true : false;
     }
 
     inline bool isPendingDelete() const {
-        return (*(reinterpret_cast<const char*> (m_data)) & PENDING_DELETE_MASK) ? true : false;
+        return (m_data[TUPLE_HEADER_FLAGS_OFFSET] & PENDING_DELETE_MASK) ? true : false;
     }
 
     inline bool isPendingDeleteOnUndoRelease() const {
-        return (*(reinterpret_cast<const char*> (m_data)) & PENDING_DELETE_ON_UNDO_RELEASE_MASK) ? true : false;
+        return (m_data[TUPLE_HEADER_FLAGS_OFFSET] & PENDING_DELETE_ON_UNDO_RELEASE_MASK) ? true : false;
+    }
+
+    /**
+     * Is this not a tuple at all but the tombstone an evicted tuple left
+     * behind in the indexes? Only the flags byte of a tombstone is valid.
+     */
+    inline bool isEvicted() const {
+        return (m_data[TUPLE_HEADER_FLAGS_OFFSET] & EVICTED_MASK) ? true : false;
     }
 
     /** Is the column value null? */
@@ -290,7 +312,7 @@ public:
     }
 
     /** Print out a human readable description of this tuple */
-    std::string debug(const std::string& tableName); // ### bylo )const
+    std::string debug(const std::string& tableName) const;
     std::string debugNoHeader() const;
 
     /** Copy values from one tuple into another (uses memcpy) */
@@ -322,38 +344,38 @@ public:
 protected:
     inline void setActiveTrue() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) |= static_cast<char>(ACTIVE_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] |= static_cast<char>(ACTIVE_MASK);
     }
     inline void setActiveFalse() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) &= static_cast<char>(~ACTIVE_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] &= static_cast<char>(~ACTIVE_MASK);
     }
 
     inline void setPendingDeleteOnUndoReleaseTrue() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) |= static_cast<char>(PENDING_DELETE_ON_UNDO_RELEASE_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] |= static_cast<char>(PENDING_DELETE_ON_UNDO_RELEASE_MASK);
     }
     inline void setPendingDeleteOnUndoReleaseFalse() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) &= static_cast<char>(~PENDING_DELETE_ON_UNDO_RELEASE_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] &= static_cast<char>(~PENDING_DELETE_ON_UNDO_RELEASE_MASK);
     }
 
     inline void setPendingDeleteTrue() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) |= static_cast<char>(PENDING_DELETE_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] |= static_cast<char>(PENDING_DELETE_MASK);
     }
     inline void setPendingDeleteFalse() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) &= static_cast<char>(~PENDING_DELETE_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] &= static_cast<char>(~PENDING_DELETE_MASK);
     }
 
     inline void setDirtyTrue() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) |= static_cast<char>(DIRTY_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] |= static_cast<char>(DIRTY_MASK);
     }
     inline void setDirtyFalse() {
         // treat the first "value" as a boolean flag
-        *(reinterpret_cast<char*> (m_data)) &= static_cast<char>(~DIRTY_MASK);
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] &= static_cast<char>(~DIRTY_MASK);
     }
 	
 	
@@ -404,20 +426,18 @@ private:
 
 inline TableTuple::TableTuple() :
     m_schema(NULL), m_data(NULL) {
-    // ### 
-    m_CSI = 0;
     isTuple = true;
 }
 
 inline TableTuple::TableTuple(const TableTuple &rhs) :
     m_schema(rhs.m_schema), m_data(rhs.m_data) {
-    isTuple = true; // ###
+    isTuple = true;
 }
 
 inline TableTuple::TableTuple(const TupleSchema *schema) :
     m_schema(schema), m_data(NULL) {
     assert (m_schema);
-    isTuple = true; // ###
+    isTuple = true;
 }
 
 /** Setup the tuple given the specified data location and schema **/
@@ -426,7 +446,7 @@ inline TableTuple::TableTuple(char *data, const voltdb::TupleSchema *schema) {
     assert(schema);
     m_data = data;
     m_schema = schema;
-    isTuple = true; // ###
+    isTuple = true;
 }
 
 inline TableTuple& TableTuple::operator=(const TableTuple &rhs) {
@@ -461,6 +481,12 @@ inline void TableTuple::setNValueAllocateForObjectCopies(const int idx,
     const bool isInlined = m_schema->columnIsInlined(idx);
     char *dataPtr = getDataPtr(idx);
     const int32_t columnLength = m_schema->columnLength(idx);
+    if (!isInlined && dataPool == NULL && !value.isNull()) {
+        StringDictionary *dictionary = m_schema->columnDictionary(idx);
+        if (dictionary != NULL && dictionary->share(value, columnLength, dataPtr)) {
+            return;
+        }
+    }
     value.serializeToTupleStorageAllocateForObjects(dataPtr, isInlined,
                                                     columnLength, dataPool);
 }
@@ -508,7 +534,7 @@ inline void TableTuple::copyForPersistentInsert(const voltdb::TableTuple &source
                                                     source.getNValue(uinlineableObjectColumnIndex),
                                                     pool);
             }
-            m_data[0] = source.m_data[0];
+            m_data[TUPLE_HEADER_FLAGS_OFFSET] = source.m_data[TUPLE_HEADER_FLAGS_OFFSET];
         } else {
             // copy the data AND the isActive flag
             ::memcpy(m_data, source.m_data, m_schema->tupleLength() + TUPLE_HEADER_SIZE);
@@ -522,7 +548,7 @@ inline void TableTuple::copyForPersistentInsert(const voltdb::TableTuple &source
             setNValueAllocateForObjectCopies(ii, source.getNValue(ii), pool);
         }
 
-        m_data[0] = source.m_data[0];
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] = source.m_data[TUPLE_HEADER_FLAGS_OFFSET];
     }
 }
 
@@ -590,7 +616,7 @@ inline void TableTuple::copyForPersistentUpdate(const TableTuple &source,
         }
         // This obscure assignment is propagating the tuple flags rather than leaving it to the caller.
         // TODO: It would be easier for the caller to simply set the values it wants upon return.
-        m_data[0] = source.m_data[0];
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] = source.m_data[TUPLE_HEADER_FLAGS_OFFSET];
     } else {
         // copy the tuple flags and the data (all inline/scalars)
         ::memcpy(m_data, source.m_data, m_schema->tupleLength() + TUPLE_HEADER_SIZE);
@@ -628,7 +654,7 @@ inline void TableTuple::copy(const TableTuple &source) {
         for (uint16_t ii = 0; ii < columnCount; ii++) {
             setNValue(ii, source.getNValue(ii));
         }
-        m_data[0] = source.m_data[0];
+        m_data[TUPLE_HEADER_FLAGS_OFFSET] = source.m_data[TUPLE_HEADER_FLAGS_OFFSET];
     }
 }
 
@@ -57,6 +57,13 @@ enum HashinatorType {
     , HASHINATOR_ELASTIC = 1
 };
 
+// How Cold Storage tracks hotness: a counter in every tuple header,
+// or a reference bit and sampled counter per tuple block
+enum ColdStoragePolicy {
+    COLD_STORAGE_POLICY_TUPLE = 0
+    , COLD_STORAGE_POLICY_BLOCK = 1
+};
+
 // ------------------------------------------------------------------
 // Value Types
 // This file defines all the types that we will support
@@ -338,7 +345,13 @@ enum TableStreamType {
 // ------------------------------------------------------------------
 enum StatisticsSelectorType {
     STATISTICS_SELECTOR_TYPE_TABLE,
-    STATISTICS_SELECTOR_TYPE_INDEX
+    STATISTICS_SELECTOR_TYPE_INDEX,
+    // the ordinal of SysProcSelector.COLDSTORAGE
+    STATISTICS_SELECTOR_TYPE_COLD_STORAGE = 16,
+    // the ordinal of SysProcSelector.EETRACE; the engine's trace ring, not a StatsSource
+    STATISTICS_SELECTOR_TYPE_TRACE = 17,
+    // the ordinal of SysProcSelector.TEMPBLOCKPOOL; one row per site, under locator 0
+    STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL = 18
 };
 
 // ------------------------------------------------------------------
@@ -54,11 +54,14 @@
 #include "common/valuevector.h"
 #include "common/TheHashinator.h"
 #include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "common/ValueFactory.hpp"
 #include "common/executorcontext.hpp"
 #include "common/FatalException.hpp"
 #include "common/RecoveryProtoMessage.h"
 #include "common/LegacyHashinator.h"
 #include "common/ElasticHashinator.h"
+#include "common/LargePages.h"
 #include "catalog/catalogmap.h"
 #include "catalog/catalog.h"
 #include "catalog/cluster.h"
@@ -83,12 +86,15 @@
 #include "storage/table.h"
 #include "storage/tablefactory.h"
 #include "indexes/tableindex.h"
+#include "indexes/IndexBuilder.h"
 #include "storage/constraintutil.h"
 #include "storage/persistenttable.h"
 #include "storage/streamedtable.h"
 #include "storage/MaterializedViewMetadata.h"
 #include "storage/StreamBlock.h"
 #include "storage/TableCatalogDelegate.hpp"
+#include "storage/TableImage.h"
+#include "storage/TempBlockPool.h"
 #include "org_voltdb_jni_ExecutionEngine.h" // to use static values
 #include "stats/StatsAgent.h"
 #include "voltdbipc.h"
@@ -96,6 +102,7 @@
 
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 #include <fstream>
 #include <errno.h>
 #include <sstream>
@@ -111,7 +118,7 @@ namespace voltdb {
 const int64_t AD_HOC_FRAG_ID = -1;
 
 VoltDBEngine::VoltDBEngine(Topend *topend, LogProxy *logProxy, bool coldStorageIsEnabled, float limitMemoryUsage, 
-                           float percentageOfDataToMove)
+                           float percentageOfDataToMove, ColdStoragePolicy coldStoragePolicy)
     : m_currentUndoQuantum(NULL),
       m_hashinator(NULL),
       m_staticParams(MAX_PARAM_COUNT),
@@ -125,7 +132,17 @@ VoltDBEngine::VoltDBEngine(Topend *topend, LogProxy *logProxy, bool coldStorageI
       m_topend(topend),
       m_isCSEnabled(coldStorageIsEnabled), //przekazana informacja, czy Cold Storage jest włączony
       m_limitMemoryUsage(limitMemoryUsage), //przekazana liczba procent użycia pamięci, przy którym wyjonywany jest zrzut na dysk
-      m_percentageOfDataToMove(percentageOfDataToMove) //przekazywana liczba procent danych do zrzutu na dysk
+      m_percentageOfDataToMove(percentageOfDataToMove), //przekazywana liczba procent danych do zrzutu na dysk
+      m_coldStoragePolicy(coldStoragePolicy),
+      m_coldStorageMemoryLimit(0),
+      m_traceTable(NULL),
+      m_compactionStepsPerTick(DEFAULT_COMPACTION_STEPS_PER_TICK),
+      m_compactionMicrosPerTick(DEFAULT_COMPACTION_MICROS_PER_TICK),
+      m_coldStorageAgingBlocksPerTick(DEFAULT_COLD_STORAGE_AGING_BLOCKS_PER_TICK),
+      m_coldStorageAgingMicrosPerTick(DEFAULT_COLD_STORAGE_AGING_MICROS_PER_TICK),
+      m_largePages(false),
+      m_tempTableSpillThreshold(-1),
+      m_tempTableSpillDirectory("/tmp")
 {
     // init the number of planfragments executed
     m_pfCount = 0;
@@ -135,6 +152,11 @@ VoltDBEngine::VoltDBEngine(Topend *topend, LogProxy *logProxy, bool coldStorageI
         m_partOfDataToMove = percentageOfDataToMove * 0.01f; //cześć danych do zrzutu (wyrażona w ułamku dziesiętnym)
         m_numCSCut = static_cast<int>(round(m_partOfDataToMove * 127)); //wartość, o którą będą obniżane indesy
         m_maxCutCS = 127 - m_numCSCut; //maksymalna wartość indesu po ucięciu wszystkich indesów
+
+        // The limit is a percentage of the physical memory of the host.
+        const int64_t physicalMemory =
+            static_cast<int64_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<int64_t>(sysconf(_SC_PAGE_SIZE));
+        m_coldStorageMemoryLimit = static_cast<int64_t>(static_cast<double>(physicalMemory) * (limitMemoryUsage * 0.01));
     }
     
     // require a site id, at least, to inititalize.
@@ -182,6 +204,18 @@ VoltDBEngine::initialize(int32_t clusterIndex,
     m_partitionId = partitionId;
     m_tempTableMemoryLimit = tempTableMemoryLimit;
 
+    // Back tables, indexes and pools with huge pages from here on, and
+    // keep this site's thread and memory on one NUMA node. The low half
+    // of the site id numbers the sites of the host.
+    if (m_largePages) {
+        LargePages::setEnabled(true);
+        const int node = LargePages::bindToNode(static_cast<int32_t>(siteId));
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Site %jd backs its storage with huge pages, NUMA node %d",
+                 (intmax_t)siteId, node);
+        LogManager::getThreadLogger(LOGGERID_HOST)->log(LOGLEVEL_INFO, msg);
+    }
+
     // Instantiate our catalog - it will be populated later on by load()
     m_catalog = boost::shared_ptr<catalog::Catalog>(new catalog::Catalog());
 
@@ -223,6 +257,19 @@ VoltDBEngine::initialize(int32_t clusterIndex,
                                             m_isELEnabled,
                                             hostname,
                                             hostId);
+    m_executorContext->setColdStorageEnabled(m_isCSEnabled);
+    m_executorContext->setColdStoragePolicy(m_coldStoragePolicy);
+
+    // The pool outlives catalog changes, so this is registered once and
+    // rebuildTableCollections() leaves it alone
+    m_tempBlockPoolStats.configure("Temp block pool stats", 1);
+    getStatsManager().registerStatsSource(STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL, 0,
+                                          &m_tempBlockPoolStats);
+
+    if (m_isCSEnabled) {
+        const char *antiCacheDir = getenv("TMPDIR");
+        m_antiCacheDB.reset(new AntiCacheDB(antiCacheDir != NULL ? antiCacheDir : P_tmpdir, siteId));
+    }
 
     switch (hashinatorType) {
     case HASHINATOR_LEGACY:
@@ -272,6 +319,8 @@ VoltDBEngine::~VoltDBEngine() {
         tidPair.second->decrementRefcount();
     }
 
+    delete m_traceTable;
+
     delete m_topend;
     delete m_executorContext;
 }
@@ -318,22 +367,13 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
                                bool first, bool last)
 {
     assert(planfragmentId != 0);
-    
-    if (m_isCSEnabled) //jeśli Cold Storage jest włączony, wypisuj znaki nowego wiersza
-    {
-	//std::cout << "\n —————————————————————————————————————————————— \n";
-	std::cout << "\n\n";
-	params.debug(); // ###
-	std::cout << "\n\n";
-	//std::cout << "\n —————————————————————————————————————————————— \n";
-    }
-    
+    VOLT_TRACE_EVENT(m_executorContext->traceRing(), TRACE_EVENT_FRAGMENT_BEGIN,
+                     planfragmentId, params.size());
+
     Table *cleanUpTable = NULL;
     m_currentOutputDepId = outputDependencyId;
     m_currentInputDepId = inputDependencyId;
 
-	//std::cout << std::endl << "WYKONUJ SIE… " << std::endl; #####
-	
     /*
      * Reserve space in the result output buffer for the number of
      * result dependencies and for the dirty byte. Necessary for a
@@ -388,78 +428,16 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
     // children are positioned before it in this list, therefore
     // dependency tracking is not needed here.
     size_t ttl = execsForFrag->list.size();
+    bool rerun = false;
     for (int ctr = 0; ctr < ttl; ++ctr)
     {
         AbstractExecutor *executor = execsForFrag->list[ctr];
         assert (executor);
-        if (m_isCSEnabled) //jeśli Cold Sorage jest włączony, inkrementuj indesy
-        {
-            bool maxIsAchieved = false; //czy przekroczono maksymalną wartość indeksu
-
-                    // ###
-            std::vector<Table*>& dTmp = executor->getPlanNode()->getInputTables();
-            for(int i = 0; i < dTmp.size(); i++)
-            {
-
-                       Table * realtbl = this->getTable( dTmp[i]->name() );
-                               if( realtbl == NULL ) {
-                                            std::cout << "Real Tabele - NULL \n" << std::endl;
-                                            continue; 
-                               }
-                               TableTuple tempTuple = TableTuple(realtbl->schema());
-                               TableIterator iterator = realtbl->iterator();
-                       while (iterator.next(tempTuple)) {
-                                    std::cout << "> Odczytane CSI dla wiersza : " << tempTuple.getCSI() << ". Inkrementujemy!\n";
-                                    tempTuple.incrementCSI();
-                                    if (tempTuple.getCSI() < 0) //jeśli indeks mniejszy od zera, to oznacza, że przekroczono maksimum
-                                    {
-                                        maxIsAchieved = true;
-                                    }
-                   }
-
-            }
-            if (maxIsAchieved) //jeśli przekroczono maksymalną wartość indeksu, to pomniejsz wszystkie indeksy
-            {
-                map<int32_t, Table*>::const_iterator ti; 
-                const map<int32_t, Table*>::const_iterator begin = m_tables.begin();
-                const map<int32_t, Table*>::const_iterator end = m_tables.end();
-                for (ti = begin; ti != end; ti++)
-                {
-                    Table *table = ti->second;
-                    if( table == NULL )
-                    {
-                        continue; 
-                    }
-                    TableTuple tempTuple = TableTuple(table->schema());
-                    TableIterator iterator = table->iterator();
-                    while (iterator.next(tempTuple))
-                    {
-                        int cs =  tempTuple.getCSI();
-                        if (cs >= m_numCSCut)
-                        {
-                            tempTuple.setCSI(cs - m_numCSCut);
-                        }
-                        else
-                        {
-                            if (cs > 0)
-                            {
-                                tempTuple.setCSI(0);
-                            }
-                            else
-                            {
-                                if (cs < 0)
-                                {
-                                    tempTuple.setCSI(m_maxCutCS);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            // ###  
+        // The dependencies a receive node loaded can't be loaded again,
+        // so a re-run keeps the tables the first run received.
+        if (rerun && executor->getPlanNode()->getPlanNodeType() == PLAN_NODE_TYPE_RECEIVE) {
+            continue;
         }
-        
-
         if (executor->needsPostExecuteClear())
             cleanUpTable =
                 dynamic_cast<Table*>(executor->getPlanNode()->getOutputTable());
@@ -478,6 +456,30 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
                 m_currentInputDepId = -1;
                 return ENGINE_ERRORCODE_ERROR;
             }
+
+            // Cold Storage: the executor skipped tuples that are in the
+            // anti-cache. Bring them back and run the fragment again from
+            // the start, except for its receive nodes. Executors that modify
+            // tables usually run after the scans that feed them, so nothing
+            // has been changed yet.
+            if (m_executorContext->hasEvictedAccesses()) {
+                const size_t fetched = unevictAccessedBlocks();
+                if (m_tuplesModified != 0) {
+                    // Too late to run it again here. Fail the fragment so
+                    // the undo log rolls back its changes; the tuples are
+                    // resident when the transaction is retried.
+                    char message[256];
+                    snprintf(message, sizeof(message),
+                             "PlanFragment '%jd' reached evicted tuples after modifying %jd tuples;"
+                             " they have been fetched back, retry the transaction",
+                             (intmax_t)planfragmentId, (intmax_t)m_tuplesModified);
+                    throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION, message);
+                }
+                VOLT_TRACE_EVENT(m_executorContext->traceRing(), TRACE_EVENT_FRAGMENT_RERUN,
+                                 planfragmentId, fetched);
+                rerun = true;
+                ctr = -1;
+            }
         } catch (const SerializableEEException &e) {
             VOLT_TRACE("The Executor's execution at position '%d'"
                        " failed for PlanFragment '%jd'",
@@ -496,6 +498,12 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
     if (cleanUpTable != NULL)
         cleanUpTable->deleteAllTuples(false);
 
+    // The executors bump the access counter of every tuple they
+    // touch. If one of them saturated, have tick() age the counters.
+    if (m_executorContext->takeColdStorageAgingRequest()) {
+        requestColdStorageAging();
+    }
+
     // assume this is sendless dml
     if (m_numResultDependencies == 0) {
         // put the number of tuples modified into our simple table
@@ -524,10 +532,154 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
     m_currentOutputDepId = -1;
     m_currentInputDepId = -1;
 
+    VOLT_TRACE_EVENT(m_executorContext->traceRing(), TRACE_EVENT_FRAGMENT_END,
+                     planfragmentId, m_tuplesModified);
     VOLT_DEBUG("Finished executing.");
     return ENGINE_ERRORCODE_SUCCESS;
 }
 
+/*
+ * Cold Storage: start a pass that lowers the access counter of every
+ * tuple in every table by m_numCSCut, so that the relative hotness of
+ * tuples is preserved while making room for new accesses. The pass
+ * itself runs a few blocks at a time from tick().
+ */
+void VoltDBEngine::requestColdStorageAging()
+{
+    typedef pair<int32_t, Table*> TablePair;
+    BOOST_FOREACH (TablePair entry, m_tables) {
+        PersistentTable *table = dynamic_cast<PersistentTable*>(entry.second);
+        if (table != NULL) {
+            table->requestColdStorageAging();
+        }
+    }
+}
+
+/*
+ * Cold Storage: advance the aging pass by at most
+ * m_coldStorageAgingBlocksPerTick blocks and m_coldStorageAgingMicrosPerTick,
+ * so each tick pays a small, bounded cost instead of a transaction
+ * stalling on every table.
+ */
+void VoltDBEngine::ageColdStorageIncrementally()
+{
+    const int64_t deadline = ColdStorageStats::nowMicros() + m_coldStorageAgingMicrosPerTick;
+    size_t budget = m_coldStorageAgingBlocksPerTick;
+    typedef pair<int32_t, Table*> TablePair;
+    BOOST_FOREACH (TablePair entry, m_tables) {
+        if (budget == 0 || ColdStorageStats::nowMicros() >= deadline) {
+            break;
+        }
+        PersistentTable *table = dynamic_cast<PersistentTable*>(entry.second);
+        if (table != NULL && table->coldStorageAgingPending()) {
+            budget -= table->ageColdStorageBlocks(m_numCSCut, m_maxCutCS, budget, deadline);
+        }
+    }
+    if (budget < m_coldStorageAgingBlocksPerTick) {
+        VOLT_TRACE_EVENT(m_executorContext->traceRing(), TRACE_EVENT_COLD_STORAGE_AGING,
+                         m_coldStorageAgingBlocksPerTick - budget, budget);
+    }
+}
+
+/*
+ * Cold Storage: read every anti-cache block the current fragment ran
+ * into in one batched read and put the tuples back into their tables.
+ */
+size_t VoltDBEngine::unevictAccessedBlocks()
+{
+    std::map<PersistentTable*, std::set<int32_t> > accesses;
+    m_executorContext->takeEvictedAccesses(accesses);
+
+    std::vector<int32_t> blockIds;
+    std::vector<PersistentTable*> owners;
+    typedef pair<PersistentTable* const, std::set<int32_t> > AccessPair;
+    BOOST_FOREACH (AccessPair &access, accesses) {
+        BOOST_FOREACH (int32_t blockId, access.second) {
+            blockIds.push_back(blockId);
+            owners.push_back(access.first);
+        }
+    }
+
+    const int64_t start = ColdStorageStats::nowMicros();
+    std::vector<std::vector<char> > blocks;
+    m_antiCacheDB->readBlocks(blockIds, blocks);
+    for (size_t ii = 0; ii < blockIds.size(); ++ii) {
+        owners[ii]->unevictBlock(blockIds[ii], blocks[ii]);
+    }
+
+    // The fragment waited for the whole batch, whichever table it was for
+    const int64_t elapsed = ColdStorageStats::nowMicros() - start;
+    BOOST_FOREACH (AccessPair &access, accesses) {
+        access.first->getColdStorageStats()->recordFetchLatency(elapsed);
+    }
+    VOLT_TRACE_EVENT(m_executorContext->traceRing(), TRACE_EVENT_COLD_STORAGE_FETCH_BATCH,
+                     blockIds.size(), elapsed);
+    return blockIds.size();
+}
+
+/*
+ * Cold Storage: memory held by persistent table tuples and their
+ * strings. Index memory is left out since evicting tuples does not
+ * shrink the indexes; their entries just point at tombstones.
+ */
+int64_t VoltDBEngine::coldStorageMemoryInUse() const
+{
+    int64_t bytes = 0;
+    typedef pair<int32_t, Table*> TablePair;
+    BOOST_FOREACH (TablePair table, m_tables) {
+        PersistentTable *persistentTable = dynamic_cast<PersistentTable*>(table.second);
+        if (persistentTable != NULL) {
+            bytes += persistentTable->allocatedTupleMemory() + persistentTable->nonInlinedMemorySize();
+        }
+    }
+    return bytes;
+}
+
+/*
+ * Cold Storage: once table memory crosses m_coldStorageMemoryLimit,
+ * evict m_partOfDataToMove of the resident tuples of every table,
+ * coldest first. Materialized views are maintained through index
+ * lookups on their own tables, so those are never evicted.
+ */
+void VoltDBEngine::evictColdTuples()
+{
+    const int64_t memoryInUse = coldStorageMemoryInUse();
+    if (memoryInUse <= m_coldStorageMemoryLimit) {
+        return;
+    }
+
+    int64_t evicted = 0;
+    map<string, catalog::Table*>::const_iterator tableIterator;
+    for (tableIterator = m_database->tables().begin();
+         tableIterator != m_database->tables().end(); ++tableIterator) {
+        catalog::Table *catalogTable = tableIterator->second;
+        if (catalogTable->materializer() != NULL) {
+            continue;
+        }
+        PersistentTable *table = dynamic_cast<PersistentTable*>(m_tables[catalogTable->relativeIndex()]);
+        if (table == NULL || ! table->canEvict()) {
+            continue;
+        }
+        const int64_t tupleCount = static_cast<int64_t>(static_cast<float>(table->activeTupleCount()) * m_partOfDataToMove);
+        if (m_coldStoragePolicy == COLD_STORAGE_POLICY_BLOCK) {
+            evicted += table->evictColdBlocks(m_antiCacheDB.get(), tupleCount);
+        } else {
+            evicted += table->evictColdTuples(m_antiCacheDB.get(), tupleCount);
+        }
+    }
+
+    if (evicted == 0) {
+        return;
+    }
+    char msg[512];
+    snprintf(msg, sizeof(msg),
+             "Cold Storage evicted %jd tuples with table memory at %jd of %jd bytes;"
+             " anti-cache now holds %jd bytes in %jd blocks",
+             (intmax_t)evicted, (intmax_t)memoryInUse, (intmax_t)m_coldStorageMemoryLimit,
+             (intmax_t)m_antiCacheDB->bytesStored(), (intmax_t)m_antiCacheDB->blockCount());
+    LogManager::getThreadLogger(LOGGERID_HOST)->log(LOGLEVEL_INFO, msg);
+}
+
 // -------------------------------------------------
 // RESULT FUNCTIONS
 // -------------------------------------------------
@@ -738,6 +890,11 @@ VoltDBEngine::processCatalogAdditions(bool addAll, int64_t timestamp)
             m_catalogDelegates[tcd->path()] = tcd;
             m_delegatesByName[tcd->getTable()->name()] = tcd;
 
+            PersistentTable *persistentTable = dynamic_cast<PersistentTable*>(tcd->getTable());
+            if (persistentTable != NULL) {
+                applyTableLayout(persistentTable);
+            }
+
             // set export info on the new table
             if (tcd->exportEnabled()) {
                 tcd->getTable()->setSignatureAndGeneration(catalogTable->signature(), timestamp);
@@ -807,6 +964,7 @@ VoltDBEngine::processCatalogAdditions(bool addAll, int64_t timestamp)
             //////////////////////////////////////////
 
             vector<TableIndex*> currentIndexes = persistenttable->allIndexes();
+            vector<TableIndex*> addedIndexes;
 
             // iterate over indexes for this table in the catalog
             map<string, catalog::Index*>::const_iterator indexIter;
@@ -839,14 +997,15 @@ VoltDBEngine::processCatalogAdditions(bool addAll, int64_t timestamp)
                     if (!success) {
                         VOLT_ERROR("Failed to initialize index '%s' from catalog",
                                    indexIter->second->name().c_str());
+                        for (int i = 0; i < addedIndexes.size(); i++) {
+                            delete addedIndexes[i];
+                        }
                         return false;
                     }
 
                     TableIndex *index = TableIndexFactory::getInstance(scheme);
                     assert(index);
-
-                    // all of the data should be added here
-                    persistenttable->addIndex(index);
+                    addedIndexes.push_back(index);
 
                     // add the index to the stats source
                     index->getIndexStats()->configure(index->getName() + " stats",
@@ -855,6 +1014,12 @@ VoltDBEngine::processCatalogAdditions(bool addAll, int64_t timestamp)
                 }
             }
 
+            // all of the data should be added here, building the new
+            // indexes side by side
+            if (!addedIndexes.empty()) {
+                persistenttable->addIndexes(addedIndexes);
+            }
+
             //////////////////////////////////////////
             // now find all of the indexes to remove
             //////////////////////////////////////////
@@ -1025,6 +1190,49 @@ VoltDBEngine::loadTable(int32_t tableId,
     return true;
 }
 
+bool
+VoltDBEngine::saveTableToDisk(int32_t clusterId, int32_t databaseId, int32_t tableId,
+                              std::string saveFilePath)
+{
+    PersistentTable* table = dynamic_cast<PersistentTable*>(getTable(tableId));
+    if (table == NULL) {
+        VOLT_ERROR("Table ID %d doesn't exist or is not a persistent table."
+                   " Could not save it to %s", (int) tableId, saveFilePath.c_str());
+        return false;
+    }
+
+    try {
+        TableImage image(saveFilePath, true);
+        image.writeHeader(clusterId, databaseId, tableId, table->name(), table->schema());
+        image.finish(table->saveImage(image));
+    } catch (const SerializableEEException &e) {
+        VOLT_ERROR("Could not save table %s: %s", table->name().c_str(), e.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool
+VoltDBEngine::restoreTableFromDisk(std::string restoreFilePath)
+{
+    try {
+        TableImage image(restoreFilePath, false);
+        image.readHeader();
+        // Table ids are catalog positions that can shift, names can't
+        PersistentTable* table = dynamic_cast<PersistentTable*>(getTable(image.tableName()));
+        if (table == NULL) {
+            VOLT_ERROR("Table %s from %s doesn't exist or is not a persistent table."
+                       " Could not restore it", image.tableName().c_str(), restoreFilePath.c_str());
+            return false;
+        }
+        table->restoreImage(image);
+    } catch (const SerializableEEException &e) {
+        VOLT_ERROR("Could not restore table: %s", e.message().c_str());
+        return false;
+    }
+    return true;
+}
+
 /*
  * Delete and rebuild id based table collections. Does not affect
  * any currently stored tuples.
@@ -1040,6 +1248,7 @@ void VoltDBEngine::rebuildTableCollections()
     // need to re-map all the table ids / indexes
     getStatsManager().unregisterStatsSource(STATISTICS_SELECTOR_TYPE_TABLE);
     getStatsManager().unregisterStatsSource(STATISTICS_SELECTOR_TYPE_INDEX);
+    getStatsManager().unregisterStatsSource(STATISTICS_SELECTOR_TYPE_COLD_STORAGE);
 
     // walk the table delegates and update local table collections
     BOOST_FOREACH (LabeledCDPair cdPair, m_catalogDelegates) {
@@ -1053,6 +1262,14 @@ void VoltDBEngine::rebuildTableCollections()
                                                   catTable->relativeIndex(),
                                                   tcd->getTable()->getTableStats());
 
+            PersistentTable *persistentTable = dynamic_cast<PersistentTable*>(tcd->getTable());
+            if (persistentTable != NULL) {
+                persistentTable->getColdStorageStats()->setMemoryLimit(m_coldStorageMemoryLimit);
+                getStatsManager().registerStatsSource(STATISTICS_SELECTOR_TYPE_COLD_STORAGE,
+                                                      catTable->relativeIndex(),
+                                                      persistentTable->getColdStorageStats());
+            }
+
             // add all of the indexes to the stats source
             std::vector<TableIndex*> tindexes = tcd->getTable()->allIndexes();
             for (int i = 0; i < tindexes.size(); i++) {
@@ -1125,6 +1342,7 @@ VoltDBEngine::ExecutorVector *VoltDBEngine::getExecutorVectorForFragmentId(const
         }
 
         boost::shared_ptr<ExecutorVector> ev(new ExecutorVector(fragId, frag_temptable_log_limit, frag_temptable_limit, pnf));
+        ev->limits.setSpillThreshold(m_tempTableSpillThreshold, m_tempTableSpillDirectory);
 
         // Initialize each node!
         for (int ctr = 0, cnt = (int)pnf->getExecuteList().size();
@@ -1297,10 +1515,165 @@ bool VoltDBEngine::isLocalSite(const NValue& value)
 /** Perform once per second, non-transactional work. */
 void VoltDBEngine::tick(int64_t timeInMillis, int64_t lastCommittedSpHandle) {
     m_executorContext->setupForTick(lastCommittedSpHandle);
+    VOLT_TRACE_EVENT(m_executorContext->traceRing(), TRACE_EVENT_TICK, timeInMillis, 0);
     typedef pair<string, Table*> TablePair;
     BOOST_FOREACH (TablePair table, m_exportingTables) {
         table.second->flushOldTuples(timeInMillis);
     }
+
+    if (m_isCSEnabled) {
+        ageColdStorageIncrementally();
+    }
+
+    // Undo actions find their tuples by address or key, so nothing may be
+    // evicted or moved while any transaction could still roll back.
+    if (m_currentUndoQuantum == NULL && m_undoLog.isEmpty()) {
+        if (m_antiCacheDB) {
+            evictColdTuples();
+        }
+        compactTablesIncrementally();
+    }
+}
+
+void VoltDBEngine::setCompactionBudget(size_t stepsPerTick, int64_t microsPerTick)
+{
+    m_compactionStepsPerTick = stepsPerTick;
+    m_compactionMicrosPerTick = microsPerTick;
+}
+
+void VoltDBEngine::setColdStorageAgingBudget(size_t blocksPerTick, int64_t microsPerTick)
+{
+    m_coldStorageAgingBlocksPerTick = blocksPerTick;
+    m_coldStorageAgingMicrosPerTick = microsPerTick;
+}
+
+void VoltDBEngine::setLargePages(bool enabled)
+{
+    m_largePages = enabled;
+}
+
+void VoltDBEngine::setTempTableSpill(int64_t threshold, const std::string &directory)
+{
+    m_tempTableSpillThreshold = threshold;
+    m_tempTableSpillDirectory = directory;
+    // fragments already planned pick it up too
+    for (PlanSet::iterator iter = m_plans.begin(); iter != m_plans.end(); iter++) {
+        (*iter)->limits.setSpillThreshold(threshold, directory);
+    }
+}
+
+void VoltDBEngine::setTempBlockPoolCapacity(size_t capacity)
+{
+    ThreadLocalPool::getTempBlockPool()->setCapacity(capacity);
+}
+
+void VoltDBEngine::setIndexBuildThreads(int threadCount)
+{
+    IndexBuilder::setThreadCount(threadCount);
+}
+
+/*
+ * Split "TABLE.COLUMN,TABLE.COLUMN" into the column names of each table.
+ */
+static void parseTableColumns(const std::string &tableColumns,
+                              std::map<std::string, std::vector<std::string> > &columnsByTable)
+{
+    columnsByTable.clear();
+    size_t start = 0;
+    while (start < tableColumns.size()) {
+        size_t end = tableColumns.find(',', start);
+        if (end == std::string::npos) {
+            end = tableColumns.size();
+        }
+        const std::string entry = tableColumns.substr(start, end - start);
+        const size_t dot = entry.find('.');
+        if (dot != std::string::npos && dot > 0 && dot + 1 < entry.size()) {
+            columnsByTable[entry.substr(0, dot)].push_back(entry.substr(dot + 1));
+        }
+        start = end + 1;
+    }
+}
+
+void VoltDBEngine::setMinipageColumns(const std::string &tableColumns)
+{
+    parseTableColumns(tableColumns, m_minipageColumns);
+}
+
+void VoltDBEngine::setDictionaryColumns(const std::string &tableColumns)
+{
+    parseTableColumns(tableColumns, m_dictionaryColumns);
+}
+
+static void warnSkippedLayoutColumn(const PersistentTable *table, const string &name, const char *layout)
+{
+    char msg[512];
+    snprintf(msg, sizeof(msg), "Column %s of table %s can't be %s, skipping it",
+             name.c_str(), table->name().c_str(), layout);
+    LogManager::getThreadLogger(LOGGERID_HOST)->log(LOGLEVEL_WARN, msg);
+}
+
+/*
+ * Give a table the catalog just added the layout the deployment asked
+ * for. The table is still empty, which the layout setters insist on.
+ */
+void VoltDBEngine::applyTableLayout(PersistentTable *table)
+{
+    const TupleSchema *schema = table->schema();
+    map<string, vector<string> >::const_iterator minipages = m_minipageColumns.find(table->name());
+    if (minipages != m_minipageColumns.end()) {
+        vector<int> columns;
+        BOOST_FOREACH(const string &name, minipages->second) {
+            const int column = table->columnIndex(name);
+            if (column < 0 || !schema->columnIsInlined(column)) {
+                warnSkippedLayoutColumn(table, name, "kept in minipages");
+                continue;
+            }
+            columns.push_back(column);
+        }
+        table->setMinipageColumns(columns);
+    }
+
+    map<string, vector<string> >::const_iterator dictionaries = m_dictionaryColumns.find(table->name());
+    if (dictionaries != m_dictionaryColumns.end()) {
+        vector<int> columns;
+        BOOST_FOREACH(const string &name, dictionaries->second) {
+            const int column = table->columnIndex(name);
+            if (column < 0 || schema->columnIsInlined(column) ||
+                (schema->columnType(column) != VALUE_TYPE_VARCHAR &&
+                 schema->columnType(column) != VALUE_TYPE_VARBINARY)) {
+                warnSkippedLayoutColumn(table, name, "dictionary encoded");
+                continue;
+            }
+            columns.push_back(column);
+        }
+        table->setDictionaryColumns(columns);
+    }
+}
+
+/*
+ * Merge the blocks of fragmented tables a few at a time, so the cost of
+ * compaction is spread over ticks instead of landing on whichever
+ * transaction's commit happened to trip the compaction predicate.
+ * PersistentTable::notifyQuantumRelease() still compacts a table in one
+ * go if it gets far more fragmented than this keeps up with.
+ */
+void VoltDBEngine::compactTablesIncrementally()
+{
+    if (m_compactionStepsPerTick == 0) {
+        return;
+    }
+    const int64_t deadline = ColdStorageStats::nowMicros() + m_compactionMicrosPerTick;
+    size_t budget = m_compactionStepsPerTick;
+    typedef pair<int32_t, Table*> TablePair;
+    BOOST_FOREACH (TablePair entry, m_tables) {
+        if (budget == 0 || ColdStorageStats::nowMicros() >= deadline) {
+            break;
+        }
+        PersistentTable *table = dynamic_cast<PersistentTable*>(entry.second);
+        if (table != NULL) {
+            budget -= table->doIncrementalCompaction(budget, deadline);
+        }
+    }
 }
 
 /** For now, bring the Export system to a steady state with no buffers with content */
@@ -1370,6 +1743,7 @@ int VoltDBEngine::getStats(int selector, int locators[], int numLocators,
     try {
         switch (selector) {
         case STATISTICS_SELECTOR_TYPE_TABLE:
+        case STATISTICS_SELECTOR_TYPE_COLD_STORAGE:
             for (int ii = 0; ii < numLocators; ii++) {
                 CatalogId locator = static_cast<CatalogId>(locators[ii]);
                 if ( ! getTable(locator)) {
@@ -1403,6 +1777,14 @@ int VoltDBEngine::getStats(int selector, int locators[], int numLocators,
                 (StatisticsSelectorType) selector,
                 locatorIds, interval, now);
             break;
+        case STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL:
+            resultTable = m_statsManager.getStats(
+                (StatisticsSelectorType) selector,
+                locatorIds, interval, now);
+            break;
+        case STATISTICS_SELECTOR_TYPE_TRACE:
+            resultTable = getTraceTable();
+            break;
         default:
             char message[256];
             snprintf(message, 256, "getStats() called with an unrecognized selector"
@@ -1427,6 +1809,53 @@ int VoltDBEngine::getStats(int selector, int locators[], int numLocators,
     }
 }
 
+void VoltDBEngine::setTraceEnabled(bool enabled)
+{
+    m_executorContext->traceRing().setEnabled(enabled);
+}
+
+/*
+ * Copy what is left in the trace ring into a table, oldest event
+ * first. The ring itself is not cleared, so consecutive dumps overlap.
+ */
+Table* VoltDBEngine::getTraceTable()
+{
+    if (m_traceTable == NULL) {
+        vector<string> columnNames;
+        vector<ValueType> columnTypes;
+        vector<int32_t> columnLengths;
+        vector<bool> columnAllowNull;
+        const char *names[] = { "SITE_ID", "SEQUENCE", "TIMESTAMP", "EVENT", "ARG0", "ARG1" };
+        for (int ii = 0; ii < 6; ii++) {
+            columnNames.push_back(names[ii]);
+            const ValueType type = ii == 3 ? VALUE_TYPE_VARCHAR : VALUE_TYPE_BIGINT;
+            columnTypes.push_back(type);
+            columnLengths.push_back(ii == 3 ? 32 : NValue::getTupleStorageSize(type));
+            columnAllowNull.push_back(false);
+        }
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths,
+                                                             columnAllowNull, true);
+        m_traceTable = TableFactory::getTempTable(1, "EE trace ring", schema,
+                                                  columnNames, NULL);
+    }
+    m_traceTable->deleteAllTuples(false);
+
+    vector<TraceEvent> events;
+    m_executorContext->traceRing().snapshot(events);
+    TableTuple tuple = m_traceTable->tempTuple();
+    BOOST_FOREACH (const TraceEvent &event, events) {
+        NValue eventName = ValueFactory::getStringValue(TraceRing::eventName(event.m_code));
+        tuple.setNValue(0, ValueFactory::getBigIntValue(m_siteId));
+        tuple.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(event.m_sequence)));
+        tuple.setNValue(2, ValueFactory::getBigIntValue(event.m_timestamp));
+        tuple.setNValue(3, eventName);
+        tuple.setNValue(4, ValueFactory::getBigIntValue(event.m_arg0));
+        tuple.setNValue(5, ValueFactory::getBigIntValue(event.m_arg1));
+        m_traceTable->insertTuple(tuple);
+        eventName.free();
+    }
+    return m_traceTable;
+}
 
 void VoltDBEngine::setCurrentUndoQuantum(voltdb::UndoQuantum* undoQuantum)
 {
@@ -55,6 +55,7 @@
 #include <boost/ptr_container/ptr_vector.hpp>
 #include "json_spirit/json_spirit.h"
 #include "boost/shared_ptr.hpp"
+#include "boost/scoped_ptr.hpp"
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
@@ -77,6 +78,8 @@
 #include "plannodes/plannodefragment.h"
 #include "stats/StatsAgent.h"
 #include "storage/TempTableLimits.h"
+#include "storage/TempBlockPoolStats.h"
+#include "storage/AntiCacheDB.h"
 #include "common/ThreadLocalPool.h"
 
 // shorthand for ExecutionEngine versions generated by javah
@@ -113,6 +116,12 @@ class RecoveryProtoMsg;
 
 const int64_t DEFAULT_TEMP_TABLE_MEMORY = 1024 * 1024 * 100;
 const size_t PLAN_CACHE_SIZE = 1024 * 10;
+// Default budget for the compaction done from tick(), across all tables
+const size_t DEFAULT_COMPACTION_STEPS_PER_TICK = 16;
+const int64_t DEFAULT_COMPACTION_MICROS_PER_TICK = 5000;
+// Default budget for the Cold Storage aging done from tick(), across all tables
+const size_t DEFAULT_COLD_STORAGE_AGING_BLOCKS_PER_TICK = 128;
+const int64_t DEFAULT_COLD_STORAGE_AGING_MICROS_PER_TICK = 2000;
 
 /**
  * Represents an Execution Engine which holds catalog objects (i.e. table) and executes
@@ -134,11 +143,20 @@ class __attribute__((visibility("default"))) VoltDBEngine {
           m_currentInputDepId(-1),
           m_isELEnabled(false),
           m_numResultDependencies(0),
-          m_logManager(new StdoutLogProxy()), m_templateSingleLongTable(NULL), m_topend(NULL)
+          m_logManager(new StdoutLogProxy()), m_templateSingleLongTable(NULL), m_topend(NULL),
+          m_isCSEnabled(false), m_limitMemoryUsage(0), m_percentageOfDataToMove(0),
+          m_partOfDataToMove(0), m_numCSCut(0), m_maxCutCS(0),
+          m_coldStoragePolicy(COLD_STORAGE_POLICY_TUPLE), m_coldStorageMemoryLimit(0),
+          m_traceTable(NULL), m_compactionStepsPerTick(DEFAULT_COMPACTION_STEPS_PER_TICK),
+          m_compactionMicrosPerTick(DEFAULT_COMPACTION_MICROS_PER_TICK),
+          m_coldStorageAgingBlocksPerTick(DEFAULT_COLD_STORAGE_AGING_BLOCKS_PER_TICK),
+          m_coldStorageAgingMicrosPerTick(DEFAULT_COLD_STORAGE_AGING_MICROS_PER_TICK),
+          m_largePages(false), m_tempTableSpillThreshold(-1), m_tempTableSpillDirectory("/tmp")
         {
         }
         //poniżej deklaracja konstruktora z dodatkowymi wartościami z konfiguracji Cold Storage
-        VoltDBEngine(Topend *topend, LogProxy *logProxy, bool coldStorageIsEnabled, float limitMemoryUsage, float percentageOfDataToMove);
+        VoltDBEngine(Topend *topend, LogProxy *logProxy, bool coldStorageIsEnabled, float limitMemoryUsage, float percentageOfDataToMove,
+                     ColdStoragePolicy coldStoragePolicy = COLD_STORAGE_POLICY_TUPLE);
         bool initialize(int32_t clusterIndex,
                         int64_t siteId,
                         int32_t partitionId,
@@ -237,26 +255,90 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         /** flush active work (like EL buffers) */
         void quiesce(int64_t lastCommittedSpHandle);
 
+        /**
+         * Bound the table compaction each tick() does: at most stepsPerTick
+         * blocks filled up, with no new one started after microsPerTick.
+         * Zero steps turns it off, leaving only forced compaction.
+         */
+        void setCompactionBudget(size_t stepsPerTick, int64_t microsPerTick);
+
+        /**
+         * Bound the Cold Storage aging each tick() does: at most
+         * blocksPerTick blocks aged, with no new one started after
+         * microsPerTick. A pass still in progress when the next one is
+         * requested is finished first (see
+         * PersistentTable::requestColdStorageAging()).
+         */
+        void setColdStorageAgingBudget(size_t blocksPerTick, int64_t microsPerTick);
+
+        /**
+         * Have initialize() back tables, indexes and pools with huge pages
+         * (see LargePages) and bind the site thread and its memory to a
+         * NUMA node. Off by default.
+         */
+        void setLargePages(bool enabled);
+
+        /**
+         * Let the temp tables of a fragment spill their blocks to scratch
+         * files in directory once they hold more than threshold bytes,
+         * rather than growing to the temp table memory limit and failing.
+         * A negative threshold turns spilling off, which is the default.
+         */
+        void setTempTableSpill(int64_t threshold, const std::string &directory);
+
+        /**
+         * Bytes of dropped temp table blocks the site keeps for reuse
+         * (see TempBlockPool). Zero turns the recycling off.
+         */
+        void setTempBlockPoolCapacity(size_t capacity);
+
+        /**
+         * Threads that build indexes side by side when a catalog update
+         * adds them or a table is loaded (see IndexBuilder). Applies to
+         * all sites of the process; one builds on the site thread only.
+         */
+        void setIndexBuildThreads(int threadCount);
+
+        /**
+         * Columns to mirror into minipages (see
+         * PersistentTable::setMinipageColumns()), as comma separated
+         * TABLE.COLUMN names. Applies to the tables the catalog adds from
+         * then on; columns that don't exist or aren't inlined are skipped.
+         */
+        void setMinipageColumns(const std::string &tableColumns);
+
+        /**
+         * VARCHAR and VARBINARY columns to share through dictionaries (see
+         * PersistentTable::setDictionaryColumns()), in the same form and
+         * with the same reach as setMinipageColumns().
+         */
+        void setDictionaryColumns(const std::string &tableColumns);
+
         // -------------------------------------------------
         // Save and Restore Table to/from disk functions
         // -------------------------------------------------
 
         /**
          * Save the table specified by catalog id tableId to the
-         * absolute path saveFilePath
+         * absolute path saveFilePath as a native binary image (see
+         * TableImage.h). Evicted tuples are fetched back first.
          *
-         * @param tableGuid the GUID of the table in the catalog
+         * @param tableId the catalog id of the table
          * @param saveFilePath the full path of the desired savefile
          * @return true if successful, false if save failed
          */
         bool saveTableToDisk(int32_t clusterId, int32_t databaseId, int32_t tableId, std::string saveFilePath);
 
         /**
-         * Restore the table from the absolute path saveFilePath
+         * Restore the table from the absolute path saveFilePath. The
+         * table is found by the name recorded in the image, must be
+         * empty and must still have the schema the image was saved
+         * with. Its indexes are built after all tuples are loaded. The
+         * restore is not undoable.
          *
          * @param restoreFilePath the full path of the file with the
          * table to restore
-         * @return true if successful, false if save failed
+         * @return true if successful, false if restore failed
          */
         bool restoreTableFromDisk(std::string restoreFilePath);
 
@@ -297,6 +379,9 @@ class __attribute__((visibility("default"))) VoltDBEngine {
                 bool interval,
                 int64_t now);
 
+        /** Switch recording into this engine's event trace on or off */
+        void setTraceEnabled(bool enabled);
+
         inline Pool* getStringPool() { return &m_stringPool; }
 
         inline LogManager* getLogManager() {
@@ -395,6 +480,16 @@ class __attribute__((visibility("default"))) VoltDBEngine {
 
         void printReport();
 
+        void requestColdStorageAging();
+        void ageColdStorageIncrementally();
+        void compactTablesIncrementally();
+        int64_t coldStorageMemoryInUse() const;
+        void evictColdTuples();
+        size_t unevictAccessedBlocks();
+        void applyTableLayout(PersistentTable *table);
+
+        Table* getTraceTable();
+
 
         /**
          * Keep a list of executors for runtime - intentionally near the top of VoltDBEngine
@@ -570,6 +665,36 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         float m_partOfDataToMove; //Cold Storage: część danych do zrzutu
         int m_numCSCut; //Cold Storage: wartość, o którą obniżany jest indeks
         int m_maxCutCS; //Cold Storage: maksymalna wartość indeksu po obcięciu
+        ColdStoragePolicy m_coldStoragePolicy; //Cold Storage: per-tuple counters or per-block CLOCK
+        int64_t m_coldStorageMemoryLimit; //Cold Storage: m_limitMemoryUsage in bytes of table memory
+        boost::scoped_ptr<AntiCacheDB> m_antiCacheDB; //Cold Storage: where evicted tuples go
+
+        /** Rows of the trace ring, refilled for each STATISTICS_SELECTOR_TYPE_TRACE request */
+        Table *m_traceTable;
+
+        // Compaction done from tick(), across all tables: at most this many
+        // blocks filled up, and no new block started after the time is up
+        size_t m_compactionStepsPerTick;
+        int64_t m_compactionMicrosPerTick;
+
+        // Cold Storage aging done from tick(), across all tables: at most
+        // this many blocks aged, and no new block started after the time is up
+        size_t m_coldStorageAgingBlocksPerTick;
+        int64_t m_coldStorageAgingMicrosPerTick;
+
+        // Applied by initialize(), see setLargePages()
+        bool m_largePages;
+
+        // Applied to the TempTableLimits of every fragment
+        int64_t m_tempTableSpillThreshold;
+        std::string m_tempTableSpillDirectory;
+
+        // Minipage and dictionary columns of the tables the catalog adds, by table name
+        std::map<std::string, std::vector<std::string> > m_minipageColumns;
+        std::map<std::string, std::vector<std::string> > m_dictionaryColumns;
+
+        /** The site's TempBlockPool, as STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL */
+        TempBlockPoolStats m_tempBlockPoolStats;
 
     private:
         ThreadLocalPool m_tlPool;
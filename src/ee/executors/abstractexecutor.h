@@ -115,6 +115,18 @@ class AbstractExecutor {
      */
     void setDMLCountOutputTable(TempTableLimits* limits);
 
+    /**
+     * Bring the spilled blocks of a temp input table back into memory, for
+     * executors that hold on to its tuples, or to values inlined in them,
+     * past the next one. See TableIterator::nextSpilledTuple().
+     */
+    static void loadSpilledInput(Table *input) {
+        TempTable *temp = dynamic_cast<TempTable*>(input);
+        if (temp != NULL) {
+            temp->loadSpilledBlocks();
+        }
+    }
+
     // execution engine owns the plannode allocation.
     AbstractPlanNode* m_abstractNode;
     TempTable* m_tmpOutputTable;
@@ -315,6 +315,22 @@ public:
     }
 };
 
+/*
+ * True if values of some column of the schema live inside the tuple, so an
+ * NValue taken from the tuple is only good as long as the tuple's storage.
+ */
+inline bool hasInlinedObjects(const TupleSchema *schema)
+{
+    for (int ii = 0; ii < schema->columnCount(); ii++) {
+        const ValueType type = schema->columnType(ii);
+        if ((type == VALUE_TYPE_VARCHAR || type == VALUE_TYPE_VARBINARY) &&
+            schema->columnIsInlined(ii)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*
  * Create an instance of an aggregator for the specified aggregate type and "distinct" flag.
  * The object is allocated from the provided memory pool.
@@ -558,6 +574,8 @@ bool AggregateHashExecutor::p_execute(const NValueArray& params)
     Table* input_table = m_abstractNode->getInputTables()[0];
     assert(input_table);
     VOLT_TRACE("input table\n%s", input_table->debug().c_str());
+    // every group keeps its last input tuple for the pass-through columns
+    loadSpilledInput(input_table);
     TableIterator it = input_table->iterator();
     TableTuple nxtTuple(input_table->schema());
     PoolBackedTempTuple nextGroupByKeyTuple(m_groupByKeySchema, &m_memoryPool);
@@ -611,6 +629,11 @@ bool AggregateSerialExecutor::p_execute(const NValueArray& params)
     Table* input_table = m_abstractNode->getInputTables()[0];
     assert(input_table);
     VOLT_TRACE("input table\n%s", input_table->debug().c_str());
+    // A spilled input streams through here, as only the previous tuple is
+    // kept, unless MIN or MAX could hold on to a string inlined in a tuple
+    if (hasInlinedObjects(input_table->schema())) {
+        loadSpilledInput(input_table);
+    }
     TableIterator it = input_table->iterator();
     TableTuple nxtTuple(input_table->schema());
     PoolBackedTempTuple nextGroupByKeyTuple(m_groupByKeySchema, &m_memoryPool);
@@ -47,6 +47,7 @@
 
 #include "common/ValueFactory.hpp"
 #include "common/debuglog.h"
+#include "common/executorcontext.hpp"
 #include "common/tabletuple.h"
 #include "storage/table.h"
 #include "storage/tableiterator.h"
@@ -96,8 +97,8 @@ bool DeleteExecutor::p_execute(const NValueArray &params) {
 
     if (m_truncate) {
         VOLT_TRACE("truncating table %s...", m_targetTable->name().c_str());
-        // count the truncated tuples as deleted
-        modified_tuples = m_targetTable->activeTupleCount();
+        // count the truncated tuples as deleted, evicted ones included
+        modified_tuples = m_targetTable->activeTupleCount() + m_targetTable->evictedTupleCount();
 
         // actually delete all the tuples
         m_targetTable->deleteAllTuples(true);
@@ -107,6 +108,7 @@ bool DeleteExecutor::p_execute(const NValueArray &params) {
         assert(m_inputTable);
         assert(m_inputTuple.sizeInValues() == m_inputTable->columnCount());
         assert(m_targetTuple.sizeInValues() == m_targetTable->columnCount());
+        ExecutorContext *executorContext = ExecutorContext::getExecutorContext();
         TableIterator inputIterator = m_inputTable->iterator();
         while (inputIterator.next(m_inputTuple)) {
             //
@@ -118,6 +120,8 @@ bool DeleteExecutor::p_execute(const NValueArray &params) {
             //
             void *targetAddress = m_inputTuple.getNValue(0).castAsAddress();
             m_targetTuple.move(targetAddress);
+            // the tuple survives an undo of this delete with its access counted
+            executorContext->recordTupleAccess(m_targetTable, m_targetTuple);
 
             // Delete from target table
             if (!m_targetTable->deleteTuple(m_targetTuple, true)) {
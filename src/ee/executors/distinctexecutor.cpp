@@ -91,6 +91,8 @@ bool DistinctExecutor::p_execute(const NValueArray &params) {
     Table* input_table = node->getInputTables()[0];
     assert(input_table);
 
+    // the values found may point into the input tuples
+    loadSpilledInput(input_table);
     TableIterator iterator = input_table->iterator();
     TableTuple tuple(input_table->schema());
 
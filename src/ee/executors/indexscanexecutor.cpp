@@ -49,6 +49,7 @@
 #include "common/common.h"
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
 #include "expressions/abstractexpression.h"
 #include "expressions/expressionutil.h"
 #include "indexes/tableindex.h"
@@ -377,6 +378,8 @@ bool IndexScanExecutor::p_execute(const NValueArray &params)
         m_index->moveToEnd(toStartActually);
     }
 
+    ExecutorContext *executorContext = ExecutorContext::getExecutorContext();
+
     int tuple_ctr = 0;
     int tuples_skipped = 0;     // for offset
     int limit = -1;
@@ -393,6 +396,11 @@ bool IndexScanExecutor::p_execute(const NValueArray &params)
              !(m_tuple = m_index->nextValueAtKey()).isNullTuple()) ||
            ((localLookupType != INDEX_LOOKUP_TYPE_EQ || activeNumOfSearchKeys == 0) &&
             !(m_tuple = m_index->nextValue()).isNullTuple()))) {
+        if (m_tuple.isEvicted()) {
+            // fetched back once this executor returns, and the fragment re-run
+            executorContext->recordEvictedAccess(m_targetTable, m_tuple);
+            continue;
+        }
         VOLT_TRACE("LOOPING in indexscan: tuple: '%s'\n", m_tuple.debug("tablename").c_str());
         //
         // First check whether the end_expression is now false
@@ -418,6 +426,7 @@ bool IndexScanExecutor::p_execute(const NValueArray &params)
                 continue;
             }
             tuple_ctr++;
+            executorContext->recordTupleAccess(m_targetTable, m_tuple);
 
             if (m_projectionNode != NULL)
             {
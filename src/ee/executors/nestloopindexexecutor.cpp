@@ -50,6 +50,7 @@
 #include "common/debuglog.h"
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
 #include "execution/VoltDBEngine.h"
 #include "expressions/abstractexpression.h"
 #include "expressions/tuplevalueexpression.h"
@@ -66,6 +67,16 @@ using namespace voltdb;
 
 namespace
 {
+    // An outer tuple waiting in a batch, with how to look up its matches
+    struct OuterRow {
+        TableTuple tuple;
+        bool keyException;
+        IndexLookupType lookupType;
+        SortDirectionType sortDirection;
+        // position of its search key in the batch given to moveToKeys()
+        size_t batchSlot;
+    };
+
     // FUTURE: the planner should be able to make this decision and
     // add that info to TupleValueExpression rather than having to
     // play the name game here.  These two methods are currently duped
@@ -240,10 +251,14 @@ bool NestLoopIndexExecutor::p_init(AbstractPlanNode* abstractNode,
         return false;
     }
 
-    index_values = TableTuple(index->getKeySchema());
-    index_values_backing_store = new char[index->getKeySchema()->tupleLength()];
-    index_values.move( index_values_backing_store - TUPLE_HEADER_SIZE);
-    index_values.setAllNulls();
+    // search keys for a batch of outer tuples, see p_execute()
+    const int keyLength = index->getKeySchema()->tupleLength();
+    index_values.assign(OUTER_BATCH_SIZE, TableTuple(index->getKeySchema()));
+    index_values_backing_store = new char[keyLength * OUTER_BATCH_SIZE];
+    for (int ii = 0; ii < OUTER_BATCH_SIZE; ii++) {
+        index_values[ii].moveNoHeader(index_values_backing_store + keyLength * ii);
+        index_values[ii].setAllNulls();
+    }
 
     // for each tuple value expression in the predicate, determine
     // which tuple is being represented. Tuple could come from outer
@@ -323,6 +338,9 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params)
     //
     // OUTER TABLE ITERATION
     //
+    // a batch keeps OUTER_BATCH_SIZE outer tuples, and the search keys
+    // built from them, until their matches have been joined
+    loadSpilledInput(outer_table);
     TableTuple outer_tuple(outer_table->schema());
     TableTuple inner_tuple(inner_table->schema());
     TableIterator outer_iterator = outer_table->iterator();
@@ -331,218 +349,269 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params)
     assert (outer_tuple.sizeInValues() == outer_table->columnCount());
     assert (inner_tuple.sizeInValues() == inner_table->columnCount());
     TableTuple &join_tuple = output_table->tempTuple();
+    ExecutorContext *executorContext = ExecutorContext::getExecutorContext();
 
     VOLT_TRACE("<num_of_outer_cols>: %d\n", num_of_outer_cols);
-    while (outer_iterator.next(outer_tuple)) {
-        VOLT_TRACE("outer_tuple:%s",
-                   outer_tuple.debug(outer_table->name()).c_str());
-
-        int activeNumOfSearchKeys = num_of_searchkeys;
-        VOLT_TRACE ("<Nested Loop Index exec, WHILE-LOOP...> Number of searchKeys: %d \n", num_of_searchkeys);
-        IndexLookupType localLookupType = m_lookupType;
-        SortDirectionType localSortDirection = m_sortDirection;
-        VOLT_TRACE("Lookup type: %d\n", m_lookupType);
-        VOLT_TRACE("SortDirectionType: %d\n", m_sortDirection);
-
-        // did this loop body find at least one match for this tuple?
-        bool match = false;
-        // did setting the search key fail (usually due to overflow)
-        bool keyException = false;
-
-        //
-        // Now use the outer table tuple to construct the search key
-        // against the inner table
-        //
-        index_values.setAllNulls();
-        for (int ctr = 0; ctr < activeNumOfSearchKeys; ctr++) {
-            // in a normal index scan, params would be substituted here,
-            // but this scan fills in params outside the loop
-            NValue candidateValue = inline_node->getSearchKeyExpressions()[ctr]->eval(&outer_tuple, NULL);
-            try {
-                index_values.setNValue(ctr, candidateValue);
-            }
-            catch (const SQLException &e) {
-                // This next bit of logic handles underflow and overflow while
-                // setting up the search keys.
-                // e.g. TINYINT > 200 or INT <= 6000000000
-
-                // re-throw if not an overflow or underflow
-                // currently, it's expected to always be an overflow or underflow
-                if ((e.getInternalFlags() & (SQLException::TYPE_OVERFLOW | SQLException::TYPE_UNDERFLOW)) == 0) {
-                    throw e;
-                }
-
-                // handle the case where this is a comparison, rather than equality match
-                // comparison is the only place where the executor might return matching tuples
-                // e.g. TINYINT < 1000 should return all values
-                if ((localLookupType != INDEX_LOOKUP_TYPE_EQ) &&
-                    (ctr == (activeNumOfSearchKeys - 1))) {
-
-                    // sanity check that there is at least one EQ column
-                    // or else the join wouldn't work, right?
-                    assert(activeNumOfSearchKeys > 1);
+    //
+    // The outer tuples are taken OUTER_BATCH_SIZE at a time. All of their
+    // search keys are built first, so that the equality lookups of the
+    // batch go to the index together and overlap their cache misses.
+    //
+    std::vector<OuterRow> outer_rows(OUTER_BATCH_SIZE);
+    std::vector<const TableTuple*> batch_keys;
+    bool moreOuterTuples = true;
+    while (moreOuterTuples) {
+        int batchSize = 0;
+        batch_keys.clear();
+        while (batchSize < OUTER_BATCH_SIZE &&
+               (moreOuterTuples = outer_iterator.next(outer_tuple))) {
+            VOLT_TRACE("outer_tuple:%s",
+                       outer_tuple.debug(outer_table->name()).c_str());
+
+            int activeNumOfSearchKeys = num_of_searchkeys;
+            VOLT_TRACE ("<Nested Loop Index exec, WHILE-LOOP...> Number of searchKeys: %d \n", num_of_searchkeys);
+            IndexLookupType localLookupType = m_lookupType;
+            SortDirectionType localSortDirection = m_sortDirection;
+            VOLT_TRACE("Lookup type: %d\n", m_lookupType);
+            VOLT_TRACE("SortDirectionType: %d\n", m_sortDirection);
+
+            // did setting the search key fail (usually due to overflow)
+            bool keyException = false;
 
-                    if (e.getInternalFlags() & SQLException::TYPE_OVERFLOW) {
-                        if ((localLookupType == INDEX_LOOKUP_TYPE_GT) ||
-                            (localLookupType == INDEX_LOOKUP_TYPE_GTE)) {
+            //
+            // Now use the outer table tuple to construct the search key
+            // against the inner table
+            //
+            index_values[batchSize].setAllNulls();
+            for (int ctr = 0; ctr < activeNumOfSearchKeys; ctr++) {
+                // in a normal index scan, params would be substituted here,
+                // but this scan fills in params outside the loop
+                NValue candidateValue = inline_node->getSearchKeyExpressions()[ctr]->eval(&outer_tuple, NULL);
+                try {
+                    index_values[batchSize].setNValue(ctr, candidateValue);
+                }
+                catch (const SQLException &e) {
+                    // This next bit of logic handles underflow and overflow while
+                    // setting up the search keys.
+                    // e.g. TINYINT > 200 or INT <= 6000000000
+
+                    // re-throw if not an overflow or underflow
+                    // currently, it's expected to always be an overflow or underflow
+                    if ((e.getInternalFlags() & (SQLException::TYPE_OVERFLOW | SQLException::TYPE_UNDERFLOW)) == 0) {
+                        throw e;
+                    }
 
-                            // gt or gte when key overflows breaks out
-                            // and only returns for left-outer
-                            keyException = true;
-                            break; // the outer while loop
+                    // handle the case where this is a comparison, rather than equality match
+                    // comparison is the only place where the executor might return matching tuples
+                    // e.g. TINYINT < 1000 should return all values
+                    if ((localLookupType != INDEX_LOOKUP_TYPE_EQ) &&
+                        (ctr == (activeNumOfSearchKeys - 1))) {
+
+                        // sanity check that there is at least one EQ column
+                        // or else the join wouldn't work, right?
+                        assert(activeNumOfSearchKeys > 1);
+
+                        if (e.getInternalFlags() & SQLException::TYPE_OVERFLOW) {
+                            if ((localLookupType == INDEX_LOOKUP_TYPE_GT) ||
+                                (localLookupType == INDEX_LOOKUP_TYPE_GTE)) {
+
+                                // gt or gte when key overflows breaks out
+                                // and only returns for left-outer
+                                keyException = true;
+                                break; // the outer while loop
+                            }
+                            else {
+                                // VoltDB should only support LT or LTE with
+                                // empty search keys for order-by without lookup
+                                throw e;
+                            }
                         }
-                        else {
-                            // VoltDB should only support LT or LTE with
-                            // empty search keys for order-by without lookup
-                            throw e;
+                        if (e.getInternalFlags() & SQLException::TYPE_UNDERFLOW) {
+                            if ((localLookupType == INDEX_LOOKUP_TYPE_LT) ||
+                                (localLookupType == INDEX_LOOKUP_TYPE_LTE)) {
+
+                                // VoltDB should only support LT or LTE with
+                                // empty search keys for order-by without lookup
+                                throw e;
+                            }
+                            else {
+                                // don't allow GTE because it breaks null handling
+                                localLookupType = INDEX_LOOKUP_TYPE_GT;
+                            }
                         }
-                    }
-                    if (e.getInternalFlags() & SQLException::TYPE_UNDERFLOW) {
-                        if ((localLookupType == INDEX_LOOKUP_TYPE_LT) ||
-                            (localLookupType == INDEX_LOOKUP_TYPE_LTE)) {
 
-                            // VoltDB should only support LT or LTE with
-                            // empty search keys for order-by without lookup
-                            throw e;
-                        }
-                        else {
-                            // don't allow GTE because it breaks null handling
-                            localLookupType = INDEX_LOOKUP_TYPE_GT;
+                        // if here, means all tuples with the previous searchkey
+                        // columns need to be scaned.
+                        activeNumOfSearchKeys--;
+                        if (localSortDirection == SORT_DIRECTION_TYPE_INVALID) {
+                            localSortDirection = SORT_DIRECTION_TYPE_ASC;
                         }
                     }
-
-                    // if here, means all tuples with the previous searchkey
-                    // columns need to be scaned.
-                    activeNumOfSearchKeys--;
-                    if (localSortDirection == SORT_DIRECTION_TYPE_INVALID) {
-                        localSortDirection = SORT_DIRECTION_TYPE_ASC;
+                    // if a EQ comparison is out of range, then the tuple from
+                    // the outer loop returns no matches (except left-outer)
+                    else {
+                        keyException = true;
                     }
+                    break;
                 }
-                // if a EQ comparison is out of range, then the tuple from
-                // the outer loop returns no matches (except left-outer)
-                else {
-                    keyException = true;
-                }
-                break;
             }
+            VOLT_TRACE("Searching %s", index_values[batchSize].debug("").c_str());
+
+            OuterRow &row = outer_rows[batchSize];
+            row.tuple = outer_tuple;
+            row.keyException = keyException;
+            row.lookupType = localLookupType;
+            row.sortDirection = localSortDirection;
+            if (!keyException && num_of_searchkeys > 0 && localLookupType == INDEX_LOOKUP_TYPE_EQ) {
+                row.batchSlot = batch_keys.size();
+                batch_keys.push_back(&index_values[batchSize]);
+            }
+            batchSize++;
+        }
+        if (!batch_keys.empty()) {
+            index->moveToKeys(batch_keys);
         }
-        VOLT_TRACE("Searching %s", index_values.debug("").c_str());
 
+        for (int rowIndex = 0; rowIndex < batchSize; rowIndex++) {
+            const OuterRow &row = outer_rows[rowIndex];
+            outer_tuple = row.tuple;
+            const IndexLookupType localLookupType = row.lookupType;
+            const SortDirectionType localSortDirection = row.sortDirection;
+            const bool keyException = row.keyException;
 
-        // if a search value didn't fit into the targeted index key, skip this key
-        if (!keyException) {
+            // did this loop body find at least one match for this tuple?
+            bool match = false;
 
-            //
-            // Our index scan on the inner table is going to have three parts:
-            //  (1) Lookup tuples using the search key
-            //
-            //  (2) For each tuple that comes back, check whether the
-            //      end_expression is false.  If it is, then we stop
-            //      scanning. Otherwise...
-            //
-            //  (3) Check whether the tuple satisfies the post expression.
-            //      If it does, then add it to the output table
-            //
-            // Use our search key to prime the index iterator
-            // The loop through each tuple given to us by the iterator
-            //
-            // Essentially cut and pasted this if ladder from
-            // index scan executor
-            if (num_of_searchkeys > 0)
-            {
-                if (localLookupType == INDEX_LOOKUP_TYPE_EQ) {
-                    index->moveToKey(&index_values);
-                }
-                else if (localLookupType == INDEX_LOOKUP_TYPE_GT) {
-                    index->moveToGreaterThanKey(&index_values);
-                }
-                else if (localLookupType == INDEX_LOOKUP_TYPE_GTE) {
-                    index->moveToKeyOrGreater(&index_values);
-                }
-                else {
-                    return false;
-                }
-            } else {
-                bool toStartActually = (localSortDirection != SORT_DIRECTION_TYPE_DESC);
-                index->moveToEnd(toStartActually);
-            }
-
-            while ((localLookupType == INDEX_LOOKUP_TYPE_EQ &&
-                    !(inner_tuple = index->nextValueAtKey()).isNullTuple()) ||
-                   ((localLookupType != INDEX_LOOKUP_TYPE_EQ || num_of_searchkeys == 0) &&
-                    !(inner_tuple = index->nextValue()).isNullTuple()))
-            {
-                match = true;
-                VOLT_TRACE("inner_tuple:%s",
-                           inner_tuple.debug(inner_table->name()).c_str());
+            // if a search value didn't fit into the targeted index key, skip this key
+            if (!keyException) {
 
                 //
-                // First check whether the end_expression is now false
+                // Our index scan on the inner table is going to have three parts:
+                //  (1) Lookup tuples using the search key
                 //
-                if (end_expression != NULL &&
-                    end_expression->eval(&outer_tuple, &inner_tuple).isFalse())
-                {
-                    VOLT_TRACE("End Expression evaluated to false, stopping scan");
-                    break;
-                }
+                //  (2) For each tuple that comes back, check whether the
+                //      end_expression is false.  If it is, then we stop
+                //      scanning. Otherwise...
                 //
-                // Then apply our post-predicate to do further filtering
+                //  (3) Check whether the tuple satisfies the post expression.
+                //      If it does, then add it to the output table
                 //
-                if (post_expression == NULL ||
-                    post_expression->eval(&outer_tuple, &inner_tuple).isTrue())
+                // Use our search key to prime the index iterator
+                // The loop through each tuple given to us by the iterator
+                //
+                // Essentially cut and pasted this if ladder from
+                // index scan executor
+                if (num_of_searchkeys > 0)
+                {
+                    if (localLookupType == INDEX_LOOKUP_TYPE_EQ) {
+                        index->moveToBatchedKey(row.batchSlot);
+                    }
+                    else if (localLookupType == INDEX_LOOKUP_TYPE_GT) {
+                        index->moveToGreaterThanKey(&index_values[rowIndex]);
+                    }
+                    else if (localLookupType == INDEX_LOOKUP_TYPE_GTE) {
+                        index->moveToKeyOrGreater(&index_values[rowIndex]);
+                    }
+                    else {
+                        return false;
+                    }
+                } else {
+                    bool toStartActually = (localSortDirection != SORT_DIRECTION_TYPE_DESC);
+                    index->moveToEnd(toStartActually);
+                }
+
+                while ((localLookupType == INDEX_LOOKUP_TYPE_EQ &&
+                        !(inner_tuple = index->nextValueAtKey()).isNullTuple()) ||
+                       ((localLookupType != INDEX_LOOKUP_TYPE_EQ || num_of_searchkeys == 0) &&
+                        !(inner_tuple = index->nextValue()).isNullTuple()))
                 {
+                    if (inner_tuple.isEvicted()) {
+                        // fetched back once this executor returns, and the fragment re-run
+                        executorContext->recordEvictedAccess(inner_table, inner_tuple);
+                        continue;
+                    }
+                    match = true;
+                    VOLT_TRACE("inner_tuple:%s",
+                               inner_tuple.debug(inner_table->name()).c_str());
+
                     //
-                    // Try to put the tuple into our output table
+                    // First check whether the end_expression is now false
                     //
-                    // This is a bit hacky.  It duplicates the non-eval
-                    // world that was here before.  Could fold these two
-                    // loops together if we assign table indexes in p_init
-                    for (int col_ctr = 0; col_ctr < num_of_outer_cols;
-                         ++col_ctr)
+                    if (end_expression != NULL &&
+                        end_expression->eval(&outer_tuple, &inner_tuple).isFalse())
                     {
-                        join_tuple.setNValue(col_ctr,
-                                             m_outputExpressions[col_ctr]->
-                                             eval(&outer_tuple, NULL));
+                        VOLT_TRACE("End Expression evaluated to false, stopping scan");
+                        break;
                     }
                     //
-                    // Append the inner values to the end of our join tuple
+                    // Then apply our post-predicate to do further filtering
                     //
-                    for (int col_ctr = num_of_outer_cols;
-                         col_ctr < join_tuple.sizeInValues();
-                         ++col_ctr)
+                    if (post_expression == NULL ||
+                        post_expression->eval(&outer_tuple, &inner_tuple).isTrue())
                     {
-                        // For the sake of consistency, we don't try to do
-                        // output expressions here with columns from both tables.
-                        join_tuple.
-                        setNValue(col_ctr,
-                                  m_outputExpressions[col_ctr]->
-                                  eval(&inner_tuple, NULL));
-                    }
-                    VOLT_TRACE("join_tuple tuple: %s",
-                               join_tuple.debug(output_table->name()).c_str());
+                        executorContext->recordTupleAccess(inner_table, inner_tuple);
+                        //
+                        // Try to put the tuple into our output table
+                        //
+                        // This is a bit hacky.  It duplicates the non-eval
+                        // world that was here before.  Could fold these two
+                        // loops together if we assign table indexes in p_init
+                        for (int col_ctr = 0; col_ctr < num_of_outer_cols;
+                             ++col_ctr)
+                        {
+                            join_tuple.setNValue(col_ctr,
+                                                 m_outputExpressions[col_ctr]->
+                                                 eval(&outer_tuple, NULL));
+                        }
+                        //
+                        // Append the inner values to the end of our join tuple
+                        //
+                        for (int col_ctr = num_of_outer_cols;
+                             col_ctr < join_tuple.sizeInValues();
+                             ++col_ctr)
+                        {
+                            // For the sake of consistency, we don't try to do
+                            // output expressions here with columns from both tables.
+                            join_tuple.
+                            setNValue(col_ctr,
+                                      m_outputExpressions[col_ctr]->
+                                      eval(&inner_tuple, NULL));
+                        }
+                        VOLT_TRACE("join_tuple tuple: %s",
+                                   join_tuple.debug(output_table->name()).c_str());
 
-                    VOLT_TRACE("MATCH: %s",
-                               join_tuple.debug(output_table->name()).c_str());
-                    output_table->insertTupleNonVirtual(join_tuple);
+                        VOLT_TRACE("MATCH: %s",
+                                   join_tuple.debug(output_table->name()).c_str());
+                        output_table->insertTupleNonVirtual(join_tuple);
+                    }
                 }
             }
-        }
 
-        //
-        // Left Outer Join
-        //
-        if (!match && join_type == JOIN_TYPE_LEFT) {
             //
-            // Append NULLs to the end of our join tuple
+            // Left Outer Join
             //
-            for (int col_ctr = 0; col_ctr < num_of_inner_cols; ++col_ctr)
-            {
-                const int index = col_ctr + num_of_outer_cols;
-                NValue value = join_tuple.getNValue(index);
-                value.setNull();
-                join_tuple.setNValue(col_ctr + num_of_outer_cols, value);
+            if (!match && join_type == JOIN_TYPE_LEFT) {
+                //
+                // The outer values, which no match has set for this tuple
+                //
+                for (int col_ctr = 0; col_ctr < num_of_outer_cols; ++col_ctr)
+                {
+                    join_tuple.setNValue(col_ctr,
+                                         m_outputExpressions[col_ctr]->
+                                         eval(&outer_tuple, NULL));
+                }
+                //
+                // Append NULLs to the end of our join tuple
+                //
+                for (int col_ctr = 0; col_ctr < num_of_inner_cols; ++col_ctr)
+                {
+                    const int index = col_ctr + num_of_outer_cols;
+                    NValue value = join_tuple.getNValue(index);
+                    value.setNull();
+                    join_tuple.setNValue(col_ctr + num_of_outer_cols, value);
+                }
+                output_table->insertTupleNonVirtual(join_tuple);
             }
-            output_table->insertTupleNonVirtual(join_tuple);
         }
     }
 
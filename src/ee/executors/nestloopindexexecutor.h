@@ -46,6 +46,8 @@
 #ifndef HSTORENESTLOOPINDEXEXECUTOR_H
 #define HSTORENESTLOOPINDEXEXECUTOR_H
 
+#include <vector>
+
 #include "common/common.h"
 #include "common/valuevector.h"
 #include "common/tabletuple.h"
@@ -89,6 +91,9 @@ public:
     ~NestLoopIndexExecutor();
 
 protected:
+    // outer tuples whose index lookups are made together
+    static const int OUTER_BATCH_SIZE = 32;
+
     bool p_init(AbstractPlanNode*,
                 TempTableLimits* limits);
     bool p_execute(const NValueArray &params);
@@ -99,7 +104,8 @@ protected:
     TempTable* output_table;
     PersistentTable* inner_table;
     TableIndex *index;
-    TableTuple index_values;
+    // search keys of a batch of outer tuples
+    std::vector<TableTuple> index_values;
     Table* outer_table;
     JoinType join_type;
     std::vector<AbstractExpression*> m_outputExpressions;
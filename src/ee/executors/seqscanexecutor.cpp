@@ -44,22 +44,43 @@
  */
 
 #include <iostream>
+#include <boost/scoped_ptr.hpp>
 #include "seqscanexecutor.h"
 #include "common/debuglog.h"
 #include "common/common.h"
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
 #include "expressions/abstractexpression.h"
 #include "plannodes/seqscannode.h"
 #include "plannodes/projectionnode.h"
 #include "plannodes/limitnode.h"
 #include "storage/table.h"
+#include "storage/persistenttable.h"
 #include "storage/temptable.h"
 #include "storage/tablefactory.h"
 #include "storage/tableiterator.h"
+#include "storage/MinipageLayout.h"
+#include "storage/EvictedTupleIterator.h"
 
 using namespace voltdb;
 
+// A DML statement's scan hands the tuple addresses on to be updated or
+// deleted, which an evicted tuple does not have.
+static bool projectsTupleAddress(ProjectionPlanNode* projection_node) {
+    if (projection_node == NULL) {
+        return false;
+    }
+    const std::vector<AbstractExpression*> &expressions =
+        projection_node->getOutputColumnExpressions();
+    for (size_t ctr = 0; ctr < expressions.size(); ctr++) {
+        if (expressions[ctr]->getExpressionType() == EXPRESSION_TYPE_VALUE_TUPLE_ADDRESS) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool SeqScanExecutor::p_init(AbstractPlanNode* abstract_node,
                              TempTableLimits* limits)
 {
@@ -120,6 +141,8 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
                (int)target_table->allocatedTupleCount(),
                (int)target_table->usedTupleCount());
 
+    PersistentTable* persistent_target = dynamic_cast<PersistentTable*>(target_table);
+
     //
     // OPTIMIZATION: NESTED PROJECTION
     //
@@ -142,6 +165,16 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
     //
     LimitPlanNode* limit_node = dynamic_cast<LimitPlanNode*>(node->getInlinePlanNode(PLAN_NODE_TYPE_LIMIT));
 
+    // Evicted tuples are read from the anti-cache below, after the
+    // resident ones. That can't serve an output that is the table itself,
+    // or a DML statement that needs tuple addresses: then have them all
+    // fetched back and the fragment re-run instead of scanning now.
+    bool scanEvicted = persistent_target != NULL && persistent_target->evictedTupleCount() > 0;
+    if (scanEvicted && (output_table == target_table || projectsTupleAddress(projection_node))) {
+        ExecutorContext::getExecutorContext()->recordEvictedTable(persistent_target);
+        return true;
+    }
+
     //
     // OPTIMIZATION:
     //
@@ -171,23 +204,56 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
                        predicate->debug(true).c_str());
         }
 
+        // When the predicate only reads columns kept in the blocks'
+        // minipages, let the iterator evaluate it there and only stop
+        // at the rows that qualify.
+        boost::scoped_ptr<MinipageFilter> minipageFilter;
+        if (predicate != NULL && persistent_target != NULL &&
+            persistent_target->minipageLayout() != NULL &&
+            persistent_target->minipageLayout()->covers(predicate))
+        {
+            minipageFilter.reset(new MinipageFilter(*persistent_target->minipageLayout(),
+                                                    target_table->schema(), predicate));
+            iterator.setMinipageFilter(minipageFilter.get());
+        }
+
         int limit = -1;
         int offset = -1;
         if (limit_node) {
             limit_node->getLimitAndOffsetByReference(params, limit, offset);
         }
 
+        // Only the tuples that qualify are counted as accessed: a
+        // predicate scan touches every row, but says nothing about
+        // which of them are hot.
+        ExecutorContext *executorContext = ExecutorContext::getExecutorContext();
+
+        // Evicted tuples aren't in any block, so the minipage filter
+        // doesn't see them, and they aren't counted as accessed. Their
+        // strings go in the temp string pool, like other values the
+        // output table points at.
+        boost::scoped_ptr<EvictedTupleIterator> evicted;
+        if (scanEvicted) {
+            evicted.reset(new EvictedTupleIterator(persistent_target));
+            evicted->setStringPool(ExecutorContext::getTempStringPool());
+        }
+
         int tuple_ctr = 0;
         int tuple_skipped = 0;
-        while ((limit == -1 || tuple_ctr < limit) && iterator.next(tuple))
+        while (limit == -1 || tuple_ctr < limit)
         {
+            const bool resident = iterator.next(tuple);
+            if (!resident && !(evicted && evicted->next(tuple))) {
+                break;
+            }
             VOLT_TRACE("INPUT TUPLE: %s, %d/%d\n",
                        tuple.debug(target_table->name()).c_str(), tuple_ctr,
                        (int)target_table->activeTupleCount());
             //
             // For each tuple we need to evaluate it against our predicate
             //
-            if (predicate == NULL || predicate->eval(&tuple, NULL).isTrue())
+            if (predicate == NULL || (resident && minipageFilter) ||
+                predicate->eval(&tuple, NULL).isTrue())
             {
                 // Check if we have to skip this tuple because of offset
                 if (tuple_skipped < offset) {
@@ -195,6 +261,9 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
                     continue;
                 }
                 ++tuple_ctr;
+                if (resident) {
+                    executorContext->recordTupleAccess(persistent_target, tuple);
+                }
 
                 //
                 // Nested Projection
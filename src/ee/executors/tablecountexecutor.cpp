@@ -25,6 +25,7 @@
 #include "expressions/abstractexpression.h"
 #include "plannodes/tablecountnode.h"
 #include "storage/table.h"
+#include "storage/persistenttable.h"
 #include "storage/temptable.h"
 #include "storage/tablefactory.h"
 #include "storage/tableiterator.h"
@@ -66,8 +67,15 @@ bool TableCountExecutor::p_execute(const NValueArray &params) {
 
     assert (node->getPredicate() == NULL);
 
+    int64_t count = target_table->activeTupleCount();
+    // tuples in the Cold Storage anti-cache still count
+    PersistentTable* persistent_table = dynamic_cast<PersistentTable*>(target_table);
+    if (persistent_table != NULL) {
+        count += persistent_table->evictedTupleCount();
+    }
+
     TableTuple& tmptup = output_table->tempTuple();
-    tmptup.setNValue(0, ValueFactory::getBigIntValue( target_table->activeTupleCount() ));
+    tmptup.setNValue(0, ValueFactory::getBigIntValue( count ));
     output_table->insertTuple(tmptup);
 
 
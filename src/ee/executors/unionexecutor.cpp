@@ -363,6 +363,13 @@ bool UnionExecutor::p_init(AbstractPlanNode* abstract_node,
 }
 
 bool UnionExecutor::p_execute(const NValueArray &params) {
+    // all but UNION ALL keep the input tuples in a set or a map
+    UnionPlanNode* node = dynamic_cast<UnionPlanNode*>(m_abstractNode);
+    if (node->getUnionType() != UNION_TYPE_UNION_ALL) {
+        for (size_t ctr = 0, cnt = node->getInputTables().size(); ctr < cnt; ctr++) {
+            loadSpilledInput(node->getInputTables()[ctr]);
+        }
+    }
     return m_setOperator->processTuples();
 }
 
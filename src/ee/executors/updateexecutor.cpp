@@ -55,6 +55,7 @@
 #include "common/types.h"
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
 #include "plannodes/updatenode.h"
 #include "plannodes/projectionnode.h"
 #include "storage/table.h"
@@ -162,6 +163,7 @@ bool UpdateExecutor::p_execute(const NValueArray &params) {
 
     assert(m_inputTuple.sizeInValues() == m_inputTable->columnCount());
     assert(m_targetTuple.sizeInValues() == m_targetTable->columnCount());
+    ExecutorContext *executorContext = ExecutorContext::getExecutorContext();
     TableIterator input_iterator = m_inputTable->iterator();
     while (input_iterator.next(m_inputTuple)) {
         //
@@ -173,6 +175,9 @@ bool UpdateExecutor::p_execute(const NValueArray &params) {
         //
         void *target_address = m_inputTuple.getNValue(0).castAsAddress();
         m_targetTuple.move(target_address);
+        // count the write before the temp copy is taken, so the
+        // updated tuple keeps the bumped counter
+        executorContext->recordTupleAccess(m_targetTable, m_targetTuple);
 
         // Loop through INPUT_COL_IDX->TARGET_COL_IDX mapping and only update
         // the values that we need to. The key thing to note here is that we
@@ -65,6 +65,12 @@ class CompactingHashMultiMapIndex : public TableIndex
     typedef typename KeyType::KeyHasher KeyHasher;
     typedef CompactingHashTable<KeyType, const void*, KeyHasher, KeyEqualityChecker> MapType;
     typedef typename MapType::iterator MapIterator;
+    typedef std::pair<KeyType, const void*> Entry;
+
+    class KeyedEntries : public PreparedEntries {
+    public:
+        std::vector<Entry> m_entries;
+    };
 
     ~CompactingHashMultiMapIndex() {};
 
@@ -74,6 +80,38 @@ class CompactingHashMultiMapIndex : public TableIndex
         return m_entries.insert(setKeyFromTuple(tuple), tuple->address());
     }
 
+    PreparedEntries *prepareEntries(const std::vector<char*> &addresses)
+    {
+        std::vector<Entry> entries;
+        entries.reserve(addresses.size());
+        TableTuple tuple(getTupleSchema());
+        for (size_t ii = 0; ii < addresses.size(); ii++) {
+            tuple.move(addresses[ii]);
+            entries.push_back(Entry(setKeyFromTuple(&tuple), addresses[ii]));
+        }
+        KeyedEntries *prepared = new KeyedEntries();
+        prepared->m_entries.swap(entries);
+        return prepared;
+    }
+
+    bool addPreparedEntries(const std::vector<char*> &addresses,
+                            PreparedEntries *prepared, TableTuple &conflict)
+    {
+        if (prepared == NULL) {
+            return TableIndex::addPreparedEntries(addresses, NULL, conflict);
+        }
+        const std::vector<Entry> &entries = static_cast<KeyedEntries*>(prepared)->m_entries;
+        m_entries.reserve(m_entries.size() + entries.size());
+        for (size_t ii = 0; ii < entries.size(); ii++) {
+            ++m_inserts;
+            if (!m_entries.insert(entries[ii].first, entries[ii].second)) {
+                conflict.move(const_cast<void*>(entries[ii].second));
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool deleteEntry(const TableTuple *tuple)
     {
         ++m_deletes;
@@ -108,6 +146,20 @@ class CompactingHashMultiMapIndex : public TableIndex
         return true;
     }
 
+    bool replaceEntryAddress(const TableTuple &keyTuple, const void *currentAddress, const void *newAddress)
+    {
+        assert( ! KeyType::keyDependsOnTupleAddress());
+        MapIterator mapiter = m_entries.find(setKeyFromTuple(&keyTuple), currentAddress);
+        if (mapiter.isEnd()) {
+            return false;
+        }
+        mapiter.setValue(newAddress);
+        m_updates++;
+        return true;
+    }
+
+    bool keyDependsOnTupleAddress() const { return KeyType::keyDependsOnTupleAddress(); }
+
     bool keyUsesNonInlinedMemory() { return KeyType::keyUsesNonInlinedMemory(); }
 
     bool checkForIndexChange(const TableTuple *lhs, const TableTuple *rhs) {
@@ -130,6 +182,29 @@ class CompactingHashMultiMapIndex : public TableIndex
         return true;
     }
 
+    void moveToKeys(const std::vector<const TableTuple*> &searchKeys) {
+        m_lookups += static_cast<int>(searchKeys.size());
+        m_batchKeys.clear();
+        for (size_t ii = 0; ii < searchKeys.size(); ii++) {
+            m_batchKeys.push_back(KeyType(searchKeys[ii]));
+        }
+        m_batchIters.resize(searchKeys.size());
+        if ( ! searchKeys.empty()) {
+            m_entries.findBatch(&m_batchKeys[0], m_batchKeys.size(), &m_batchIters[0]);
+        }
+    }
+
+    bool moveToBatchedKey(size_t ii) {
+        assert(ii < m_batchIters.size());
+        m_keyIter = m_batchIters[ii];
+        if (m_keyIter.isEnd()) {
+            m_match.move(NULL);
+            return false;
+        }
+        m_match.move(const_cast<void*>(m_keyIter.value()));
+        return true;
+    }
+
     TableTuple nextValueAtKey() {
         if (m_match.isNullTuple()) {
             return m_match;
@@ -150,6 +225,8 @@ class CompactingHashMultiMapIndex : public TableIndex
 
     size_t getSize() const { return m_entries.size(); }
 
+    void ensureCapacity(uint32_t capacity) { m_entries.reserve(capacity); }
+
     int64_t getMemoryEstimate() const
     {
         return m_entries.bytesAllocated();
@@ -180,6 +257,10 @@ class CompactingHashMultiMapIndex : public TableIndex
     MapIterator m_keyIter;
     TableTuple m_match;
 
+    // keys and walks of the last moveToKeys()
+    std::vector<KeyType> m_batchKeys;
+    std::vector<MapIterator> m_batchIters;
+
     // comparison stuff
    KeyEqualityChecker m_eq;
 
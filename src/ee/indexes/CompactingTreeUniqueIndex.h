@@ -47,12 +47,14 @@
 #define COMPACTINGTREEUNIQUEINDEX_H_
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 
 #include "common/debuglog.h"
 #include "common/tabletuple.h"
 #include "indexes/tableindex.h"
 #include "structures/CompactingMap.h"
+#include "structures/CompactingBTree.h"
 
 namespace voltdb {
 
@@ -60,12 +62,20 @@ namespace voltdb {
  * Index implemented as a Binary Tree Unique Map.
  * @see TableIndex
  */
-template<typename KeyType, bool hasRank>
+template<typename KeyType, bool hasRank,
+         template<typename, typename, typename, bool> class TreeMap = CompactingMap>
 class CompactingTreeUniqueIndex : public TableIndex
 {
     typedef typename KeyType::KeyComparator KeyComparator;
-    typedef CompactingMap<KeyType, const void*, KeyComparator, hasRank> MapType;
+    typedef TreeMap<KeyType, const void*, KeyComparator, hasRank> MapType;
     typedef typename MapType::iterator MapIterator;
+    typedef std::pair<KeyType, const void*> Entry;
+    typedef std::vector<Entry> EntryVector;
+
+    class SortedEntries : public PreparedEntries {
+    public:
+        EntryVector m_entries;
+    };
 
     ~CompactingTreeUniqueIndex() {};
 
@@ -75,6 +85,50 @@ class CompactingTreeUniqueIndex : public TableIndex
         return m_entries.insert(setKeyFromTuple(tuple), tuple->address());
     }
 
+    PreparedEntries *prepareEntries(const std::vector<char*> &addresses)
+    {
+        EntryVector entries;
+        entries.reserve(addresses.size());
+        TableTuple tuple(getTupleSchema());
+        for (size_t ii = 0; ii < addresses.size(); ii++) {
+            tuple.move(addresses[ii]);
+            entries.push_back(Entry(setKeyFromTuple(&tuple), addresses[ii]));
+        }
+        std::sort(entries.begin(), entries.end(), typename MapType::EntryLess(m_cmp));
+        SortedEntries *prepared = new SortedEntries();
+        prepared->m_entries.swap(entries);
+        return prepared;
+    }
+
+    bool addPreparedEntries(const std::vector<char*> &addresses,
+                            PreparedEntries *prepared, TableTuple &conflict)
+    {
+        if (prepared == NULL) {
+            return TableIndex::addPreparedEntries(addresses, NULL, conflict);
+        }
+        const EntryVector &entries = static_cast<SortedEntries*>(prepared)->m_entries;
+        if (m_entries.size() != 0) {
+            // too late to build bottom up, but the keys are still good
+            for (size_t ii = 0; ii < entries.size(); ii++) {
+                ++m_inserts;
+                if (!m_entries.insert(entries[ii].first, entries[ii].second)) {
+                    conflict.move(const_cast<void*>(entries[ii].second));
+                    return false;
+                }
+            }
+            return true;
+        }
+        for (size_t ii = 1; ii < entries.size(); ii++) {
+            if (m_cmp(entries[ii - 1].first, entries[ii].first) == 0) {
+                conflict.move(const_cast<void*>(entries[ii].second));
+                return false;
+            }
+        }
+        m_entries.bulkLoad(entries);
+        m_inserts += static_cast<int>(entries.size());
+        return true;
+    }
+
     bool deleteEntry(const TableTuple *tuple)
     {
         ++m_deletes;
@@ -105,6 +159,23 @@ class CompactingTreeUniqueIndex : public TableIndex
         return true;
     }
 
+    bool replaceEntryAddress(const TableTuple &keyTuple, const void *currentAddress, const void *newAddress)
+    {
+        assert( ! KeyType::keyDependsOnTupleAddress());
+        MapIterator mapiter = m_entries.find(setKeyFromTuple(&keyTuple));
+        if ( ! mapiter.isEnd() && mapiter.value() != currentAddress) {
+            return false;
+        }
+        if (mapiter.isEnd()) {
+            return false;
+        }
+        mapiter.setValue(newAddress);
+        m_updates++;
+        return true;
+    }
+
+    bool keyDependsOnTupleAddress() const { return KeyType::keyDependsOnTupleAddress(); }
+
     bool keyUsesNonInlinedMemory() { return KeyType::keyUsesNonInlinedMemory(); }
 
     bool checkForIndexChange(const TableTuple* lhs, const TableTuple* rhs)
@@ -131,6 +202,33 @@ class CompactingTreeUniqueIndex : public TableIndex
         return true;
     }
 
+    void moveToKeys(const std::vector<const TableTuple*> &searchKeys)
+    {
+        m_lookups += static_cast<int>(searchKeys.size());
+        m_batchKeys.clear();
+        for (size_t ii = 0; ii < searchKeys.size(); ii++) {
+            m_batchKeys.push_back(KeyType(searchKeys[ii]));
+        }
+        m_batchIters.resize(searchKeys.size());
+        if ( ! searchKeys.empty()) {
+            m_entries.lowerBoundBatch(&m_batchKeys[0], m_batchKeys.size(), &m_batchIters[0]);
+        }
+    }
+
+    bool moveToBatchedKey(size_t ii)
+    {
+        assert(ii < m_batchIters.size());
+        m_begin = true;
+        m_keyIter = m_batchIters[ii];
+        if (m_keyIter.isEnd() || m_cmp(m_batchKeys[ii], m_keyIter.key()) != 0) {
+            m_keyIter = MapIterator();
+            m_match.move(NULL);
+            return false;
+        }
+        m_match.move(const_cast<void*>(m_keyIter.value()));
+        return true;
+    }
+
     void moveToKeyOrGreater(const TableTuple *searchKey)
     {
         ++m_lookups;
@@ -274,7 +372,7 @@ class CompactingTreeUniqueIndex : public TableIndex
 
     virtual TableIndex *cloneEmptyNonCountingTreeIndex() const
     {
-        return new CompactingTreeUniqueIndex<KeyType, false >(TupleSchema::createTupleSchema(getKeySchema()), m_scheme);
+        return new CompactingTreeUniqueIndex<KeyType, false, TreeMap>(TupleSchema::createTupleSchema(getKeySchema()), m_scheme);
     }
 
 
@@ -299,6 +397,10 @@ class CompactingTreeUniqueIndex : public TableIndex
     typename MapType::iterator m_keyIter;
     TableTuple m_match;
 
+    // keys and walks of the last moveToKeys()
+    std::vector<KeyType> m_batchKeys;
+    std::vector<MapIterator> m_batchIters;
+
     // comparison stuff
     KeyComparator m_cmp;
 
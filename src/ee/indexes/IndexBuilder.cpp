@@ -0,0 +1,124 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "indexes/IndexBuilder.h"
+#include "common/tabletuple.h"
+
+#include <algorithm>
+
+namespace voltdb {
+
+int IndexBuilder::s_threadCount = IndexBuilder::DEFAULT_THREAD_COUNT;
+
+IndexBuilder::IndexBuilder(const std::vector<TableIndex*> &indexes, const std::vector<char*> &addresses) :
+    m_indexes(indexes),
+    m_addresses(addresses),
+    m_prepared(indexes.size(), NULL),
+    m_nextQueued(0)
+{
+    pthread_mutex_init(&m_queueLock, NULL);
+}
+
+IndexBuilder::~IndexBuilder()
+{
+    for (size_t ii = 0; ii < m_prepared.size(); ii++) {
+        delete m_prepared[ii];
+    }
+    pthread_mutex_destroy(&m_queueLock);
+}
+
+TableIndex *IndexBuilder::build(TableTuple &conflict)
+{
+    if (m_addresses.size() >= MIN_PARALLEL_TUPLES) {
+        for (size_t ii = 0; ii < m_indexes.size(); ii++) {
+            if (m_indexes[ii]->getIndexedExpressions().empty()) {
+                m_queue.push_back(ii);
+            }
+        }
+    }
+    if (m_queue.size() > 1 && s_threadCount > 1) {
+        const size_t workerCount = std::min(m_queue.size(), static_cast<size_t>(s_threadCount)) - 1;
+        std::vector<pthread_t> workers;
+        workers.reserve(workerCount);
+        for (size_t ii = 0; ii < workerCount; ii++) {
+            pthread_t worker;
+            if (pthread_create(&worker, NULL, prepareLoop, this) != 0) {
+                // the site thread picks up the slack
+                break;
+            }
+            workers.push_back(worker);
+        }
+        prepareQueued();
+        for (size_t ii = 0; ii < workers.size(); ii++) {
+            pthread_join(workers[ii], NULL);
+        }
+    }
+
+    for (size_t ii = 0; ii < m_indexes.size(); ii++) {
+        TableIndex *index = m_indexes[ii];
+        // Not queued, or its preparation failed on a worker. In the latter
+        // case the failure repeats here and takes the usual way out.
+        if (m_prepared[ii] == NULL) {
+            m_prepared[ii] = index->prepareEntries(m_addresses);
+        }
+        const bool added = index->addPreparedEntries(m_addresses, m_prepared[ii], conflict);
+        delete m_prepared[ii];
+        m_prepared[ii] = NULL;
+        if (!added) {
+            return index;
+        }
+    }
+    return NULL;
+}
+
+void IndexBuilder::setThreadCount(int threadCount)
+{
+    s_threadCount = std::max(threadCount, 1);
+}
+
+int IndexBuilder::threadCount()
+{
+    return s_threadCount;
+}
+
+void *IndexBuilder::prepareLoop(void *builder)
+{
+    static_cast<IndexBuilder*>(builder)->prepareQueued();
+    return NULL;
+}
+
+void IndexBuilder::prepareQueued()
+{
+    while (true) {
+        pthread_mutex_lock(&m_queueLock);
+        if (m_nextQueued == m_queue.size()) {
+            pthread_mutex_unlock(&m_queueLock);
+            return;
+        }
+        const size_t position = m_queue[m_nextQueued++];
+        pthread_mutex_unlock(&m_queueLock);
+
+        try {
+            m_prepared[position] = m_indexes[position]->prepareEntries(m_addresses);
+        } catch (...) {
+            // left NULL for build() to retry on the site thread
+        }
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INDEXBUILDER_H_
+#define INDEXBUILDER_H_
+
+#include <vector>
+#include <pthread.h>
+#include "indexes/tableindex.h"
+
+namespace voltdb {
+
+class TableTuple;
+
+/**
+ * Fills several indexes of one table with the same batch of tuples, for
+ * adding indexes to a populated table and for loading an empty one.
+ *
+ * The slow part of filling an index from scratch, extracting every key and
+ * sorting them (TableIndex::prepareEntries()), only reads the tuples, so
+ * the indexes take turns being prepared by a few short-lived worker
+ * threads and the site thread itself. Once all are prepared the site
+ * thread merges the entries into the indexes one after the other
+ * (TableIndex::addPreparedEntries()). Nothing may change the table until
+ * build() returns, which the site thread guarantees by waiting.
+ *
+ * Small batches, single indexes and indexes on expressions, whose
+ * evaluation may use the site's thread local pools, are prepared on the
+ * site thread only.
+ */
+class IndexBuilder {
+  public:
+    /** Batches smaller than this aren't worth starting threads for */
+    static const size_t MIN_PARALLEL_TUPLES = 16384;
+    /** Threads preparing indexes at once, site thread included, unless told otherwise */
+    static const int DEFAULT_THREAD_COUNT = 4;
+
+    IndexBuilder(const std::vector<TableIndex*> &indexes, const std::vector<char*> &addresses);
+    ~IndexBuilder();
+
+    /**
+     * Add an entry for each tuple to each index. Returns NULL on success,
+     * otherwise the unique index that got a key twice, with conflict
+     * moved to one of the tuples holding it. The indexes before that one
+     * are complete, the rest may be partly filled.
+     */
+    TableIndex *build(TableTuple &conflict);
+
+    /**
+     * Change how many threads prepare indexes at once, for all sites of
+     * the process. One keeps everything on the site thread.
+     */
+    static void setThreadCount(int threadCount);
+    static int threadCount();
+
+  private:
+    // no copy, no assignment
+    IndexBuilder(IndexBuilder const&);
+    IndexBuilder operator=(IndexBuilder const&);
+
+    static void *prepareLoop(void *builder);
+    /** Prepare indexes off the queue until it is empty */
+    void prepareQueued();
+
+    const std::vector<TableIndex*> &m_indexes;
+    const std::vector<char*> &m_addresses;
+    std::vector<TableIndex::PreparedEntries*> m_prepared;
+    // positions in m_indexes of the indexes worker threads may prepare
+    std::vector<size_t> m_queue;
+    size_t m_nextQueued;
+    pthread_mutex_t m_queueLock;
+
+    static int s_threadCount;
+};
+
+}
+
+#endif /* INDEXBUILDER_H_ */
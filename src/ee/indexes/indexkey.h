@@ -133,6 +133,21 @@ struct IntsKey
     static inline bool keyDependsOnTupleAddress() { return false; }
     static inline bool keyUsesNonInlinedMemory() { return false; }
 
+    // Required by AdaptiveRadixTree keyed by IntsKey<>
+    enum { RADIX_LENGTH = keySize * sizeof(uint64_t) };
+
+    /*
+     * Write the key out as RADIX_LENGTH bytes that sort like the key:
+     * each uint64_t in turn, most significant byte first.
+     */
+    inline void toRadix(uint8_t *bytes) const {
+        for (unsigned int ii = 0; ii < keySize; ii++) {
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                *bytes++ = static_cast<uint8_t>(data[ii] >> shift);
+            }
+        }
+    }
+
     /*
      * Take a value that is part of the key (already converted to a uint64_t) and inserts it into the
      * most significant bytes available in the key. Templated on the size of the type of key being inserted.
@@ -638,6 +653,220 @@ private:
     const TupleSchema *m_keySchema;
 };
 
+template <std::size_t keySize> struct NormalizedEqualityChecker;
+template <std::size_t keySize> struct NormalizedComparator;
+template <std::size_t keySize> struct NormalizedHasher;
+
+/**
+ * Key object for indexes of mixed types whose columns are all stored inline
+ * (numbers, decimals, timestamps and short strings). Rather than a key tuple,
+ * it holds each column encoded so that keys sort like their bytes, and two
+ * keys compare with one memcmp:
+ *   integers and timestamps big-endian with the sign bit flipped,
+ *   doubles with the sign bit flipped, or all bits if negative,
+ *   decimals as a 128-bit integer,
+ *   strings zero-padded to the column length, then one byte of length + 1.
+ * Every column takes as many bytes as in a key tuple, so a NormalizedKey is
+ * no bigger than the GenericKey it stands in for. NULLs are the smallest
+ * value of each type, as NValue::compare() has them: the integer NULLs
+ * already are, and a NULL double or string is all zeros. Every double at
+ * or below DOUBLE_NULL, -inf included, is NULL, so no other number
+ * encodes as zeros.
+ *
+ * Strings compare as bytes. NValue compares VARCHARs with strncmp(), which
+ * stops at an embedded '\0', so the two only differ for strings holding one.
+ */
+template <std::size_t keySize>
+struct NormalizedKey
+{
+    typedef NormalizedEqualityChecker<keySize> KeyEqualityChecker;
+    typedef NormalizedComparator<keySize> KeyComparator;
+    typedef NormalizedHasher<keySize> KeyHasher;
+
+    static inline bool keyDependsOnTupleAddress() { return false; }
+    static inline bool keyUsesNonInlinedMemory() { return false; }
+
+    /** Whether keys of keySchema can be normalized: no out-of-line columns */
+    static bool canNormalize(const TupleSchema *keySchema) {
+        if (keySchema->getUninlinedObjectColumnCount() != 0) {
+            return false;
+        }
+        const int columnCount = keySchema->columnCount();
+        for (int ii = 0; ii < columnCount; ++ii) {
+            switch (keySchema->columnType(ii)) {
+            case VALUE_TYPE_TINYINT:
+            case VALUE_TYPE_SMALLINT:
+            case VALUE_TYPE_INTEGER:
+            case VALUE_TYPE_BIGINT:
+            case VALUE_TYPE_TIMESTAMP:
+            case VALUE_TYPE_DOUBLE:
+            case VALUE_TYPE_DECIMAL:
+            case VALUE_TYPE_VARCHAR:
+            case VALUE_TYPE_VARBINARY:
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    NormalizedKey() {}
+
+    NormalizedKey(const TableTuple *tuple) {
+        assert(tuple);
+        const TupleSchema *keySchema = tuple->getSchema();
+        char *next = data;
+        const int columnCount = keySchema->columnCount();
+        for (int ii = 0; ii < columnCount; ++ii) {
+            next = setColumn(next, keySchema, ii, tuple->getNValue(ii));
+        }
+        assert(next <= data + keySize);
+    }
+
+    NormalizedKey(const TableTuple *tuple, const std::vector<int> &indices,
+                  const std::vector<AbstractExpression*> &indexed_expressions, const TupleSchema *keySchema) {
+        assert(tuple);
+        char *next = data;
+        const int columnCount = keySchema->columnCount();
+        if (indexed_expressions.size() > 0) {
+            for (int ii = 0; ii < columnCount; ++ii) {
+                AbstractExpression* ae = indexed_expressions[ii];
+                next = setColumn(next, keySchema, ii, ae->eval(tuple, NULL));
+            }
+        } else {
+            for (int ii = 0; ii < columnCount; ++ii) {
+                next = setColumn(next, keySchema, ii, tuple->getNValue(indices[ii]));
+            }
+        }
+        assert(next <= data + keySize);
+    }
+
+    // Encoded columns, tupleLength() bytes of the key schema; the rest is unused.
+    char data[keySize];
+
+private:
+    static inline char *setBigEndian(char *next, uint64_t value, int bytes) {
+        for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+            *next++ = static_cast<char>(value >> shift);
+        }
+        return next;
+    }
+
+    static char *setColumn(char *next, const TupleSchema *keySchema, int column, NValue value) {
+        const ValueType type = keySchema->columnType(column);
+        value = value.castAs(type);
+        switch (type) {
+        case VALUE_TYPE_TINYINT:
+            return setBigEndian(next, static_cast<uint8_t>(ValuePeeker::peekTinyInt(value)) ^ 0x80, 1);
+        case VALUE_TYPE_SMALLINT:
+            return setBigEndian(next, static_cast<uint16_t>(ValuePeeker::peekSmallInt(value)) ^ 0x8000, 2);
+        case VALUE_TYPE_INTEGER:
+            return setBigEndian(next, static_cast<uint32_t>(ValuePeeker::peekInteger(value)) ^ 0x80000000, 4);
+        case VALUE_TYPE_BIGINT:
+            return setBigEndian(next, static_cast<uint64_t>(ValuePeeker::peekBigInt(value)) ^ (UINT64_C(1) << 63), 8);
+        case VALUE_TYPE_TIMESTAMP:
+            return setBigEndian(next, static_cast<uint64_t>(ValuePeeker::peekTimestamp(value)) ^ (UINT64_C(1) << 63), 8);
+        case VALUE_TYPE_DOUBLE: {
+            if (value.isNull()) {
+                // below every value that isn't NULL, -inf included (it is NULL too)
+                return setBigEndian(next, 0, 8);
+            }
+            double doubleValue = ValuePeeker::peekDouble(value);
+            if (doubleValue == 0.0) {
+                doubleValue = 0.0; // -0.0 is equal to 0.0
+            }
+            uint64_t bits;
+            ::memcpy(&bits, &doubleValue, sizeof(bits));
+            if (bits & (UINT64_C(1) << 63)) {
+                bits = ~bits;
+            } else {
+                bits |= UINT64_C(1) << 63;
+            }
+            return setBigEndian(next, bits, 8);
+        }
+        case VALUE_TYPE_DECIMAL: {
+            const TTInt decimal = ValuePeeker::peekDecimal(value);
+            next = setBigEndian(next, static_cast<uint64_t>(decimal.table[1]) ^ (UINT64_C(1) << 63), 8);
+            return setBigEndian(next, static_cast<uint64_t>(decimal.table[0]), 8);
+        }
+        case VALUE_TYPE_VARCHAR:
+        case VALUE_TYPE_VARBINARY: {
+            const int32_t columnLength = static_cast<int32_t>(keySchema->columnLength(column));
+            assert(columnLength < UNINLINEABLE_OBJECT_LENGTH);
+            if (value.isNull()) {
+                ::memset(next, 0, columnLength + 1);
+                return next + columnLength + 1;
+            }
+            const int32_t length = ValuePeeker::peekObjectLength(value);
+            if (length > columnLength) {
+                char msg[1024];
+                snprintf(msg, 1024,
+                         "In NormalizedKey, Object exceeds specified size. Size is %d and max is %d",
+                         length, columnLength);
+                throw SQLException(SQLException::data_exception_string_data_length_mismatch, msg);
+            }
+            ::memcpy(next, ValuePeeker::peekObjectValue(value), length);
+            ::memset(next + length, 0, columnLength - length);
+            next[columnLength] = static_cast<char>(length + 1);
+            return next + columnLength + 1;
+        }
+        default:
+            throwDynamicSQLException("NormalizedKey can't hold a column of type %s",
+                                     getTypeName(type).c_str());
+        }
+        return next;
+    }
+};
+
+/**
+ * Function object returns -1/0/1 if lhs </==/> rhs.
+ * Required by CompactingMap keyed by NormalizedKey<>
+ */
+template <std::size_t keySize>
+struct NormalizedComparator
+{
+    NormalizedComparator(const TupleSchema *keySchema) : m_length(keySchema->tupleLength()) {}
+
+    inline int operator()(const NormalizedKey<keySize> &lhs, const NormalizedKey<keySize> &rhs) const {
+        const int result = ::memcmp(lhs.data, rhs.data, m_length);
+        return (result > 0) - (result < 0);
+    }
+private:
+    size_t m_length;
+};
+
+/**
+ * Required by CompactingHashTable keyed by NormalizedKey<>
+ */
+template <std::size_t keySize>
+struct NormalizedEqualityChecker
+{
+    NormalizedEqualityChecker(const TupleSchema *keySchema) : m_length(keySchema->tupleLength()) {}
+
+    inline bool operator()(const NormalizedKey<keySize> &lhs, const NormalizedKey<keySize> &rhs) const {
+        return ::memcmp(lhs.data, rhs.data, m_length) == 0;
+    }
+private:
+    size_t m_length;
+};
+
+/**
+ * Required by CompactingHashTable keyed by NormalizedKey<>
+ */
+template <std::size_t keySize>
+struct NormalizedHasher
+{
+    NormalizedHasher(const TupleSchema *keySchema) : m_length(keySchema->tupleLength()) {}
+
+    inline size_t operator()(NormalizedKey<keySize> const &p) const
+    {
+        return boost::hash_range(p.data, p.data + m_length);
+    }
+private:
+    size_t m_length;
+};
+
 struct TupleKeyComparator;
 
 /*
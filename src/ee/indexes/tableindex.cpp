@@ -44,10 +44,13 @@
  */
 
 #include <iostream>
+#include <cassert>
 #include "indexes/tableindex.h"
 #include "expressions/abstractexpression.h"
 #include "storage/TableCatalogDelegate.hpp"
 
+#include <boost/scoped_ptr.hpp>
+
 using namespace voltdb;
 
 TableIndex::TableIndex(const TupleSchema *keySchema, const TableIndexScheme &scheme) :
@@ -109,6 +112,43 @@ std::string TableIndex::debug() const
     return (ret);
 }
 
+bool TableIndex::addEntries(const std::vector<char*> &addresses, TableTuple &conflict)
+{
+    boost::scoped_ptr<PreparedEntries> prepared(prepareEntries(addresses));
+    return addPreparedEntries(addresses, prepared.get(), conflict);
+}
+
+TableIndex::PreparedEntries *TableIndex::prepareEntries(const std::vector<char*> &addresses)
+{
+    return NULL;
+}
+
+bool TableIndex::addPreparedEntries(const std::vector<char*> &addresses,
+                                    PreparedEntries *prepared, TableTuple &conflict)
+{
+    ensureCapacity(static_cast<uint32_t>(getSize() + addresses.size()));
+    TableTuple tuple(getTupleSchema());
+    for (size_t ii = 0; ii < addresses.size(); ii++) {
+        tuple.move(addresses[ii]);
+        if (!addEntry(&tuple)) {
+            conflict.move(addresses[ii]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void TableIndex::moveToKeys(const std::vector<const TableTuple*> &searchKeys)
+{
+    m_batchSearchKeys.assign(searchKeys.begin(), searchKeys.end());
+}
+
+bool TableIndex::moveToBatchedKey(size_t ii)
+{
+    assert(ii < m_batchSearchKeys.size());
+    return moveToKey(m_batchSearchKeys[ii]);
+}
+
 IndexStats* TableIndex::getIndexStats() {
     return &m_stats;
 }
@@ -192,6 +192,41 @@ public:
      */
     virtual bool addEntry(const TableTuple *tuple) = 0;
 
+    /**
+     * Keys pulled out of a batch of tuples by prepareEntries(), waiting to
+     * go into the index.
+     */
+    class PreparedEntries {
+    public:
+        virtual ~PreparedEntries() {}
+    };
+
+    /**
+     * adds an entry for each of the tuples at addresses, for loading a
+     * whole table at once. Returns false if a unique index would get a
+     * key twice, with conflict moved to one of the tuples holding it;
+     * entries may have been added for some of the others by then.
+     * Tree indexes sort the keys and build an empty tree bottom up.
+     */
+    bool addEntries(const std::vector<char*> &addresses, TableTuple &conflict);
+
+    /**
+     * The first half of addEntries(): build (and for tree indexes, sort)
+     * the keys of the tuples at addresses. Only reads the tuples and the
+     * index scheme, never the entries, so IndexBuilder may run it for
+     * several indexes of one table on worker threads at once as long as
+     * nothing changes the table meanwhile. Returns NULL if the index has
+     * nothing to do ahead of time.
+     */
+    virtual PreparedEntries *prepareEntries(const std::vector<char*> &addresses);
+
+    /**
+     * The second half of addEntries(), on the site thread. prepared is what
+     * prepareEntries() returned for the same addresses, and may be NULL.
+     */
+    virtual bool addPreparedEntries(const std::vector<char*> &addresses,
+                                    PreparedEntries *prepared, TableTuple &conflict);
+
     /**
      * removes the index entry linked to given value (and tuple
      * pointer, if it's non-unique index).
@@ -204,6 +239,25 @@ public:
     virtual bool replaceEntryNoKeyChange(const TableTuple &destinationTuple,
                                          const TableTuple &originalTuple) = 0;
 
+    /**
+     * Point the entry for keyTuple's key that currently refers to
+     * currentAddress at newAddress instead. The key is computed from
+     * keyTuple, whose own address is ignored, so this works when the
+     * entry refers to something that is not a tuple at all (an
+     * anti-cache tombstone). Not supported when the key depends on
+     * the tuple address.
+     */
+    virtual bool replaceEntryAddress(const TableTuple &keyTuple,
+                                     const void *currentAddress,
+                                     const void *newAddress) = 0;
+
+    /**
+     * Is the key derived from the tuple's address rather than only
+     * from its values? Entries of such indexes can't be re-pointed
+     * with replaceEntryAddress.
+     */
+    virtual bool keyDependsOnTupleAddress() const = 0;
+
     /**
      * Does the key out-of-line strings or binary data?
      * Used for an optimization when key values are the same.
@@ -240,6 +294,21 @@ public:
      */
     virtual bool moveToKey(const TableTuple *searchKey) = 0;
 
+    /**
+     * Look up a batch of search keys at once, for moveToBatchedKey() to
+     * then position on the matches of each. Indexes that can walk to
+     * several keys together overlap the cache misses of the walks; the
+     * default only remembers the keys, which must stay put until the
+     * batch is done with.
+     */
+    virtual void moveToKeys(const std::vector<const TableTuple*> &searchKeys);
+
+    /**
+     * moveToKey() on the ii-th key of the last moveToKeys(), taking the
+     * walk to it from the batch. Follow with nextValueAtKey().
+     */
+    virtual bool moveToBatchedKey(size_t ii);
+
     /**
      * This method moves to the first tuple equal or greater than
      * given key.  Use this with nextValue(). This method works for
@@ -466,6 +535,9 @@ protected:
     // stats
     IndexStats m_stats;
 
+    // keys of the last moveToKeys(), for the default moveToBatchedKey()
+    std::vector<const TableTuple*> m_batchSearchKeys;
+
 private:
 
     // This should always/only be required for unique key indexes used for primary keys.
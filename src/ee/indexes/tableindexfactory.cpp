@@ -56,33 +56,84 @@
 #include "indexes/CompactingTreeMultiMapIndex.h"
 #include "indexes/CompactingHashUniqueIndex.h"
 #include "indexes/CompactingHashMultiMapIndex.h"
+#include "structures/AdaptiveRadixTree.h"
+
+/**
+ * Tree indexes over keys that hold their whole value live in a
+ * CompactingBTree unless VOLT_BTREE_INDEXES is set to 0, which puts
+ * every tree index back on the red-black CompactingMap.
+ */
+#ifndef VOLT_BTREE_INDEXES
+    #define VOLT_BTREE_INDEXES 1
+#endif
+
+/**
+ * Tree indexes over integer keys that don't count go in an
+ * AdaptiveRadixTree unless VOLT_ART_INDEXES is set to 0.
+ */
+#ifndef VOLT_ART_INDEXES
+    #define VOLT_ART_INDEXES 1
+#endif
+
+/**
+ * Mixed-type keys with no out-of-line columns are NormalizedKeys, compared
+ * with memcmp, unless VOLT_NORMALIZED_KEYS is set to 0, which keeps them
+ * GenericKeys compared column by column.
+ */
+#ifndef VOLT_NORMALIZED_KEYS
+    #define VOLT_NORMALIZED_KEYS 1
+#endif
 
 namespace voltdb {
 
 class TableIndexPicker
 {
-    template <class TKeyType>
+    template <class TKeyType, template<typename, typename, typename, bool> class TreeMap>
     TableIndex *getInstanceForKeyType() const
     {
            if (m_scheme.unique) {
             if (m_type != BALANCED_TREE_INDEX) {
                 return new CompactingHashUniqueIndex<TKeyType >(m_keySchema, m_scheme);
             } else if (m_scheme.countable) {
-                return new CompactingTreeUniqueIndex<TKeyType, true>(m_keySchema, m_scheme);
+                return new CompactingTreeUniqueIndex<TKeyType, true, TreeMap>(m_keySchema, m_scheme);
             } else {
-                return new CompactingTreeUniqueIndex<TKeyType, false>(m_keySchema, m_scheme);
+                return new CompactingTreeUniqueIndex<TKeyType, false, TreeMap>(m_keySchema, m_scheme);
             }
         } else {
             if (m_type != BALANCED_TREE_INDEX) {
                 return new CompactingHashMultiMapIndex<TKeyType >(m_keySchema, m_scheme);
             } else if (m_scheme.countable) {
-                return new CompactingTreeMultiMapIndex<TKeyType, true>(m_keySchema, m_scheme);
+                return new CompactingTreeMultiMapIndex<TKeyType, true, TreeMap>(m_keySchema, m_scheme);
             } else {
-                return new CompactingTreeMultiMapIndex<TKeyType, false>(m_keySchema, m_scheme);
+                return new CompactingTreeMultiMapIndex<TKeyType, false, TreeMap>(m_keySchema, m_scheme);
             }
         }
     }
 
+    // For maps without rank, which can't back a countable index
+    template <class TKeyType, template<typename, typename, typename, bool> class TreeMap>
+    TableIndex *getNonCountingTreeInstance() const
+    {
+        if (m_scheme.unique) {
+            return new CompactingTreeUniqueIndex<TKeyType, false, TreeMap>(m_keySchema, m_scheme);
+        }
+        return new CompactingTreeMultiMapIndex<TKeyType, false, TreeMap>(m_keySchema, m_scheme);
+    }
+
+    template <class TKeyType>
+    TableIndex *getInstanceForKeyType() const
+    {
+#if VOLT_BTREE_INDEXES
+        // The B+tree copies keys into its inner nodes, and those copies
+        // can outlive the tuple a key came from. That only works for keys
+        // that don't point at the tuple's out-of-line strings.
+        if (m_keySchema->getUninlinedObjectColumnCount() == 0) {
+            return getInstanceForKeyType<TKeyType, CompactingBTree>();
+        }
+#endif
+        return getInstanceForKeyType<TKeyType, CompactingMap>();
+    }
+
     template <std::size_t KeySize>
     TableIndex *getInstanceIfKeyFits()
     {
@@ -92,6 +143,11 @@ class TableIndexPicker
         if (m_intsOnly) {
             // The IntsKey size parameter ((KeySize-1)/8 + 1) is calculated to be
             // the number of 8-byte uint64's required to store KeySize packed bytes.
+#if VOLT_ART_INDEXES
+            if (m_type == BALANCED_TREE_INDEX && !m_scheme.countable) {
+                return getNonCountingTreeInstance<IntsKey<(KeySize-1)/8 + 1>, AdaptiveRadixTree>();
+            }
+#endif
             return getInstanceForKeyType<IntsKey<(KeySize-1)/8 + 1> >();
         }
         // Generic Key
@@ -101,6 +157,11 @@ class TableIndexPicker
                       m_scheme.name.c_str());
             m_type = BALANCED_TREE_INDEX;
         }
+#if VOLT_NORMALIZED_KEYS
+        if (NormalizedKey<KeySize>::canNormalize(m_keySchema)) {
+            return getInstanceForKeyType<NormalizedKey<KeySize> >();
+        }
+#endif
         // If any indexed expression value can not either be stored "inline" within a (GenericKey) key tuple
         // or specifically in a non-inlined object shared with the base table (because it is a simple column value),
         // then the GenericKey will have to reference and maintain its own persistent non-inline storage.
@@ -109,7 +170,7 @@ class TableIndexPicker
         if (m_inlinesOrColumnsOnly) {
             return getInstanceForKeyType<GenericKey<KeySize> >();
         }
-        return getInstanceForKeyType<GenericPersistentKey<KeySize> >();
+        return getInstanceForKeyType<GenericPersistentKey<KeySize>, CompactingMap>();
     }
 
     template <int ColCount>
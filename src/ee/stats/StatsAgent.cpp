@@ -20,6 +20,8 @@
 #include "common/tabletuple.h"
 #include "common/TupleSchema.h"
 #include "storage/PersistentTableStats.h"
+#include "storage/ColdStorageStats.h"
+#include "storage/TempBlockPoolStats.h"
 #include "storage/tablefactory.h"
 #include "storage/tableiterator.h"
 #include <cassert>
@@ -49,6 +51,14 @@ namespace
             {
                 return IndexStats::generateEmptyIndexStatsTable();
             }
+        case STATISTICS_SELECTOR_TYPE_COLD_STORAGE:
+            {
+                return ColdStorageStats::generateEmptyColdStorageStatsTable();
+            }
+        case STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL:
+            {
+                return TempBlockPoolStats::generateEmptyTempBlockPoolStatsTable();
+            }
         default:
             {
                 throwFatalException("Attempted to get unsupported stats type");
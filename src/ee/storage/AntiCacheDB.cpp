@@ -0,0 +1,188 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/AntiCacheDB.h"
+#include "common/FatalException.hpp"
+#include "logging/LogManager.h"
+
+#include <cassert>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+
+namespace voltdb {
+
+AntiCacheDB::AntiCacheDB(const std::string &dir, int64_t siteId) :
+    m_fd(-1),
+    m_nextBlockId(0),
+    m_bytesStored(0),
+    m_fileSize(0)
+{
+    std::ostringstream path;
+    path << dir << "/voltdb-anticache-" << siteId << "-XXXXXX";
+    std::string pathTemplate = path.str();
+    std::vector<char> pathBuffer(pathTemplate.begin(), pathTemplate.end());
+    pathBuffer.push_back('\0');
+
+    m_fd = ::mkstemp(&pathBuffer[0]);
+    if (m_fd == -1) {
+        throwFatalException("Unable to create anti-cache block file %s: %s",
+                            &pathBuffer[0], strerror(errno));
+    }
+    // Only this process ever needs the file, so let the OS reclaim it on exit.
+    ::unlink(&pathBuffer[0]);
+}
+
+AntiCacheDB::~AntiCacheDB()
+{
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+}
+
+off_t AntiCacheDB::allocateExtent(int32_t length)
+{
+    std::multimap<int32_t, off_t>::iterator fit = m_freeExtents.lower_bound(length);
+    if (fit == m_freeExtents.end()) {
+        off_t offset = m_fileSize;
+        m_fileSize += length;
+        return offset;
+    }
+
+    const int32_t extentLength = fit->first;
+    const off_t offset = fit->second;
+    m_freeExtents.erase(fit);
+    if (extentLength > length) {
+        m_freeExtents.insert(std::make_pair(extentLength - length, offset + length));
+    }
+    return offset;
+}
+
+int32_t AntiCacheDB::writeBlock(const char *data, int32_t length)
+{
+    assert(length > 0);
+    const off_t offset = allocateExtent(length);
+
+    int32_t written = 0;
+    while (written < length) {
+        ssize_t rc = ::pwrite(m_fd, data + written, length - written, offset + written);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            char msg[512];
+            snprintf(msg, sizeof(msg), "Failed to write %d byte anti-cache block: %s",
+                     length, strerror(errno));
+            LogManager::getThreadLogger(LOGGERID_HOST)->log(LOGLEVEL_ERROR, msg);
+            m_freeExtents.insert(std::make_pair(length, offset));
+            return -1;
+        }
+        written += static_cast<int32_t>(rc);
+    }
+
+    const int32_t blockId = m_nextBlockId++;
+    BlockLocation location;
+    location.m_offset = offset;
+    location.m_length = length;
+    m_blocks[blockId] = location;
+    m_bytesStored += length;
+    return blockId;
+}
+
+const AntiCacheDB::BlockLocation &AntiCacheDB::locate(int32_t blockId) const
+{
+    std::map<int32_t, BlockLocation>::const_iterator it = m_blocks.find(blockId);
+    if (it == m_blocks.end()) {
+        throwFatalException("Tried to read anti-cache block %d but it does not exist", blockId);
+    }
+    return it->second;
+}
+
+void AntiCacheDB::readFully(off_t offset, char *buffer, size_t length, int32_t blockId) const
+{
+    size_t bytesRead = 0;
+    while (bytesRead < length) {
+        ssize_t rc = ::pread(m_fd, buffer + bytesRead, length - bytesRead, offset + bytesRead);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            throwFatalException("Failed to read anti-cache block %d: %s",
+                                blockId, rc == 0 ? "unexpected end of file" : strerror(errno));
+        }
+        bytesRead += rc;
+    }
+}
+
+void AntiCacheDB::readBlock(int32_t blockId, std::vector<char> &buffer) const
+{
+    const BlockLocation &location = locate(blockId);
+    buffer.resize(location.m_length);
+    readFully(location.m_offset, &buffer[0], location.m_length, blockId);
+}
+
+void AntiCacheDB::readBlocks(const std::vector<int32_t> &blockIds,
+                             std::vector<std::vector<char> > &buffers) const
+{
+    // (offset, position in blockIds)
+    std::vector<std::pair<off_t, size_t> > order;
+    order.reserve(blockIds.size());
+    for (size_t ii = 0; ii < blockIds.size(); ++ii) {
+        order.push_back(std::make_pair(locate(blockIds[ii]).m_offset, ii));
+    }
+    std::sort(order.begin(), order.end());
+
+    buffers.resize(blockIds.size());
+    std::vector<char> run;
+    size_t first = 0;
+    while (first < order.size()) {
+        const off_t runStart = order[first].first;
+        off_t runEnd = runStart + locate(blockIds[order[first].second]).m_length;
+        size_t last = first + 1;
+        while (last < order.size() && order[last].first == runEnd) {
+            runEnd += locate(blockIds[order[last].second]).m_length;
+            ++last;
+        }
+
+        run.resize(runEnd - runStart);
+        readFully(runStart, &run[0], run.size(), blockIds[order[first].second]);
+        for (size_t ii = first; ii < last; ++ii) {
+            const size_t position = order[ii].second;
+            const char *blockStart = &run[0] + (order[ii].first - runStart);
+            buffers[position].assign(blockStart, blockStart + locate(blockIds[position]).m_length);
+        }
+        first = last;
+    }
+}
+
+void AntiCacheDB::releaseBlock(int32_t blockId)
+{
+    std::map<int32_t, BlockLocation>::iterator it = m_blocks.find(blockId);
+    if (it == m_blocks.end()) {
+        return;
+    }
+    m_freeExtents.insert(std::make_pair(it->second.m_length, it->second.m_offset));
+    m_bytesStored -= it->second.m_length;
+    m_blocks.erase(it);
+}
+
+}
@@ -0,0 +1,116 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTICACHEDB_H_
+#define ANTICACHEDB_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace voltdb {
+
+/**
+ * What an index entry points at once the tuple it used to point at has
+ * been evicted. The first byte lines up with the tuple header flags so
+ * that TableTuple::isActive()/isEvicted() work on it unchanged, and the
+ * second byte keeps the CSI; the rest says where the tuple went.
+ */
+struct EvictedTupleTombstone {
+    char m_flags;
+    char m_csi; // the evicted tuple's CSI, so it isn't reloaded as stone cold
+    char m_unused[2];
+    int32_t m_blockId;
+    int32_t m_tupleIndex;
+};
+
+/**
+ * Per-site block file that holds tuples evicted from PersistentTables by
+ * the Cold Storage anti-cache. Each block is an opaque byte string written
+ * and read in one piece; the caller decides what is inside. The file is
+ * unlinked as soon as it is opened, so its contents never outlive the
+ * process and there is nothing to clean up after a crash.
+ */
+class AntiCacheDB {
+  public:
+    /**
+     * Create the block file in directory dir. The site id only makes the
+     * file name easier to recognize while the process is alive.
+     */
+    AntiCacheDB(const std::string &dir, int64_t siteId);
+    ~AntiCacheDB();
+
+    /**
+     * Write length bytes of data as a new block and return its id.
+     * Returns -1 if the write failed, in which case nothing was stored.
+     */
+    int32_t writeBlock(const char *data, int32_t length);
+
+    /**
+     * Read the block with the given id into buffer, replacing its
+     * contents. Throws a FatalException if the block cannot be read,
+     * since the tuples in it would otherwise be lost.
+     */
+    void readBlock(int32_t blockId, std::vector<char> &buffer) const;
+
+    /**
+     * Read several blocks in one pass: the blocks are visited in file
+     * order and runs of adjacent blocks are read with a single call.
+     * buffers[i] receives the block blockIds[i].
+     */
+    void readBlocks(const std::vector<int32_t> &blockIds,
+                    std::vector<std::vector<char> > &buffers) const;
+
+    /** Forget a block and make its space on disk available for reuse. */
+    void releaseBlock(int32_t blockId);
+
+    /** Length in bytes of the block with the given id */
+    int32_t blockLength(int32_t blockId) const { return locate(blockId).m_length; }
+
+    size_t blockCount() const { return m_blocks.size(); }
+    int64_t bytesStored() const { return m_bytesStored; }
+    int64_t fileSize() const { return m_fileSize; }
+
+  private:
+    // no copy, no assignment
+    AntiCacheDB(AntiCacheDB const&);
+    AntiCacheDB operator=(AntiCacheDB const&);
+
+    struct BlockLocation {
+        off_t m_offset;
+        int32_t m_length;
+    };
+
+    off_t allocateExtent(int32_t length);
+    const BlockLocation &locate(int32_t blockId) const;
+    void readFully(off_t offset, char *buffer, size_t length, int32_t blockId) const;
+
+    int m_fd;
+    int32_t m_nextBlockId;
+    // Live blocks by id
+    std::map<int32_t, BlockLocation> m_blocks;
+    // Released extents by length, reused first fit
+    std::multimap<int32_t, off_t> m_freeExtents;
+    int64_t m_bytesStored;
+    off_t m_fileSize;
+};
+
+}
+
+#endif /* ANTICACHEDB_H_ */
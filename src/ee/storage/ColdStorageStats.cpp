@@ -0,0 +1,215 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/ColdStorageStats.h"
+#include "stats/StatsSource.h"
+#include "common/TupleSchema.h"
+#include "common/ids.h"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+
+using namespace voltdb;
+using namespace std;
+
+vector<string> ColdStorageStats::generateColdStorageStatsColumnNames() {
+    vector<string> columnNames = StatsSource::generateBaseStatsColumnNames();
+    columnNames.push_back("TABLE_NAME");
+    columnNames.push_back("EVICTED_TUPLES");
+    columnNames.push_back("EVICTED_BYTES");
+    columnNames.push_back("EVICTED_BLOCKS");
+    columnNames.push_back("TUPLES_EVICTED");
+    columnNames.push_back("TUPLES_FETCHED");
+    columnNames.push_back("FETCHES");
+    columnNames.push_back("FETCH_LATENCY_AVG");
+    columnNames.push_back("FETCH_LATENCY_MAX");
+    columnNames.push_back("AGING_PASSES");
+    columnNames.push_back("EVICTION_REVOLUTIONS");
+    for (int ii = 0; ii < COLD_STORAGE_CSI_BUCKETS; ii++) {
+        char name[32];
+        snprintf(name, sizeof(name), "CSI_%d_%d", ii * COLD_STORAGE_CSI_BUCKET_WIDTH,
+                 (ii + 1) * COLD_STORAGE_CSI_BUCKET_WIDTH - 1);
+        columnNames.push_back(name);
+    }
+    columnNames.push_back("CSI_SATURATED");
+    columnNames.push_back("TABLE_MEMORY");
+    columnNames.push_back("MEMORY_LIMIT");
+    columnNames.push_back("PERCENT_OF_MEMORY_LIMIT");
+    return columnNames;
+}
+
+void ColdStorageStats::populateColdStorageStatsSchema(
+        vector<ValueType> &types,
+        vector<int32_t> &columnLengths,
+        vector<bool> &allowNull) {
+    StatsSource::populateBaseSchema(types, columnLengths, allowNull);
+    types.push_back(VALUE_TYPE_VARCHAR); columnLengths.push_back(4096); allowNull.push_back(false);
+    // everything but the percentages is a BIGINT count, size in KB or latency in microseconds
+    const int bigintColumns = 10 + COLD_STORAGE_CSI_BUCKETS + 1 + 2;
+    for (int ii = 0; ii < bigintColumns; ii++) {
+        types.push_back(VALUE_TYPE_BIGINT); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT)); allowNull.push_back(false);
+    }
+    types.push_back(VALUE_TYPE_DOUBLE); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_DOUBLE)); allowNull.push_back(false);
+}
+
+Table*
+ColdStorageStats::generateEmptyColdStorageStatsTable()
+{
+    string name = "Persistent Table aggregated cold storage stats temp table";
+    // An empty stats table isn't clearly associated with any specific
+    // database ID.  Just pick something that works for now.
+    CatalogId databaseId = 1;
+    vector<string> columnNames = ColdStorageStats::generateColdStorageStatsColumnNames();
+    vector<ValueType> columnTypes;
+    vector<int32_t> columnLengths;
+    vector<bool> columnAllowNull;
+    ColdStorageStats::populateColdStorageStatsSchema(columnTypes, columnLengths,
+                                                     columnAllowNull);
+    TupleSchema *schema =
+        TupleSchema::createTupleSchema(columnTypes, columnLengths,
+                                       columnAllowNull, true);
+
+    return
+        reinterpret_cast<Table*>(TableFactory::getTempTable(databaseId,
+                                                            name,
+                                                            schema,
+                                                            columnNames,
+                                                            NULL));
+}
+
+ColdStorageStats::ColdStorageStats(PersistentTable* table)
+    : StatsSource(), m_table(table), m_memoryLimit(0),
+      m_tuplesEvicted(0), m_tuplesFetched(0), m_fetches(0), m_fetchMicros(0),
+      m_fetchMicrosMax(0), m_agingPasses(0), m_evictionRevolutions(0),
+      m_lastTuplesEvicted(0), m_lastTuplesFetched(0), m_lastFetches(0),
+      m_lastFetchMicros(0), m_lastAgingPasses(0), m_lastEvictionRevolutions(0),
+      m_intervalFetchMicrosMax(0)
+{
+}
+
+ColdStorageStats::~ColdStorageStats() {
+    m_tableName.free();
+}
+
+void ColdStorageStats::configure(
+        string name,
+        CatalogId databaseId) {
+    StatsSource::configure(name, databaseId);
+    m_tableName = ValueFactory::getStringValue(m_table->name());
+}
+
+void ColdStorageStats::recordFetchLatency(int64_t micros) {
+    m_fetches++;
+    m_fetchMicros += micros;
+    if (micros > m_fetchMicrosMax) {
+        m_fetchMicrosMax = micros;
+    }
+    if (micros > m_intervalFetchMicrosMax) {
+        m_intervalFetchMicrosMax = micros;
+    }
+}
+
+vector<string> ColdStorageStats::generateStatsColumnNames() {
+    return ColdStorageStats::generateColdStorageStatsColumnNames();
+}
+
+/**
+ * Update the stats tuple with the latest statistics available to this StatsSource.
+ * The CSI histogram takes a pass over the table's resident tuples.
+ */
+void ColdStorageStats::updateStatsTuple(TableTuple *tuple) {
+    tuple->setNValue(StatsSource::m_columnName2Index["TABLE_NAME"], m_tableName);
+
+    int64_t tuplesEvicted = m_tuplesEvicted;
+    int64_t tuplesFetched = m_tuplesFetched;
+    int64_t fetches = m_fetches;
+    int64_t fetchMicros = m_fetchMicros;
+    int64_t fetchMicrosMax = m_fetchMicrosMax;
+    int64_t agingPasses = m_agingPasses;
+    int64_t evictionRevolutions = m_evictionRevolutions;
+    if (interval()) {
+        tuplesEvicted -= m_lastTuplesEvicted;
+        tuplesFetched -= m_lastTuplesFetched;
+        fetches -= m_lastFetches;
+        fetchMicros -= m_lastFetchMicros;
+        fetchMicrosMax = m_intervalFetchMicrosMax;
+        agingPasses -= m_lastAgingPasses;
+        evictionRevolutions -= m_lastEvictionRevolutions;
+        m_lastTuplesEvicted = m_tuplesEvicted;
+        m_lastTuplesFetched = m_tuplesFetched;
+        m_lastFetches = m_fetches;
+        m_lastFetchMicros = m_fetchMicros;
+        m_lastAgingPasses = m_agingPasses;
+        m_lastEvictionRevolutions = m_evictionRevolutions;
+        m_intervalFetchMicrosMax = 0;
+    }
+
+    tuple->setNValue(StatsSource::m_columnName2Index["EVICTED_TUPLES"],
+                     ValueFactory::getBigIntValue(m_table->evictedTupleCount()));
+    tuple->setNValue(StatsSource::m_columnName2Index["EVICTED_BYTES"],
+                     ValueFactory::getBigIntValue(m_table->evictedByteCount()));
+    tuple->setNValue(StatsSource::m_columnName2Index["EVICTED_BLOCKS"],
+                     ValueFactory::getBigIntValue(static_cast<int64_t>(m_table->evictedBlockCount())));
+    tuple->setNValue(StatsSource::m_columnName2Index["TUPLES_EVICTED"],
+                     ValueFactory::getBigIntValue(tuplesEvicted));
+    tuple->setNValue(StatsSource::m_columnName2Index["TUPLES_FETCHED"],
+                     ValueFactory::getBigIntValue(tuplesFetched));
+    tuple->setNValue(StatsSource::m_columnName2Index["FETCHES"],
+                     ValueFactory::getBigIntValue(fetches));
+    tuple->setNValue(StatsSource::m_columnName2Index["FETCH_LATENCY_AVG"],
+                     ValueFactory::getBigIntValue(fetches == 0 ? 0 : fetchMicros / fetches));
+    tuple->setNValue(StatsSource::m_columnName2Index["FETCH_LATENCY_MAX"],
+                     ValueFactory::getBigIntValue(fetchMicrosMax));
+    tuple->setNValue(StatsSource::m_columnName2Index["AGING_PASSES"],
+                     ValueFactory::getBigIntValue(agingPasses));
+    tuple->setNValue(StatsSource::m_columnName2Index["EVICTION_REVOLUTIONS"],
+                     ValueFactory::getBigIntValue(evictionRevolutions));
+
+    int64_t histogram[COLD_STORAGE_CSI_BUCKETS + 1] = { 0 };
+    TableTuple resident(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(resident)) {
+        const int csi = resident.getCSI();
+        ++histogram[csi == TUPLE_CSI_MAX ? COLD_STORAGE_CSI_BUCKETS : csi / COLD_STORAGE_CSI_BUCKET_WIDTH];
+    }
+    const int firstBucketColumn = StatsSource::m_columnName2Index["CSI_0_15"];
+    for (int ii = 0; ii <= COLD_STORAGE_CSI_BUCKETS; ii++) {
+        tuple->setNValue(firstBucketColumn + ii, ValueFactory::getBigIntValue(histogram[ii]));
+    }
+
+    const int64_t tableMemory = m_table->allocatedTupleMemory() + m_table->nonInlinedMemorySize();
+    tuple->setNValue(StatsSource::m_columnName2Index["TABLE_MEMORY"],
+                     ValueFactory::getBigIntValue(tableMemory / 1024));
+    tuple->setNValue(StatsSource::m_columnName2Index["MEMORY_LIMIT"],
+                     ValueFactory::getBigIntValue(m_memoryLimit / 1024));
+    tuple->setNValue(StatsSource::m_columnName2Index["PERCENT_OF_MEMORY_LIMIT"],
+                     ValueFactory::getDoubleValue(m_memoryLimit == 0 ? 0.0 :
+                                                  100.0 * static_cast<double>(tableMemory) / static_cast<double>(m_memoryLimit)));
+
+}
+
+void ColdStorageStats::populateSchema(
+        vector<ValueType> &types,
+        vector<int32_t> &columnLengths,
+        vector<bool> &allowNull) {
+    ColdStorageStats::populateColdStorageStatsSchema(types, columnLengths, allowNull);
+}
@@ -0,0 +1,116 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLDSTORAGESTATS_H_
+#define COLDSTORAGESTATS_H_
+
+#include "stats/StatsSource.h"
+#include "common/ids.h"
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <sys/time.h>
+
+namespace voltdb {
+class PersistentTable;
+
+// CSI histogram: buckets of COLD_STORAGE_CSI_BUCKET_WIDTH values, plus one for saturated counters
+const int COLD_STORAGE_CSI_BUCKETS = 8;
+const int COLD_STORAGE_CSI_BUCKET_WIDTH = 16;
+
+/**
+ * StatsSource reporting what Cold Storage does to one persistent table:
+ * what is in the anti-cache, how often and how slowly it is fetched
+ * back, how often the access counters were aged and the eviction clock
+ * went around, how the counters are
+ * spread, and how big the table is compared to the memory limit.
+ */
+class ColdStorageStats : public voltdb::StatsSource {
+public:
+    static std::vector<std::string> generateColdStorageStatsColumnNames();
+
+    static void populateColdStorageStatsSchema(std::vector<voltdb::ValueType>& types,
+                                               std::vector<int32_t>& columnLengths,
+                                               std::vector<bool>& allowNull);
+
+    static Table* generateEmptyColdStorageStatsTable();
+
+    ColdStorageStats(voltdb::PersistentTable* table);
+
+    ~ColdStorageStats();
+
+    void configure(
+            std::string name,
+            voltdb::CatalogId databaseId);
+
+    /** Bytes of table memory at which the engine starts evicting, site wide */
+    void setMemoryLimit(int64_t memoryLimit) { m_memoryLimit = memoryLimit; }
+
+    void recordEviction(int64_t tuples) { m_tuplesEvicted += tuples; }
+
+    void recordFetch(int64_t tuples) { m_tuplesFetched += tuples; }
+
+    /** One fetch-back that brought tuples of this table in, end to end */
+    void recordFetchLatency(int64_t micros);
+
+    void recordAgingPass() { m_agingPasses++; }
+
+    /** The block policy's eviction clock wrapped around the table */
+    void recordEvictionRevolution() { m_evictionRevolutions++; }
+
+    /** Wall clock in microseconds, for timing fetch-backs */
+    static int64_t nowMicros() {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+    }
+
+protected:
+    virtual void updateStatsTuple(voltdb::TableTuple *tuple);
+
+    virtual std::vector<std::string> generateStatsColumnNames();
+
+    virtual void populateSchema(std::vector<voltdb::ValueType> &types, std::vector<int32_t> &columnLengths, std::vector<bool> &allowNull);
+
+private:
+    voltdb::PersistentTable *m_table;
+
+    voltdb::NValue m_tableName;
+
+    int64_t m_memoryLimit;
+
+    int64_t m_tuplesEvicted;
+    int64_t m_tuplesFetched;
+    int64_t m_fetches;
+    int64_t m_fetchMicros;
+    int64_t m_fetchMicrosMax;
+    int64_t m_agingPasses;
+    int64_t m_evictionRevolutions;
+
+    int64_t m_lastTuplesEvicted;
+    int64_t m_lastTuplesFetched;
+    int64_t m_lastFetches;
+    int64_t m_lastFetchMicros;
+    int64_t m_lastAgingPasses;
+    int64_t m_lastEvictionRevolutions;
+    // largest latency since the last interval was taken
+    int64_t m_intervalFetchMicrosMax;
+};
+
+}
+
+#endif /* COLDSTORAGESTATS_H_ */
@@ -18,6 +18,7 @@
 #include "storage/temptable.h"
 #include "storage/tablefactory.h"
 #include "storage/CopyOnWriteIterator.h"
+#include "storage/EvictedTupleIterator.h"
 #include "storage/tableiterator.h"
 #include "common/FatalException.hpp"
 #include "logging/LogManager.h"
@@ -32,11 +33,15 @@ CopyOnWriteContext::CopyOnWriteContext(PersistentTable *table, TupleSerializer *
                                                                "COW of " + table->name(),
                                                                table, NULL)),
              m_serializer(serializer), m_pool(2097152, 320), m_blocks(m_table->m_data),
-             m_iterator(new CopyOnWriteIterator(table, m_blocks.begin(), m_blocks.end())),
+             m_iterator(m_blocks.empty() ? NULL :
+                        new CopyOnWriteIterator(table, m_blocks.begin(), m_blocks.end())),
+             m_evictedTuples(new EvictedTupleIterator(table)),
              m_maxTupleLength(serializer->getMaxSerializedTupleSize(table->schema())),
-             m_tuple(table->schema()), m_finishedTableScan(false), m_partitionId(partitionId),
+             m_tuple(table->schema()), m_finishedTableScan(m_blocks.empty()),
+             m_finishedEvictedScan(false), m_partitionId(partitionId),
              m_tuplesSerialized(0),
-             m_expectedTupleCount(static_cast<int32_t>(table->activeTupleCount())) {}
+             m_expectedTupleCount(static_cast<int32_t>(table->activeTupleCount() +
+                                                       table->evictedTupleCount())) {}
 
 bool CopyOnWriteContext::serializeMore(ReferenceSerializeOutput *out) {
     out->writeInt(m_partitionId);
@@ -54,14 +59,16 @@ bool CopyOnWriteContext::serializeMore(ReferenceSerializeOutput *out) {
 
     std::size_t bytesSerialized = 0;
     while (out->remaining() >= (m_maxTupleLength + sizeof(int32_t))) {
-        const bool hadMore = m_iterator->next(tuple);
+        const bool hadMore = m_finishedTableScan && !m_finishedEvictedScan ?
+                m_evictedTuples->next(tuple) : m_iterator->next(tuple);
 
         /**
-         * After this finishes scanning the persistent table switch to scanning
-         * the temp table with the tuples that were backed up
+         * After this finishes scanning the persistent table switch to reading
+         * the evicted tuples from the anti-cache, and then to scanning the
+         * temp table with the tuples that were backed up
          */
         if (!hadMore) {
-            if (m_finishedTableScan) {
+            if (m_finishedEvictedScan) {
                 out->writeIntAt( rowCountPosition, rowsSerialized);
                 if (m_tuplesSerialized != m_expectedTupleCount) {
 #ifndef DEBUG
@@ -76,9 +83,12 @@ bool CopyOnWriteContext::serializeMore(ReferenceSerializeOutput *out) {
 
                 }
                 return false;
+            } else if (m_finishedTableScan) {
+                m_finishedEvictedScan = true;
+                m_iterator.reset(m_backedUpTuples.get()->makeIterator());
+                continue;
             } else {
                 m_finishedTableScan = true;
-                m_iterator.reset(m_backedUpTuples.get()->makeIterator());
                 continue;
             }
         }
@@ -223,6 +233,13 @@ void CopyOnWriteContext::markTupleDirty(TableTuple tuple, bool newTuple) {
     }
 }
 
+void CopyOnWriteContext::markEvictedTupleGone(TableTuple tuple, const EvictedTupleTombstone &tombstone) {
+    if (m_finishedEvictedScan || !m_evictedTuples->willReturn(tombstone.m_blockId, tombstone.m_tupleIndex)) {
+        return;
+    }
+    m_backedUpTuples->insertTupleNonVirtualWithDeepCopy(tuple, &m_pool);
+}
+
 void CopyOnWriteContext::notifyBlockWasCompactedAway(TBPtr block) {
     assert(!m_finishedTableScan);
     CopyOnWriteIterator *iter = static_cast<CopyOnWriteIterator*>(m_iterator.get());
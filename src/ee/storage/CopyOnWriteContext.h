@@ -27,6 +27,8 @@
 
 namespace voltdb {
 class TupleIterator;
+class EvictedTupleIterator;
+struct EvictedTupleTombstone;
 class TempTable;
 class ReferenceSerializeOut;
 
@@ -55,6 +57,12 @@ public:
 
     void notifyBlockWasCompactedAway(TBPtr block);
 
+    /**
+     * An evicted tuple is leaving the anti-cache, fetched back or deleted.
+     * If the snapshot has yet to read it from there, a copy is backed up.
+     */
+    void markEvictedTupleGone(TableTuple tuple, const EvictedTupleTombstone &tombstone);
+
     bool canSafelyFreeTuple(TableTuple tuple);
 
     virtual ~CopyOnWriteContext();
@@ -92,6 +100,12 @@ private:
      */
     boost::scoped_ptr<TupleIterator> m_iterator;
 
+    /**
+     * Reads the tuples that were evicted when the snapshot started, once
+     * the table has been scanned and before the backed up tuples
+     */
+    boost::scoped_ptr<EvictedTupleIterator> m_evictedTuples;
+
     /**
      * Maximum serialized length of a tuple
      */
@@ -101,6 +115,8 @@ private:
 
     bool m_finishedTableScan;
 
+    bool m_finishedEvictedScan;
+
     const int32_t m_partitionId;
 
     int32_t m_tuplesSerialized;
@@ -0,0 +1,126 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "storage/EvictedTupleIterator.h"
+#include "storage/persistenttable.h"
+#include "common/FatalException.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace voltdb {
+
+EvictedTupleIterator::EvictedTupleIterator(PersistentTable *table) :
+        m_table(table),
+        m_blocks(&table->m_evictedBlocks),
+        m_nextBlock(0),
+        m_blockId(-1),
+        m_blockTupleCount(0),
+        m_nextTuple(0),
+        m_tupleData(new char[table->m_tupleLength]),
+        m_tuple(table->schema()),
+        m_stringPool(&m_pool) {
+    init();
+}
+
+EvictedTupleIterator::EvictedTupleIterator(PersistentTable *table,
+                                           const PersistentTable::EvictedBlockMap &blocks) :
+        m_table(table),
+        m_blocks(&blocks),
+        m_nextBlock(0),
+        m_blockId(-1),
+        m_blockTupleCount(0),
+        m_nextTuple(0),
+        m_tupleData(new char[table->m_tupleLength]),
+        m_tuple(table->schema()),
+        m_stringPool(&m_pool) {
+    init();
+}
+
+void EvictedTupleIterator::init() {
+    // the map is ordered, so the ids come out sorted
+    m_blockIds.reserve(m_blocks->size());
+    for (PersistentTable::EvictedBlockMap::const_iterator i = m_blocks->begin();
+         i != m_blocks->end(); ++i) {
+        m_blockIds.push_back(i->first);
+    }
+    ::memset(m_tupleData.get(), 0, m_table->m_tupleLength);
+    m_tuple.move(m_tupleData.get());
+}
+
+bool EvictedTupleIterator::nextBlock() {
+    while (m_nextBlock < m_blockIds.size()) {
+        m_blockId = m_blockIds[m_nextBlock++];
+        if (m_blocks->find(m_blockId) == m_blocks->end()) {
+            continue;
+        }
+        m_table->m_antiCacheDB->readBlock(m_blockId, m_blockData);
+        m_blockIn.reset(new ReferenceSerializeInput(&m_blockData[0], m_blockData.size()));
+        m_blockTupleCount = m_blockIn->readInt();
+        m_nextTuple = 0;
+        if (m_stringPool == &m_pool) {
+            m_pool.purge();
+        }
+        return true;
+    }
+    m_blockId = -1;
+    return false;
+}
+
+bool EvictedTupleIterator::inEvictedBlock() const {
+    return m_blockId != -1 && m_nextTuple < m_blockTupleCount &&
+        m_blocks->find(m_blockId) != m_blocks->end();
+}
+
+bool EvictedTupleIterator::hasNext() {
+    while ( ! inEvictedBlock()) {
+        if ( ! nextBlock()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EvictedTupleIterator::next(TableTuple &out) {
+    if ( ! hasNext()) {
+        return false;
+    }
+    m_tuple.setActiveTrue();
+    m_tuple.deserializeFrom(*m_blockIn, m_stringPool);
+    m_tuple.setCSI(tombstoneAt(m_nextTuple)->m_csi);
+    ++m_nextTuple;
+    out.move(m_tupleData.get());
+    return true;
+}
+
+EvictedTupleTombstone *EvictedTupleIterator::tombstoneAt(int32_t tupleIndex) const {
+    PersistentTable::EvictedBlockMap::const_iterator block = m_blocks->find(m_blockId);
+    assert(block != m_blocks->end());
+    return block->second[tupleIndex];
+}
+
+EvictedTupleTombstone *EvictedTupleIterator::tombstone() const {
+    assert(m_blockId != -1 && m_nextTuple > 0);
+    return tombstoneAt(m_nextTuple - 1);
+}
+
+bool EvictedTupleIterator::willReturn(int32_t blockId, int32_t tupleIndex) const {
+    if (blockId == m_blockId) {
+        return tupleIndex >= m_nextTuple;
+    }
+    return std::binary_search(m_blockIds.begin() + m_nextBlock, m_blockIds.end(), blockId);
+}
+
+}
@@ -0,0 +1,99 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EVICTEDTUPLEITERATOR_H_
+#define EVICTEDTUPLEITERATOR_H_
+
+#include <vector>
+#include <stdint.h>
+#include "boost/scoped_array.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "common/Pool.hpp"
+#include "common/serializeio.h"
+#include "common/tabletuple.h"
+#include "storage/TupleIterator.h"
+#include "storage/persistenttable.h"
+
+namespace voltdb {
+
+/**
+ * Reads the tuples a PersistentTable has evicted straight from the
+ * anti-cache, one block at a time, without putting them back into the
+ * table. A tuple returned by next() lives in the iterator's own buffer,
+ * with its strings in the iterator's pool, and is only good until the
+ * next call. It carries the CSI it was evicted with.
+ *
+ * The blocks are the ones evicted when the iterator was created. A block
+ * that leaves the anti-cache part way through (fetched back or deleted)
+ * is skipped from then on; see willReturn().
+ *
+ * The second constructor reads a set of blocks already taken out of the
+ * table, whose tombstones the indexes no longer hold, to release or undo
+ * the delete of them.
+ */
+class EvictedTupleIterator : public TupleIterator {
+public:
+    EvictedTupleIterator(PersistentTable *table);
+    EvictedTupleIterator(PersistentTable *table, const PersistentTable::EvictedBlockMap &blocks);
+
+    bool hasNext();
+    bool next(TableTuple &out);
+
+    /**
+     * Allocate the strings of the tuples returned in pool rather than the
+     * iterator's own, for a caller whose copies of them outlive the
+     * iterator, like a scan's output table.
+     */
+    void setStringPool(Pool *pool) { m_stringPool = pool; }
+
+    /** The tombstone the indexes hold for the tuple next() returned last */
+    EvictedTupleTombstone *tombstone() const;
+
+    /** Is tuple tupleIndex of block blockId still to be returned by next()? */
+    bool willReturn(int32_t blockId, int32_t tupleIndex) const;
+
+    virtual ~EvictedTupleIterator() {}
+
+private:
+    bool inEvictedBlock() const;
+    EvictedTupleTombstone *tombstoneAt(int32_t tupleIndex) const;
+    bool nextBlock();
+
+    void init();
+
+    PersistentTable *m_table;
+    const PersistentTable::EvictedBlockMap *m_blocks;
+
+    // ids of the blocks to read, in ascending order, and the next one
+    std::vector<int32_t> m_blockIds;
+    size_t m_nextBlock;
+
+    // the block being read, or -1
+    int32_t m_blockId;
+    std::vector<char> m_blockData;
+    boost::scoped_ptr<ReferenceSerializeInput> m_blockIn;
+    int32_t m_blockTupleCount;
+    int32_t m_nextTuple;
+
+    boost::scoped_array<char> m_tupleData;
+    TableTuple m_tuple;
+    Pool m_pool;
+    Pool *m_stringPool;
+};
+
+}
+
+#endif /* EVICTEDTUPLEITERATOR_H_ */
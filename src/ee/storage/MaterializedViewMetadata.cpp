@@ -30,6 +30,7 @@
 #include "indexes/tableindex.h"
 #include "storage/persistenttable.h"
 #include "storage/MaterializedViewMetadata.h"
+#include "storage/EvictedTupleIterator.h"
 
 namespace voltdb {
 
@@ -83,12 +84,18 @@ DEBUG_STREAM_HERE("New mat view on source table " << srcTable->name() << " @" <<
     allocateBackedTuples();
 
     // Catch up on pre-existing source tuples UNLESS target tuples have already been migrated in.
-    if (srcTable->activeTupleCount() != 0 && m_target->activeTupleCount() == 0) {
+    if ((srcTable->activeTupleCount() != 0 || srcTable->evictedTupleCount() != 0) &&
+        m_target->activeTupleCount() == 0 && m_target->evictedTupleCount() == 0) {
         TableTuple scannedTuple(srcTable->schema());
         TableIterator &iterator = srcTable->iterator();
         while (iterator.next(scannedTuple)) {
             processTupleInsert(scannedTuple, false);
         }
+        // the scan only sees resident tuples; read the evicted ones from the anti-cache
+        EvictedTupleIterator evicted(srcTable);
+        while (evicted.next(scannedTuple)) {
+            processTupleInsert(scannedTuple, false);
+        }
     }
 }
 
@@ -128,20 +135,20 @@ void MaterializedViewMetadata::freeBackedTuples()
 void MaterializedViewMetadata::allocateBackedTuples()
 {
     m_searchKey = TableTuple(m_index->getKeySchema());
-    m_searchKeyBackingStore = new char[m_index->getKeySchema()->tupleLength() + 1];
-    memset(m_searchKeyBackingStore, 0, m_index->getKeySchema()->tupleLength() + 1);
+    m_searchKeyBackingStore = new char[m_index->getKeySchema()->tupleLength() + TUPLE_HEADER_SIZE];
+    memset(m_searchKeyBackingStore, 0, m_index->getKeySchema()->tupleLength() + TUPLE_HEADER_SIZE);
     m_searchKey.move(m_searchKeyBackingStore);
 
     m_existingTuple = TableTuple(m_target->schema());
 
     m_updatedTuple = TableTuple(m_target->schema());
-    m_updatedTupleBackingStore = new char[m_target->schema()->tupleLength() + 1];
-    memset(m_updatedTupleBackingStore, 0, m_target->schema()->tupleLength() + 1);
+    m_updatedTupleBackingStore = new char[m_target->schema()->tupleLength() + TUPLE_HEADER_SIZE];
+    memset(m_updatedTupleBackingStore, 0, m_target->schema()->tupleLength() + TUPLE_HEADER_SIZE);
     m_updatedTuple.move(m_updatedTupleBackingStore);
 
     m_emptyTuple = TableTuple(m_target->schema());
-    m_emptyTupleBackingStore = new char[m_target->schema()->tupleLength() + 1];
-    memset(m_emptyTupleBackingStore, 0, m_target->schema()->tupleLength() + 1);
+    m_emptyTupleBackingStore = new char[m_target->schema()->tupleLength() + TUPLE_HEADER_SIZE];
+    memset(m_emptyTupleBackingStore, 0, m_target->schema()->tupleLength() + TUPLE_HEADER_SIZE);
     m_emptyTuple.move(m_emptyTupleBackingStore);
 }
 
@@ -176,7 +183,7 @@ void MaterializedViewMetadata::processTupleInsert(TableTuple &newTuple, bool fal
     }
 
     // clear the tuple that will be built to insert or overwrite
-    memset(m_updatedTupleBackingStore, 0, m_target->schema()->tupleLength() + 1);
+    memset(m_updatedTupleBackingStore, 0, m_target->schema()->tupleLength() + TUPLE_HEADER_SIZE);
 
     int colindex = 0;
     // set up the first n columns, based on group-by columns
@@ -240,7 +247,7 @@ void MaterializedViewMetadata::processTupleDelete(TableTuple &oldTuple, bool fal
     findExistingTuple(oldTuple, true);
 
     // clear the tuple that will be built to insert or overwrite
-    memset(m_updatedTupleBackingStore, 0, m_target->schema()->tupleLength() + 1);
+    memset(m_updatedTupleBackingStore, 0, m_target->schema()->tupleLength() + TUPLE_HEADER_SIZE);
 
     //printf("  Existing tuple: %s.\n", m_existingTuple.debugNoHeader().c_str());
     //fflush(stdout);
@@ -0,0 +1,121 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/MinipageLayout.h"
+#include "storage/TupleBlock.h"
+#include "common/TupleSchema.h"
+#include "common/NValue.hpp"
+#include "expressions/abstractexpression.h"
+#include "expressions/tuplevalueexpression.h"
+
+#include <string.h>
+
+namespace voltdb {
+
+MinipageLayout::MinipageLayout(const TupleSchema *schema, const std::vector<int> &columns,
+                               uint32_t tuplesPerBlock) :
+    m_bytesPerBlock(0)
+{
+    for (size_t ii = 0; ii < columns.size(); ++ii) {
+        const int index = columns[ii];
+        const uint32_t end = index + 1 < schema->columnCount() ?
+            schema->columnOffset(index + 1) : schema->tupleLength();
+        Column column;
+        column.m_index = index;
+        column.m_tupleOffset = schema->columnOffset(index) + TUPLE_HEADER_SIZE;
+        column.m_width = end - schema->columnOffset(index);
+        column.m_minipageOffset = m_bytesPerBlock;
+        m_bytesPerBlock += column.m_width * tuplesPerBlock;
+        m_columns.push_back(column);
+    }
+}
+
+bool MinipageLayout::covers(int column) const {
+    for (size_t ii = 0; ii < m_columns.size(); ++ii) {
+        if (m_columns[ii].m_index == column) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MinipageLayout::covers(const AbstractExpression *expression) const {
+    if (expression == NULL) {
+        return true;
+    }
+    switch (expression->getExpressionType()) {
+    case EXPRESSION_TYPE_VALUE_TUPLE:
+        return covers(static_cast<const TupleValueExpression*>(expression)->getColumnId());
+    case EXPRESSION_TYPE_VALUE_CONSTANT:
+    case EXPRESSION_TYPE_VALUE_PARAMETER:
+    case EXPRESSION_TYPE_VALUE_NULL:
+    case EXPRESSION_TYPE_OPERATOR_PLUS:
+    case EXPRESSION_TYPE_OPERATOR_MINUS:
+    case EXPRESSION_TYPE_OPERATOR_MULTIPLY:
+    case EXPRESSION_TYPE_OPERATOR_DIVIDE:
+    case EXPRESSION_TYPE_OPERATOR_MOD:
+    case EXPRESSION_TYPE_OPERATOR_NOT:
+    case EXPRESSION_TYPE_OPERATOR_IS_NULL:
+    case EXPRESSION_TYPE_COMPARE_EQUAL:
+    case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+    case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+    case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+    case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+    case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+    case EXPRESSION_TYPE_COMPARE_LIKE:
+    case EXPRESSION_TYPE_CONJUNCTION_AND:
+    case EXPRESSION_TYPE_CONJUNCTION_OR:
+        return covers(expression->getLeft()) && covers(expression->getRight());
+    default:
+        // Functions keep their arguments out of left and right, and tuple
+        // addresses mean nothing for a rebuilt tuple
+        return false;
+    }
+}
+
+void MinipageLayout::store(char *minipages, uint32_t slot, const char *tupleData) const {
+    for (size_t ii = 0; ii < m_columns.size(); ++ii) {
+        const Column &column = m_columns[ii];
+        ::memcpy(minipages + column.m_minipageOffset + slot * column.m_width,
+                 tupleData + column.m_tupleOffset, column.m_width);
+    }
+}
+
+void MinipageLayout::load(const char *minipages, uint32_t slot, char *tupleData) const {
+    for (size_t ii = 0; ii < m_columns.size(); ++ii) {
+        const Column &column = m_columns[ii];
+        ::memcpy(tupleData + column.m_tupleOffset,
+                 minipages + column.m_minipageOffset + slot * column.m_width, column.m_width);
+    }
+}
+
+MinipageFilter::MinipageFilter(const MinipageLayout &layout, const TupleSchema *schema,
+                               const AbstractExpression *predicate) :
+    m_layout(layout),
+    m_predicate(predicate),
+    m_scratchData(new char[schema->tupleLength() + TUPLE_HEADER_SIZE]),
+    m_scratch(m_scratchData.get(), schema)
+{
+    ::memset(m_scratchData.get(), 0, schema->tupleLength() + TUPLE_HEADER_SIZE);
+}
+
+bool MinipageFilter::passes(TupleBlock &block, uint32_t slot) {
+    m_layout.load(block.minipages(), slot, m_scratch.address());
+    return m_predicate->eval(&m_scratch, NULL).isTrue();
+}
+
+}
@@ -0,0 +1,100 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MINIPAGELAYOUT_H_
+#define MINIPAGELAYOUT_H_
+
+#include "common/tabletuple.h"
+
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+
+namespace voltdb {
+
+class AbstractExpression;
+class TupleBlock;
+class TupleSchema;
+
+/**
+ * Optional PAX layout for a PersistentTable. Rows stay where they are, so
+ * TableTuple, the indexes and everything else keep working on them, but
+ * each TupleBlock also keeps its copies of a few inlined columns in
+ * column-major minipages, one per column, indexed by the tuple's slot in
+ * the block. A scan whose predicate reads only those columns evaluates it
+ * on the minipages and touches the rows of qualifying tuples alone.
+ *
+ * PersistentTable writes a tuple's columns into its block's minipages
+ * whenever it writes the tuple's data. The minipage entries of free slots
+ * are stale and must be skipped using the block's occupancy bitmap.
+ */
+class MinipageLayout {
+  public:
+    MinipageLayout(const TupleSchema *schema, const std::vector<int> &columns, uint32_t tuplesPerBlock);
+
+    /** Bytes of minipages each block of the table needs */
+    uint32_t bytesPerBlock() const { return m_bytesPerBlock; }
+
+    bool covers(int column) const;
+
+    /**
+     * True if expression reads no columns but those in the minipages and
+     * is made only of operators, comparisons, conjunctions and values, so
+     * it can be evaluated on a tuple rebuilt from the minipages.
+     */
+    bool covers(const AbstractExpression *expression) const;
+
+    /** Copy the columns of the tuple at tupleData into slot of minipages */
+    void store(char *minipages, uint32_t slot, const char *tupleData) const;
+
+    /** Copy slot of minipages into the tuple at tupleData, leaving other columns alone */
+    void load(const char *minipages, uint32_t slot, char *tupleData) const;
+
+  private:
+    struct Column {
+        int m_index;
+        uint32_t m_tupleOffset;     // from the start of the tuple, header included
+        uint32_t m_width;
+        uint32_t m_minipageOffset;  // from the start of the block's minipages
+    };
+
+    std::vector<Column> m_columns;
+    uint32_t m_bytesPerBlock;
+};
+
+/**
+ * A scan predicate evaluated on the minipages of a table's blocks. Handed
+ * to a TableIterator, which then only stops at tuples that pass it.
+ */
+class MinipageFilter {
+  public:
+    MinipageFilter(const MinipageLayout &layout, const TupleSchema *schema,
+                   const AbstractExpression *predicate);
+
+    bool passes(TupleBlock &block, uint32_t slot);
+
+  private:
+    const MinipageLayout &m_layout;
+    const AbstractExpression *m_predicate;
+    // A tuple of the table holding only the minipage columns
+    boost::scoped_array<char> m_scratchData;
+    TableTuple m_scratch;
+};
+
+}
+
+#endif /* MINIPAGELAYOUT_H_ */
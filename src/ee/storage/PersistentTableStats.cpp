@@ -16,13 +16,17 @@
  */
 #include "storage/PersistentTableStats.h"
 #include "storage/persistenttable.h"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
 #include <vector>
 #include <string>
 
 namespace voltdb {
 
 PersistentTableStats::PersistentTableStats(voltdb::PersistentTable* table)
-  : voltdb::TableStats(table)
+  : voltdb::TableStats(table), m_persistentTable(table),
+    m_lastCompactedBlocks(0), m_lastCompactedTuples(0),
+    m_lastForcedCompactions(0), m_lastCompactionMicros(0)
 {
 }
 
@@ -30,4 +34,30 @@ std::vector<std::string> PersistentTableStats::generateStatsColumnNames() {
     std::vector<std::string> columnNames = TableStats::generateStatsColumnNames();
     return columnNames;
 }
+
+void PersistentTableStats::updateStatsTuple(voltdb::TableTuple *tuple) {
+    TableStats::updateStatsTuple(tuple);
+    int64_t compactedBlocks = m_persistentTable->compactedBlockCount();
+    int64_t compactedTuples = m_persistentTable->compactedTupleCount();
+    int64_t forcedCompactions = m_persistentTable->forcedCompactionCount();
+    int64_t compactionMicros = m_persistentTable->compactionMicros();
+    if (interval()) {
+        compactedBlocks -= m_lastCompactedBlocks;
+        m_lastCompactedBlocks = m_persistentTable->compactedBlockCount();
+        compactedTuples -= m_lastCompactedTuples;
+        m_lastCompactedTuples = m_persistentTable->compactedTupleCount();
+        forcedCompactions -= m_lastForcedCompactions;
+        m_lastForcedCompactions = m_persistentTable->forcedCompactionCount();
+        compactionMicros -= m_lastCompactionMicros;
+        m_lastCompactionMicros = m_persistentTable->compactionMicros();
+    }
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTED_BLOCKS"],
+                     ValueFactory::getBigIntValue(compactedBlocks));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTED_TUPLES"],
+                     ValueFactory::getBigIntValue(compactedTuples));
+    tuple->setNValue(StatsSource::m_columnName2Index["FORCED_COMPACTIONS"],
+                     ValueFactory::getBigIntValue(forcedCompactions));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTION_TIME"],
+                     ValueFactory::getBigIntValue(compactionMicros));
+}
 }
@@ -26,13 +26,22 @@ namespace voltdb {
 class PersistentTable;
 
 /**
- * Further specialization of TableStats that currently adds no extra functionality.
+ * Further specialization of TableStats that adds the table's compaction
+ * progress: blocks freed and tuples moved by compaction, forced compactions
+ * run in the commit path, and the time spent compacting in microseconds.
  */
 class PersistentTableStats : public voltdb::TableStats {
   public:
     PersistentTableStats(voltdb::PersistentTable* table);
   protected:
     virtual std::vector<std::string> generateStatsColumnNames();
+    virtual void updateStatsTuple(voltdb::TableTuple *tuple);
+  private:
+    voltdb::PersistentTable *m_persistentTable;
+    int64_t m_lastCompactedBlocks;
+    int64_t m_lastCompactedTuples;
+    int64_t m_lastForcedCompactions;
+    int64_t m_lastCompactionMicros;
 };
 
 }
@@ -0,0 +1,59 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERSISTENTTABLEUNDODELETEEVICTEDACTION_H_
+#define PERSISTENTTABLEUNDODELETEEVICTEDACTION_H_
+
+#include "common/UndoAction.h"
+#include "storage/persistenttable.h"
+
+namespace voltdb {
+
+/*
+ * Undo for deleting every evicted tuple of a table. The blocks stay in
+ * the anti-cache, with their tombstones, until the delete is released.
+ */
+class PersistentTableUndoDeleteEvictedAction: public UndoAction {
+public:
+    inline PersistentTableUndoDeleteEvictedAction(PersistentTable::EvictedBlockMap &blocks,
+                                                  PersistentTable *table)
+        : m_table(table)
+    {
+        m_blocks.swap(blocks);
+    }
+
+private:
+    virtual ~PersistentTableUndoDeleteEvictedAction() { }
+
+    /*
+     * Put the blocks back and point the indexes at their tombstones again.
+     */
+    virtual void undo() { m_table->insertEvictedTuplesForUndo(m_blocks); }
+
+    /*
+     * Free the tombstones and the blocks' space in the anti-cache.
+     */
+    virtual void release() { m_table->deleteEvictedTuplesRelease(m_blocks); }
+
+private:
+    PersistentTable::EvictedBlockMap m_blocks;
+    PersistentTable *m_table;
+};
+
+}
+
+#endif /* PERSISTENTTABLEUNDODELETEEVICTEDACTION_H_ */
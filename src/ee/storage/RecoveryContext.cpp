@@ -18,6 +18,7 @@
 #include "common/RecoveryProtoMessageBuilder.h"
 #include "common/DefaultTupleSerializer.h"
 #include "storage/persistenttable.h"
+#include "storage/EvictedTupleIterator.h"
 
 #include <cstdio>
 using namespace std;
@@ -31,6 +32,8 @@ RecoveryContext::RecoveryContext(PersistentTable *table, int32_t tableId) :
         m_recoveryPhase(RECOVERY_MSG_TYPE_SCAN_TUPLES) {
 }
 
+RecoveryContext::~RecoveryContext() {}
+
 /*
  * Generate the next recovery message. Eventually returns a message containing the message type
  * RECOVERY_MSG_TYPE_COMPLETE indicating that all tuple data and updates to shipped data
@@ -49,11 +52,12 @@ bool RecoveryContext::nextMessage(ReferenceSerializeOutput *out) {
     if (m_firstMessage)
     {
         m_iterator = m_table->iterator();
+        m_evictedTuples.reset(new EvictedTupleIterator(m_table));
         m_firstMessage = false;
 
     }
 
-    if (!m_iterator.hasNext()) {
+    if (!m_iterator.hasNext() && !m_evictedTuples->hasNext()) {
         m_recoveryPhase = RECOVERY_MSG_TYPE_COMPLETE;
         out->writeByte(static_cast<int8_t>(RECOVERY_MSG_TYPE_COMPLETE));
         out->writeInt(m_tableId);
@@ -68,7 +72,8 @@ bool RecoveryContext::nextMessage(ReferenceSerializeOutput *out) {
     }
     DefaultTupleSerializer serializer;
     //Use allocated tuple count to size stuff at the other end
-    uint32_t allocatedTupleCount = static_cast<uint32_t>(m_table->allocatedTupleCount());
+    uint32_t allocatedTupleCount = static_cast<uint32_t>(m_table->allocatedTupleCount() +
+                                                         m_table->evictedTupleCount());
     RecoveryProtoMsgBuilder message(
             m_recoveryPhase,
             m_tableId,
@@ -77,7 +82,8 @@ bool RecoveryContext::nextMessage(ReferenceSerializeOutput *out) {
             &m_serializer,
             m_table->schema());
     TableTuple tuple(m_table->schema());
-    while (message.canAddMoreTuples() && m_iterator.next(tuple)) {
+    while (message.canAddMoreTuples() &&
+           (m_iterator.next(tuple) || m_evictedTuples->next(tuple))) {
         message.addTuple(tuple);
     }
     message.finalize();
@@ -19,6 +19,7 @@
 
 #include "storage/tableiterator.h"
 #include "common/DefaultTupleSerializer.h"
+#include "boost/scoped_ptr.hpp"
 
 /*
  * A log of changes to tuple data that has already been sent to a recovering
@@ -27,10 +28,12 @@
 namespace voltdb {
 class PersistentTable;
 class ReferenceSerializeOutput;
+class EvictedTupleIterator;
 
 class RecoveryContext {
 public:
     RecoveryContext(PersistentTable *table, int32_t tableId);
+    ~RecoveryContext();
 
     /*
      * Generate the next recovery message. Eventually returns a message containing the message type
@@ -52,6 +55,12 @@ private:
      */
     TableIterator m_iterator;
 
+    /*
+     * Reads the evicted tuples from the anti-cache once the
+     * table has been scanned
+     */
+    boost::scoped_ptr<EvictedTupleIterator> m_evictedTuples;
+
     /*
      * Integer indices of tuples that have been updated since being shipped
      * in a recovery message
@@ -31,6 +31,7 @@
 #include "expressions/expressionutil.h"
 #include "indexes/tableindex.h"
 #include "storage/constraintutil.h"
+#include "storage/EvictedTupleIterator.h"
 #include "storage/MaterializedViewMetadata.h"
 #include "storage/persistenttable.h"
 #include "storage/StreamBlock.h"
@@ -473,6 +474,36 @@ TableCatalogDelegate::processSchemaChanges(catalog::Database const &catalogDatab
     assert(newTable);
     PersistentTable *existingTable = dynamic_cast<PersistentTable*>(m_table);
 
+    // Keep the minipage columns that survived the change
+    const MinipageLayout *minipages = existingTable->minipageLayout();
+    if (minipages != NULL) {
+        vector<int> columns;
+        for (int ii = 0; ii < existingTable->columnCount(); ii++) {
+            if (minipages->covers(ii)) {
+                const int column = newTable->columnIndex(existingTable->columnName(ii));
+                if (column >= 0 && newTable->schema()->columnIsInlined(column)) {
+                    columns.push_back(column);
+                }
+            }
+        }
+        newTable->setMinipageColumns(columns);
+    }
+
+    // and the dictionary encoded ones, whose values migrate re-encoded
+    vector<int> dictionaryColumns;
+    for (int ii = 0; ii < existingTable->columnCount(); ii++) {
+        if (existingTable->columnDictionary(ii) != NULL) {
+            const int column = newTable->columnIndex(existingTable->columnName(ii));
+            if (column >= 0 && !newTable->schema()->columnIsInlined(column) &&
+                newTable->schema()->columnType(column) == existingTable->schema()->columnType(ii)) {
+                dictionaryColumns.push_back(column);
+            }
+        }
+    }
+    if (!dictionaryColumns.empty()) {
+        newTable->setDictionaryColumns(dictionaryColumns);
+    }
+
     ///////////////////////////////////////////////
     // Move tuples from one table to the other
     ///////////////////////////////////////////////
@@ -495,12 +526,32 @@ TableCatalogDelegate::processSchemaChanges(catalog::Database const &catalogDatab
     m_table = newTable;
 }
 
+// set the values from the old table or from defaults
+static void setMigratedValues(TableTuple &tupleToInsert, const TableTuple &scannedTuple,
+                              int columnCount, const int *columnSourceMap,
+                              const bool *columnExploded, const NValue *defaults)
+{
+    for (int i = 0; i < columnCount; i++) {
+        if (columnSourceMap[i] >= 0) {
+            NValue value = scannedTuple.getNValue(columnSourceMap[i]);
+            if (columnExploded[i]) {
+                value.allocatePersistentObjectFromInlineValue();
+            }
+            tupleToInsert.setNValue(i, value);
+        }
+        else {
+            tupleToInsert.setNValue(i, defaults[i]);
+        }
+    }
+}
+
 void
 TableCatalogDelegate::migrateChangedTuples(catalog::Table const &catalogTable,
                                            PersistentTable* existingTable,
                                            PersistentTable* newTable)
 {
-    int64_t existingTupleCount = existingTable->activeTupleCount();
+    int64_t existingTupleCount = existingTable->activeTupleCount() +
+        existingTable->evictedTupleCount();
 
     // remove all indexes from the existing table
     vector<TableIndex*> currentIndexes = existingTable->allIndexes();
@@ -582,19 +633,8 @@ TableCatalogDelegate::migrateChangedTuples(catalog::Table const &catalogTable,
 
             //printf("tuple: %s\n", scannedTuple.debug(existingTable->name()).c_str());
 
-            // set the values from the old table or from defaults
-            for (int i = 0; i < columnCount; i++) {
-                if (columnSourceMap[i] >= 0) {
-                    NValue value = scannedTuple.getNValue(columnSourceMap[i]);
-                    if (columnExploded[i]) {
-                        value.allocatePersistentObjectFromInlineValue();
-                    }
-                    tupleToInsert.setNValue(i, value);
-                }
-                else {
-                    tupleToInsert.setNValue(i, defaults[i]);
-                }
-            }
+            setMigratedValues(tupleToInsert, scannedTuple, columnCount,
+                              columnSourceMap, columnExploded, defaults);
 
             // insert into the new table
             newTable->insertPersistentTuple(tupleToInsert, false);
@@ -615,6 +655,20 @@ TableCatalogDelegate::migrateChangedTuples(catalog::Table const &catalogTable,
         }
     }
 
+    // The evicted tuples are read from the anti-cache and migrated into the
+    // new table's memory; their blocks are released all at once after.
+    if (existingTable->evictedTupleCount() != 0) {
+        EvictedTupleIterator evicted(existingTable);
+        TableTuple &tupleToInsert = newTable->tempTuple();
+        while (evicted.next(scannedTuple)) {
+            setMigratedValues(tupleToInsert, scannedTuple, columnCount,
+                              columnSourceMap, columnExploded, defaults);
+            newTable->insertPersistentTuple(tupleToInsert, false);
+            ++tuplesMigrated;
+        }
+        existingTable->discardEvictedTuples();
+    }
+
     // release any memory held by the default values --
     // normally you'd want this in a finally block, but since this code failing
     // implies serious problems, we'll not worry our pretty little heads
@@ -0,0 +1,299 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/TableImage.h"
+#include "common/SerializableEEException.h"
+#include "common/TupleSchema.h"
+#include "common/tabletuple.h"
+#include "crc/crc32c.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace voltdb {
+
+static const uint32_t TABLE_IMAGE_MAGIC = 0x474d4956; // "VIMG" on little endian hosts
+static const uint32_t TABLE_IMAGE_VERSION = 1;
+static const size_t TABLE_IMAGE_BUFFER_SIZE = 1024 * 1024;
+
+static void throwImageException(const std::string &path, const char *what, int error = 0)
+{
+    char msg[1024];
+    if (error != 0) {
+        snprintf(msg, sizeof(msg), "Table image %s: %s: %s", path.c_str(), what, strerror(error));
+    } else {
+        snprintf(msg, sizeof(msg), "Table image %s: %s", path.c_str(), what);
+    }
+    throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION, msg);
+}
+
+TableImage::TableImage(const std::string &path, bool forWrite) :
+    m_path(path),
+    m_fd(-1),
+    m_forWrite(forWrite),
+    m_finished(false),
+    m_crc(vdbcrc::crc32cInit()),
+    m_buffered(0),
+    m_clusterId(-1),
+    m_databaseId(-1),
+    m_tableId(-1),
+    m_tupleLength(0)
+{
+    if (forWrite) {
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        m_buffer.resize(TABLE_IMAGE_BUFFER_SIZE);
+    } else {
+        m_fd = ::open(path.c_str(), O_RDONLY);
+    }
+    if (m_fd == -1) {
+        throwImageException(path, "unable to open", errno);
+    }
+}
+
+TableImage::~TableImage()
+{
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+    // Don't leave a truncated image behind for a later restore to trip over
+    if (m_forWrite && !m_finished) {
+        ::unlink(m_path.c_str());
+    }
+}
+
+void TableImage::writeHeader(int32_t clusterId, int32_t databaseId, int32_t tableId,
+                             const std::string &tableName, const TupleSchema *schema)
+{
+    m_clusterId = clusterId;
+    m_databaseId = databaseId;
+    m_tableId = tableId;
+    m_tableName = tableName;
+    m_tupleLength = schema->tupleLength() + TUPLE_HEADER_SIZE;
+
+    write(&TABLE_IMAGE_MAGIC, sizeof(TABLE_IMAGE_MAGIC));
+    write(&TABLE_IMAGE_VERSION, sizeof(TABLE_IMAGE_VERSION));
+    write(&m_clusterId, sizeof(m_clusterId));
+    write(&m_databaseId, sizeof(m_databaseId));
+    write(&m_tableId, sizeof(m_tableId));
+    const uint16_t nameLength = static_cast<uint16_t>(tableName.size());
+    write(&nameLength, sizeof(nameLength));
+    write(tableName.data(), nameLength);
+
+    const uint16_t columnCount = schema->columnCount();
+    write(&columnCount, sizeof(columnCount));
+    m_columns.resize(columnCount);
+    for (uint16_t ii = 0; ii < columnCount; ++ii) {
+        ColumnLayout &column = m_columns[ii];
+        column.m_type = static_cast<int8_t>(schema->columnType(ii));
+        column.m_inlined = schema->columnIsInlined(ii) ? 1 : 0;
+        column.m_length = static_cast<int32_t>(schema->columnLength(ii));
+        write(&column.m_type, sizeof(column.m_type));
+        write(&column.m_inlined, sizeof(column.m_inlined));
+        write(&column.m_length, sizeof(column.m_length));
+    }
+    write(&m_tupleLength, sizeof(m_tupleLength));
+    writeChecksum();
+}
+
+void TableImage::readHeader()
+{
+    uint32_t magic;
+    read(&magic, sizeof(magic));
+    if (magic != TABLE_IMAGE_MAGIC) {
+        throwImageException(m_path, "not a table image");
+    }
+    uint32_t version;
+    read(&version, sizeof(version));
+    if (version != TABLE_IMAGE_VERSION) {
+        throwImageException(m_path, "unsupported table image version");
+    }
+    read(&m_clusterId, sizeof(m_clusterId));
+    read(&m_databaseId, sizeof(m_databaseId));
+    read(&m_tableId, sizeof(m_tableId));
+    uint16_t nameLength;
+    read(&nameLength, sizeof(nameLength));
+    std::vector<char> name(nameLength + 1, '\0');
+    read(&name[0], nameLength);
+    m_tableName.assign(&name[0], nameLength);
+
+    uint16_t columnCount;
+    read(&columnCount, sizeof(columnCount));
+    m_columns.resize(columnCount);
+    for (uint16_t ii = 0; ii < columnCount; ++ii) {
+        ColumnLayout &column = m_columns[ii];
+        read(&column.m_type, sizeof(column.m_type));
+        read(&column.m_inlined, sizeof(column.m_inlined));
+        read(&column.m_length, sizeof(column.m_length));
+    }
+    read(&m_tupleLength, sizeof(m_tupleLength));
+    verifyChecksum("header");
+}
+
+void TableImage::checkSchema(const TupleSchema *schema) const
+{
+    bool matches = m_columns.size() == schema->columnCount() &&
+        m_tupleLength == schema->tupleLength() + TUPLE_HEADER_SIZE;
+    for (uint16_t ii = 0; matches && ii < m_columns.size(); ++ii) {
+        const ColumnLayout &column = m_columns[ii];
+        matches = column.m_type == static_cast<int8_t>(schema->columnType(ii)) &&
+            (column.m_inlined != 0) == schema->columnIsInlined(ii) &&
+            column.m_length == static_cast<int32_t>(schema->columnLength(ii));
+    }
+    if (!matches) {
+        throwImageException(m_path, ("the schema of table " + m_tableName +
+                                     " changed since the image was saved").c_str());
+    }
+}
+
+void TableImage::writeChunkHeader(uint32_t tupleCount, uint32_t heapLength)
+{
+    write(&tupleCount, sizeof(tupleCount));
+    write(&heapLength, sizeof(heapLength));
+}
+
+uint32_t TableImage::readChunkHeader(uint32_t &heapLength)
+{
+    uint32_t tupleCount;
+    read(&tupleCount, sizeof(tupleCount));
+    read(&heapLength, sizeof(heapLength));
+    return tupleCount;
+}
+
+void TableImage::write(const void *data, size_t length)
+{
+    m_crc = vdbcrc::crc32c(m_crc, data, length);
+    writeRaw(data, length);
+}
+
+void TableImage::read(void *data, size_t length)
+{
+    readRaw(data, length);
+    m_crc = vdbcrc::crc32c(m_crc, data, length);
+}
+
+void TableImage::finish(int64_t tupleCount)
+{
+    writeChunkHeader(0, 0);
+    write(&tupleCount, sizeof(tupleCount));
+    writeChecksum();
+    flush();
+    if (::fsync(m_fd) != 0) {
+        throwImageException(m_path, "unable to sync", errno);
+    }
+    const int fd = m_fd;
+    m_fd = -1;
+    if (::close(fd) != 0) {
+        throwImageException(m_path, "unable to close", errno);
+    }
+    m_finished = true;
+}
+
+void TableImage::verifyTrailer(int64_t tupleCount)
+{
+    int64_t savedTupleCount;
+    read(&savedTupleCount, sizeof(savedTupleCount));
+    verifyChecksum("tuple data");
+    if (savedTupleCount != tupleCount) {
+        throwImageException(m_path, "tuple count does not match the trailer");
+    }
+}
+
+void TableImage::writeChecksum()
+{
+    const uint32_t crc = vdbcrc::crc32cFinish(m_crc);
+    writeRaw(&crc, sizeof(crc));
+    m_crc = vdbcrc::crc32cInit();
+}
+
+void TableImage::verifyChecksum(const char *section)
+{
+    const uint32_t crc = vdbcrc::crc32cFinish(m_crc);
+    uint32_t savedCrc;
+    readRaw(&savedCrc, sizeof(savedCrc));
+    if (crc != savedCrc) {
+        throwImageException(m_path, (std::string("checksum mismatch in the ") + section).c_str());
+    }
+    m_crc = vdbcrc::crc32cInit();
+}
+
+void TableImage::writeRaw(const void *data, size_t length)
+{
+    if (m_buffered + length <= m_buffer.size()) {
+        ::memcpy(&m_buffer[m_buffered], data, length);
+        m_buffered += length;
+        return;
+    }
+    flush();
+    if (length < m_buffer.size()) {
+        ::memcpy(&m_buffer[0], data, length);
+        m_buffered = length;
+        return;
+    }
+
+    const char *bytes = static_cast<const char*>(data);
+    size_t written = 0;
+    while (written < length) {
+        ssize_t rc = ::write(m_fd, bytes + written, length - written);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            throwImageException(m_path, "write failed", errno);
+        }
+        written += rc;
+    }
+}
+
+void TableImage::flush()
+{
+    size_t written = 0;
+    while (written < m_buffered) {
+        ssize_t rc = ::write(m_fd, &m_buffer[written], m_buffered - written);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            throwImageException(m_path, "write failed", errno);
+        }
+        written += rc;
+    }
+    m_buffered = 0;
+}
+
+void TableImage::readRaw(void *data, size_t length)
+{
+    char *bytes = static_cast<char*>(data);
+    size_t bytesRead = 0;
+    while (bytesRead < length) {
+        ssize_t rc = ::read(m_fd, bytes + bytesRead, length - bytesRead);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc < 0) {
+            throwImageException(m_path, "read failed", errno);
+        }
+        if (rc == 0) {
+            throwImageException(m_path, "unexpected end of file");
+        }
+        bytesRead += rc;
+    }
+}
+
+}
@@ -0,0 +1,119 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TABLEIMAGE_H_
+#define TABLEIMAGE_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace voltdb {
+
+class TupleSchema;
+
+/**
+ * A file holding a native binary image of one PersistentTable, written by
+ * VoltDBEngine::saveTableToDisk() and read back by restoreTableFromDisk().
+ * Tuples are stored exactly as they sit in their TupleBlocks, so a restore
+ * is a few large reads straight into fresh blocks rather than a
+ * deserialization per row. The layout, in host byte order:
+ *
+ *   header:  magic, version, cluster/database/table ids, table name,
+ *            column types, lengths and inlining, tuple length, and the
+ *            CRC32C of the header
+ *   chunks:  tuple count, heap length, the raw tuples, then the
+ *            non-inlined values of those tuples in VoltTable wire format
+ *   trailer: an empty chunk, the total tuple count and the CRC32C of all
+ *            chunk bytes
+ *
+ * No chunk holds more tuples than fit in one block. Images are meant to be
+ * read back by the same build on the same architecture. All I/O errors and
+ * damaged images are reported with a SerializableEEException.
+ */
+class TableImage {
+  public:
+    /**
+     * Open the image at path. For writing, the file is created or
+     * truncated, and removed again if the image is never finished.
+     */
+    TableImage(const std::string &path, bool forWrite);
+    ~TableImage();
+
+    void writeHeader(int32_t clusterId, int32_t databaseId, int32_t tableId,
+                     const std::string &tableName, const TupleSchema *schema);
+    void readHeader();
+
+    /** Throw unless tuples of schema are laid out exactly like the image's */
+    void checkSchema(const TupleSchema *schema) const;
+
+    void writeChunkHeader(uint32_t tupleCount, uint32_t heapLength);
+    /** Returns the chunk's tuple count, 0 once the chunks are exhausted */
+    uint32_t readChunkHeader(uint32_t &heapLength);
+
+    void write(const void *data, size_t length);
+    void read(void *data, size_t length);
+
+    /** Write the trailer and make the image durable */
+    void finish(int64_t tupleCount);
+    /** Read the trailer and throw if the chunks don't add up to it */
+    void verifyTrailer(int64_t tupleCount);
+
+    int32_t clusterId() const { return m_clusterId; }
+    int32_t databaseId() const { return m_databaseId; }
+    int32_t tableId() const { return m_tableId; }
+    const std::string &tableName() const { return m_tableName; }
+    const std::string &path() const { return m_path; }
+
+  private:
+    // no copy, no assignment
+    TableImage(TableImage const&);
+    TableImage operator=(TableImage const&);
+
+    struct ColumnLayout {
+        int8_t m_type;
+        int8_t m_inlined;
+        int32_t m_length;
+    };
+
+    void writeRaw(const void *data, size_t length);
+    void readRaw(void *data, size_t length);
+    void flush();
+    void writeChecksum();
+    void verifyChecksum(const char *section);
+
+    std::string m_path;
+    int m_fd;
+    bool m_forWrite;
+    bool m_finished;
+    uint32_t m_crc;
+    // Small writes are gathered here, large ones go straight to the file
+    std::vector<char> m_buffer;
+    size_t m_buffered;
+
+    int32_t m_clusterId;
+    int32_t m_databaseId;
+    int32_t m_tableId;
+    std::string m_tableName;
+    uint32_t m_tupleLength;
+    std::vector<ColumnLayout> m_columns;
+};
+
+}
+
+#endif /* TABLEIMAGE_H_ */
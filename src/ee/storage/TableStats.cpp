@@ -36,6 +36,10 @@ vector<string> TableStats::generateTableStatsColumnNames() {
     columnNames.push_back("TUPLE_ALLOCATED_MEMORY");
     columnNames.push_back("TUPLE_DATA_MEMORY");
     columnNames.push_back("STRING_DATA_MEMORY");
+    columnNames.push_back("COMPACTED_BLOCKS");
+    columnNames.push_back("COMPACTED_TUPLES");
+    columnNames.push_back("FORCED_COMPACTIONS");
+    columnNames.push_back("COMPACTION_TIME");
     return columnNames;
 }
 
@@ -50,6 +54,10 @@ void TableStats::populateTableStatsSchema(
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT)); allowNull.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT)); allowNull.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT)); allowNull.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT)); allowNull.push_back(false);
 }
 
 Table*
@@ -169,6 +177,12 @@ void TableStats::updateStatsTuple(TableTuple *tuple) {
     tuple->setNValue( StatsSource::m_columnName2Index["STRING_DATA_MEMORY"],
                       ValueFactory::
                       getIntegerValue(static_cast<int32_t>(string_data_mem_kb)));
+
+    // Only persistent tables compact, PersistentTableStats fills these in
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTED_BLOCKS"], ValueFactory::getBigIntValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTED_TUPLES"], ValueFactory::getBigIntValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["FORCED_COMPACTIONS"], ValueFactory::getBigIntValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTION_TIME"], ValueFactory::getBigIntValue(0));
 }
 
 /**
@@ -0,0 +1,88 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/TempBlockPool.h"
+#include "storage/TupleBlock.h"
+
+namespace voltdb {
+
+TempBlockPool::TempBlockPool(size_t capacity) :
+    m_capacity(capacity),
+    m_retainedBytes(0),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+TempBlockPool::~TempBlockPool()
+{
+    clear();
+}
+
+char* TempBlockPool::acquire(size_t size, bool &largePages)
+{
+    SizeClassMap::iterator sizeClass = m_sizeClasses.find(size);
+    if (sizeClass == m_sizeClasses.end() || sizeClass->second.empty()) {
+        m_misses++;
+        return NULL;
+    }
+    const FreeBlock block = sizeClass->second.back();
+    sizeClass->second.pop_back();
+    m_retainedBytes -= size;
+    m_hits++;
+    largePages = block.m_largePages;
+    return block.m_storage;
+}
+
+bool TempBlockPool::release(char *storage, size_t size, bool largePages)
+{
+    if (m_retainedBytes + size > m_capacity) {
+        return false;
+    }
+    FreeBlock block;
+    block.m_storage = storage;
+    block.m_largePages = largePages;
+    m_sizeClasses[size].push_back(block);
+    m_retainedBytes += size;
+    return true;
+}
+
+void TempBlockPool::setCapacity(size_t capacity)
+{
+    m_capacity = capacity;
+    trim(capacity);
+}
+
+void TempBlockPool::clear()
+{
+    trim(0);
+}
+
+void TempBlockPool::trim(size_t target)
+{
+    for (SizeClassMap::iterator sizeClass = m_sizeClasses.begin();
+         m_retainedBytes > target && sizeClass != m_sizeClasses.end(); ++sizeClass) {
+        std::vector<FreeBlock> &blocks = sizeClass->second;
+        while (m_retainedBytes > target && !blocks.empty()) {
+            TupleBlock::freeStorage(blocks.back().m_storage, sizeClass->first, blocks.back().m_largePages);
+            blocks.pop_back();
+            m_retainedBytes -= sizeClass->first;
+        }
+    }
+}
+
+}
@@ -0,0 +1,101 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEMPBLOCKPOOL_H_
+#define TEMPBLOCKPOOL_H_
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
+namespace voltdb {
+
+/**
+ * A free list of TupleBlock storage shared by all the TempTables of a site.
+ * Temp tables fill and drop blocks all the time: every fragment builds its
+ * intermediate results from scratch, and deleteAllTuples() keeps only the
+ * first block. Without the pool each of those blocks is a fresh aligned
+ * allocation of the table's block size, which for blocks this big means a
+ * mapping and an unmapping, and page faults on the way in.
+ *
+ * Storage is kept in size classes, one per allocation size, so blocks of
+ * tables with different tuple lengths don't mix. The pool retains at most
+ * capacity() bytes; storage returned beyond that is freed. One pool lives
+ * with each site's ThreadLocalPool, see ThreadLocalPool::getTempBlockPool().
+ */
+class TempBlockPool {
+  public:
+    /** Bytes retained unless told otherwise: 64 default sized blocks */
+    static const size_t DEFAULT_CAPACITY = 64 * 131072;
+
+    explicit TempBlockPool(size_t capacity = DEFAULT_CAPACITY);
+    /** Frees the retained storage */
+    ~TempBlockPool();
+
+    /**
+     * Storage of size bytes from the free list, or NULL if the size class
+     * is empty. largePages is set to whether it came from LargePages.
+     */
+    char* acquire(size_t size, bool &largePages);
+
+    /**
+     * Take back storage of size bytes. Returns false, leaving the storage
+     * to the caller, if retaining it would exceed the capacity.
+     */
+    bool release(char *storage, size_t size, bool largePages);
+
+    /** Change the capacity, freeing storage until the pool fits in it */
+    void setCapacity(size_t capacity);
+    size_t capacity() const { return m_capacity; }
+
+    /** Free all retained storage */
+    void clear();
+
+    size_t retainedBytes() const { return m_retainedBytes; }
+    int64_t hits() const { return m_hits; }
+    int64_t misses() const { return m_misses; }
+    /** Fraction of acquire() calls served from the free list */
+    double hitRate() const {
+        const int64_t requests = m_hits + m_misses;
+        return requests == 0 ? 0.0 : static_cast<double>(m_hits) / static_cast<double>(requests);
+    }
+
+  private:
+    // no copy, no assignment
+    TempBlockPool(TempBlockPool const&);
+    TempBlockPool operator=(TempBlockPool const&);
+
+    struct FreeBlock {
+        char *m_storage;
+        bool m_largePages;
+    };
+    typedef boost::unordered_map<size_t, std::vector<FreeBlock> > SizeClassMap;
+
+    /** Free storage until at most target bytes are retained */
+    void trim(size_t target);
+
+    SizeClassMap m_sizeClasses;
+    size_t m_capacity;
+    size_t m_retainedBytes;
+    int64_t m_hits;
+    int64_t m_misses;
+};
+
+}
+
+#endif /* TEMPBLOCKPOOL_H_ */
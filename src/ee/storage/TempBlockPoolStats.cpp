@@ -0,0 +1,125 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "storage/TempBlockPoolStats.h"
+#include "stats/StatsSource.h"
+#include "common/TupleSchema.h"
+#include "common/ids.h"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "common/ThreadLocalPool.h"
+#include "storage/tablefactory.h"
+#include "storage/TempBlockPool.h"
+#include <vector>
+#include <string>
+
+using namespace voltdb;
+using namespace std;
+
+vector<string> TempBlockPoolStats::generateTempBlockPoolStatsColumnNames() {
+    vector<string> columnNames = StatsSource::generateBaseStatsColumnNames();
+    columnNames.push_back("HITS");
+    columnNames.push_back("MISSES");
+    columnNames.push_back("RETAINED_MEMORY");
+    columnNames.push_back("CAPACITY");
+    columnNames.push_back("HIT_RATE");
+    return columnNames;
+}
+
+void TempBlockPoolStats::populateTempBlockPoolStatsSchema(
+        vector<ValueType> &types,
+        vector<int32_t> &columnLengths,
+        vector<bool> &allowNull) {
+    StatsSource::populateBaseSchema(types, columnLengths, allowNull);
+    // counts, then the retained memory and capacity in KB
+    for (int ii = 0; ii < 4; ii++) {
+        types.push_back(VALUE_TYPE_BIGINT); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT)); allowNull.push_back(false);
+    }
+    types.push_back(VALUE_TYPE_DOUBLE); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_DOUBLE)); allowNull.push_back(false);
+}
+
+Table*
+TempBlockPoolStats::generateEmptyTempBlockPoolStatsTable()
+{
+    string name = "Temp block pool stats temp table";
+    // An empty stats table isn't clearly associated with any specific
+    // database ID.  Just pick something that works for now.
+    CatalogId databaseId = 1;
+    vector<string> columnNames = TempBlockPoolStats::generateTempBlockPoolStatsColumnNames();
+    vector<ValueType> columnTypes;
+    vector<int32_t> columnLengths;
+    vector<bool> columnAllowNull;
+    TempBlockPoolStats::populateTempBlockPoolStatsSchema(columnTypes, columnLengths,
+                                                         columnAllowNull);
+    TupleSchema *schema =
+        TupleSchema::createTupleSchema(columnTypes, columnLengths,
+                                       columnAllowNull, true);
+
+    return
+        reinterpret_cast<Table*>(TableFactory::getTempTable(databaseId,
+                                                            name,
+                                                            schema,
+                                                            columnNames,
+                                                            NULL));
+}
+
+TempBlockPoolStats::TempBlockPoolStats()
+    : StatsSource(), m_lastHits(0), m_lastMisses(0)
+{
+}
+
+vector<string> TempBlockPoolStats::generateStatsColumnNames() {
+    return TempBlockPoolStats::generateTempBlockPoolStatsColumnNames();
+}
+
+/**
+ * Update the stats tuple with the latest statistics available to this StatsSource.
+ * The pool is the one of the calling thread's ThreadLocalPool, so this
+ * has to run on the site's thread.
+ */
+void TempBlockPoolStats::updateStatsTuple(TableTuple *tuple) {
+    const TempBlockPool *tempBlocks = ThreadLocalPool::getTempBlockPool();
+
+    int64_t hits = tempBlocks->hits();
+    int64_t misses = tempBlocks->misses();
+    if (interval()) {
+        hits -= m_lastHits;
+        misses -= m_lastMisses;
+        m_lastHits = tempBlocks->hits();
+        m_lastMisses = tempBlocks->misses();
+    }
+
+    tuple->setNValue(StatsSource::m_columnName2Index["HITS"],
+                     ValueFactory::getBigIntValue(hits));
+    tuple->setNValue(StatsSource::m_columnName2Index["MISSES"],
+                     ValueFactory::getBigIntValue(misses));
+    tuple->setNValue(StatsSource::m_columnName2Index["RETAINED_MEMORY"],
+                     ValueFactory::getBigIntValue(static_cast<int64_t>(tempBlocks->retainedBytes() / 1024)));
+    tuple->setNValue(StatsSource::m_columnName2Index["CAPACITY"],
+                     ValueFactory::getBigIntValue(static_cast<int64_t>(tempBlocks->capacity() / 1024)));
+    tuple->setNValue(StatsSource::m_columnName2Index["HIT_RATE"],
+                     ValueFactory::getDoubleValue(hits + misses == 0 ? 0.0 :
+                                                  100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses)));
+}
+
+void TempBlockPoolStats::populateSchema(
+        vector<ValueType> &types,
+        vector<int32_t> &columnLengths,
+        vector<bool> &allowNull) {
+    TempBlockPoolStats::populateTempBlockPoolStatsSchema(types, columnLengths, allowNull);
+}
@@ -0,0 +1,61 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEMPBLOCKPOOLSTATS_H_
+#define TEMPBLOCKPOOLSTATS_H_
+
+#include "stats/StatsSource.h"
+#include "common/ids.h"
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * StatsSource reporting how well the site's TempBlockPool recycles temp
+ * table blocks: acquires served from the free list and from the
+ * allocator, and what the pool holds against its capacity. There is one
+ * pool per site, so this is one row per site, registered under locator 0.
+ */
+class TempBlockPoolStats : public voltdb::StatsSource {
+public:
+    static std::vector<std::string> generateTempBlockPoolStatsColumnNames();
+
+    static void populateTempBlockPoolStatsSchema(std::vector<voltdb::ValueType>& types,
+                                                 std::vector<int32_t>& columnLengths,
+                                                 std::vector<bool>& allowNull);
+
+    static Table* generateEmptyTempBlockPoolStatsTable();
+
+    TempBlockPoolStats();
+
+protected:
+    virtual void updateStatsTuple(voltdb::TableTuple *tuple);
+
+    virtual std::vector<std::string> generateStatsColumnNames();
+
+    virtual void populateSchema(std::vector<voltdb::ValueType> &types, std::vector<int32_t> &columnLengths, std::vector<bool> &allowNull);
+
+private:
+    int64_t m_lastHits;
+    int64_t m_lastMisses;
+};
+
+}
+
+#endif /* TEMPBLOCKPOOLSTATS_H_ */
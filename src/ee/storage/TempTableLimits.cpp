@@ -28,7 +28,10 @@ TempTableLimits::TempTableLimits()
     : m_currMemoryInBytes(0),
       m_logThreshold(-1),
       m_memoryLimit(1024 * 1024 * 100),
-      m_logLatch(false)
+      m_logLatch(false),
+      m_spillThreshold(-1),
+      m_spillDirectory("/tmp"),
+      m_spilledBytes(0)
 {
 }
 
@@ -99,3 +102,40 @@ TempTableLimits::getMemoryLimit() const
 {
     return m_memoryLimit;
 }
+
+void
+TempTableLimits::setSpillThreshold(int64_t threshold, const std::string &directory)
+{
+    m_spillThreshold = threshold;
+    m_spillDirectory = directory;
+}
+
+int64_t
+TempTableLimits::getSpillThreshold() const
+{
+    return m_spillThreshold;
+}
+
+const std::string&
+TempTableLimits::getSpillDirectory() const
+{
+    return m_spillDirectory;
+}
+
+bool
+TempTableLimits::shouldSpill(int bytes) const
+{
+    return m_spillThreshold >= 0 && m_currMemoryInBytes + bytes > m_spillThreshold;
+}
+
+void
+TempTableLimits::recordSpill(int bytes)
+{
+    m_spilledBytes += bytes;
+}
+
+int64_t
+TempTableLimits::getSpilledBytes() const
+{
+    return m_spilledBytes;
+}
@@ -19,6 +19,7 @@
 #define _EE_STORAGE_TEMPTABLELIMITS_H_
 
 #include <stdint.h>
+#include <string>
 
 namespace voltdb
 {
@@ -47,6 +48,21 @@ namespace voltdb
         void setMemoryLimit(int64_t limit);
         int64_t getMemoryLimit() const;
 
+        /**
+         * Once the temp tables hold more than threshold bytes, a TempTable
+         * that needs another block writes its full blocks to a scratch
+         * file in directory and reuses one of them instead. A negative
+         * threshold disables spilling, leaving the memory limit to throw.
+         */
+        void setSpillThreshold(int64_t threshold, const std::string &directory);
+        int64_t getSpillThreshold() const;
+        const std::string &getSpillDirectory() const;
+        /** True if allocating bytes more would cross the spill threshold */
+        bool shouldSpill(int bytes) const;
+        void recordSpill(int bytes);
+        /** Bytes of tuples written to scratch files, ever */
+        int64_t getSpilledBytes() const;
+
     private:
         // The current amount of memory used by temp tables for this
         // plan fragment
@@ -61,6 +77,12 @@ namespace voltdb
         // True if we have already generated a log message for
         // exceeding the log threshold and not yet dropped below it.
         bool m_logLatch;
+        // The memory allocation above which temp tables spill their
+        // blocks to scratch files in m_spillDirectory.  A negative value
+        // disables spilling.
+        int64_t m_spillThreshold;
+        std::string m_spillDirectory;
+        int64_t m_spilledBytes;
     };
 }
 
@@ -0,0 +1,102 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/TempTableSpill.h"
+#include "common/SerializableEEException.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace voltdb {
+
+static void throwSpillException(const std::string &path, const char *what, int error)
+{
+    char msg[1024];
+    snprintf(msg, sizeof(msg), "Temp table spill file %s: %s: %s", path.c_str(), what, strerror(error));
+    throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION, msg);
+}
+
+TempTableSpill::TempTableSpill(const std::string &directory, uint32_t tupleLength,
+                               uint32_t tuplesPerBlock) :
+    m_path(directory + "/voltdb-temp-spill-XXXXXX"),
+    m_fd(-1),
+    m_tupleLength(tupleLength),
+    m_tuplesPerBlock(tuplesPerBlock),
+    m_end(0),
+    m_tupleCount(0)
+{
+    std::vector<char> path(m_path.begin(), m_path.end());
+    path.push_back('\0');
+    m_fd = ::mkstemp(&path[0]);
+    if (m_fd == -1) {
+        throwSpillException(m_path, "unable to create", errno);
+    }
+    m_path = &path[0];
+    ::unlink(m_path.c_str());
+}
+
+TempTableSpill::~TempTableSpill()
+{
+    ::close(m_fd);
+}
+
+void TempTableSpill::writeBlock(const char *tuples, uint32_t tupleCount)
+{
+    const size_t length = static_cast<size_t>(tupleCount) * m_tupleLength;
+    size_t written = 0;
+    while (written < length) {
+        ssize_t rc = ::pwrite(m_fd, tuples + written, length - written,
+                              m_end + static_cast<off_t>(written));
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            throwSpillException(m_path, "write failed", errno);
+        }
+        written += rc;
+    }
+    SpilledBlock block;
+    block.m_offset = m_end;
+    block.m_tupleCount = tupleCount;
+    m_blocks.push_back(block);
+    m_end += static_cast<off_t>(length);
+    m_tupleCount += tupleCount;
+}
+
+uint32_t TempTableSpill::readBlock(size_t index, char *buffer) const
+{
+    const SpilledBlock &block = m_blocks[index];
+    const size_t length = static_cast<size_t>(block.m_tupleCount) * m_tupleLength;
+    size_t bytesRead = 0;
+    while (bytesRead < length) {
+        ssize_t rc = ::pread(m_fd, buffer + bytesRead, length - bytesRead,
+                             block.m_offset + static_cast<off_t>(bytesRead));
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            throwSpillException(m_path, "read failed", rc == 0 ? EIO : errno);
+        }
+        bytesRead += rc;
+    }
+    return block.m_tupleCount;
+}
+
+}
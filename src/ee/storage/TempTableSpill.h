@@ -0,0 +1,77 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEMPTABLESPILL_H_
+#define TEMPTABLESPILL_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace voltdb {
+
+/**
+ * The scratch file a TempTable moves its full blocks to once the temp
+ * tables of its fragment hold more than TempTableLimits' spill threshold.
+ * Blocks are written as the raw images of their tuples and read back in
+ * the order they were written, one block at a time, by TableIterator.
+ * Non-inlined values aren't written: the tuples keep pointing at strings
+ * owned by a persistent table or a pool, exactly as they did in memory.
+ *
+ * The file is unlinked as soon as it is created, so it goes away with the
+ * TempTable or the process. I/O errors are reported with a
+ * SerializableEEException.
+ */
+class TempTableSpill {
+  public:
+    TempTableSpill(const std::string &directory, uint32_t tupleLength, uint32_t tuplesPerBlock);
+    ~TempTableSpill();
+
+    void writeBlock(const char *tuples, uint32_t tupleCount);
+    /**
+     * Read the index'th block written into buffer, which must hold
+     * blockBytes(). Returns the number of tuples read.
+     */
+    uint32_t readBlock(size_t index, char *buffer) const;
+
+    size_t blockCount() const { return m_blocks.size(); }
+    size_t blockBytes() const { return static_cast<size_t>(m_tupleLength) * m_tuplesPerBlock; }
+    int64_t tupleCount() const { return m_tupleCount; }
+
+  private:
+    // no copy, no assignment
+    TempTableSpill(TempTableSpill const&);
+    TempTableSpill operator=(TempTableSpill const&);
+
+    struct SpilledBlock {
+        off_t m_offset;
+        uint32_t m_tupleCount;
+    };
+
+    std::string m_path;
+    int m_fd;
+    const uint32_t m_tupleLength;
+    const uint32_t m_tuplesPerBlock;
+    off_t m_end;
+    int64_t m_tupleCount;
+    std::vector<SpilledBlock> m_blocks;
+};
+
+}
+
+#endif /* TEMPTABLESPILL_H_ */
@@ -18,13 +18,60 @@
 #include "storage/table.h"
 #include <sys/mman.h>
 #include <errno.h>
+#include <stdlib.h>
 #include "common/ThreadLocalPool.h"
+#include "common/LargePages.h"
+#include "storage/TempBlockPool.h"
 
 namespace voltdb {
 
 volatile int tupleBlocksAllocated = 0;
 
-TupleBlock::TupleBlock(Table *table, TBBucketPtr bucket) :
+char* TupleBlock::allocateStorage(size_t allocationSize, bool largePages) {
+    if (largePages) {
+        return LargePages::allocate(allocationSize, allocationSize);
+    }
+#ifdef USE_MMAP
+    // Map twice the size and trim it to an aligned window
+    char *mapping = static_cast<char*>(::mmap( 0, allocationSize * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 ));
+    if (mapping == MAP_FAILED) {
+        std::cout << strerror( errno ) << std::endl;
+        throwFatalException("Failed mmap");
+    }
+    char *allocation = reinterpret_cast<char*>(
+            (reinterpret_cast<uintptr_t>(mapping) + allocationSize - 1) & ~static_cast<uintptr_t>(allocationSize - 1));
+    if (allocation != mapping) {
+        ::munmap(mapping, allocation - mapping);
+    }
+    ::munmap(allocation + allocationSize, mapping + allocationSize - allocation);
+    return allocation;
+#else
+    void *memory = NULL;
+    const int error = ::posix_memalign(&memory, allocationSize, allocationSize);
+    if (error != 0) {
+        std::cout << strerror( error ) << std::endl;
+        throwFatalException("Failed to allocate a tuple block");
+    }
+    return static_cast<char*>(memory);
+#endif
+}
+
+void TupleBlock::freeStorage(char *allocation, size_t allocationSize, bool largePages) {
+    if (largePages) {
+        LargePages::free(allocation, allocationSize);
+        return;
+    }
+#ifdef USE_MMAP
+    if (::munmap( allocation, allocationSize) != 0) {
+        std::cout << strerror( errno ) << std::endl;
+        throwFatalException("Failed munmap");
+    }
+#else
+    ::free(allocation);
+#endif
+}
+
+TupleBlock::TupleBlock(Table *table, TBBucketPtr bucket, bool pooled) :
         m_references(0),
         m_table(table),
         m_storage(NULL),
@@ -34,22 +81,26 @@ TupleBlock::TupleBlock(Table *table, TBBucketPtr bucket) :
         m_nextFreeTuple(0),
         m_lastCompactionOffset(0),
         m_tuplesPerBlockDivNumBuckets(m_tuplesPerBlock / static_cast<double>(TUPLE_BLOCK_NUM_BUCKETS)),
+        m_usedSlots(new uint64_t[bitmapWords()]),
+        m_firstFreeWord(0),
+        m_largePages(LargePages::useFor(table->m_tableAllocationSize)),
+        m_pooled(pooled),
         m_bucketIndex(0),
-        m_bucket(bucket) {
-#ifdef MEMCHECK
-    m_storage = new char[table->m_tableAllocationSize];
-#else
-#ifdef USE_MMAP
-    m_storage = static_cast<char*>(::mmap( 0, table->m_tableAllocationSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 ));
-    if (m_storage == MAP_FAILED) {
-        std::cout << strerror( errno ) << std::endl;
-        throwFatalException("Failed mmap");
+        m_bucket(bucket),
+        m_referenced(true), // new blocks survive the first pass of the clock hand
+        m_accessSamples(0) {
+    const size_t allocationSize = table->m_tableAllocationSize;
+    char *allocation = NULL;
+    TempBlockPool *pool = pooled ? ThreadLocalPool::getTempBlockPool() : NULL;
+    if (pool != NULL) {
+        allocation = pool->acquire(allocationSize, m_largePages);
     }
-#else
-    //m_storage = static_cast<char*>(ThreadLocalPool::getExact(m_table->m_tableAllocationSize)->malloc());
-    m_storage = new char[table->m_tableAllocationSize];
-#endif
-#endif
+    if (allocation == NULL) {
+        allocation = allocateStorage(allocationSize, m_largePages);
+    }
+    *reinterpret_cast<TupleBlock**>(static_cast<void*>(allocation)) = this;
+    m_storage = allocation + TUPLE_BLOCK_HEADER_SIZE;
+    ::memset(m_usedSlots.get(), 0, bitmapWords() * sizeof(uint64_t));
     tupleBlocksAllocated++;
 }
 
@@ -59,18 +110,14 @@ TupleBlock::~TupleBlock() {
       std::cout << "Destructing tuple block " << static_cast<void*>(this)
                 << " with " << tupleBlocksAllocated << " left " << std::endl;
     */
-#ifdef MEMCHECK
-    delete []m_storage;
-#else
-#ifdef USE_MMAP
-    if (::munmap( m_storage, m_table->m_tableAllocationSize) != 0) {
-        std::cout << strerror( errno ) << std::endl;
-        throwFatalException("Failed munmap");
+    char *allocation = m_storage - TUPLE_BLOCK_HEADER_SIZE;
+    const size_t allocationSize = m_table->m_tableAllocationSize;
+    // The pool may already be gone if the block outlives its site
+    TempBlockPool *pool = m_pooled ? ThreadLocalPool::getTempBlockPool() : NULL;
+    if (pool != NULL && pool->release(allocation, allocationSize, m_largePages)) {
+        return;
     }
-#else
-    delete []m_storage;
-#endif
-#endif
+    freeStorage(allocation, allocationSize, m_largePages);
 }
 
 std::pair<int, int> TupleBlock::merge(Table *table, TBPtr source) {
@@ -90,9 +137,11 @@ std::pair<int, int> TupleBlock::merge(Table *table, TBPtr source) {
         TableTuple destinationTuple(table->schema());
 
         bool foundSourceTuple = false;
-        //Iterate further into the block looking for active tuples
+        //Iterate further into the block looking for active tuples, skipping free slots
         //Stop when running into the unused tuple boundry
-        while (m_nextTupleInSourceOffset < source->unusedTupleBoundry()) {
+        for (m_nextTupleInSourceOffset = source->nextUsedSlot(m_nextTupleInSourceOffset);
+             m_nextTupleInSourceOffset < source->unusedTupleBoundry();
+             m_nextTupleInSourceOffset = source->nextUsedSlot(m_nextTupleInSourceOffset)) {
             sourceTupleWithNewValues.move(&source->address()[m_tupleLength * m_nextTupleInSourceOffset]);
             m_nextTupleInSourceOffset++;
             if (sourceTupleWithNewValues.isActive()) {
@@ -126,6 +175,10 @@ std::pair<int, int> TupleBlock::merge(Table *table, TBPtr source) {
     }
     source->lastCompactionOffset(m_nextTupleInSourceOffset);
 
+    // The moved tuples bring their block's hotness with them
+    m_referenced = m_referenced || source->m_referenced;
+    m_accessSamples += source->m_accessSamples;
+
     int newBucketIndex = calculateBucketIndex();
     if (newBucketIndex != m_bucketIndex) {
         m_bucketIndex = newBucketIndex;
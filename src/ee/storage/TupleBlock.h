@@ -46,31 +46,6 @@ void intrusive_ptr_release(voltdb::TupleBlock * p);
 namespace voltdb {
 class Table;
 
-class TruncatedInt {
-public:
-    TruncatedInt(uint32_t value) {
-        ::memcpy(m_data, reinterpret_cast<char*>(&value), 3);
-    }
-
-    TruncatedInt(const TruncatedInt &other) {
-        ::memcpy(m_data, other.m_data, 3);
-    }
-
-    TruncatedInt& operator=(const TruncatedInt&rhs) {
-        ::memcpy(m_data, rhs.m_data, 3);
-        return *this;
-    }
-
-    uint32_t unpack() {
-        char valueBytes[4];
-        ::memcpy(valueBytes, m_data, 3);
-        valueBytes[3] = 0;
-        return *reinterpret_cast<int32_t*>(valueBytes);
-    }
-private:
-    char m_data[3];
-};
-
 //typedef boost::shared_ptr<TupleBlock> TBPtr;
 typedef boost::intrusive_ptr<TupleBlock> TBPtr;
 //typedef TupleBlock* TBPtr;
@@ -81,12 +56,26 @@ typedef TBBucket::iterator TBBucketI;
 typedef boost::shared_ptr<TBBucket> TBBucketPtr;
 typedef std::vector<TBBucketPtr> TBBucketMap;
 const int TUPLE_BLOCK_NUM_BUCKETS = 20;
+/*
+ * Block storage is aligned to its allocation size (a power of two) and
+ * starts with this many bytes holding a pointer back to the TupleBlock.
+ * The tuples follow, still on a cache line boundary.
+ */
+const int TUPLE_BLOCK_HEADER_SIZE = 64;
 
 class TupleBlock {
     friend void ::intrusive_ptr_add_ref(voltdb::TupleBlock * p);
     friend void ::intrusive_ptr_release(voltdb::TupleBlock * p);
 public:
-    TupleBlock(Table *table, TBBucketPtr bucket);
+    /**
+     * Pooled blocks take their storage from the site's TempBlockPool and
+     * give it back when they are destroyed. TempTables use them.
+     */
+    TupleBlock(Table *table, TBBucketPtr bucket, bool pooled = false);
+
+    /** Aligned block storage, from LargePages if largePages */
+    static char* allocateStorage(size_t allocationSize, bool largePages);
+    static void freeStorage(char *allocation, size_t allocationSize, bool largePages);
 
     double loadFactor() {
         return m_activeTuples / m_tuplesPerBlock;
@@ -143,17 +132,16 @@ public:
     std::pair<int, int> merge(Table *table, TBPtr source);
 
     inline std::pair<char*, int> nextFreeTuple() {
-        char *retval = NULL;
-        if (!m_freeList.empty()) {
+        uint32_t slot;
+        if (m_activeTuples < m_nextFreeTuple) {
+            // Fill the lowest hole first so the block stays dense at the front
             m_lastCompactionOffset = 0;
-            retval = m_storage;
-            TruncatedInt offset = m_freeList.back();
-            m_freeList.pop_back();
-            retval += offset.unpack();
+            slot = firstFreeSlot();
         } else {
-            retval = &(m_storage[m_tupleLength * m_nextFreeTuple]);
-            m_nextFreeTuple++;
+            slot = m_nextFreeTuple++;
         }
+        m_usedSlots[slot >> 6] |= 1ULL << (slot & 63);
+        char *retval = &(m_storage[m_tupleLength * slot]);
         m_activeTuples++;
         int newBucketIndex = calculateBucketIndex();
         if (newBucketIndex != m_bucketIndex) {
@@ -177,9 +165,12 @@ public:
     inline int freeTuple(char *tupleStorage) {
         m_lastCompactionOffset = 0;
         m_activeTuples--;
-        //Find the offset
-        uint32_t offset = static_cast<uint32_t>(tupleStorage - m_storage);
-        m_freeList.push_back(offset);
+        const uint32_t slot = static_cast<uint32_t>(tupleStorage - m_storage) / m_tupleLength;
+        assert(m_usedSlots[slot >> 6] & (1ULL << (slot & 63)));
+        m_usedSlots[slot >> 6] &= ~(1ULL << (slot & 63));
+        if ((slot >> 6) < m_firstFreeWord) {
+            m_firstFreeWord = slot >> 6;
+        }
         int newBucketIndex = calculateBucketIndex();
         if (newBucketIndex != m_bucketIndex) {
             m_bucketIndex = newBucketIndex;
@@ -189,14 +180,56 @@ public:
         }
     }
 
+    /**
+     * The first slot at or after slot that holds a tuple, or
+     * unusedTupleBoundry() if there is none. Free slots are skipped a
+     * word of the occupancy bitmap at a time.
+     */
+    inline uint32_t nextUsedSlot(uint32_t slot) const {
+        if (slot >= m_nextFreeTuple) {
+            return m_nextFreeTuple;
+        }
+        uint32_t word = slot >> 6;
+        const uint32_t lastWord = (m_nextFreeTuple - 1) >> 6;
+        uint64_t bits = m_usedSlots[word] & (~0ULL << (slot & 63));
+        while (bits == 0) {
+            if (++word > lastWord) {
+                return m_nextFreeTuple;
+            }
+            bits = m_usedSlots[word];
+        }
+        return (word << 6) + __builtin_ctzll(bits);
+    }
+
     inline char * address() {
         return m_storage;
     }
 
+    /** The block's PAX minipages, NULL unless the table has a MinipageLayout */
+    inline char * minipages() {
+        return m_minipages.get();
+    }
+
+    inline void allocateMinipages(uint32_t bytes) {
+        m_minipages.reset(new char[bytes]);
+    }
+
+    /**
+     * The block holding tuple, found by masking the tuple's address down to
+     * the start of the block's aligned storage and reading the back pointer
+     * there. allocationSize is the table's m_tableAllocationSize.
+     */
+    static inline TupleBlock* owner(const char *tuple, uint32_t allocationSize) {
+        assert((allocationSize & (allocationSize - 1)) == 0);
+        const uintptr_t base = reinterpret_cast<uintptr_t>(tuple) & ~static_cast<uintptr_t>(allocationSize - 1);
+        return *reinterpret_cast<TupleBlock* const*>(base);
+    }
+
     inline void reset() {
+        ::memset(m_usedSlots.get(), 0, bitmapWords() * sizeof(uint64_t));
+        m_firstFreeWord = 0;
         m_activeTuples = 0;
         m_nextFreeTuple = 0;
-        m_freeList.clear();
     }
 
     inline uint32_t unusedTupleBoundry() {
@@ -220,7 +253,47 @@ public:
     inline TBBucketPtr currentBucket() {
         return m_bucket;
     }
+
+    /** Cold Storage block policy: a sampled access landed in this block */
+    inline void recordAccess() {
+        m_referenced = true;
+        m_accessSamples++;
+    }
+
+    inline bool referenced() const {
+        return m_referenced;
+    }
+
+    inline uint32_t accessSamples() const {
+        return m_accessSamples;
+    }
+
+    /**
+     * The clock hand passed the block: give it another revolution to be
+     * referenced again, and halve its samples so old hotness fades.
+     */
+    inline void ageAccess() {
+        m_referenced = false;
+        m_accessSamples >>= 1;
+    }
 private:
+    inline uint32_t bitmapWords() const {
+        return (m_tuplesPerBlock + 63) >> 6;
+    }
+
+    /**
+     * The lowest free slot. Only called when there is a hole below
+     * m_nextFreeTuple, so the scan always stops before running past it.
+     */
+    inline uint32_t firstFreeSlot() {
+        uint32_t word = m_firstFreeWord;
+        while (m_usedSlots[word] == ~0ULL) {
+            ++word;
+        }
+        m_firstFreeWord = word;
+        return (word << 6) + __builtin_ctzll(~m_usedSlots[word]);
+    }
+
     uint32_t m_references;
     Table* m_table;
     char*   m_storage;
@@ -232,16 +305,27 @@ private:
     const double m_tuplesPerBlockDivNumBuckets;
 
     /*
-     * queue of offsets to <b>once used and then deleted</b> tuples.
-     * Tuples after m_nextFreeTuple are also free, this queue
-     * is used to find "hole" tuples which were once used (before used_tuples index)
-     * and also deleted.
-     * NOTE THAT THESE ARE NOT THE ONLY FREE TUPLES.
+     * One bit per slot, set while the slot holds a tuple. Slots at or past
+     * m_nextFreeTuple have never been used and their bits are clear.
+     * Every word below m_firstFreeWord is full.
      **/
-    std::deque<TruncatedInt, FastAllocator<TruncatedInt> > m_freeList;
+    boost::scoped_array<uint64_t> m_usedSlots;
+    uint32_t m_firstFreeWord;
+
+    // Storage came from LargePages::allocate()
+    bool m_largePages;
+    // Storage goes back to the TempBlockPool
+    bool m_pooled;
+
+    // Copies of the table's MinipageLayout columns, column-major by slot
+    boost::scoped_array<char> m_minipages;
 
     int m_bucketIndex;
     TBBucketPtr m_bucket;
+
+    // Cold Storage block policy hotness
+    bool m_referenced;
+    uint32_t m_accessSamples;
 };
 
 }
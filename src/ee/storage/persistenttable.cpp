@@ -60,6 +60,7 @@
 #include "common/RecoveryProtoMessage.h"
 #include "indexes/tableindex.h"
 #include "indexes/tableindexfactory.h"
+#include "indexes/IndexBuilder.h"
 #include "logging/LogManager.h"
 #include "storage/table.h"
 #include "storage/tableiterator.h"
@@ -68,13 +69,19 @@
 #include "storage/PersistentTableStats.h"
 #include "storage/PersistentTableUndoInsertAction.h"
 #include "storage/PersistentTableUndoDeleteAction.h"
+#include "storage/PersistentTableUndoDeleteEvictedAction.h"
 #include "storage/PersistentTableUndoUpdateAction.h"
 #include "storage/ConstraintFailureException.h"
 #include "storage/MaterializedViewMetadata.h"
 #include "storage/CopyOnWriteContext.h"
+#include "storage/TableImage.h"
 #include "storage/tableiterator.h"
+#include "storage/EvictedTupleIterator.h"
+#include "storage/temptable.h"
+#include "storage/tablefactory.h"
 
 #include <algorithm>    // std::find
+#include <cstring>
 
 using namespace voltdb;
 
@@ -89,9 +96,22 @@ PersistentTable::PersistentTable(int partitionColumn) :
     m_allowNulls(),
     m_partitionColumn(partitionColumn),
     stats_(this),
+    m_coldStorageStats(this),
     m_COWContext(NULL),
+    m_antiCacheDB(NULL),
+    m_evictedTupleCount(0),
+    m_evictedByteCount(0),
+    m_evictionClockHand(NULL),
+    m_csiAgingPending(false),
+    m_csiAgingRequeued(false),
+    m_csiAgingHand(NULL),
     m_failedCompactionCount(0),
-    m_tuplesPendingDeleteCount(0)
+    m_compactedBlockCount(0),
+    m_compactedTupleCount(0),
+    m_forcedCompactionCount(0),
+    m_compactionMicros(0),
+    m_tuplesPendingDeleteCount(0),
+    m_bulkLoading(false)
 {
     for (int ii = 0; ii < TUPLE_BLOCK_NUM_BUCKETS; ii++) {
         m_blocksNotPendingSnapshotLoad.push_back(TBBucketPtr(new TBBucket()));
@@ -114,12 +134,22 @@ PersistentTable::~PersistentTable()
         tuple.setActiveFalse();
     }
 
+    // evicted tuples die with the table
+    BOOST_FOREACH(EvictedBlockMap::value_type &evicted, m_evictedBlocks) {
+        BOOST_FOREACH(EvictedTupleTombstone *tombstone, evicted.second) {
+            ThreadLocalPool::getExact(sizeof(EvictedTupleTombstone))->free(tombstone);
+        }
+        m_antiCacheDB->releaseBlock(evicted.first);
+    }
+
     // note this class has ownership of the views, even if they
     // were allocated by VoltDBEngine
     for (int i = 0; i < m_views.size(); i++) {
         delete m_views[i];
     }
 
+    // the tuples have let go of the shared strings
+    freeDictionaries();
 }
 
 // ------------------------------------------------------------------
@@ -194,12 +224,36 @@ void PersistentTable::nextFreeTuple(TableTuple *tuple) {
 }
 
 void PersistentTable::deleteAllTuples(bool freeAllocatedStrings) {
-    // nothing interesting
     TableIterator ti(this, m_data.begin());
     TableTuple tuple(m_schema);
     while (ti.next(tuple)) {
         deleteTuple(tuple, true);
     }
+    deleteEvictedTuples(true);
+}
+
+void PersistentTable::addIndexes(const std::vector<TableIndex*> &indexes) {
+    BOOST_FOREACH(TableIndex *index, indexes) {
+        if ( ! indexCanHoldTombstones(index)) {
+            unevictAll();
+            break;
+        }
+    }
+    // The indexes are filled from a scan of the resident tuples, so the
+    // evicted ones are read from the anti-cache and given tombstone entries.
+    Table::addIndexes(indexes);
+    EvictedTupleIterator evicted(this);
+    TableTuple tuple(m_schema);
+    while (evicted.next(tuple)) {
+        BOOST_FOREACH(TableIndex *index, indexes) {
+            // a unique index keeps the first tuple of a duplicated key
+            if (index->addEntry(&tuple) &&
+                ! index->replaceEntryAddress(tuple, tuple.address(), evicted.tombstone())) {
+                throwFatalException("Failed to point new index %s of Table %s at an evicted tuple's tombstone",
+                                    index->getName().c_str(), m_name.c_str());
+            }
+        }
+    }
 }
 
 void setSearchKeyFromTuple(TableTuple &source) {
@@ -238,6 +292,7 @@ void PersistentTable::insertPersistentTuple(TableTuple &source, bool fallible)
     // Then copy the source into the target
     //
     target.copyForPersistentInsert(source); // tuple in freelist must be already cleared
+    storeMinipageColumns(target);
     if (m_schema->getUninlinedObjectColumnCount() != 0) {
         increaseStringMemCount(target.getNonInlinedMemorySize());
     }
@@ -389,7 +444,6 @@ bool PersistentTable::updateTupleWithSpecificIndexes(TableTuple &targetTupleToUp
 
     if (m_schema->getUninlinedObjectColumnCount() != 0) {
         decreaseStringMemCount(targetTupleToUpdate.getNonInlinedMemorySize());
-        increaseStringMemCount(sourceTupleWithNewValues.getNonInlinedMemorySize());
     }
 
     // TODO: This is a little messed up.
@@ -416,6 +470,11 @@ bool PersistentTable::updateTupleWithSpecificIndexes(TableTuple &targetTupleToUp
 
     // this is the actual write of the new values
     targetTupleToUpdate.copyForPersistentUpdate(sourceTupleWithNewValues, oldObjects, newObjects);
+    storeMinipageColumns(targetTupleToUpdate);
+    // measured after the copy, which may have shared the new strings
+    if (m_schema->getUninlinedObjectColumnCount() != 0) {
+        increaseStringMemCount(targetTupleToUpdate.getNonInlinedMemorySize());
+    }
 
     if (uq) {
         /*
@@ -499,6 +558,7 @@ void PersistentTable::updateTupleForUndo(char* tupleWithUnwantedValues,
     bool dirty = targetTupleToUpdate.isDirty();
     // this is the actual in-place revert to the old version
     targetTupleToUpdate.copy(sourceTupleWithNewValues);
+    storeMinipageColumns(targetTupleToUpdate);
     if (dirty) {
         targetTupleToUpdate.setDirtyTrue();
     } else {
@@ -859,6 +919,8 @@ void PersistentTable::onSetColumns() {
  * memory tracking
  */
 void PersistentTable::processLoadedTuple(TableTuple &tuple) {
+    shareLoadedStrings(tuple);
+    storeMinipageColumns(tuple);
 
     // not null checks at first
     FAIL_IF(!checkNulls(tuple)) {
@@ -866,14 +928,19 @@ void PersistentTable::processLoadedTuple(TableTuple &tuple) {
                                          CONSTRAINT_TYPE_NOT_NULL);
     }
 
-    if (!tryInsertOnAllIndexes(&tuple)) {
-        throw ConstraintFailureException(this, tuple, TableTuple(),
-                                         CONSTRAINT_TYPE_UNIQUE);
-    }
+    if (m_bulkLoading) {
+        // indexed along with the rest by finishLoadingTuples()
+        m_bulkLoadedTuples.push_back(tuple.address());
+    } else {
+        if (!tryInsertOnAllIndexes(&tuple)) {
+            throw ConstraintFailureException(this, tuple, TableTuple(),
+                                             CONSTRAINT_TYPE_UNIQUE);
+        }
 
-    // handle any materialized views
-    for (int i = 0; i < m_views.size(); i++) {
-        m_views[i]->processTupleInsert(tuple, true);
+        // handle any materialized views
+        for (int i = 0; i < m_views.size(); i++) {
+            m_views[i]->processTupleInsert(tuple, true);
+        }
     }
 
     // Account for non-inlined memory allocated via bulk load or recovery
@@ -883,6 +950,73 @@ void PersistentTable::processLoadedTuple(TableTuple &tuple) {
     }
 }
 
+void PersistentTable::beginLoadingTuples(int tupleCount) {
+    m_bulkLoading = m_tupleCount == 0 && m_evictedTupleCount == 0 && m_COWContext == NULL;
+    if (m_bulkLoading) {
+        m_bulkLoadedTuples.reserve(tupleCount);
+    }
+}
+
+void PersistentTable::finishLoadingTuples() {
+    if (!m_bulkLoading) {
+        return;
+    }
+    m_bulkLoading = false;
+    std::vector<char*> loaded;
+    loaded.swap(m_bulkLoadedTuples);
+
+    TableTuple tuple(m_schema);
+    IndexBuilder builder(m_indexes, loaded);
+    if (builder.build(tuple) != NULL) {
+        // the exception keeps a pointer to the duplicate, so copy it out
+        // of the blocks before they are released
+        if (m_schema->getUninlinedObjectColumnCount() != 0) {
+            m_tempTuple.copyForPersistentInsert(tuple, ExecutorContext::getTempStringPool());
+        } else {
+            m_tempTuple.copy(tuple);
+        }
+        discardLoadedTuples(loaded);
+        throw ConstraintFailureException(this, m_tempTuple, TableTuple(),
+                                         CONSTRAINT_TYPE_UNIQUE);
+    }
+    for (int i = 0; i < m_views.size(); i++) {
+        for (size_t ii = 0; ii < loaded.size(); ii++) {
+            tuple.move(loaded[ii]);
+            m_views[i]->processTupleInsert(tuple, true);
+        }
+    }
+}
+
+void PersistentTable::abortLoadingTuples() {
+    if (!m_bulkLoading) {
+        return;
+    }
+    m_bulkLoading = false;
+    std::vector<char*> loaded;
+    loaded.swap(m_bulkLoadedTuples);
+    discardLoadedTuples(loaded);
+}
+
+/*
+ * Undo a failed bulk load: drop whatever index entries were built, free
+ * the strings of the loaded tuples and release every block. The table
+ * was empty, so the only other tuple in the blocks is the one that
+ * failed to load. Its strings may be half read and are left alone.
+ */
+void PersistentTable::discardLoadedTuples(const std::vector<char*> &loaded) {
+    TableTuple tuple(m_schema);
+    BOOST_FOREACH(char *address, loaded) {
+        tuple.move(address);
+        BOOST_FOREACH(TableIndex *index, m_indexes) {
+            index->deleteEntry(&tuple);
+        }
+        if (m_schema->getUninlinedObjectColumnCount() != 0) {
+            tuple.freeObjectColumns();
+        }
+    }
+    releaseAllBlocks();
+}
+
 TableStats* PersistentTable::getTableStats() {
     return &stats_;
 }
@@ -894,7 +1028,7 @@ bool PersistentTable::activateCopyOnWrite(TupleSerializer *serializer, int32_t p
     if (m_COWContext != NULL) {
         return true;
     }
-    if (m_tupleCount == 0) {
+    if (m_tupleCount == 0 && m_evictedTupleCount == 0) {
         return false;
     }
 
@@ -974,6 +1108,738 @@ void PersistentTable::processRecoveryMessage(RecoveryProtoMsg* message, Pool *po
     }
 }
 
+bool PersistentTable::canEvict() const {
+    if (m_COWContext != NULL || m_recoveryContext != NULL || m_tuplesPinnedByUndo != 0) {
+        return false;
+    }
+    BOOST_FOREACH(TableIndex *index, m_indexes) {
+        if ( ! indexCanHoldTombstones(index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PersistentTable::indexCanHoldTombstones(TableIndex *index) const {
+    if (index->keyDependsOnTupleAddress()) {
+        return false;
+    }
+    // A columns-only key over an out-of-line column points at the
+    // tuple's string, which eviction frees.
+    if (index->keyUsesNonInlinedMemory() && index->getIndexedExpressions().empty()) {
+        BOOST_FOREACH(int column, index->getColumnIndices()) {
+            if ( ! m_schema->columnIsInlined(column)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static inline bool isEvictable(const TableTuple &tuple) {
+    return ! tuple.isPendingDelete() && ! tuple.isPendingDeleteOnUndoRelease();
+}
+
+// Bytes of serialized tuples per anti-cache block
+#define ANTICACHE_BLOCKSIZE 1048576
+
+/**
+ * Two passes over the table: the first builds a histogram of CSI values
+ * to find the cut-off that selects tupleCount tuples, the second collects
+ * them. The victims are then written out one anti-cache block at a time.
+ */
+int64_t PersistentTable::evictColdTuples(AntiCacheDB *antiCacheDB, int64_t tupleCount) {
+    assert(antiCacheDB != NULL);
+    assert(m_antiCacheDB == NULL || m_antiCacheDB == antiCacheDB);
+    if (tupleCount <= 0 || ! canEvict()) {
+        return 0;
+    }
+    m_antiCacheDB = antiCacheDB;
+
+    int64_t histogram[TUPLE_CSI_MAX + 1] = { 0 };
+    TableTuple tuple(m_schema);
+    TableIterator ti(this, m_data.begin());
+    while (ti.next(tuple)) {
+        if (isEvictable(tuple)) {
+            ++histogram[tuple.getCSI()];
+        }
+    }
+
+    int cutoff = 0;
+    int64_t belowCutoff = 0;
+    for (; cutoff <= TUPLE_CSI_MAX; ++cutoff) {
+        if (belowCutoff + histogram[cutoff] >= tupleCount) {
+            break;
+        }
+        belowCutoff += histogram[cutoff];
+    }
+    int64_t remainingAtCutoff = tupleCount - belowCutoff;
+
+    std::vector<char*> victims;
+    victims.reserve(static_cast<size_t>(std::min(tupleCount, activeTupleCount())));
+    ti.reset(m_data.begin());
+    while (ti.next(tuple)) {
+        if ( ! isEvictable(tuple)) {
+            continue;
+        }
+        const int rank = tuple.getCSI();
+        if (rank < cutoff || (rank == cutoff && remainingAtCutoff-- > 0)) {
+            victims.push_back(tuple.address());
+        }
+    }
+
+    // Storage may only be freed once the iteration is over, so the
+    // victims are evicted from the collected addresses.
+    return evictTuples(antiCacheDB, victims);
+}
+
+/**
+ * The clock hand moves in address order from the block after the one it
+ * passed last, wrapping around at most once, so a call never looks at a
+ * block twice. Hot blocks that stop it now are aged and become victims
+ * on a later call if they stay cold.
+ */
+int64_t PersistentTable::evictColdBlocks(AntiCacheDB *antiCacheDB, int64_t tupleCount) {
+    assert(antiCacheDB != NULL);
+    assert(m_antiCacheDB == NULL || m_antiCacheDB == antiCacheDB);
+    if (tupleCount <= 0 || ! canEvict()) {
+        return 0;
+    }
+    m_antiCacheDB = antiCacheDB;
+
+    std::vector<char*> victims;
+    TableTuple tuple(m_schema);
+    const size_t blockCount = m_data.size();
+    for (size_t visited = 0; visited < blockCount && static_cast<int64_t>(victims.size()) < tupleCount; ++visited) {
+        TBMapI i = m_evictionClockHand == NULL ? m_data.begin() : m_data.upper_bound(m_evictionClockHand);
+        if (i == m_data.end()) {
+            m_coldStorageStats.recordEvictionRevolution();
+            i = m_data.begin();
+        }
+        TBPtr block = i.data();
+        m_evictionClockHand = i.key();
+        if (block->referenced() || block->accessSamples() > 0) {
+            block->ageAccess();
+            continue;
+        }
+
+        char *tupleAddress = block->address();
+        const uint32_t boundary = block->unusedTupleBoundry();
+        for (uint32_t ii = 0; ii < boundary; ii++, tupleAddress += m_tupleLength) {
+            tuple.move(tupleAddress);
+            if (tuple.isActive() && isEvictable(tuple)) {
+                victims.push_back(tupleAddress);
+            }
+        }
+    }
+
+    return evictTuples(antiCacheDB, victims);
+}
+
+/**
+ * Serialize the victims into anti-cache blocks of about
+ * ANTICACHE_BLOCKSIZE bytes and evict them one block at a time.
+ */
+int64_t PersistentTable::evictTuples(AntiCacheDB *antiCacheDB, const std::vector<char*> &victims) {
+    TableTuple tuple(m_schema);
+    CopySerializeOutput blockOut;
+    std::vector<char*> batch;
+    int64_t evicted = 0;
+    BOOST_FOREACH(char *victim, victims) {
+        if (batch.empty()) {
+            blockOut.reset();
+            blockOut.writeInt(0); // tuple count, filled in by evictBlock
+        }
+        tuple.move(victim);
+        tuple.serializeTo(blockOut);
+        batch.push_back(victim);
+        if (blockOut.size() >= ANTICACHE_BLOCKSIZE) {
+            if ( ! evictBlock(antiCacheDB, batch, blockOut)) {
+                batch.clear();
+                break;
+            }
+            evicted += batch.size();
+            batch.clear();
+        }
+    }
+    if ( ! batch.empty() && evictBlock(antiCacheDB, batch, blockOut)) {
+        evicted += batch.size();
+    }
+
+    // Eviction punches holes all over the blocks; give the memory back.
+    if (compactionPredicate()) {
+        doForcedCompaction();
+    }
+    return evicted;
+}
+
+/**
+ * Write out the block holding the serialized victims, then swap every
+ * index entry over to a tombstone and free the tuple. Nothing is changed
+ * if the block can't be written.
+ */
+bool PersistentTable::evictBlock(AntiCacheDB *antiCacheDB, const std::vector<char*> &victims,
+                                 CopySerializeOutput &blockOut) {
+    blockOut.writeIntAt(0, static_cast<int32_t>(victims.size()));
+    const int32_t blockId = antiCacheDB->writeBlock(blockOut.data(), static_cast<int32_t>(blockOut.size()));
+    if (blockId == -1) {
+        return false;
+    }
+
+    m_evictedByteCount += blockOut.size();
+    m_coldStorageStats.recordEviction(static_cast<int64_t>(victims.size()));
+    VOLT_TRACE_EVENT(ExecutorContext::getExecutorContext()->traceRing(), TRACE_EVENT_COLD_STORAGE_EVICT,
+                     blockId, static_cast<int64_t>(victims.size()));
+
+    TableTuple victim(m_schema);
+    std::vector<EvictedTupleTombstone*> &tombstones = m_evictedBlocks[blockId];
+    tombstones.reserve(victims.size());
+    for (size_t ii = 0; ii < victims.size(); ++ii) {
+        victim.move(victims[ii]);
+        EvictedTupleTombstone *tombstone = static_cast<EvictedTupleTombstone*>(
+                ThreadLocalPool::getExact(sizeof(EvictedTupleTombstone))->malloc());
+        tombstone->m_flags = static_cast<char>(ACTIVE_MASK | EVICTED_MASK);
+        tombstone->m_csi = static_cast<char>(victim.getCSI());
+        tombstone->m_blockId = blockId;
+        tombstone->m_tupleIndex = static_cast<int32_t>(ii);
+        tombstones.push_back(tombstone);
+
+        BOOST_FOREACH(TableIndex *index, m_indexes) {
+            if ( ! index->replaceEntryAddress(victim, victim.address(), tombstone)) {
+                throwFatalException("Failed to replace evicted tuple with its tombstone in Table: %s Index %s",
+                                    m_name.c_str(), index->getName().c_str());
+            }
+        }
+        deleteTupleStorage(victim); // also frees object columns
+        ++m_evictedTupleCount;
+    }
+    return true;
+}
+
+void PersistentTable::collectEvictedBlockIds(std::set<int32_t> &blockIds) const {
+    BOOST_FOREACH(const EvictedBlockMap::value_type &evicted, m_evictedBlocks) {
+        blockIds.insert(evicted.first);
+    }
+}
+
+void PersistentTable::unevictBlock(int32_t blockId, const std::vector<char> &blockData) {
+    EvictedBlockMap::iterator evicted = m_evictedBlocks.find(blockId);
+    if (evicted == m_evictedBlocks.end()) {
+        throwFatalException("Table %s has no evicted block %d", m_name.c_str(), blockId);
+    }
+    std::vector<EvictedTupleTombstone*> &tombstones = evicted->second;
+
+    ReferenceSerializeInput blockIn(&blockData[0], blockData.size());
+    const int32_t tupleCount = blockIn.readInt();
+    if (static_cast<size_t>(tupleCount) != tombstones.size()) {
+        throwFatalException("Anti-cache block %d of table %s holds %d tuples, expected %d",
+                            blockId, m_name.c_str(), tupleCount, static_cast<int>(tombstones.size()));
+    }
+
+    TableTuple target(m_schema);
+    for (int32_t ii = 0; ii < tupleCount; ++ii) {
+        EvictedTupleTombstone *tombstone = tombstones[ii];
+        nextFreeTuple(&target);
+        target.setActiveTrue();
+        target.setPendingDeleteFalse();
+        target.setPendingDeleteOnUndoReleaseFalse();
+        target.deserializeFrom(blockIn, NULL);
+        target.setCSI(tombstone->m_csi);
+        shareLoadedStrings(target);
+        storeMinipageColumns(target);
+        if (m_COWContext) {
+            m_COWContext->markTupleDirty(target, true);
+            m_COWContext->markEvictedTupleGone(target, *tombstone);
+        } else {
+            target.setDirtyFalse();
+        }
+        if (m_schema->getUninlinedObjectColumnCount() != 0) {
+            increaseStringMemCount(target.getNonInlinedMemorySize());
+        }
+
+        BOOST_FOREACH(TableIndex *index, m_indexes) {
+            if ( ! index->replaceEntryAddress(target, tombstone, target.address())) {
+                throwFatalException("Failed to replace tombstone with reloaded tuple in Table: %s Index %s",
+                                    m_name.c_str(), index->getName().c_str());
+            }
+        }
+        ThreadLocalPool::getExact(sizeof(EvictedTupleTombstone))->free(tombstone);
+        --m_evictedTupleCount;
+    }
+
+    m_evictedBlocks.erase(evicted);
+    m_antiCacheDB->releaseBlock(blockId);
+    m_evictedByteCount -= blockData.size();
+    m_coldStorageStats.recordFetch(tupleCount);
+    VOLT_TRACE_EVENT(ExecutorContext::getExecutorContext()->traceRing(), TRACE_EVENT_COLD_STORAGE_FETCH,
+                     blockId, tupleCount);
+}
+
+void PersistentTable::unevictAll() {
+    if (m_evictedBlocks.empty()) {
+        return;
+    }
+    const int64_t start = ColdStorageStats::nowMicros();
+    std::vector<int32_t> blockIds;
+    BOOST_FOREACH(EvictedBlockMap::value_type &evicted, m_evictedBlocks) {
+        blockIds.push_back(evicted.first);
+    }
+    std::vector<std::vector<char> > blocks;
+    m_antiCacheDB->readBlocks(blockIds, blocks);
+    for (size_t ii = 0; ii < blockIds.size(); ++ii) {
+        unevictBlock(blockIds[ii], blocks[ii]);
+    }
+    m_coldStorageStats.recordFetchLatency(ColdStorageStats::nowMicros() - start);
+}
+
+/*
+ * Like deleteTuple() for every evicted tuple at once. The tuples are read
+ * from the anti-cache to take them out of the indexes and views, but not
+ * put back into the table; their blocks are released when the delete is.
+ */
+void PersistentTable::deleteEvictedTuples(bool fallible) {
+    if (m_evictedBlocks.empty()) {
+        return;
+    }
+    EvictedTupleIterator evicted(this);
+    TableTuple tuple(m_schema);
+    while (evicted.next(tuple)) {
+        EvictedTupleTombstone *tombstone = evicted.tombstone();
+        BOOST_FOREACH(TableIndex *index, m_indexes) {
+            // point the entry back at the tuple so it can be found and deleted
+            if ( ! index->replaceEntryAddress(tuple, tombstone, tuple.address()) ||
+                 ! index->deleteEntry(&tuple)) {
+                throwFatalException("Failed to delete evicted tuple from Table: %s Index %s",
+                                    m_name.c_str(), index->getName().c_str());
+            }
+        }
+        for (int i = 0; i < m_views.size(); i++) {
+            m_views[i]->processTupleDelete(tuple, fallible);
+        }
+    }
+
+    EvictedBlockMap deleted;
+    takeEvictedBlocks(deleted);
+    if (fallible) {
+        UndoQuantum *uq = ExecutorContext::currentUndoQuantum();
+        if (uq) {
+            uq->registerUndoAction(new (*uq) PersistentTableUndoDeleteEvictedAction(deleted, this), this);
+            return;
+        }
+    }
+    deleteEvictedTuplesRelease(deleted);
+}
+
+void PersistentTable::takeEvictedBlocks(EvictedBlockMap &blocks) {
+    m_evictedBlocks.swap(blocks);
+    BOOST_FOREACH(EvictedBlockMap::value_type &evicted, blocks) {
+        m_evictedTupleCount -= static_cast<int64_t>(evicted.second.size());
+        m_evictedByteCount -= m_antiCacheDB->blockLength(evicted.first);
+    }
+}
+
+/*
+ * Undo of deleteEvictedTuples(). The blocks are still in the anti-cache,
+ * so the tuples only need their tombstone entries back.
+ */
+void PersistentTable::insertEvictedTuplesForUndo(EvictedBlockMap &blocks) {
+    EvictedTupleIterator restored(this, blocks);
+    TableTuple tuple(m_schema);
+    while (restored.next(tuple)) {
+        EvictedTupleTombstone *tombstone = restored.tombstone();
+        BOOST_FOREACH(TableIndex *index, m_indexes) {
+            if ( ! index->addEntry(&tuple) ||
+                 ! index->replaceEntryAddress(tuple, tuple.address(), tombstone)) {
+                throwFatalException("Failed to restore evicted tuple to Table: %s Index %s",
+                                    m_name.c_str(), index->getName().c_str());
+            }
+        }
+    }
+    BOOST_FOREACH(EvictedBlockMap::value_type &evicted, blocks) {
+        m_evictedTupleCount += static_cast<int64_t>(evicted.second.size());
+        m_evictedByteCount += m_antiCacheDB->blockLength(evicted.first);
+    }
+    m_evictedBlocks.insert(blocks.begin(), blocks.end());
+    blocks.clear();
+}
+
+/*
+ * Release of deleteEvictedTuples(). A snapshot that has yet to read the
+ * deleted tuples from the anti-cache gets its copies now, before their
+ * blocks go; had it been done at delete time, an undo would have left
+ * the snapshot with each tuple twice.
+ */
+void PersistentTable::deleteEvictedTuplesRelease(EvictedBlockMap &blocks) {
+    if (m_COWContext) {
+        EvictedTupleIterator deleted(this, blocks);
+        TableTuple tuple(m_schema);
+        while (deleted.next(tuple)) {
+            m_COWContext->markEvictedTupleGone(tuple, *deleted.tombstone());
+        }
+    }
+    BOOST_FOREACH(EvictedBlockMap::value_type &evicted, blocks) {
+        BOOST_FOREACH(EvictedTupleTombstone *tombstone, evicted.second) {
+            ThreadLocalPool::getExact(sizeof(EvictedTupleTombstone))->free(tombstone);
+        }
+        m_antiCacheDB->releaseBlock(evicted.first);
+    }
+    blocks.clear();
+}
+
+void PersistentTable::discardEvictedTuples() {
+    EvictedBlockMap discarded;
+    takeEvictedBlocks(discarded);
+    deleteEvictedTuplesRelease(discarded);
+}
+
+void PersistentTable::requestColdStorageAging() {
+    if (m_csiAgingPending) {
+        // Tuples behind the hand saturated after it passed them
+        m_csiAgingRequeued = true;
+        return;
+    }
+    m_csiAgingPending = true;
+    m_csiAgingHand = NULL;
+}
+
+/*
+ * Blocks are visited in address order starting after the hand, so
+ * blocks allocated or compacted away during a revolution neither
+ * invalidate the hand nor stop the revolution from finishing.
+ */
+size_t PersistentTable::ageColdStorageBlocks(int csiCut, int maxCutCSI, size_t maxBlocks, int64_t deadline) {
+    size_t aged = 0;
+    while (m_csiAgingPending && aged < maxBlocks) {
+        TBMapI i = m_csiAgingHand == NULL ? m_data.begin() : m_data.upper_bound(m_csiAgingHand);
+        if (i == m_data.end()) {
+            m_coldStorageStats.recordAgingPass();
+            m_csiAgingPending = m_csiAgingRequeued;
+            m_csiAgingRequeued = false;
+            m_csiAgingHand = NULL;
+            if (m_data.empty()) {
+                m_csiAgingPending = false;
+            }
+            continue;
+        }
+
+        TBPtr block = i.data();
+        char *tupleAddress = block->address();
+        const uint32_t boundary = block->unusedTupleBoundry();
+        TableTuple tuple(m_schema);
+        for (uint32_t ii = 0; ii < boundary; ii++, tupleAddress += m_tupleLength) {
+            tuple.move(tupleAddress);
+            if (!tuple.isActive()) {
+                continue;
+            }
+            const int csi = tuple.getCSI();
+            if (csi == TUPLE_CSI_MAX) {
+                tuple.setCSI(maxCutCSI);
+            } else if (csi >= csiCut) {
+                tuple.setCSI(csi - csiCut);
+            } else if (csi > 0) {
+                tuple.setCSI(0);
+            }
+        }
+        m_csiAgingHand = i.key();
+        ++aged;
+        if (ColdStorageStats::nowMicros() >= deadline) {
+            break;
+        }
+    }
+    return aged;
+}
+
+static void writeImageChunk(TableImage &image, std::vector<std::pair<const char*, size_t> > &runs,
+                            CopySerializeOutput &heap, uint32_t &chunkTuples) {
+    image.writeChunkHeader(chunkTuples, static_cast<uint32_t>(heap.size()));
+    for (size_t ii = 0; ii < runs.size(); ii++) {
+        image.write(runs[ii].first, runs[ii].second);
+    }
+    image.write(heap.data(), heap.size());
+    runs.clear();
+    heap.reset();
+    chunkTuples = 0;
+}
+
+/*
+ * Live tuples are written in runs of adjacent slots, so a densely packed
+ * block goes out in a single write. Chunks are cut at m_tuplesPerBlock
+ * tuples, which lets restoreImage() read each one into a fresh block.
+ */
+int64_t PersistentTable::saveImage(TableImage &image) {
+    const uint16_t uninlinedCount = m_schema->getUninlinedObjectColumnCount();
+    std::vector<std::pair<const char*, size_t> > runs;
+    CopySerializeOutput heap;
+    uint32_t chunkTuples = 0;
+    int64_t tupleCount = 0;
+    TableTuple tuple(m_schema);
+    for (TBMapI i = m_data.begin(); i != m_data.end(); i++) {
+        TBPtr block = i.data();
+        char *tupleAddress = block->address();
+        const uint32_t boundary = block->unusedTupleBoundry();
+        for (uint32_t ii = 0; ii < boundary; ii++, tupleAddress += m_tupleLength) {
+            tuple.move(tupleAddress);
+            if (!tuple.isActive() || tuple.isPendingDelete() || tuple.isPendingDeleteOnUndoRelease()) {
+                continue;
+            }
+            if (!runs.empty() && runs.back().first + runs.back().second == tupleAddress) {
+                runs.back().second += m_tupleLength;
+            } else {
+                runs.push_back(std::pair<const char*, size_t>(tupleAddress, m_tupleLength));
+            }
+            for (uint16_t jj = 0; jj < uninlinedCount; jj++) {
+                tuple.getNValue(m_schema->getUninlinedObjectColumnInfoIndex(jj)).serializeTo(heap);
+            }
+            ++tupleCount;
+            if (++chunkTuples == m_tuplesPerBlock) {
+                writeImageChunk(image, runs, heap, chunkTuples);
+            }
+        }
+    }
+
+    // The evicted tuples follow, read from the anti-cache. The iterator
+    // reuses its tuple, so each one is copied to a buffer that lasts
+    // until its chunk is written.
+    std::vector<char> evictedRows(static_cast<size_t>(m_tuplesPerBlock) * m_tupleLength);
+    size_t evictedRowsUsed = 0;
+    EvictedTupleIterator evicted(this);
+    while (evicted.next(tuple)) {
+        char *row = &evictedRows[evictedRowsUsed];
+        ::memcpy(row, tuple.address(), m_tupleLength);
+        evictedRowsUsed += m_tupleLength;
+        if (!runs.empty() && runs.back().first + runs.back().second == row) {
+            runs.back().second += m_tupleLength;
+        } else {
+            runs.push_back(std::pair<const char*, size_t>(row, m_tupleLength));
+        }
+        for (uint16_t jj = 0; jj < uninlinedCount; jj++) {
+            tuple.getNValue(m_schema->getUninlinedObjectColumnInfoIndex(jj)).serializeTo(heap);
+        }
+        ++tupleCount;
+        if (++chunkTuples == m_tuplesPerBlock) {
+            writeImageChunk(image, runs, heap, chunkTuples);
+            evictedRowsUsed = 0;
+        }
+    }
+
+    if (chunkTuples != 0) {
+        writeImageChunk(image, runs, heap, chunkTuples);
+    }
+    return tupleCount;
+}
+
+/*
+ * The table starts out empty and every chunk but the last fills a block,
+ * so the slots handed out for a chunk are adjacent and its tuples can be
+ * read straight into place. A tuple is only marked active once its
+ * non-inlined values have been allocated, which is what
+ * discardRestoredTuples() relies on to clean up after a failure.
+ */
+void PersistentTable::restoreImage(TableImage &image) {
+    if (m_tupleCount != 0 || m_evictedTupleCount != 0 || m_COWContext != NULL || m_recoveryContext != NULL) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "Table " + m_name + " must be empty to be restored from an image");
+    }
+    image.checkSchema(m_schema);
+
+    const uint16_t uninlinedCount = m_schema->getUninlinedObjectColumnCount();
+    std::vector<char> heap;
+    TableTuple tuple(m_schema);
+    int64_t tupleCount = 0;
+    try {
+        uint32_t heapLength = 0;
+        uint32_t chunkTuples;
+        while ((chunkTuples = image.readChunkHeader(heapLength)) != 0) {
+            if (chunkTuples > m_tuplesPerBlock) {
+                throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                              "Table image " + image.path() + " has a chunk larger than a block");
+            }
+            nextFreeTuple(&tuple);
+            char *chunkAddress = tuple.address();
+            tuple.setActiveFalse();
+            for (uint32_t ii = 1; ii < chunkTuples; ii++) {
+                nextFreeTuple(&tuple);
+                tuple.setActiveFalse();
+            }
+            if (tuple.address() != chunkAddress + (chunkTuples - 1) * m_tupleLength) {
+                throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                              "Table image " + image.path() + " does not fit the table's blocks");
+            }
+
+            const size_t chunkLength = static_cast<size_t>(chunkTuples) * m_tupleLength;
+            try {
+                image.read(chunkAddress, chunkLength);
+            } catch (const SerializableEEException &e) {
+                // A short read leaves saved headers in some of the slots
+                for (uint32_t ii = 0; ii < chunkTuples; ii++) {
+                    tuple.move(chunkAddress + ii * m_tupleLength);
+                    tuple.setActiveFalse();
+                }
+                throw;
+            }
+            for (uint32_t ii = 0; ii < chunkTuples; ii++) {
+                tuple.move(chunkAddress + ii * m_tupleLength);
+                tuple.setActiveFalse();
+                tuple.setDirtyFalse();
+                tuple.setPendingDeleteFalse();
+                tuple.setPendingDeleteOnUndoReleaseFalse();
+            }
+
+            heap.resize(heapLength);
+            if (heapLength != 0) {
+                image.read(&heap[0], heapLength);
+            }
+            ReferenceSerializeInput heapIn(heap.empty() ? NULL : &heap[0], heapLength);
+            for (uint32_t ii = 0; ii < chunkTuples; ii++) {
+                tuple.move(chunkAddress + ii * m_tupleLength);
+                for (uint16_t jj = 0; jj < uninlinedCount; jj++) {
+                    const int column = m_schema->getUninlinedObjectColumnInfoIndex(jj);
+                    NValue::deserializeFrom(heapIn, m_schema->columnType(column), tuple.getDataPtr(column),
+                                            false, m_schema->columnLength(column), NULL);
+                }
+                tuple.setActiveTrue();
+                shareLoadedStrings(tuple);
+                storeMinipageColumns(tuple);
+                if (uninlinedCount != 0) {
+                    increaseStringMemCount(tuple.getNonInlinedMemorySize());
+                }
+            }
+            tupleCount += chunkTuples;
+        }
+        image.verifyTrailer(tupleCount);
+
+        // Bulk build: all the indexes at once, over all the tuples at once
+        std::vector<char*> restored;
+        restored.reserve(m_tupleCount);
+        TableIterator ti(this, m_data.begin());
+        while (ti.next(tuple)) {
+            restored.push_back(tuple.address());
+        }
+        IndexBuilder builder(m_indexes, restored);
+        if (builder.build(tuple) != NULL) {
+            throw ConstraintFailureException(this, tuple, TableTuple(),
+                                             CONSTRAINT_TYPE_UNIQUE);
+        }
+    } catch (const SerializableEEException &e) {
+        discardRestoredTuples();
+        throw;
+    }
+
+    if (!m_views.empty()) {
+        TableIterator ti(this, m_data.begin());
+        while (ti.next(tuple)) {
+            for (int i = 0; i < m_views.size(); i++) {
+                m_views[i]->processTupleInsert(tuple, true);
+            }
+        }
+    }
+}
+
+/*
+ * Undo a failed restoreImage(): drop whatever index entries were built,
+ * free the strings of the tuples that got them and release every block.
+ */
+void PersistentTable::discardRestoredTuples() {
+    TableTuple tuple(m_schema);
+    for (TBMapI i = m_data.begin(); i != m_data.end(); i++) {
+        TBPtr block = i.data();
+        char *tupleAddress = block->address();
+        const uint32_t boundary = block->unusedTupleBoundry();
+        for (uint32_t ii = 0; ii < boundary; ii++, tupleAddress += m_tupleLength) {
+            tuple.move(tupleAddress);
+            if (!tuple.isActive()) {
+                continue;
+            }
+            BOOST_FOREACH(TableIndex *index, m_indexes) {
+                index->deleteEntry(&tuple);
+            }
+            if (m_schema->getUninlinedObjectColumnCount() != 0) {
+                tuple.freeObjectColumns();
+            }
+        }
+    }
+    releaseAllBlocks();
+}
+
+/*
+ * Drop every block of a table whose tuples hold no strings or index
+ * entries any more.
+ */
+void PersistentTable::releaseAllBlocks() {
+    for (TBMapI i = m_data.begin(); i != m_data.end(); i++) {
+        //Eliminates circular reference
+        i.data()->swapToBucket(TBBucketPtr());
+    }
+    m_data.clear();
+    m_blocksWithSpace.clear();
+    m_blocksNotPendingSnapshot.clear();
+    m_tupleCount = 0;
+    BOOST_FOREACH(StringDictionary *dictionary, m_dictionaries) {
+        if (dictionary != NULL) {
+            dictionary->sweep();
+        }
+    }
+    m_nonInlinedMemorySize = 0;
+}
+
+void PersistentTable::setMinipageColumns(const std::vector<int> &columns) {
+    if (m_tupleCount != 0 || m_evictedTupleCount != 0 || !m_data.empty()) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "Table " + m_name + " must be empty to change its minipage columns");
+    }
+    BOOST_FOREACH(int column, columns) {
+        if (column < 0 || static_cast<uint32_t>(column) >= m_columnCount ||
+            !m_schema->columnIsInlined(column)) {
+            char msg[1024];
+            snprintf(msg, sizeof(msg), "Column %d of table %s can't be kept in minipages",
+                     column, m_name.c_str());
+            throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION, msg);
+        }
+    }
+    if (columns.empty()) {
+        m_minipageLayout.reset();
+    } else {
+        m_minipageLayout.reset(new MinipageLayout(m_schema, columns, m_tuplesPerBlock));
+    }
+}
+
+void PersistentTable::setDictionaryColumns(const std::vector<int> &columns, size_t maxEntries) {
+    if (m_tupleCount != 0 || m_evictedTupleCount != 0 || !m_data.empty()) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "Table " + m_name + " must be empty to change its dictionary columns");
+    }
+    BOOST_FOREACH(int column, columns) {
+        if (column < 0 || static_cast<uint32_t>(column) >= m_columnCount ||
+            m_schema->columnIsInlined(column) ||
+            (m_schema->columnType(column) != VALUE_TYPE_VARCHAR &&
+             m_schema->columnType(column) != VALUE_TYPE_VARBINARY)) {
+            char msg[1024];
+            snprintf(msg, sizeof(msg), "Column %d of table %s can't be dictionary encoded",
+                     column, m_name.c_str());
+            throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION, msg);
+        }
+    }
+    freeDictionaries();
+    if (columns.empty()) {
+        return;
+    }
+    m_dictionaries.resize(m_columnCount, NULL);
+    BOOST_FOREACH(int column, columns) {
+        if (m_dictionaries[column] == NULL) {
+            m_dictionaries[column] = new StringDictionary(maxEntries, m_nonInlinedMemorySize);
+        }
+    }
+    m_schema->setColumnDictionaries(&m_dictionaries[0]);
+}
+
+void PersistentTable::freeDictionaries() {
+    m_schema->setColumnDictionaries(NULL);
+    BOOST_FOREACH(StringDictionary *dictionary, m_dictionaries) {
+        delete dictionary;
+    }
+    m_dictionaries.clear();
+}
+
 /**
  * Create a tree index on the primary key and then iterate it and hash
  * the tuple data.
@@ -986,6 +1852,22 @@ size_t PersistentTable::hashCode() {
         pkeyIndex->addEntry(&tuple);
     }
 
+    // Copies of the evicted tuples, read from the anti-cache, are hashed
+    // alongside the resident ones.
+    Pool evictedPool;
+    boost::scoped_ptr<TempTable> evictedCopies;
+    if (m_evictedTupleCount != 0) {
+        evictedCopies.reset(TableFactory::getCopiedTempTable(databaseId(), name(), this, NULL));
+        EvictedTupleIterator evicted(this);
+        while (evicted.next(tuple)) {
+            evictedCopies->insertTupleNonVirtualWithDeepCopy(tuple, &evictedPool);
+        }
+        TableIterator copies = evictedCopies->iterator();
+        while (copies.next(tuple)) {
+            pkeyIndex->addEntry(&tuple);
+        }
+    }
+
     pkeyIndex->moveToEnd(true);
 
     size_t hashCode = 0;
@@ -994,7 +1876,7 @@ size_t PersistentTable::hashCode() {
          if (tuple.isNullTuple()) {
              break;
          }
-         tuple.hashCode(hashCode);
+         hashCode = tuple.hashCode(hashCode);
     }
     return hashCode;
 }
@@ -1013,6 +1895,7 @@ void PersistentTable::notifyBlockWasCompactedAway(TBPtr block) {
 void PersistentTable::swapTuples(TableTuple &originalTuple,
                                  TableTuple &destinationTuple) {
     ::memcpy(destinationTuple.address(), originalTuple.address(), m_tupleLength);
+    storeMinipageColumns(destinationTuple);
     originalTuple.setActiveFalse();
     assert(!originalTuple.isPendingDeleteOnUndoRelease());
 
@@ -1111,13 +1994,16 @@ bool PersistentTable::doCompactionWithinSubset(TBBucketMap *bucketMap) {
             return false;
         }
 
+        const uint32_t lightestTuplesBefore = lightest->activeTuples();
         std::pair<int, int> bucketChanges = fullest->merge(this, lightest);
+        m_compactedTupleCount += lightestTuplesBefore - lightest->activeTuples();
         int tempFullestBucketChange = bucketChanges.first;
         if (tempFullestBucketChange != -1) {
             fullestBucketChange = tempFullestBucketChange;
         }
 
         if (lightest->isEmpty()) {
+            m_compactedBlockCount++;
             notifyBlockWasCompactedAway(lightest);
             m_data.erase(lightest->address());
             m_blocksWithSpace.erase(lightest);
@@ -1150,6 +2036,33 @@ void PersistentTable::doIdleCompaction() {
     }
 }
 
+size_t PersistentTable::doIncrementalCompaction(size_t maxSteps, int64_t deadline) {
+    if (m_recoveryContext != NULL) {
+        return 0;
+    }
+    const int64_t start = ColdStorageStats::nowMicros();
+    size_t steps = 0;
+    while (steps < maxSteps && compactionPredicate()) {
+        bool hadWork = false;
+        if (!m_blocksNotPendingSnapshot.empty()) {
+            hadWork = doCompactionWithinSubset(&m_blocksNotPendingSnapshotLoad);
+        }
+        if (!hadWork && !m_blocksPendingSnapshot.empty()) {
+            hadWork = doCompactionWithinSubset(&m_blocksPendingSnapshotLoad);
+        }
+        if (!hadWork) {
+            // The load buckets have nothing to merge, see doForcedCompaction()
+            break;
+        }
+        steps++;
+        if (ColdStorageStats::nowMicros() >= deadline) {
+            break;
+        }
+    }
+    m_compactionMicros += ColdStorageStats::nowMicros() - start;
+    return steps;
+}
+
 void PersistentTable::doForcedCompaction() {
     if (m_recoveryContext != NULL)
     {
@@ -1157,6 +2070,8 @@ void PersistentTable::doForcedCompaction() {
             "Deferring compaction until recovery is complete.");
         return;
     }
+    const int64_t start = ColdStorageStats::nowMicros();
+    m_forcedCompactionCount++;
     bool hadWork1 = true;
     bool hadWork2 = true;
 
@@ -1217,6 +2132,7 @@ void PersistentTable::doForcedCompaction() {
     }
 
     assert(!compactionPredicate());
+    m_compactionMicros += ColdStorageStats::nowMicros() - start;
     snprintf(msg, sizeof(msg), "Finished forced compaction with allocated tuple count %zd",
              ((intmax_t)allocatedTupleCount()));
     LogManager::getThreadLogger(LOGGERID_SQL)->log(LOGLEVEL_INFO, msg);
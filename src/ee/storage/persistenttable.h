@@ -46,6 +46,7 @@
 #ifndef HSTOREPERSISTENTTABLE_H
 #define HSTOREPERSISTENTTABLE_H
 
+#include <set>
 #include <string>
 #include <vector>
 #include <cassert>
@@ -54,18 +55,23 @@
 #include "common/ids.h"
 #include "common/valuevector.h"
 #include "common/tabletuple.h"
+#include "common/StringDictionary.h"
 #include "storage/table.h"
 #include "storage/TupleStreamWrapper.h"
 #include "storage/TableStats.h"
 #include "storage/PersistentTableStats.h"
+#include "storage/ColdStorageStats.h"
+#include "storage/MinipageLayout.h"
 #include "storage/CopyOnWriteContext.h"
 #include "storage/RecoveryContext.h"
+#include "storage/AntiCacheDB.h"
 #include "common/UndoQuantumReleaseInterest.h"
 #include "common/ThreadLocalPool.h"
 
 class CopyOnWriteTest_CopyOnWriteIterator;
 class CompactionTest_BasicCompaction;
 class CompactionTest_CompactionWithCopyOnWrite;
+class CompactionTest_IncrementalCompaction;
 
 namespace catalog {
 class MaterializedViewInfo;
@@ -83,6 +89,8 @@ class Topend;
 class ReferenceSerializeOutput;
 class MaterializedViewMetadata;
 class RecoveryProtoMsg;
+class CopySerializeOutput;
+class TableImage;
 
 /**
  * Represents a non-temporary table which permanently resides in
@@ -113,16 +121,19 @@ class RecoveryProtoMsg;
 class PersistentTable : public Table, public UndoQuantumReleaseInterest {
     friend class CopyOnWriteContext;
     friend class CopyOnWriteIterator;
+    friend class EvictedTupleIterator;
     friend class TableFactory;
     friend class TableTuple;
     friend class TableIterator;
     friend class PersistentTableStats;
     friend class PersistentTableUndoDeleteAction;
+    friend class PersistentTableUndoDeleteEvictedAction;
     friend class PersistentTableUndoInsertAction;
     friend class PersistentTableUndoUpdateAction;
     friend class ::CopyOnWriteTest_CopyOnWriteIterator;
     friend class ::CompactionTest_BasicCompaction;
     friend class ::CompactionTest_CompactionWithCopyOnWrite;
+    friend class ::CompactionTest_IncrementalCompaction;
   private:
     // no default ctor, no copy, no assignment
     PersistentTable();
@@ -136,7 +147,10 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
     virtual ~PersistentTable();
 
     void notifyQuantumRelease() {
-        if (compactionPredicate()) {
+        // Compaction is normally done a slice at a time from
+        // VoltDBEngine::tick(). Only fall back to compacting in the commit
+        // path once the table is badly fragmented.
+        if (forcedCompactionPredicate()) {
             doForcedCompaction();
         }
     }
@@ -182,6 +196,10 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
                                                 TableTuple &sourceTupleWithNewValues,
                                                 std::vector<TableIndex*> const &indexesToUpdate,
                                                 bool fallible=true);
+    // Evicted tuples get entries pointing at their tombstones, read from
+    // the anti-cache, unless some new index can't hold tombstones; then
+    // they are fetched back first.
+    virtual void addIndexes(const std::vector<TableIndex*> &indexes);
 
 
     // ------------------------------------------------------------------
@@ -259,8 +277,22 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
     }
 
     void doIdleCompaction();
+    /**
+     * Merge blocks until the table no longer needs compaction, taking at
+     * most maxSteps steps and stopping once deadline (microseconds, as from
+     * ColdStorageStats::nowMicros()) has passed. Each step fills up one
+     * block from the emptiest ones. Returns the number of steps taken.
+     * Tuples move, so no undo action may be holding on to one.
+     */
+    size_t doIncrementalCompaction(size_t maxSteps, int64_t deadline);
     void printBucketInfo();
 
+    // Compaction progress, reported by PersistentTableStats
+    int64_t compactedBlockCount() const { return m_compactedBlockCount; }
+    int64_t compactedTupleCount() const { return m_compactedTupleCount; }
+    int64_t forcedCompactionCount() const { return m_forcedCompactionCount; }
+    int64_t compactionMicros() const { return m_compactionMicros; }
+
     void increaseStringMemCount(size_t bytes)
     {
         m_nonInlinedMemorySize += bytes;
@@ -276,6 +308,133 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
 
     // This is a testability feature not intended for use in product logic.
     int getTuplesPendingDeleteCount() const { return m_tuplesPendingDeleteCount; }
+
+    // ------------------------------------------------------------------
+    // ANTI-CACHE (Cold Storage eviction)
+    // ------------------------------------------------------------------
+    /**
+     * Can tuples be evicted right now? Not while a snapshot or recovery
+     * stream is scanning the table, while undo still refers to its
+     * tuples, or if some index key depends on tuple addresses or holds
+     * pointers to the tuples' out-of-line strings.
+     */
+    bool canEvict() const;
+
+    /**
+     * Write up to tupleCount of the coldest tuples (lowest CSI) to the
+     * anti-cache, free their storage and leave a tombstone behind in
+     * every index. Returns the number of tuples evicted.
+     */
+    int64_t evictColdTuples(AntiCacheDB *antiCacheDB, int64_t tupleCount);
+
+    /**
+     * Cold Storage block policy: sweep a clock hand over the blocks and
+     * evict every tuple of each block that hasn't been referenced since
+     * the hand last passed it and whose sampled counter has decayed to
+     * zero, until at least tupleCount tuples are gone. Blocks the hand
+     * skips are aged. Returns the number of tuples evicted.
+     */
+    int64_t evictColdBlocks(AntiCacheDB *antiCacheDB, int64_t tupleCount);
+
+    /** Cold Storage block policy: a sampled access to a tuple of this table */
+    void recordBlockAccess(const TableTuple &tuple) {
+        findBlock(tuple.address())->recordAccess();
+    }
+
+    /** Add the ids of all anti-cache blocks holding tuples of this table */
+    void collectEvictedBlockIds(std::set<int32_t> &blockIds) const;
+
+    /**
+     * Put the tuples of an anti-cache block that was read back into the
+     * table and point the indexes at them again. The block is released.
+     */
+    void unevictBlock(int32_t blockId, const std::vector<char> &blockData);
+
+    /** Fetch back every evicted tuple */
+    void unevictAll();
+
+    /**
+     * Forget every evicted tuple without reading it back and release its
+     * block. Only for a table whose indexes have already been dropped,
+     * after a schema change copied its tuples elsewhere.
+     */
+    void discardEvictedTuples();
+
+    int64_t evictedTupleCount() const { return m_evictedTupleCount; }
+    int64_t evictedByteCount() const { return m_evictedByteCount; }
+
+    voltdb::ColdStorageStats* getColdStorageStats() { return &m_coldStorageStats; }
+    size_t evictedBlockCount() const { return m_evictedBlocks.size(); }
+
+    // ------------------------------------------------------------------
+    // COLD STORAGE AGING
+    // ------------------------------------------------------------------
+    /**
+     * Ask for every CSI in the table to be lowered. The work is done by a
+     * clock hand that ageColdStorageBlocks() advances over the blocks, so
+     * this only starts a revolution (or queues one more if a revolution
+     * is already under way).
+     */
+    void requestColdStorageAging();
+
+    /**
+     * Advance the aging hand by at most maxBlocks blocks, lowering each
+     * CSI it passes by csiCut and dropping saturated ones to maxCutCSI.
+     * No block is started once deadline (microseconds, as from
+     * ColdStorageStats::nowMicros()) has passed, except the first.
+     * Returns the number of blocks aged.
+     */
+    size_t ageColdStorageBlocks(int csiCut, int maxCutCSI, size_t maxBlocks, int64_t deadline);
+
+    bool coldStorageAgingPending() const { return m_csiAgingPending; }
+
+    // ------------------------------------------------------------------
+    // TABLE IMAGES (see TableImage.h)
+    // ------------------------------------------------------------------
+    /**
+     * Write every live tuple and its non-inlined values to the chunks of
+     * image, as many tuples per chunk as fit in a block. Evicted tuples
+     * are fetched back first. Returns the number of tuples written.
+     */
+    int64_t saveImage(TableImage &image);
+
+    /**
+     * Fill this empty table from the chunks of image, then build the
+     * indexes one at a time over the loaded tuples. This is not undoable.
+     * If the image is damaged or breaks a unique index the table is left
+     * empty and the exception is rethrown.
+     */
+    void restoreImage(TableImage &image);
+
+    // ------------------------------------------------------------------
+    // PAX MINIPAGES (see MinipageLayout.h)
+    // ------------------------------------------------------------------
+    /**
+     * Mirror the given inlined columns into per-block minipages, so scans
+     * filtering on them only need to read those. Only an empty table can
+     * change its layout; an empty vector turns the minipages off.
+     */
+    void setMinipageColumns(const std::vector<int> &columns);
+
+    /** NULL unless setMinipageColumns() was given some columns */
+    const MinipageLayout* minipageLayout() const { return m_minipageLayout.get(); }
+
+    // ------------------------------------------------------------------
+    // DICTIONARY ENCODED COLUMNS (see StringDictionary.h)
+    // ------------------------------------------------------------------
+    /**
+     * Share the values of the given non-inlined VARCHAR or VARBINARY
+     * columns through one StringDictionary per column, each holding up to
+     * maxEntries distinct values. Only an empty table can change its
+     * dictionary columns; an empty vector turns the dictionaries off.
+     */
+    void setDictionaryColumns(const std::vector<int> &columns,
+                              size_t maxEntries = StringDictionary::DEFAULT_MAX_ENTRIES);
+
+    /** NULL unless the column is dictionary encoded */
+    const StringDictionary* columnDictionary(int column) const {
+        return m_schema->columnDictionary(column);
+    }
   private:
 
     void snapshotFinishedScanningBlock(TBPtr finishedBlock, TBPtr nextBlock) {
@@ -312,6 +471,21 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
     void notifyBlockWasCompactedAway(TBPtr block);
     void swapTuples(TableTuple &sourceTupleWithNewValues, TableTuple &destinationTuple);
 
+    int64_t evictTuples(AntiCacheDB *antiCacheDB, const std::vector<char*> &victims);
+    bool evictBlock(AntiCacheDB *antiCacheDB, const std::vector<char*> &victims,
+                    CopySerializeOutput &blockOut);
+    bool indexCanHoldTombstones(TableIndex *index) const;
+
+    typedef std::map<int32_t, std::vector<EvictedTupleTombstone*> > EvictedBlockMap;
+    void deleteEvictedTuples(bool fallible);
+    void takeEvictedBlocks(EvictedBlockMap &blocks);
+    void insertEvictedTuplesForUndo(EvictedBlockMap &blocks);
+    void deleteEvictedTuplesRelease(EvictedBlockMap &blocks);
+
+    void discardRestoredTuples();
+    void discardLoadedTuples(const std::vector<char*> &loaded);
+    void releaseAllBlocks();
+
     void insertTupleForUndo(char *tuple);
     void updateTupleForUndo(char* targetTupleToUpdate,
                             char* sourceTupleWithNewValues,
@@ -325,7 +499,7 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
      */
     void deleteTupleStorage(TableTuple &tuple, TBPtr block = TBPtr(NULL));
 
-    // helper for deleteTupleStorage
+    // helper for deleteTupleStorage, constant time thanks to the block alignment
     TBPtr findBlock(char *tuple);
 
     /*
@@ -334,8 +508,27 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
      */
     virtual void processLoadedTuple(TableTuple &tuple);
 
+    /*
+     * A table that is empty when a load starts gets its tuples indexed,
+     * and its views updated, only once they have all been read, with one
+     * TableIndex::addEntries() per index. If such a load fails, on a
+     * duplicate key or part way through reading, the table is left empty.
+     * Loads into other tables keep the tuples before the failing one.
+     */
+    virtual void beginLoadingTuples(int tupleCount);
+    virtual void finishLoadingTuples();
+    virtual void abortLoadingTuples();
+
     TBPtr allocateNextBlock();
 
+    // Copy the columns of tuple into its block's minipages, if there are any
+    void storeMinipageColumns(const TableTuple &tuple);
+
+    // Swap the strings a deserialized tuple owns for their shared copies
+    // in the dictionary encoded columns
+    void shareLoadedStrings(TableTuple &tuple);
+    void freeDictionaries();
+
     // CONSTRAINTS
     std::vector<bool> m_allowNulls;
 
@@ -347,6 +540,7 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
 
     // STATS
     voltdb::PersistentTableStats stats_;
+    voltdb::ColdStorageStats m_coldStorageStats;
     voltdb::TableStats* getTableStats();
 
     // is Export enabled
@@ -360,6 +554,21 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
 
 
 
+    // ANTI-CACHE
+    // Tombstones of the tuples in each block this table wrote to the anti-cache
+    EvictedBlockMap m_evictedBlocks;
+    AntiCacheDB *m_antiCacheDB;
+    int64_t m_evictedTupleCount;
+    int64_t m_evictedByteCount;
+    // Address of the block the eviction clock hand passed last (block policy)
+    char *m_evictionClockHand;
+
+    // COLD STORAGE AGING
+    bool m_csiAgingPending;
+    bool m_csiAgingRequeued;
+    // Address of the last block aged in the current revolution, NULL before the first
+    char *m_csiAgingHand;
+
     // STORAGE TRACKING
 
     // Map from load to the blocks with level of load
@@ -380,8 +589,19 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest {
     // pointers to chunks of data. Specific to table impl. Don't leak this type.
     TBMap m_data;
     int m_failedCompactionCount;
+    int64_t m_compactedBlockCount;
+    int64_t m_compactedTupleCount;
+    int64_t m_forcedCompactionCount;
+    int64_t m_compactionMicros;
+    boost::scoped_ptr<MinipageLayout> m_minipageLayout;
+    // one entry per column, NULL for columns that aren't dictionary
+    // encoded; empty if none is
+    std::vector<StringDictionary*> m_dictionaries;
     // This is a testability feature not intended for use in product logic.
     int m_tuplesPendingDeleteCount;
+    // Tuples read by a bulk load that aren't indexed yet
+    bool m_bulkLoading;
+    std::vector<char*> m_bulkLoadedTuples;
 };
 
 inline TableTuple& PersistentTable::getTempTupleInlined(TableTuple &source) {
@@ -449,33 +669,43 @@ inline void PersistentTable::deleteTupleStorage(TableTuple &tuple, TBPtr block)
 }
 
 inline TBPtr PersistentTable::findBlock(char *tuple) {
-    TBMapI i = m_data.lower_bound(tuple);
-    if (i == m_data.end() && m_data.empty()) {
-        throwFatalException("Tried to find a tuple block for a tuple but couldn't find one");
-    }
-    if (i == m_data.end()) {
-        i--;
-        if (i.key() + m_tableAllocationSize < tuple) {
-            throwFatalException("Tried to find a tuple block for a tuple but couldn't find one");
-        }
-    } else {
-        if (i.key() != tuple) {
-            i--;
-            if (i.key() + m_tableAllocationSize < tuple) {
-                throwFatalException("Tried to find a tuple block for a tuple but couldn't find one");
-            }
-        }
-    }
-    return i.data();
+    TupleBlock *block = TupleBlock::owner(tuple, m_tableAllocationSize);
+    assert(m_data.find(block->address()) != m_data.end());
+    return TBPtr(block);
 }
 
 inline TBPtr PersistentTable::allocateNextBlock() {
     TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, m_blocksNotPendingSnapshotLoad[0]));
+    if (m_minipageLayout) {
+        block->allocateMinipages(m_minipageLayout->bytesPerBlock());
+    }
     m_data.insert( block->address(), block);
     m_blocksNotPendingSnapshot.insert(block);
     return block;
 }
 
+inline void PersistentTable::shareLoadedStrings(TableTuple &tuple) {
+    if (m_dictionaries.empty()) {
+        return;
+    }
+    const uint16_t uninlinedCount = m_schema->getUninlinedObjectColumnCount();
+    for (uint16_t ii = 0; ii < uninlinedCount; ii++) {
+        const int column = m_schema->getUninlinedObjectColumnInfoIndex(ii);
+        if (m_dictionaries[column] != NULL) {
+            m_dictionaries[column]->shareStored(tuple.getNValue(column), tuple.getDataPtr(column));
+        }
+    }
+}
+
+inline void PersistentTable::storeMinipageColumns(const TableTuple &tuple) {
+    if (!m_minipageLayout) {
+        return;
+    }
+    TupleBlock *block = TupleBlock::owner(tuple.address(), m_tableAllocationSize);
+    const uint32_t slot = static_cast<uint32_t>((tuple.address() - block->address()) / m_tupleLength);
+    m_minipageLayout->store(block->minipages(), slot, tuple.address());
+}
+
 
 }
 
@@ -46,6 +46,7 @@
 #include <sstream>
 #include <cassert>
 #include <cstdio>
+#include <algorithm>
 #include <boost/foreach.hpp>
 #include <boost/scoped_array.hpp>
 
@@ -57,6 +58,7 @@
 #include "common/Pool.hpp"
 #include "common/FatalException.hpp"
 #include "indexes/tableindex.h"
+#include "indexes/IndexBuilder.h"
 #include "storage/tableiterator.h"
 #include "storage/persistenttable.h"
 
@@ -119,26 +121,18 @@ void Table::initializeWithColumns(TupleSchema *schema, const std::vector<string>
     m_columnCount = schema->columnCount();
 
     m_tupleLength = m_schema->tupleLength() + TUPLE_HEADER_SIZE;
+    // Blocks are aligned to their size so a tuple's block can be found by
+    // masking its address, see TupleBlock::owner()
 #ifdef MEMCHECK
     m_tuplesPerBlock = 1;
-    m_tableAllocationSize = m_tupleLength;
+    m_tableAllocationSize = nexthigher(m_tupleLength + TUPLE_BLOCK_HEADER_SIZE);
 #else
-    m_tuplesPerBlock = m_tableAllocationTargetSize / m_tupleLength;
-#ifdef USE_MMAP
+    m_tableAllocationSize = nexthigher(m_tableAllocationTargetSize);
+    m_tuplesPerBlock = (m_tableAllocationSize - TUPLE_BLOCK_HEADER_SIZE) / m_tupleLength;
     if (m_tuplesPerBlock < 1) {
         m_tuplesPerBlock = 1;
-        m_tableAllocationSize = nexthigher(m_tupleLength);
-    } else {
-        m_tableAllocationSize = nexthigher(m_tableAllocationTargetSize);
+        m_tableAllocationSize = nexthigher(m_tupleLength + TUPLE_BLOCK_HEADER_SIZE);
     }
-#else
-    if (m_tuplesPerBlock < 1) {
-        m_tuplesPerBlock = 1;
-        m_tableAllocationSize = m_tupleLength;
-    } else {
-        m_tableAllocationSize = m_tableAllocationTargetSize;
-    }
-#endif
 #endif
 
     // initialize column names
@@ -390,16 +384,23 @@ void Table::loadTuplesFromNoHeader(SerializeInput &serialize_io,
 
     TableTuple target(m_schema);
 
-    for (int i = 0; i < tupleCount; ++i) {
-        nextFreeTuple(&target);
-        target.setActiveTrue();
-        target.setDirtyFalse();
-        target.setPendingDeleteFalse();
-        target.setPendingDeleteOnUndoReleaseFalse();
-        target.deserializeFrom(serialize_io, stringPool);
-
-        processLoadedTuple(target);
+    beginLoadingTuples(tupleCount);
+    try {
+        for (int i = 0; i < tupleCount; ++i) {
+            nextFreeTuple(&target);
+            target.setActiveTrue();
+            target.setDirtyFalse();
+            target.setPendingDeleteFalse();
+            target.setPendingDeleteOnUndoReleaseFalse();
+            target.deserializeFrom(serialize_io, stringPool);
+
+            processLoadedTuple(target);
+        }
+    } catch (...) {
+        abortLoadingTuples();
+        throw;
     }
+    finishLoadingTuples();
 }
 
 void Table::loadTuplesFrom(SerializeInput &serialize_io,
@@ -490,25 +491,48 @@ TableIndex *Table::index(std::string name) {
 }
 
 void Table::addIndex(TableIndex *index) {
+    addIndexes(std::vector<TableIndex*>(1, index));
+}
+
+void Table::addIndexes(const std::vector<TableIndex*> &indexes) {
     // silently ignore indexes if they've gotten this far
     if (isExport()) {
         return;
     }
 
-    assert(!isExistingTableIndex(m_indexes, index));
-
-    // fill the index with tuples... potentially the slow bit
+    // fill the indexes with tuples... potentially the slow bit
+    std::vector<char*> addresses;
+    addresses.reserve(static_cast<size_t>(activeTupleCount()));
     TableTuple tuple(m_schema);
     TableIterator iter = iterator();
     while (iter.next(tuple)) {
-        index->addEntry(&tuple);
+        addresses.push_back(tuple.address());
+    }
+    std::vector<TableIndex*> pending(indexes);
+    while (!pending.empty()) {
+        IndexBuilder builder(pending, addresses);
+        TableIndex *failed = builder.build(tuple);
+        if (failed == NULL) {
+            break;
+        }
+        // A unique index over duplicate keys. Fill it one tuple at a time
+        // like it always was, keeping the first tuple of each key, and
+        // carry on with the rest.
+        for (size_t ii = 0; ii < addresses.size(); ii++) {
+            tuple.move(addresses[ii]);
+            failed->addEntry(&tuple);
+        }
+        pending.erase(pending.begin(), std::find(pending.begin(), pending.end(), failed) + 1);
     }
 
-    // add the index to the table
-    if (index->isUniqueIndex()) {
-        m_uniqueIndexes.push_back(index);
+    // add the indexes to the table
+    BOOST_FOREACH(TableIndex *index, indexes) {
+        assert(!isExistingTableIndex(m_indexes, index));
+        if (index->isUniqueIndex()) {
+            m_uniqueIndexes.push_back(index);
+        }
+        m_indexes.push_back(index);
     }
-    m_indexes.push_back(index);
 }
 
 void Table::removeIndex(TableIndex *index) {
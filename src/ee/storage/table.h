@@ -255,6 +255,12 @@ class Table {
 
     // mutating indexes
     virtual void addIndex(TableIndex *index);
+    /**
+     * Add several indexes at once. They are filled together from one pass
+     * over the tuples, building concurrently where that pays off (see
+     * IndexBuilder).
+     */
+    virtual void addIndexes(const std::vector<TableIndex*> &indexes);
     virtual void removeIndex(TableIndex *index);
     virtual void setPrimaryKeyIndex(TableIndex *index);
 
@@ -362,6 +368,21 @@ protected:
     virtual void processLoadedTuple(TableTuple &tuple) {
     };
 
+    /*
+     * Implemented by persistent table and called by Table::loadTuplesFrom
+     * before and after the tuples it reads, so the work done for each
+     * tuple can be put off and done for the whole batch at once. Abort
+     * is called instead of finish when loading fails part way.
+     */
+    virtual void beginLoadingTuples(int tupleCount) {
+    }
+
+    virtual void finishLoadingTuples() {
+    }
+
+    virtual void abortLoadingTuples() {
+    }
+
     virtual void swapTuples(TableTuple &sourceTupleWithNewValues, TableTuple &destinationTuple) {
         throwFatalException("Unsupported operation");
     }
@@ -383,6 +404,11 @@ protected:
         return allocatedTupleCount() - activeTupleCount() > (m_tuplesPerBlock * 3) && loadFactor() < .95;
     }
 
+    // Fragmentation too bad to wait for incremental compaction
+    bool forcedCompactionPredicate() {
+        return compactionPredicate() && loadFactor() < .5;
+    }
+
     void initializeWithColumns(TupleSchema *schema, const std::vector<std::string> &columnNames, bool ownsTupleSchema);
 
     // per table-type initialization
@@ -135,6 +135,11 @@ void TableFactory::configureStats(voltdb::CatalogId databaseId,
     // initialize stats for the table
     table->getTableStats()->configure(name + " stats",
                                       databaseId);
+    PersistentTable *persistentTable = dynamic_cast<PersistentTable*>(table);
+    if (persistentTable != NULL) {
+        persistentTable->getColdStorageStats()->configure(name + " cold storage stats",
+                                                          databaseId);
+    }
 }
 
 }
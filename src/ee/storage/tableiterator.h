@@ -47,10 +47,13 @@
 #define HSTORETABLEITERATOR_H
 
 #include <cassert>
+#include "boost/shared_array.hpp"
 #include "boost/shared_ptr.hpp"
 #include "common/tabletuple.h"
 #include "table.h"
 #include "storage/TupleIterator.h"
+#include "storage/MinipageLayout.h"
+#include "storage/TempTableSpill.h"
 
 namespace voltdb {
 
@@ -84,17 +87,26 @@ public:
     bool hasNext();
     int getLocation() const;
 
+    /**
+     * Only stop at tuples of a persistent table that pass filter, which is
+     * evaluated on the blocks' minipages and must outlive the scan.
+     */
+    void setMinipageFilter(MinipageFilter *filter) {
+        m_minipageFilter = filter;
+    }
+
 private:
     // Get an iterator via table->iterator()
     TableIterator(Table *, TBMapI);
-    TableIterator(Table *, std::vector<TBPtr>::iterator);
+    TableIterator(Table *, std::vector<TBPtr>::iterator, const TempTableSpill *spill = NULL);
 
 
     bool persistentNext(TableTuple &out);
     bool tempNext(TableTuple &out);
+    bool nextSpilledTuple(TableTuple &out);
 
     void reset(TBMapI);
-    void reset(std::vector<TBPtr>::iterator);
+    void reset(std::vector<TBPtr>::iterator, const TempTableSpill *spill = NULL);
     bool continuationPredicate();
 
     /*
@@ -120,9 +132,22 @@ private:
     TBPtr m_currentBlock;
     std::vector<TBPtr>::iterator m_tempBlockIterator;
     bool m_tempTableIterator;
+    MinipageFilter *m_minipageFilter;
+    // The blocks a TempTable spilled come before its resident ones and
+    // are read back one at a time. The previous block's buffer is kept,
+    // so the tuple before the current one stays valid as it would in
+    // memory; executors that need all of them resident call
+    // TempTable::loadSpilledBlocks() first.
+    const TempTableSpill *m_spill;
+    size_t m_spillBlock;
+    uint32_t m_spillOffset;
+    uint32_t m_spillTuples;
+    boost::shared_array<char> m_spillBuffer;
+    boost::shared_array<char> m_previousSpillBuffer;
 };
 
-inline TableIterator::TableIterator(Table *parent, std::vector<TBPtr>::iterator start)
+inline TableIterator::TableIterator(Table *parent, std::vector<TBPtr>::iterator start,
+                                    const TempTableSpill *spill)
     : m_table(parent),
       m_dataPtr(NULL),
       m_location(0),
@@ -131,7 +156,9 @@ inline TableIterator::TableIterator(Table *parent, std::vector<TBPtr>::iterator
       m_foundTuples(0), m_tupleLength(parent->m_tupleLength),
       m_tuplesPerBlock(parent->m_tuplesPerBlock), m_currentBlock(NULL),
       m_tempBlockIterator(start),
-      m_tempTableIterator(true)
+      m_tempTableIterator(true),
+      m_minipageFilter(NULL),
+      m_spill(spill), m_spillBlock(0), m_spillOffset(0), m_spillTuples(0)
     {
     }
 
@@ -146,12 +173,20 @@ inline TableIterator::TableIterator(Table *parent, TBMapI start)
       m_activeTuples((int) m_table->m_tupleCount),
       m_foundTuples(0), m_tupleLength(parent->m_tupleLength),
       m_tuplesPerBlock(parent->m_tuplesPerBlock), m_currentBlock(NULL),
-      m_tempTableIterator(false)
+      m_tempTableIterator(false),
+      m_minipageFilter(NULL),
+      m_spill(NULL), m_spillBlock(0), m_spillOffset(0), m_spillTuples(0)
     {
     }
 
-inline void TableIterator::reset(std::vector<TBPtr>::iterator start) {
+inline void TableIterator::reset(std::vector<TBPtr>::iterator start, const TempTableSpill *spill) {
     m_tempBlockIterator = start;
+    m_spill = spill;
+    m_spillBlock = 0;
+    m_spillOffset = 0;
+    m_spillTuples = 0;
+    m_spillBuffer.reset();
+    m_previousSpillBuffer.reset();
     m_dataPtr= NULL;
     m_location = 0;
     m_blockOffset = 0;
@@ -160,6 +195,7 @@ inline void TableIterator::reset(std::vector<TBPtr>::iterator start) {
     m_tupleLength = m_table->m_tupleLength;
     m_tuplesPerBlock = m_table->m_tuplesPerBlock;
     m_currentBlock = NULL;
+    m_minipageFilter = NULL;
 }
 
 inline void TableIterator::reset(TBMapI start) {
@@ -172,6 +208,7 @@ inline void TableIterator::reset(TBMapI start) {
     m_tupleLength = m_table->m_tupleLength;
     m_tuplesPerBlock = m_table->m_tuplesPerBlock;
     m_currentBlock = NULL;
+    m_minipageFilter = NULL;
 }
 
 inline bool TableIterator::hasNext() {
@@ -195,13 +232,29 @@ inline bool TableIterator::persistentNext(TableTuple &out) {
 //            if (m_blockIterator == m_table->m_data.end()) {
 //                throwFatalException("Could not find the expected number of tuples during a table scan");
 //            }
-            m_dataPtr = m_blockIterator.key();
             m_currentBlock = m_blockIterator.data();
             m_blockOffset = 0;
             m_blockIterator++;
-        } else {
-            m_dataPtr += m_tupleLength;
         }
+        // Skip the free slots using the block's occupancy bitmap
+        const uint32_t slot = m_currentBlock->nextUsedSlot(m_blockOffset);
+        m_location += slot - m_blockOffset;
+        m_blockOffset = slot;
+        if (slot >= m_currentBlock->unusedTupleBoundry()) {
+            continue;
+        }
+        // A rejected tuple still counts towards the expected number if
+        // it is active, as it would below; only its flags are read
+        if (m_minipageFilter != NULL && !m_minipageFilter->passes(*m_currentBlock, slot)) {
+            const char flags = m_currentBlock->address()[m_tupleLength * slot + TUPLE_HEADER_FLAGS_OFFSET];
+            if (flags & ACTIVE_MASK) {
+                ++m_foundTuples;
+            }
+            ++m_location;
+            ++m_blockOffset;
+            continue;
+        }
+        m_dataPtr = m_currentBlock->address() + m_tupleLength * slot;
         assert (out.sizeInValues() == m_table->columnCount());
         out.move(m_dataPtr);
         assert(m_dataPtr < m_currentBlock.get()->address() + m_table->m_tableAllocationTargetSize);
@@ -227,8 +280,30 @@ inline bool TableIterator::persistentNext(TableTuple &out) {
     return false;
 }
 
+inline bool TableIterator::nextSpilledTuple(TableTuple &out) {
+    while (m_spillOffset >= m_spillTuples) {
+        if (m_spillBlock >= m_spill->blockCount()) {
+            m_spill = NULL;
+            return false;
+        }
+        m_previousSpillBuffer.swap(m_spillBuffer);
+        if (!m_spillBuffer) {
+            m_spillBuffer.reset(new char[m_spill->blockBytes()]);
+        }
+        m_spillTuples = m_spill->readBlock(m_spillBlock++, m_spillBuffer.get());
+        m_spillOffset = 0;
+    }
+    out.move(m_spillBuffer.get() + static_cast<size_t>(m_spillOffset++) * m_tupleLength);
+    return true;
+}
+
 inline bool TableIterator::tempNext(TableTuple &out) {
     if (m_foundTuples < m_activeTuples) {
+        if (m_spill != NULL && nextSpilledTuple(out)) {
+            ++m_location;
+            ++m_foundTuples;
+            return true;
+        }
         if (m_currentBlock == NULL ||
             m_blockOffset >= m_currentBlock->unusedTupleBoundry())
         {
@@ -46,6 +46,8 @@
 #include "temptable.h"
 #include "common/debuglog.h"
 
+#include <boost/foreach.hpp>
+
 #define TABLE_BLOCKSIZE 131072
 
 namespace voltdb {
@@ -81,6 +83,53 @@ bool TempTable::deleteTuple(TableTuple &, bool)
     throwFatalException("TempTable does not support deleting individual tuples");
 }
 
+/*
+ * Write every block, all of them full, to the scratch file and keep only
+ * the first one, emptied, for the tuples still to come.
+ */
+void TempTable::spillBlocks() {
+    if (!m_spill) {
+        m_spill.reset(new TempTableSpill(m_limits->getSpillDirectory(), m_tupleLength, m_tuplesPerBlock));
+    }
+    BOOST_FOREACH(TBPtr &block, m_data) {
+        m_spill->writeBlock(block->address(), block->unusedTupleBoundry());
+        m_limits->recordSpill(static_cast<int>(block->unusedTupleBoundry() * m_tupleLength));
+    }
+    while (m_data.size() > 1) {
+        m_data.pop_back();
+        m_limits->reduceAllocated(m_tableAllocationSize);
+    }
+    m_data[0]->reset();
+}
+
+void TempTable::loadSpilledBlocks() {
+    if (!m_spill) {
+        return;
+    }
+    std::vector<TBPtr> loaded;
+    try {
+        for (size_t ii = 0; ii < m_spill->blockCount(); ii++) {
+            TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, TBBucketPtr(), true));
+            loaded.push_back(block);
+            if (m_limits) {
+                m_limits->increaseAllocated(m_tableAllocationSize);
+            }
+            const uint32_t tupleCount = m_spill->readBlock(ii, block->address());
+            for (uint32_t jj = 0; jj < tupleCount; jj++) {
+                block->nextFreeTuple();
+            }
+        }
+    } catch (...) {
+        // leave the table spilled, and the limits as they were
+        for (size_t ii = 0; m_limits && ii < loaded.size(); ii++) {
+            m_limits->reduceAllocated(m_tableAllocationSize);
+        }
+        throw;
+    }
+    m_data.insert(m_data.begin(), loaded.begin(), loaded.end());
+    m_spill.reset();
+}
+
 std::string TempTable::tableType() const { return "TempTable"; }
 
 voltdb::TableStats* TempTable::getTableStats() { return NULL; }
@@ -47,10 +47,12 @@
 #define HSTORETEMPTABLE_H
 
 #include "table.h"
+#include "boost/scoped_ptr.hpp"
 #include "common/tabletuple.h"
 #include "common/ThreadLocalPool.h"
 #include "storage/tableiterator.h"
 #include "storage/TempTableLimits.h"
+#include "storage/TempTableSpill.h"
 #include "storage/TupleBlock.h"
 
 namespace voltdb {
@@ -83,12 +85,12 @@ class TempTable : public Table {
   public:
     // Return the table iterator by reference
     TableIterator& iterator() {
-        m_iter.reset(m_data.begin());
+        m_iter.reset(m_data.begin(), m_spill.get());
         return m_iter;
     }
 
     TableIterator* makeIterator() {
-        return new TableIterator(this, m_data.begin());
+        return new TableIterator(this, m_data.begin(), m_spill.get());
     }
 
     virtual ~TempTable();
@@ -128,6 +130,20 @@ class TempTable : public Table {
     // Deprecating this ugly name, and bogus return value. For now it's a wrapper.
     bool insertTupleNonVirtual(TableTuple &source) { insertTempTuple(source); return true; };
 
+    // ------------------------------------------------------------------
+    // SPILLING (see TempTableLimits::setSpillThreshold())
+    // ------------------------------------------------------------------
+    /** Tuples written to the scratch file and not yet loaded back */
+    int64_t spilledTupleCount() const {
+        return m_spill ? m_spill->tupleCount() : 0;
+    }
+    /**
+     * Bring the spilled blocks back into memory, for executors that hold
+     * on to every tuple of their input, like a sort. The memory limit
+     * applies to them again.
+     */
+    void loadSpilledBlocks();
+
     // ------------------------------------------------------------------
     // INDEXES
     // ------------------------------------------------------------------
@@ -153,14 +169,18 @@ class TempTable : public Table {
 
     TBPtr allocateNextBlock();
     void nextFreeTuple(TableTuple *tuple);
+    void spillBlocks();
 
     virtual void onSetColumns() {
         m_data.clear();
+        m_spill.reset();
     };
 
   private:
     // pointers to chunks of data. Specific to table impl. Don't leak this type.
     std::vector<TBPtr> m_data;
+    // The oldest tuples once the table spilled; they precede those in m_data
+    boost::scoped_ptr<TempTableSpill> m_spill;
 };
 
 inline void TempTable::insertTupleNonVirtualWithDeepCopy(TableTuple &source, Pool *pool) {
@@ -206,11 +226,11 @@ inline void TempTable::deleteAllTuplesNonVirtual(bool freeAllocatedStrings) {
     }
 
     // Mark tuples as deleted and free strings. No indexes to update.
-    // Don't call deleteTuple() here.
+    // Don't call deleteTuple() here. Spilled tuples own strings too.
     const uint16_t uninlinedStringColumnCount = m_schema->getUninlinedObjectColumnCount();
     if (freeAllocatedStrings && uninlinedStringColumnCount > 0) {
         TableTuple target(m_schema);
-        TableIterator iter(this, m_data.begin());
+        TableIterator iter(this, m_data.begin(), m_spill.get());
         while (iter.hasNext()) {
             iter.next(target);
             target.freeObjectColumns();
@@ -218,6 +238,7 @@ inline void TempTable::deleteAllTuplesNonVirtual(bool freeAllocatedStrings) {
     }
 
     m_tupleCount = 0;
+    m_spill.reset();
     while (m_data.size() > 1) {
         m_data.pop_back();
         if (m_limits) {
@@ -232,7 +253,7 @@ inline void TempTable::deleteAllTuplesNonVirtual(bool freeAllocatedStrings) {
 }
 
 inline TBPtr TempTable::allocateNextBlock() {
-    TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, TBBucketPtr()));
+    TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, TBBucketPtr(), true));
     m_data.push_back(block);
 
     if (m_limits) {
@@ -250,7 +271,12 @@ inline void TempTable::nextFreeTuple(TableTuple *tuple) {
 
     TBPtr block = m_data.back();
     if (!block->hasFreeTuples()) {
-        block = allocateNextBlock();
+        if (m_limits != NULL && m_limits->shouldSpill(m_tableAllocationSize)) {
+            spillBlocks();
+            block = m_data.back();
+        } else {
+            block = allocateNextBlock();
+        }
     }
 
     std::pair<char*, int> pair = block->nextFreeTuple();
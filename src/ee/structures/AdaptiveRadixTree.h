@@ -0,0 +1,1178 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ADAPTIVERADIXTREE_H_
+#define ADAPTIVERADIXTREE_H_
+
+#include <cstring>
+#include <stdint.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <new>
+#include <boost/static_assert.hpp>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "ContiguousAllocator.h"
+
+namespace voltdb {
+
+/**
+ * Adaptive radix tree (Leis et al., ICDE 2013) with the interface of
+ * CompactingMap, for tree indexes over integer keys.
+ *
+ * A key is walked a byte at a time, so a lookup costs a node per key
+ * byte at most rather than a comparison per level of a tree of log(n)
+ * levels. Nodes come in four sizes, holding up to 4, 16, 48 or 256
+ * children, and grow and shrink with their fanout. A run of bytes shared
+ * by everything under a node is kept in the node as its prefix, and a
+ * subtree with a single key is just the leaf, so dense and sparse key
+ * ranges both stay shallow. The leaves hold the full key and are chained
+ * in key order, which is how iterators move. Equal keys of a multimap
+ * share a leaf, their values kept in insertion order.
+ *
+ * Key must provide RADIX_LENGTH and toRadix(), writing the key as that
+ * many bytes that compare with memcmp() the way Compare orders keys, see
+ * IntsKey. There is no rank: countable indexes need per-subtree counts,
+ * which a radix tree would have to maintain on every path byte.
+ *
+ * Each node size, leaves included, comes from its own ContiguousAllocator,
+ * and so does each size of the value arrays of a multimap's equal keys.
+ * Nodes that empty during a mutation are released at its end, the last
+ * node of their size moving into the hole, as CompactingBTree does.
+ * Iterators are invalidated by any mutation.
+ */
+template<typename Key, typename Data, typename Compare, bool hasRank=false>
+class AdaptiveRadixTree {
+    BOOST_STATIC_ASSERT(!hasRank);
+
+protected:
+    enum { KEY_LENGTH = Key::RADIX_LENGTH };
+    enum NodeType { LEAF, NODE4, NODE16, NODE48, NODE256 };
+
+    struct Node {
+        uint8_t type;
+    };
+
+    struct Leaf : public Node {
+        Key key;
+        Leaf *prev;
+        Leaf *next;
+        uint32_t count;
+        uint32_t capacity;
+        // inlineValue until a second equal key arrives
+        Data *values;
+        Data inlineValue;
+    };
+
+    struct Inner : public Node {
+        uint8_t prefixLength;
+        uint16_t count;
+        uint8_t prefix[KEY_LENGTH];
+    };
+
+    // children sorted by key byte
+    struct Node4 : public Inner {
+        enum { KIND = NODE4 };
+        uint8_t keys[4];
+        Node *children[4];
+    };
+
+    struct Node16 : public Inner {
+        enum { KIND = NODE16 };
+        uint8_t keys[16];
+        Node *children[16];
+    };
+
+    // slots[byte] is one past the child's index, 0 for none
+    struct Node48 : public Inner {
+        enum { KIND = NODE48 };
+        uint8_t slots[256];
+        Node *children[48];
+    };
+
+    struct Node256 : public Inner {
+        enum { KIND = NODE256 };
+        Node *children[256];
+    };
+
+    static const int CACHE_LINE_SIZE = 64;
+    // value arrays go up to 2^31 values, one allocator per power of two
+    static const int VALUE_SIZES = 32;
+    // bytes per buffer of value arrays, or one array if it is bigger
+    static const int VALUE_BUFFER_SIZE = 64 * 1024;
+
+    int64_t m_count;
+    Node *m_root;
+    Leaf *m_first;
+    Leaf *m_last;
+    ContiguousAllocator m_leafAllocator;
+    ContiguousAllocator m_node4Allocator;
+    ContiguousAllocator m_node16Allocator;
+    ContiguousAllocator m_node48Allocator;
+    ContiguousAllocator m_node256Allocator;
+    // value arrays of 2^n values, each behind the leaf owning it; made on first use
+    ContiguousAllocator *m_valueAllocators[VALUE_SIZES];
+    bool m_unique;
+
+    // templated comparison function object
+    // follows STL conventions
+    Compare m_comper;
+
+    // nodes emptied by a mutation, released once the tree is whole again
+    std::vector<Node*> m_freed;
+
+public:
+
+    class iterator {
+        friend class AdaptiveRadixTree<Key, Data, Compare, hasRank>;
+    protected:
+        Leaf *m_leaf;
+        uint32_t m_slot;
+        iterator(Leaf *leaf, uint32_t slot) : m_leaf(leaf), m_slot(slot) {}
+    public:
+        iterator() : m_leaf(NULL), m_slot(0) {}
+        iterator(const iterator &iter) : m_leaf(iter.m_leaf), m_slot(iter.m_slot) {}
+        Key &key() const { return m_leaf->key; }
+        Data &value() const { return m_leaf->values[m_slot]; }
+        void setValue(const Data &value) { m_leaf->values[m_slot] = value; }
+        void moveNext() {
+            if (++m_slot == m_leaf->count) {
+                m_leaf = m_leaf->next;
+                m_slot = 0;
+            }
+        }
+        void movePrev() {
+            if (m_slot-- == 0) {
+                m_leaf = m_leaf->prev;
+                m_slot = m_leaf ? m_leaf->count - 1 : 0;
+            }
+        }
+        bool isEnd() const { return m_leaf == NULL; }
+        bool equals(const iterator &iter) const {
+            if (isEnd()) return iter.isEnd();
+            return m_leaf == iter.m_leaf && m_slot == iter.m_slot;
+        }
+    };
+
+    /** Orders key/value pairs by key, for sorting entries before bulkLoad() */
+    class EntryLess {
+        Compare m_comper;
+    public:
+        EntryLess(const Compare &comper) : m_comper(comper) {}
+        bool operator()(const std::pair<Key, Data> &lhs, const std::pair<Key, Data> &rhs) const {
+            return m_comper(lhs.first, rhs.first) < 0;
+        }
+    };
+
+    AdaptiveRadixTree(bool unique, Compare comper);
+    ~AdaptiveRadixTree();
+
+    /**
+     * Fill an empty tree with entries sorted by key. Each new key lands
+     * next to the last one, so this is a series of cheap inserts.
+     */
+    void bulkLoad(const std::vector<std::pair<Key, Data> > &entries);
+
+    bool insert(std::pair<Key, Data> value) { return insert(value.first, value.second); }
+    bool insert(const Key &key, const Data &data);
+    bool erase(const Key &key);
+    bool erase(iterator &iter);
+    iterator find(const Key &key);
+    iterator findRank(int64_t ith) { return iterator(); }
+    int64_t size() const { return m_count; }
+    iterator begin() const {
+        if (!m_count) return iterator();
+        return iterator(m_first, 0);
+    }
+    iterator rbegin() const {
+        if (!m_count) return iterator();
+        return iterator(m_last, m_last->count - 1);
+    }
+
+    iterator lowerBound(const Key &key);
+    iterator upperBound(const Key &key);
+    /**
+     * lowerBound() of each of count keys, one at a time: a lookup may back out of
+     * a subtree it went into, so the paths don't go down a level in step.
+     */
+    void lowerBoundBatch(const Key *keys, size_t count, iterator *found) {
+        for (size_t ii = 0; ii < count; ii++) {
+            found[ii] = lowerBound(keys[ii]);
+        }
+    }
+
+    std::pair<iterator, iterator> equalRange(const Key &key);
+
+    size_t bytesAllocated() const;
+
+    int64_t rankAsc(const Key& key) { return -1; }
+    int64_t rankUpper(const Key& key) { return -1; }
+
+    /**
+     * For debugging: verify node occupancy, key placement and the leaf
+     * chain. SLOW.
+     */
+    bool verify() const;
+    bool verifyRank() { return true; }
+
+protected:
+    static Leaf *asLeaf(Node *node) { return static_cast<Leaf*>(node); }
+    static Inner *asInner(Node *node) { return static_cast<Inner*>(node); }
+
+    /** The slot holding the child for byte, or NULL */
+    static Node **findChild(Inner *inner, uint8_t byte);
+    /**
+     * The child with the smallest byte above after, or NULL (after may be
+     * -1). The child's byte goes to byte, if given.
+     */
+    static Node *nextChild(Inner *inner, int after, int *byte = NULL);
+    /** The child with the largest byte below before, or NULL (before may be 256) */
+    static Node *prevChild(Inner *inner, int before);
+    static Leaf *minLeaf(Node *node);
+    static Leaf *maxLeaf(Node *node);
+
+    /** Add child at byte to the node in *ref, which may be replaced by a bigger one */
+    void addChild(Node **ref, uint8_t byte, Node *child);
+    /** Remove the child at byte of the node in *ref, which may shrink or go away */
+    void removeChild(Node **ref, uint8_t byte);
+    template<typename From, typename To> To *resize(From *from);
+    /** Replace a node left with one child by the child */
+    void collapse(Node **ref, uint8_t byte, Node *child);
+
+    Leaf *lowerBoundLeaf(Node *node, const uint8_t *bytes, int depth) const;
+
+    Leaf *newLeaf(const Key &key, const Data &data);
+    void appendValue(Leaf *leaf, const Data &data);
+    void removeLeaf(Leaf *leaf);
+    void linkBefore(Leaf *leaf, Leaf *next);
+    void linkAfter(Leaf *leaf, Leaf *prev);
+    template<typename NodeKind> NodeKind *newInner(const uint8_t *prefix, int prefixLength);
+    /** Unlinked node, released by the next releaseFreed() */
+    void freeNode(Node *node);
+
+    static int32_t nodeSize(size_t size) {
+        return static_cast<int32_t>((size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1));
+    }
+    ContiguousAllocator &allocatorFor(uint8_t type);
+    /** Free the nodes on m_freed, filling the holes with the last allocated nodes */
+    void releaseFreed();
+    /** Move a live node into a hole and repoint everything that points at it */
+    void relocate(Node *from, Node *to);
+    /** The child slot, or m_root, pointing at a node in the tree */
+    Node **refTo(Node *node);
+    void destroy(Node *node);
+    void destroySubtree(Node *node);
+
+    // the leaf owning a value array is stored just before the values
+    static Leaf *&ownerOf(Data *values) {
+        return *reinterpret_cast<Leaf**>(static_cast<char*>(static_cast<void*>(values)) - sizeof(Leaf*));
+    }
+    ContiguousAllocator &valueAllocatorFor(uint32_t capacity);
+    Data *newValues(Leaf *owner, uint32_t capacity);
+    /** Free a value array, filling the hole with the last one of its size */
+    void releaseValues(Data *values, uint32_t capacity);
+
+    bool verify(Node *node, uint8_t *path, int depth, const Leaf *&expected,
+                int64_t &count, int64_t *nodes) const;
+};
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::AdaptiveRadixTree(bool unique, Compare comper)
+    : m_count(0),
+      m_root(NULL),
+      m_first(NULL),
+      m_last(NULL),
+      m_leafAllocator(nodeSize(sizeof(Leaf)), 256),
+      m_node4Allocator(nodeSize(sizeof(Node4)), 256),
+      m_node16Allocator(nodeSize(sizeof(Node16)), 64),
+      m_node48Allocator(nodeSize(sizeof(Node48)), 32),
+      m_node256Allocator(nodeSize(sizeof(Node256)), 16),
+      m_unique(unique),
+      m_comper(comper)
+{
+    std::fill(m_valueAllocators, m_valueAllocators + VALUE_SIZES, static_cast<ContiguousAllocator*>(NULL));
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::~AdaptiveRadixTree() {
+    assert(m_freed.empty());
+    if (m_root) {
+        destroySubtree(m_root);
+    }
+    for (int ii = 0; ii < VALUE_SIZES; ii++) {
+        delete m_valueAllocators[ii];
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+size_t AdaptiveRadixTree<Key, Data, Compare, hasRank>::bytesAllocated() const {
+    size_t bytes = m_leafAllocator.bytesAllocated() + m_node4Allocator.bytesAllocated() +
+                   m_node16Allocator.bytesAllocated() + m_node48Allocator.bytesAllocated() +
+                   m_node256Allocator.bytesAllocated();
+    for (int ii = 0; ii < VALUE_SIZES; ii++) {
+        if (m_valueAllocators[ii]) {
+            bytes += m_valueAllocators[ii]->bytesAllocated();
+        }
+    }
+    return bytes;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::bulkLoad(const std::vector<std::pair<Key, Data> > &entries) {
+    assert(m_count == 0);
+    for (size_t ii = 0; ii < entries.size(); ii++) {
+        insert(entries[ii].first, entries[ii].second);
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool AdaptiveRadixTree<Key, Data, Compare, hasRank>::insert(const Key &key, const Data &data) {
+    uint8_t bytes[KEY_LENGTH];
+    key.toRadix(bytes);
+    if (m_root == NULL) {
+        Leaf *leaf = newLeaf(key, data);
+        m_root = leaf;
+        m_first = m_last = leaf;
+        m_count++;
+        return true;
+    }
+
+    Node **ref = &m_root;
+    int depth = 0;
+    while ((*ref)->type != LEAF) {
+        Inner *inner = asInner(*ref);
+        int matched = 0;
+        while (matched < inner->prefixLength && inner->prefix[matched] == bytes[depth + matched]) {
+            matched++;
+        }
+        if (matched < inner->prefixLength) {
+            // the key leaves the prefix: split it around a new node
+            Leaf *leaf = newLeaf(key, data);
+            Node4 *split = newInner<Node4>(inner->prefix, matched);
+            const uint8_t innerByte = inner->prefix[matched];
+            inner->prefixLength = static_cast<uint8_t>(inner->prefixLength - matched - 1);
+            ::memmove(inner->prefix, inner->prefix + matched + 1, inner->prefixLength);
+            *ref = split;
+            addChild(ref, innerByte, inner);
+            addChild(ref, bytes[depth + matched], leaf);
+            if (bytes[depth + matched] < innerByte) {
+                linkBefore(leaf, minLeaf(inner));
+            } else {
+                linkAfter(leaf, maxLeaf(inner));
+            }
+            m_count++;
+            return true;
+        }
+        depth += inner->prefixLength;
+        Node **child = findChild(inner, bytes[depth]);
+        if (child == NULL) {
+            Leaf *leaf = newLeaf(key, data);
+            Node *next = nextChild(inner, bytes[depth]);
+            if (next) {
+                linkBefore(leaf, minLeaf(next));
+            } else {
+                linkAfter(leaf, maxLeaf(prevChild(inner, bytes[depth])));
+            }
+            addChild(ref, bytes[depth], leaf);
+            // a full node was replaced by a bigger one
+            releaseFreed();
+            m_count++;
+            return true;
+        }
+        ref = child;
+        depth++;
+    }
+
+    Leaf *existing = asLeaf(*ref);
+    uint8_t existingBytes[KEY_LENGTH];
+    existing->key.toRadix(existingBytes);
+    int differ = depth;
+    while (differ < KEY_LENGTH && existingBytes[differ] == bytes[differ]) {
+        differ++;
+    }
+    if (differ == KEY_LENGTH) {
+        if (m_unique) {
+            return false;
+        }
+        appendValue(existing, data);
+        m_count++;
+        return true;
+    }
+    // Both keys get their own child of a node holding the bytes they share.
+    // Nothing else is under this leaf, so they end up next to each other.
+    Leaf *leaf = newLeaf(key, data);
+    *ref = newInner<Node4>(bytes + depth, differ - depth);
+    addChild(ref, existingBytes[differ], existing);
+    addChild(ref, bytes[differ], leaf);
+    if (bytes[differ] < existingBytes[differ]) {
+        linkBefore(leaf, existing);
+    } else {
+        linkAfter(leaf, existing);
+    }
+    m_count++;
+    return true;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool AdaptiveRadixTree<Key, Data, Compare, hasRank>::erase(const Key &key) {
+    iterator iter = find(key);
+    if (iter.isEnd()) return false;
+    return erase(iter);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool AdaptiveRadixTree<Key, Data, Compare, hasRank>::erase(iterator &iter) {
+    assert(!iter.isEnd());
+    Leaf *leaf = iter.m_leaf;
+    for (uint32_t ii = iter.m_slot; ii + 1 < leaf->count; ii++) {
+        leaf->values[ii] = leaf->values[ii + 1];
+    }
+    leaf->count--;
+    m_count--;
+    if (leaf->count == 0) {
+        removeLeaf(leaf);
+        releaseFreed();
+    }
+    return true;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::iterator
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::find(const Key &key) {
+    uint8_t bytes[KEY_LENGTH];
+    key.toRadix(bytes);
+    Node *node = m_root;
+    int depth = 0;
+    while (node && node->type != LEAF) {
+        Inner *inner = asInner(node);
+        if (::memcmp(inner->prefix, bytes + depth, inner->prefixLength) != 0) {
+            return iterator();
+        }
+        depth += inner->prefixLength;
+        Node **child = findChild(inner, bytes[depth]);
+        if (child == NULL) {
+            return iterator();
+        }
+        node = *child;
+        depth++;
+    }
+    if (node == NULL || m_comper(key, asLeaf(node)->key) != 0) {
+        return iterator();
+    }
+    return iterator(asLeaf(node), 0);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::iterator
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::lowerBound(const Key &key) {
+    if (m_root == NULL) return iterator();
+    uint8_t bytes[KEY_LENGTH];
+    key.toRadix(bytes);
+    return iterator(lowerBoundLeaf(m_root, bytes, 0), 0);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::iterator
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::upperBound(const Key &key) {
+    iterator iter = lowerBound(key);
+    if (!iter.isEnd() && m_comper(key, iter.key()) == 0) {
+        return iterator(iter.m_leaf->next, 0);
+    }
+    return iter;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+std::pair<typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::iterator,
+          typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::iterator>
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::equalRange(const Key &key) {
+    const iterator lower = lowerBound(key);
+    if (lower.isEnd() || m_comper(key, lower.key()) != 0) {
+        return std::pair<iterator, iterator>(lower, lower);
+    }
+    return std::pair<iterator, iterator>(lower, iterator(lower.m_leaf->next, 0));
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Leaf *
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::lowerBoundLeaf(Node *node, const uint8_t *bytes, int depth) const {
+    // Everything beside the path is entirely below or entirely above the
+    // key, so when a subtree turns out to be below it, the answer is
+    // whatever leaf follows that subtree's last one.
+    if (node->type == LEAF) {
+        Leaf *leaf = asLeaf(node);
+        uint8_t leafBytes[KEY_LENGTH];
+        leaf->key.toRadix(leafBytes);
+        return ::memcmp(leafBytes + depth, bytes + depth, KEY_LENGTH - depth) >= 0 ? leaf : leaf->next;
+    }
+    Inner *inner = asInner(node);
+    for (int ii = 0; ii < inner->prefixLength; ii++) {
+        if (inner->prefix[ii] != bytes[depth + ii]) {
+            return inner->prefix[ii] > bytes[depth + ii] ? minLeaf(inner) : maxLeaf(inner)->next;
+        }
+    }
+    depth += inner->prefixLength;
+    Node **child = findChild(inner, bytes[depth]);
+    if (child) {
+        return lowerBoundLeaf(*child, bytes, depth + 1);
+    }
+    Node *next = nextChild(inner, bytes[depth]);
+    return next ? minLeaf(next) : maxLeaf(inner)->next;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Node **
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::findChild(Inner *inner, uint8_t byte) {
+    switch (inner->type) {
+    case NODE4: {
+        Node4 *node = static_cast<Node4*>(inner);
+        for (int ii = 0; ii < node->count; ii++) {
+            if (node->keys[ii] == byte) return &node->children[ii];
+        }
+        return NULL;
+    }
+    case NODE16: {
+        Node16 *node = static_cast<Node16*>(inner);
+#ifdef __SSE2__
+        // compare all 16 key bytes at once
+        const __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(node->keys)));
+        const int mask = _mm_movemask_epi8(matches) & ((1 << node->count) - 1);
+        return mask ? &node->children[__builtin_ctz(mask)] : NULL;
+#else
+        for (int ii = 0; ii < node->count; ii++) {
+            if (node->keys[ii] == byte) return &node->children[ii];
+        }
+        return NULL;
+#endif
+    }
+    case NODE48: {
+        Node48 *node = static_cast<Node48*>(inner);
+        return node->slots[byte] ? &node->children[node->slots[byte] - 1] : NULL;
+    }
+    default: {
+        Node256 *node = static_cast<Node256*>(inner);
+        return node->children[byte] ? &node->children[byte] : NULL;
+    }
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Node *
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::nextChild(Inner *inner, int after, int *byte) {
+    int found = 256;
+    Node *child = NULL;
+    switch (inner->type) {
+    case NODE4: {
+        Node4 *node = static_cast<Node4*>(inner);
+        for (int ii = 0; ii < node->count && child == NULL; ii++) {
+            if (node->keys[ii] > after) {
+                found = node->keys[ii];
+                child = node->children[ii];
+            }
+        }
+        break;
+    }
+    case NODE16: {
+        Node16 *node = static_cast<Node16*>(inner);
+        for (int ii = 0; ii < node->count && child == NULL; ii++) {
+            if (node->keys[ii] > after) {
+                found = node->keys[ii];
+                child = node->children[ii];
+            }
+        }
+        break;
+    }
+    case NODE48: {
+        Node48 *node = static_cast<Node48*>(inner);
+        for (found = after + 1; found < 256 && !node->slots[found]; found++) {
+        }
+        if (found < 256) {
+            child = node->children[node->slots[found] - 1];
+        }
+        break;
+    }
+    default: {
+        Node256 *node = static_cast<Node256*>(inner);
+        for (found = after + 1; found < 256 && !node->children[found]; found++) {
+        }
+        if (found < 256) {
+            child = node->children[found];
+        }
+        break;
+    }
+    }
+    if (byte) {
+        *byte = found;
+    }
+    return child;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Node *
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::prevChild(Inner *inner, int before) {
+    switch (inner->type) {
+    case NODE4: {
+        Node4 *node = static_cast<Node4*>(inner);
+        for (int ii = node->count - 1; ii >= 0; ii--) {
+            if (node->keys[ii] < before) return node->children[ii];
+        }
+        return NULL;
+    }
+    case NODE16: {
+        Node16 *node = static_cast<Node16*>(inner);
+        for (int ii = node->count - 1; ii >= 0; ii--) {
+            if (node->keys[ii] < before) return node->children[ii];
+        }
+        return NULL;
+    }
+    case NODE48: {
+        Node48 *node = static_cast<Node48*>(inner);
+        for (int byte = before - 1; byte >= 0; byte--) {
+            if (node->slots[byte]) return node->children[node->slots[byte] - 1];
+        }
+        return NULL;
+    }
+    default: {
+        Node256 *node = static_cast<Node256*>(inner);
+        for (int byte = before - 1; byte >= 0; byte--) {
+            if (node->children[byte]) return node->children[byte];
+        }
+        return NULL;
+    }
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Leaf *
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::minLeaf(Node *node) {
+    while (node->type != LEAF) {
+        node = nextChild(asInner(node), -1);
+    }
+    return asLeaf(node);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Leaf *
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::maxLeaf(Node *node) {
+    while (node->type != LEAF) {
+        node = prevChild(asInner(node), 256);
+    }
+    return asLeaf(node);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::addChild(Node **ref, uint8_t byte, Node *child) {
+    Inner *inner = asInner(*ref);
+    switch (inner->type) {
+    case NODE4: {
+        Node4 *node = static_cast<Node4*>(inner);
+        if (node->count == 4) {
+            *ref = resize<Node4, Node16>(node);
+            addChild(ref, byte, child);
+            return;
+        }
+        int slot = node->count;
+        for (; slot > 0 && node->keys[slot - 1] > byte; slot--) {
+            node->keys[slot] = node->keys[slot - 1];
+            node->children[slot] = node->children[slot - 1];
+        }
+        node->keys[slot] = byte;
+        node->children[slot] = child;
+        break;
+    }
+    case NODE16: {
+        Node16 *node = static_cast<Node16*>(inner);
+        if (node->count == 16) {
+            *ref = resize<Node16, Node48>(node);
+            addChild(ref, byte, child);
+            return;
+        }
+        int slot = node->count;
+        for (; slot > 0 && node->keys[slot - 1] > byte; slot--) {
+            node->keys[slot] = node->keys[slot - 1];
+            node->children[slot] = node->children[slot - 1];
+        }
+        node->keys[slot] = byte;
+        node->children[slot] = child;
+        break;
+    }
+    case NODE48: {
+        Node48 *node = static_cast<Node48*>(inner);
+        if (node->count == 48) {
+            *ref = resize<Node48, Node256>(node);
+            addChild(ref, byte, child);
+            return;
+        }
+        int slot = 0;
+        while (node->children[slot] != NULL) {
+            slot++;
+        }
+        node->children[slot] = child;
+        node->slots[byte] = static_cast<uint8_t>(slot + 1);
+        break;
+    }
+    default:
+        static_cast<Node256*>(inner)->children[byte] = child;
+        break;
+    }
+    inner->count++;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::removeChild(Node **ref, uint8_t byte) {
+    // Shrink a little below where the smaller node would be full, so a
+    // child coming and going at the boundary doesn't resize every time
+    Inner *inner = asInner(*ref);
+    switch (inner->type) {
+    case NODE4: {
+        Node4 *node = static_cast<Node4*>(inner);
+        int slot = 0;
+        while (node->keys[slot] != byte) {
+            slot++;
+        }
+        for (; slot < node->count - 1; slot++) {
+            node->keys[slot] = node->keys[slot + 1];
+            node->children[slot] = node->children[slot + 1];
+        }
+        node->count--;
+        if (node->count == 1) {
+            collapse(ref, node->keys[0], node->children[0]);
+        }
+        return;
+    }
+    case NODE16: {
+        Node16 *node = static_cast<Node16*>(inner);
+        int slot = 0;
+        while (node->keys[slot] != byte) {
+            slot++;
+        }
+        for (; slot < node->count - 1; slot++) {
+            node->keys[slot] = node->keys[slot + 1];
+            node->children[slot] = node->children[slot + 1];
+        }
+        node->count--;
+        if (node->count == 3) {
+            *ref = resize<Node16, Node4>(node);
+        }
+        return;
+    }
+    case NODE48: {
+        Node48 *node = static_cast<Node48*>(inner);
+        node->children[node->slots[byte] - 1] = NULL;
+        node->slots[byte] = 0;
+        node->count--;
+        if (node->count == 12) {
+            *ref = resize<Node48, Node16>(node);
+        }
+        return;
+    }
+    default: {
+        Node256 *node = static_cast<Node256*>(inner);
+        node->children[byte] = NULL;
+        node->count--;
+        if (node->count == 37) {
+            *ref = resize<Node256, Node48>(node);
+        }
+        return;
+    }
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+template<typename From, typename To>
+To *AdaptiveRadixTree<Key, Data, Compare, hasRank>::resize(From *from) {
+    To *to = newInner<To>(from->prefix, from->prefixLength);
+    // the children always fit, so this never replaces to
+    Node *node = to;
+    int byte = -1;
+    for (Node *child = nextChild(from, byte, &byte); child != NULL; child = nextChild(from, byte, &byte)) {
+        addChild(&node, static_cast<uint8_t>(byte), child);
+    }
+    assert(node == to);
+    freeNode(from);
+    return to;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::collapse(Node **ref, uint8_t byte, Node *child) {
+    Inner *inner = asInner(*ref);
+    if (child->type != LEAF) {
+        // the child takes over the node's prefix and its own byte
+        Inner *only = asInner(child);
+        uint8_t prefix[KEY_LENGTH];
+        int length = inner->prefixLength;
+        ::memcpy(prefix, inner->prefix, length);
+        prefix[length++] = byte;
+        ::memcpy(prefix + length, only->prefix, only->prefixLength);
+        length += only->prefixLength;
+        ::memcpy(only->prefix, prefix, length);
+        only->prefixLength = static_cast<uint8_t>(length);
+    }
+    *ref = child;
+    freeNode(inner);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Leaf *
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::newLeaf(const Key &key, const Data &data) {
+    void *memory = m_leafAllocator.alloc();
+    Leaf *leaf = new (memory) Leaf();
+    leaf->type = LEAF;
+    leaf->key = key;
+    leaf->prev = leaf->next = NULL;
+    leaf->count = 1;
+    leaf->capacity = 1;
+    leaf->values = &leaf->inlineValue;
+    leaf->inlineValue = data;
+    return leaf;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::appendValue(Leaf *leaf, const Data &data) {
+    if (leaf->count == leaf->capacity) {
+        const uint32_t capacity = leaf->capacity * 2;
+        Data *values = newValues(leaf, capacity);
+        for (uint32_t ii = 0; ii < leaf->count; ii++) {
+            values[ii] = leaf->values[ii];
+        }
+        if (leaf->values != &leaf->inlineValue) {
+            releaseValues(leaf->values, leaf->capacity);
+        }
+        leaf->values = values;
+        leaf->capacity = capacity;
+    }
+    leaf->values[leaf->count++] = data;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::removeLeaf(Leaf *leaf) {
+    uint8_t bytes[KEY_LENGTH];
+    leaf->key.toRadix(bytes);
+    Node **ref = &m_root;
+    Node **parent = NULL;
+    uint8_t byte = 0;
+    int depth = 0;
+    while ((*ref)->type != LEAF) {
+        Inner *inner = asInner(*ref);
+        depth += inner->prefixLength;
+        parent = ref;
+        byte = bytes[depth];
+        ref = findChild(inner, byte);
+        depth++;
+    }
+    assert(*ref == leaf);
+    if (parent == NULL) {
+        m_root = NULL;
+    } else {
+        removeChild(parent, byte);
+    }
+
+    if (leaf->prev) {
+        leaf->prev->next = leaf->next;
+    } else {
+        m_first = leaf->next;
+    }
+    if (leaf->next) {
+        leaf->next->prev = leaf->prev;
+    } else {
+        m_last = leaf->prev;
+    }
+    freeNode(leaf);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::linkBefore(Leaf *leaf, Leaf *next) {
+    leaf->next = next;
+    leaf->prev = next->prev;
+    if (next->prev) {
+        next->prev->next = leaf;
+    } else {
+        m_first = leaf;
+    }
+    next->prev = leaf;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::linkAfter(Leaf *leaf, Leaf *prev) {
+    leaf->prev = prev;
+    leaf->next = prev->next;
+    if (prev->next) {
+        prev->next->prev = leaf;
+    } else {
+        m_last = leaf;
+    }
+    prev->next = leaf;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+template<typename NodeKind>
+NodeKind *AdaptiveRadixTree<Key, Data, Compare, hasRank>::newInner(const uint8_t *prefix, int prefixLength) {
+    void *memory = allocatorFor(NodeKind::KIND).alloc();
+    ::memset(memory, 0, sizeof(NodeKind));
+    NodeKind *node = new (memory) NodeKind;
+    node->type = NodeKind::KIND;
+    node->prefixLength = static_cast<uint8_t>(prefixLength);
+    ::memmove(node->prefix, prefix, prefixLength);
+    return node;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::freeNode(Node *node) {
+    if (node->type == LEAF) {
+        // only live leaves own value arrays, so moving one only repoints a live leaf
+        Leaf *leaf = asLeaf(node);
+        if (leaf->values != &leaf->inlineValue) {
+            releaseValues(leaf->values, leaf->capacity);
+            leaf->values = &leaf->inlineValue;
+        }
+    }
+    m_freed.push_back(node);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+ContiguousAllocator &AdaptiveRadixTree<Key, Data, Compare, hasRank>::allocatorFor(uint8_t type) {
+    switch (type) {
+    case LEAF:
+        return m_leafAllocator;
+    case NODE4:
+        return m_node4Allocator;
+    case NODE16:
+        return m_node16Allocator;
+    case NODE48:
+        return m_node48Allocator;
+    default:
+        return m_node256Allocator;
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::releaseFreed() {
+    while (!m_freed.empty()) {
+        Node *hole = m_freed.back();
+        m_freed.pop_back();
+        ContiguousAllocator &allocator = allocatorFor(hole->type);
+        Node *last = static_cast<Node*>(allocator.last());
+        if (last != hole) {
+            typename std::vector<Node*>::iterator pending = std::find(m_freed.begin(), m_freed.end(), last);
+            if (pending != m_freed.end()) {
+                // the last node is going too; the hole waits its turn
+                *pending = hole;
+            } else {
+                relocate(last, hole);
+            }
+        }
+        destroy(last);
+        allocator.trim();
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::relocate(Node *from, Node *to) {
+    Node **ref = refTo(from);
+    switch (from->type) {
+    case LEAF: {
+        Leaf *source = asLeaf(from);
+        Leaf *leaf = new (to) Leaf(*source);
+        if (source->values == &source->inlineValue) {
+            leaf->values = &leaf->inlineValue;
+        } else {
+            ownerOf(leaf->values) = leaf;
+        }
+        if (leaf->prev) {
+            leaf->prev->next = leaf;
+        } else {
+            m_first = leaf;
+        }
+        if (leaf->next) {
+            leaf->next->prev = leaf;
+        } else {
+            m_last = leaf;
+        }
+        break;
+    }
+    case NODE4:
+        new (to) Node4(*static_cast<Node4*>(from));
+        break;
+    case NODE16:
+        new (to) Node16(*static_cast<Node16*>(from));
+        break;
+    case NODE48:
+        new (to) Node48(*static_cast<Node48*>(from));
+        break;
+    default:
+        new (to) Node256(*static_cast<Node256*>(from));
+        break;
+    }
+    *ref = to;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename AdaptiveRadixTree<Key, Data, Compare, hasRank>::Node **
+AdaptiveRadixTree<Key, Data, Compare, hasRank>::refTo(Node *node) {
+    // any key under the node leads to it
+    uint8_t bytes[KEY_LENGTH];
+    minLeaf(node)->key.toRadix(bytes);
+    Node **ref = &m_root;
+    int depth = 0;
+    while (*ref != node) {
+        Inner *inner = asInner(*ref);
+        depth += inner->prefixLength;
+        ref = findChild(inner, bytes[depth]);
+        depth++;
+    }
+    return ref;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::destroy(Node *node) {
+    switch (node->type) {
+    case LEAF:
+        asLeaf(node)->~Leaf();
+        break;
+    case NODE4:
+        static_cast<Node4*>(node)->~Node4();
+        break;
+    case NODE16:
+        static_cast<Node16*>(node)->~Node16();
+        break;
+    case NODE48:
+        static_cast<Node48*>(node)->~Node48();
+        break;
+    default:
+        static_cast<Node256*>(node)->~Node256();
+        break;
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::destroySubtree(Node *node) {
+    if (node->type == LEAF) {
+        Leaf *leaf = asLeaf(node);
+        if (leaf->values != &leaf->inlineValue) {
+            for (uint32_t ii = 0; ii < leaf->capacity; ii++) {
+                leaf->values[ii].~Data();
+            }
+        }
+    } else {
+        Inner *inner = asInner(node);
+        int byte = -1;
+        for (Node *child = nextChild(inner, byte, &byte); child != NULL; child = nextChild(inner, byte, &byte)) {
+            destroySubtree(child);
+        }
+    }
+    destroy(node);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+ContiguousAllocator &AdaptiveRadixTree<Key, Data, Compare, hasRank>::valueAllocatorFor(uint32_t capacity) {
+    const int size = __builtin_ctz(capacity);
+    if (m_valueAllocators[size] == NULL) {
+        const int32_t bytes = static_cast<int32_t>(sizeof(Leaf*) + sizeof(Data) * capacity);
+        m_valueAllocators[size] = new ContiguousAllocator(bytes, std::max(1, VALUE_BUFFER_SIZE / bytes));
+    }
+    return *m_valueAllocators[size];
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+Data *AdaptiveRadixTree<Key, Data, Compare, hasRank>::newValues(Leaf *owner, uint32_t capacity) {
+    char *memory = static_cast<char*>(valueAllocatorFor(capacity).alloc());
+    Data *values = reinterpret_cast<Data*>(memory + sizeof(Leaf*));
+    for (uint32_t ii = 0; ii < capacity; ii++) {
+        new (values + ii) Data();
+    }
+    ownerOf(values) = owner;
+    return values;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void AdaptiveRadixTree<Key, Data, Compare, hasRank>::releaseValues(Data *values, uint32_t capacity) {
+    ContiguousAllocator &allocator = valueAllocatorFor(capacity);
+    Data *last = reinterpret_cast<Data*>(static_cast<char*>(allocator.last()) + sizeof(Leaf*));
+    if (last != values) {
+        for (uint32_t ii = 0; ii < capacity; ii++) {
+            values[ii] = last[ii];
+        }
+        ownerOf(values) = ownerOf(last);
+        ownerOf(values)->values = values;
+    }
+    for (uint32_t ii = 0; ii < capacity; ii++) {
+        last[ii].~Data();
+    }
+    allocator.trim();
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool AdaptiveRadixTree<Key, Data, Compare, hasRank>::verify() const {
+    if (m_root == NULL) {
+        return m_count == 0 && m_first == NULL && m_last == NULL;
+    }
+    uint8_t path[KEY_LENGTH];
+    const Leaf *expected = m_first;
+    int64_t count = 0;
+    int64_t nodes[NODE256 + 1] = { 0 };
+    if (!verify(m_root, path, 0, expected, count, nodes)) return false;
+    // every allocated node is in the tree
+    return expected == NULL && count == m_count && m_freed.empty() &&
+           nodes[LEAF] == m_leafAllocator.count() && nodes[NODE4] == m_node4Allocator.count() &&
+           nodes[NODE16] == m_node16Allocator.count() && nodes[NODE48] == m_node48Allocator.count() &&
+           nodes[NODE256] == m_node256Allocator.count();
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool AdaptiveRadixTree<Key, Data, Compare, hasRank>::verify(Node *node, uint8_t *path, int depth,
+                                                          const Leaf *&expected, int64_t &count,
+                                                          int64_t *nodes) const {
+    nodes[node->type]++;
+    if (node->type == LEAF) {
+        // leaves come up in the order they are chained, with keys on their path
+        const Leaf *leaf = asLeaf(node);
+        if (leaf != expected || leaf->count == 0 || leaf->count > leaf->capacity) return false;
+        if (leaf->next && leaf->next->prev != leaf) return false;
+        if ((leaf->prev == NULL) != (leaf == m_first) || (leaf->next == NULL) != (leaf == m_last)) return false;
+        if (leaf->values != &leaf->inlineValue && ownerOf(leaf->values) != leaf) return false;
+        uint8_t bytes[KEY_LENGTH];
+        leaf->key.toRadix(bytes);
+        if (::memcmp(bytes, path, depth) != 0) return false;
+        expected = leaf->next;
+        count += leaf->count;
+        return true;
+    }
+    Inner *inner = asInner(node);
+    const int minimum = inner->type == NODE4 ? 2 : inner->type == NODE16 ? 4 :
+                        inner->type == NODE48 ? 13 : 38;
+    if (inner->count < minimum || depth + inner->prefixLength >= KEY_LENGTH) return false;
+    ::memcpy(path + depth, inner->prefix, inner->prefixLength);
+    depth += inner->prefixLength;
+    int children = 0;
+    int byte = -1;
+    for (Node *child = nextChild(inner, byte, &byte); child != NULL; child = nextChild(inner, byte, &byte)) {
+        Node **slot = findChild(inner, static_cast<uint8_t>(byte));
+        if (slot == NULL || *slot != child) return false;
+        path[depth] = static_cast<uint8_t>(byte);
+        if (!verify(child, path, depth + 1, expected, count, nodes)) return false;
+        children++;
+    }
+    return children == inner->count;
+}
+
+} // namespace voltdb
+
+#endif // ADAPTIVERADIXTREE_H_
@@ -0,0 +1,1105 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COMPACTINGBTREE_H_
+#define COMPACTINGBTREE_H_
+
+#include <cstdlib>
+#include <stdint.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <new>
+#include "ContiguousAllocator.h"
+
+namespace voltdb {
+
+/**
+ * Entries under each child of a CompactingBTree inner node, kept only
+ * when the tree has rank.
+ */
+template<bool hasRank, int size>
+struct BTreeSubtreeCounts {
+    int64_t m_counts[size];
+    int64_t get(int ii) const { return m_counts[ii]; }
+    void set(int ii, int64_t count) { m_counts[ii] = count; }
+    void add(int ii, int64_t delta) { m_counts[ii] += delta; }
+};
+
+template<int size>
+struct BTreeSubtreeCounts<false, size> {
+    int64_t get(int) const { return 0; }
+    void set(int, int64_t) {}
+    void add(int, int64_t) {}
+};
+
+/**
+ * B+tree with the interface of CompactingMap, for tree indexes.
+ *
+ * A red-black tree takes a dependent cache miss per level, and there are
+ * over 25 levels to a 100M key index. Here every node is NODE_SIZE bytes,
+ * a handful of cache lines on a cache line boundary, holding as many keys
+ * as fit. The keys of a node sit next to each other for the binary
+ * search, ahead of the values or child pointers. For 8 byte keys that is
+ * 30 entries per leaf and a fanout over 20, so the same index is six
+ * levels deep. The leaves are chained for scans, and with hasRank every
+ * inner node keeps the entry count under each child, for rankAsc() and
+ * findRank() in a walk from the root.
+ *
+ * Like CompactingMap, nodes are packed into ContiguousAllocators and a
+ * freed node is filled with the last one allocated, so deletes give
+ * memory back. Iterators are invalidated by any mutation.
+ *
+ * Inner nodes keep copies of keys as separators, and those may outlive
+ * the entries they were copied from. So keys must be plain values: a
+ * copy has to stay comparable after the original is gone, which rules
+ * out keys pointing at tuples or at non-inlined storage (TupleKey,
+ * GenericKey over out-of-line columns, GenericPersistentKey). Those stay
+ * on CompactingMap, see TableIndexPicker.
+ */
+template<typename Key, typename Data, typename Compare, bool hasRank=false>
+class CompactingBTree {
+public:
+    /** Bytes per node, eight cache lines */
+    static const int NODE_SIZE = 512;
+
+protected:
+    static const int CACHE_LINE_SIZE = 64;
+    // keys lowerBoundBatch() walks down together
+    static const size_t PREFETCH_BATCH = 16;
+
+    struct InnerNode;
+
+    struct Node {
+        InnerNode *parent;
+        // entries of a leaf, keys of an inner node
+        uint16_t count;
+        bool isLeaf;
+    };
+
+    enum {
+        LEAF_FIT = (NODE_SIZE - sizeof(Node) - 2 * sizeof(void*)) / (sizeof(Key) + sizeof(Data)),
+        LEAF_CAPACITY = LEAF_FIT > 4 ? LEAF_FIT : 4,
+        LEAF_MINIMUM = LEAF_CAPACITY / 2,
+        INNER_FIT = (NODE_SIZE - sizeof(Node) - sizeof(void*) - (hasRank ? sizeof(int64_t) : 0)) /
+                    (sizeof(Key) + sizeof(void*) + (hasRank ? sizeof(int64_t) : 0)),
+        INNER_CAPACITY = INNER_FIT > 4 ? INNER_FIT : 4,
+        INNER_MINIMUM = INNER_CAPACITY / 2
+    };
+
+    struct LeafNode : public Node {
+        LeafNode *prev;
+        LeafNode *next;
+        Key keys[LEAF_CAPACITY];
+        Data values[LEAF_CAPACITY];
+    };
+
+    /**
+     * Everything under children[i] is at least keys[i-1] and at most
+     * keys[i]. Separators aren't updated when entries go away, so they
+     * need not be keys still in the tree.
+     */
+    struct InnerNode : public Node {
+        Key keys[INNER_CAPACITY];
+        Node *children[INNER_CAPACITY + 1];
+        BTreeSubtreeCounts<hasRank, INNER_CAPACITY + 1> counts;
+    };
+
+    int64_t m_count;
+    Node *m_root;
+    LeafNode *m_first;
+    LeafNode *m_last;
+    ContiguousAllocator m_leafAllocator;
+    ContiguousAllocator m_innerAllocator;
+    bool m_unique;
+
+    // templated comparison function object
+    // follows STL conventions
+    Compare m_comper;
+
+    // nodes emptied by an erase, released once the tree is whole again
+    std::vector<Node*> m_freed;
+
+public:
+
+    class iterator {
+        friend class CompactingBTree<Key, Data, Compare, hasRank>;
+    protected:
+        LeafNode *m_leaf;
+        int m_slot;
+        iterator(LeafNode *leaf, int slot) : m_leaf(leaf), m_slot(slot) {}
+    public:
+        iterator() : m_leaf(NULL), m_slot(0) {}
+        iterator(const iterator &iter) : m_leaf(iter.m_leaf), m_slot(iter.m_slot) {}
+        Key &key() const { return m_leaf->keys[m_slot]; }
+        Data &value() const { return m_leaf->values[m_slot]; }
+        void setValue(const Data &value) { m_leaf->values[m_slot] = value; }
+        void moveNext() {
+            if (++m_slot == m_leaf->count) {
+                m_leaf = m_leaf->next;
+                m_slot = 0;
+            }
+        }
+        void movePrev() {
+            if (m_slot-- == 0) {
+                m_leaf = m_leaf->prev;
+                m_slot = m_leaf ? m_leaf->count - 1 : 0;
+            }
+        }
+        bool isEnd() const { return m_leaf == NULL; }
+        bool equals(const iterator &iter) const {
+            if (isEnd()) return iter.isEnd();
+            return m_leaf == iter.m_leaf && m_slot == iter.m_slot;
+        }
+    };
+
+    /** Orders key/value pairs by key, for sorting entries before bulkLoad() */
+    class EntryLess {
+        Compare m_comper;
+    public:
+        EntryLess(const Compare &comper) : m_comper(comper) {}
+        bool operator()(const std::pair<Key, Data> &lhs, const std::pair<Key, Data> &rhs) const {
+            return m_comper(lhs.first, rhs.first) < 0;
+        }
+    };
+
+    CompactingBTree(bool unique, Compare comper);
+    ~CompactingBTree();
+
+    /**
+     * Fill an empty tree with entries, which must be sorted by key and,
+     * for a unique tree, hold no key twice. Leaves are filled up one
+     * after the other, then each level of inner nodes above them.
+     */
+    void bulkLoad(const std::vector<std::pair<Key, Data> > &entries);
+
+    bool insert(std::pair<Key, Data> value) { return insert(value.first, value.second); }
+    bool insert(const Key &key, const Data &data);
+    bool erase(const Key &key);
+    bool erase(iterator &iter);
+    iterator find(const Key &key);
+    iterator findRank(int64_t ith);
+    int64_t size() const { return m_count; }
+    iterator begin() const {
+        if (!m_count) return iterator();
+        return iterator(m_first, 0);
+    }
+    iterator rbegin() const {
+        if (!m_count) return iterator();
+        return iterator(m_last, m_last->count - 1);
+    }
+
+    iterator lowerBound(const Key &key);
+    iterator upperBound(const Key &key);
+    /**
+     * lowerBound() of each of count keys. The paths of a batch of keys
+     * are walked down a level at a time, prefetching the next level's
+     * nodes, so the cache misses of different keys overlap.
+     */
+    void lowerBoundBatch(const Key *keys, size_t count, iterator *found);
+
+    std::pair<iterator, iterator> equalRange(const Key &key);
+
+    size_t bytesAllocated() const {
+        return m_leafAllocator.bytesAllocated() + m_innerAllocator.bytesAllocated();
+    }
+
+    // Must pass a key that already in map, or else return -1
+    int64_t rankAsc(const Key& key);
+    int64_t rankUpper(const Key& key);
+
+    /**
+     * For debugging: verify ordering, occupancy, links and counts. SLOW.
+     */
+    bool verify() const;
+    bool verifyRank();
+
+protected:
+    static LeafNode *asLeaf(Node *node) { return static_cast<LeafNode*>(node); }
+    static InnerNode *asInner(Node *node) { return static_cast<InnerNode*>(node); }
+
+    /** First slot whose key is not less than key */
+    int lowerSlot(const Key *keys, int count, const Key &key) const;
+    /** First slot whose key is greater than key */
+    int upperSlot(const Key *keys, int count, const Key &key) const;
+    /**
+     * The leaf holding the lower (or upper) bound of key, or the leaf
+     * before it. Adds the entries left of the path to before, if given.
+     */
+    LeafNode *descend(const Key &key, bool upper, int64_t *before) const;
+    /** An iterator at slot, which may be one past the leaf's last entry */
+    static iterator resolve(LeafNode *leaf, int slot) {
+        if (slot == leaf->count) {
+            return iterator(leaf->next, 0);
+        }
+        return iterator(leaf, slot);
+    }
+
+    static int childSlot(const InnerNode *parent, const Node *child);
+    static int64_t subtreeCount(Node *node);
+    void adjustCounts(Node *node, int64_t delta);
+
+    LeafNode *allocateLeaf();
+    InnerNode *allocateInner();
+
+    void insertIntoLeaf(LeafNode *leaf, int slot, const Key &key, const Data &data);
+    void splitLeaf(LeafNode *leaf, int slot, const Key &key, const Data &data);
+    void insertIntoParent(Node *left, const Key &separator, Node *right);
+    void insertIntoInner(InnerNode *inner, int slot, const Key &separator, Node *child);
+    void splitInner(InnerNode *inner, int slot, const Key &separator, Node *child);
+    void moveChild(InnerNode *from, int fromSlot, InnerNode *to, int toSlot);
+
+    void removeFromInner(InnerNode *inner, int slot);
+    void rebalanceLeaf(LeafNode *leaf);
+    void mergeLeaves(LeafNode *left, LeafNode *right, InnerNode *parent, int slot);
+    void rebalanceInner(InnerNode *inner);
+    void mergeInner(InnerNode *left, InnerNode *right, InnerNode *parent, int slot);
+
+    /** Free the nodes on m_freed, filling the holes with the last allocated nodes */
+    void releaseFreed();
+    void relocate(Node *from, Node *to);
+    static void destroy(Node *node);
+    void destroySubtree(Node *node);
+
+    static size_t chunkSize(size_t remaining, size_t capacity, size_t minimum);
+
+    int64_t verify(const Node *node, const Key *low, const Key *high, int depth, int &leafDepth) const;
+};
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+CompactingBTree<Key, Data, Compare, hasRank>::CompactingBTree(bool unique, Compare comper)
+    : m_count(0),
+      m_root(NULL),
+      m_first(NULL),
+      m_last(NULL),
+      m_leafAllocator(static_cast<int32_t>((sizeof(LeafNode) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1)), 256),
+      m_innerAllocator(static_cast<int32_t>((sizeof(InnerNode) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1)), 32),
+      m_unique(unique),
+      m_comper(comper)
+{
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+CompactingBTree<Key, Data, Compare, hasRank>::~CompactingBTree() {
+    if (m_root) {
+        destroySubtree(m_root);
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::bulkLoad(const std::vector<std::pair<Key, Data> > &entries) {
+    assert(m_count == 0 && m_root == NULL);
+    if (entries.empty()) {
+        return;
+    }
+    // the nodes of the level being built, and the smallest key under each
+    std::vector<Node*> level;
+    std::vector<const Key*> lowest;
+    size_t next = 0;
+    while (next < entries.size()) {
+        const size_t take = chunkSize(entries.size() - next, LEAF_CAPACITY, LEAF_MINIMUM);
+        LeafNode *leaf = allocateLeaf();
+        for (size_t ii = 0; ii < take; ii++) {
+            leaf->keys[ii] = entries[next + ii].first;
+            leaf->values[ii] = entries[next + ii].second;
+        }
+        leaf->count = static_cast<uint16_t>(take);
+        leaf->prev = m_last;
+        if (m_last) {
+            m_last->next = leaf;
+        } else {
+            m_first = leaf;
+        }
+        m_last = leaf;
+        level.push_back(leaf);
+        lowest.push_back(&leaf->keys[0]);
+        next += take;
+    }
+    while (level.size() > 1) {
+        std::vector<Node*> upper;
+        std::vector<const Key*> upperLowest;
+        next = 0;
+        while (next < level.size()) {
+            const size_t take = chunkSize(level.size() - next, INNER_CAPACITY + 1, INNER_MINIMUM + 1);
+            InnerNode *inner = allocateInner();
+            for (size_t ii = 0; ii < take; ii++) {
+                Node *child = level[next + ii];
+                const int slot = static_cast<int>(ii);
+                inner->children[slot] = child;
+                inner->counts.set(slot, subtreeCount(child));
+                child->parent = inner;
+                if (ii > 0) {
+                    inner->keys[slot - 1] = *lowest[next + ii];
+                }
+            }
+            inner->count = static_cast<uint16_t>(take - 1);
+            upper.push_back(inner);
+            upperLowest.push_back(lowest[next]);
+            next += take;
+        }
+        level.swap(upper);
+        lowest.swap(upperLowest);
+    }
+    m_root = level[0];
+    m_count = static_cast<int64_t>(entries.size());
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool CompactingBTree<Key, Data, Compare, hasRank>::insert(const Key &key, const Data &data) {
+    if (m_root == NULL) {
+        m_first = m_last = allocateLeaf();
+        m_root = m_first;
+    }
+    // Equal keys of a multimap go after the ones already there
+    Node *node = m_root;
+    while (!node->isLeaf) {
+        InnerNode *inner = asInner(node);
+        const int slot = m_unique ? lowerSlot(inner->keys, inner->count, key) :
+                                    upperSlot(inner->keys, inner->count, key);
+        if (hasRank) {
+            inner->counts.add(slot, 1);
+        }
+        node = inner->children[slot];
+    }
+    LeafNode *leaf = asLeaf(node);
+    int slot;
+    if (m_unique) {
+        slot = lowerSlot(leaf->keys, leaf->count, key);
+        const iterator existing = resolve(leaf, slot);
+        if (!existing.isEnd() && m_comper(key, existing.key()) == 0) {
+            if (hasRank) {
+                adjustCounts(leaf, -1);
+            }
+            return false;
+        }
+    } else {
+        slot = upperSlot(leaf->keys, leaf->count, key);
+    }
+    m_count++;
+    if (leaf->count < LEAF_CAPACITY) {
+        insertIntoLeaf(leaf, slot, key, data);
+    } else {
+        splitLeaf(leaf, slot, key, data);
+    }
+    return true;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool CompactingBTree<Key, Data, Compare, hasRank>::erase(const Key &key) {
+    iterator iter = find(key);
+    if (iter.isEnd()) return false;
+    return erase(iter);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool CompactingBTree<Key, Data, Compare, hasRank>::erase(iterator &iter) {
+    assert(!iter.isEnd());
+    LeafNode *leaf = iter.m_leaf;
+    for (int ii = iter.m_slot; ii < leaf->count - 1; ii++) {
+        leaf->keys[ii] = leaf->keys[ii + 1];
+        leaf->values[ii] = leaf->values[ii + 1];
+    }
+    leaf->count--;
+    m_count--;
+    if (hasRank) {
+        adjustCounts(leaf, -1);
+    }
+    if (leaf == m_root) {
+        if (leaf->count == 0) {
+            m_freed.push_back(leaf);
+            m_root = m_first = m_last = NULL;
+        }
+    } else if (leaf->count < LEAF_MINIMUM) {
+        rebalanceLeaf(leaf);
+    }
+    releaseFreed();
+    return true;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::iterator
+CompactingBTree<Key, Data, Compare, hasRank>::find(const Key &key) {
+    iterator iter = lowerBound(key);
+    if (!iter.isEnd() && m_comper(key, iter.key()) == 0) {
+        return iter;
+    }
+    return iterator();
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::iterator
+CompactingBTree<Key, Data, Compare, hasRank>::findRank(int64_t ith) {
+    if (!hasRank || ith <= 0 || ith > m_count) return iterator();
+    Node *node = m_root;
+    int64_t rank = ith;
+    while (!node->isLeaf) {
+        InnerNode *inner = asInner(node);
+        int slot = 0;
+        while (rank > inner->counts.get(slot)) {
+            rank -= inner->counts.get(slot);
+            slot++;
+        }
+        node = inner->children[slot];
+    }
+    return iterator(asLeaf(node), static_cast<int>(rank - 1));
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::iterator
+CompactingBTree<Key, Data, Compare, hasRank>::lowerBound(const Key &key) {
+    if (m_root == NULL) return iterator();
+    LeafNode *leaf = descend(key, false, NULL);
+    return resolve(leaf, lowerSlot(leaf->keys, leaf->count, key));
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::iterator
+CompactingBTree<Key, Data, Compare, hasRank>::upperBound(const Key &key) {
+    if (m_root == NULL) return iterator();
+    LeafNode *leaf = descend(key, true, NULL);
+    return resolve(leaf, upperSlot(leaf->keys, leaf->count, key));
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::lowerBoundBatch(const Key *keys, size_t count, iterator *found) {
+    Node *nodes[PREFETCH_BATCH];
+    for (size_t base = 0; base < count; base += PREFETCH_BATCH) {
+        const size_t batch = count - base < PREFETCH_BATCH ? count - base : PREFETCH_BATCH;
+        if (m_root == NULL) {
+            for (size_t ii = 0; ii < batch; ii++) {
+                found[base + ii] = iterator();
+            }
+            continue;
+        }
+        for (size_t ii = 0; ii < batch; ii++) {
+            nodes[ii] = m_root;
+        }
+        // all leaves are at the same depth
+        while (!nodes[0]->isLeaf) {
+            for (size_t ii = 0; ii < batch; ii++) {
+                InnerNode *inner = asInner(nodes[ii]);
+                nodes[ii] = inner->children[lowerSlot(inner->keys, inner->count, keys[base + ii])];
+                for (int line = 0; line < NODE_SIZE; line += CACHE_LINE_SIZE) {
+                    __builtin_prefetch(reinterpret_cast<const char*>(nodes[ii]) + line);
+                }
+            }
+        }
+        for (size_t ii = 0; ii < batch; ii++) {
+            LeafNode *leaf = asLeaf(nodes[ii]);
+            found[base + ii] = resolve(leaf, lowerSlot(leaf->keys, leaf->count, keys[base + ii]));
+        }
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+std::pair<typename CompactingBTree<Key, Data, Compare, hasRank>::iterator,
+          typename CompactingBTree<Key, Data, Compare, hasRank>::iterator>
+CompactingBTree<Key, Data, Compare, hasRank>::equalRange(const Key &key) {
+    const iterator lower = lowerBound(key);
+    if (lower.isEnd() || m_comper(key, lower.key()) != 0) {
+        return std::pair<iterator, iterator>(lower, lower);
+    }
+    return std::pair<iterator, iterator>(lower, upperBound(key));
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int64_t CompactingBTree<Key, Data, Compare, hasRank>::rankAsc(const Key& key) {
+    if (!hasRank || m_root == NULL) return -1;
+    int64_t before = 0;
+    LeafNode *leaf = descend(key, false, &before);
+    const int slot = lowerSlot(leaf->keys, leaf->count, key);
+    const iterator iter = resolve(leaf, slot);
+    // return -1 if the key passed in is not in the map
+    if (iter.isEnd() || m_comper(key, iter.key()) != 0) return -1;
+    return before + slot + 1;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int64_t CompactingBTree<Key, Data, Compare, hasRank>::rankUpper(const Key& key) {
+    if (!hasRank) return -1;
+    if (m_unique) return rankAsc(key);
+    // return -1 if the key passed in is not in the map
+    if (find(key).isEnd()) return -1;
+    int64_t before = 0;
+    LeafNode *leaf = descend(key, true, &before);
+    return before + upperSlot(leaf->keys, leaf->count, key);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int CompactingBTree<Key, Data, Compare, hasRank>::lowerSlot(const Key *keys, int count, const Key &key) const {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (m_comper(keys[middle], key) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int CompactingBTree<Key, Data, Compare, hasRank>::upperSlot(const Key *keys, int count, const Key &key) const {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (m_comper(key, keys[middle]) >= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::LeafNode *
+CompactingBTree<Key, Data, Compare, hasRank>::descend(const Key &key, bool upper, int64_t *before) const {
+    Node *node = m_root;
+    while (!node->isLeaf) {
+        InnerNode *inner = asInner(node);
+        const int slot = upper ? upperSlot(inner->keys, inner->count, key) :
+                                 lowerSlot(inner->keys, inner->count, key);
+        if (hasRank && before) {
+            for (int ii = 0; ii < slot; ii++) {
+                *before += inner->counts.get(ii);
+            }
+        }
+        node = inner->children[slot];
+    }
+    return asLeaf(node);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int CompactingBTree<Key, Data, Compare, hasRank>::childSlot(const InnerNode *parent, const Node *child) {
+    int slot = 0;
+    while (parent->children[slot] != child) {
+        slot++;
+        assert(slot <= parent->count);
+    }
+    return slot;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int64_t CompactingBTree<Key, Data, Compare, hasRank>::subtreeCount(Node *node) {
+    if (node->isLeaf) {
+        return node->count;
+    }
+    int64_t count = 0;
+    for (int ii = 0; ii <= node->count; ii++) {
+        count += asInner(node)->counts.get(ii);
+    }
+    return count;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::adjustCounts(Node *node, int64_t delta) {
+    for (; node->parent != NULL; node = node->parent) {
+        node->parent->counts.add(childSlot(node->parent, node), delta);
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::LeafNode *
+CompactingBTree<Key, Data, Compare, hasRank>::allocateLeaf() {
+    void *memory = m_leafAllocator.alloc();
+    assert(memory);
+    LeafNode *leaf = new(memory) LeafNode;
+    leaf->parent = NULL;
+    leaf->count = 0;
+    leaf->isLeaf = true;
+    leaf->prev = leaf->next = NULL;
+    return leaf;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingBTree<Key, Data, Compare, hasRank>::InnerNode *
+CompactingBTree<Key, Data, Compare, hasRank>::allocateInner() {
+    void *memory = m_innerAllocator.alloc();
+    assert(memory);
+    InnerNode *inner = new(memory) InnerNode;
+    inner->parent = NULL;
+    inner->count = 0;
+    inner->isLeaf = false;
+    return inner;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::insertIntoLeaf(LeafNode *leaf, int slot, const Key &key, const Data &data) {
+    for (int ii = leaf->count; ii > slot; ii--) {
+        leaf->keys[ii] = leaf->keys[ii - 1];
+        leaf->values[ii] = leaf->values[ii - 1];
+    }
+    leaf->keys[slot] = key;
+    leaf->values[slot] = data;
+    leaf->count++;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::splitLeaf(LeafNode *leaf, int slot, const Key &key, const Data &data) {
+    LeafNode *right = allocateLeaf();
+    // the new entry ends up in whichever half it falls into
+    const int split = (LEAF_CAPACITY + 1) / 2;
+    const int from = slot < split ? split - 1 : split;
+    for (int ii = from; ii < LEAF_CAPACITY; ii++) {
+        right->keys[ii - from] = leaf->keys[ii];
+        right->values[ii - from] = leaf->values[ii];
+    }
+    right->count = static_cast<uint16_t>(LEAF_CAPACITY - from);
+    leaf->count = static_cast<uint16_t>(from);
+    if (slot < split) {
+        insertIntoLeaf(leaf, slot, key, data);
+    } else {
+        insertIntoLeaf(right, slot - split, key, data);
+    }
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next) {
+        leaf->next->prev = right;
+    } else {
+        m_last = right;
+    }
+    leaf->next = right;
+
+    const Key separator = right->keys[0];
+    insertIntoParent(leaf, separator, right);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::insertIntoParent(Node *left, const Key &separator, Node *right) {
+    InnerNode *parent = left->parent;
+    if (parent == NULL) {
+        InnerNode *root = allocateInner();
+        root->count = 1;
+        root->keys[0] = separator;
+        root->children[0] = left;
+        root->children[1] = right;
+        root->counts.set(0, subtreeCount(left));
+        root->counts.set(1, subtreeCount(right));
+        left->parent = right->parent = root;
+        m_root = root;
+        return;
+    }
+    const int slot = childSlot(parent, left);
+    if (parent->count < INNER_CAPACITY) {
+        insertIntoInner(parent, slot, separator, right);
+        parent->counts.set(slot, subtreeCount(left));
+        parent->counts.set(slot + 1, subtreeCount(right));
+    } else {
+        splitInner(parent, slot, separator, right);
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::insertIntoInner(InnerNode *inner, int slot, const Key &separator, Node *child) {
+    for (int ii = inner->count; ii > slot; ii--) {
+        inner->keys[ii] = inner->keys[ii - 1];
+        inner->children[ii + 1] = inner->children[ii];
+        inner->counts.set(ii + 1, inner->counts.get(ii));
+    }
+    inner->keys[slot] = separator;
+    inner->children[slot + 1] = child;
+    inner->counts.set(slot + 1, subtreeCount(child));
+    inner->count++;
+    child->parent = inner;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::moveChild(InnerNode *from, int fromSlot, InnerNode *to, int toSlot) {
+    to->children[toSlot] = from->children[fromSlot];
+    to->counts.set(toSlot, from->counts.get(fromSlot));
+    to->children[toSlot]->parent = to;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::splitInner(InnerNode *inner, int slot, const Key &separator, Node *child) {
+    // inner is full; the left of the two children now at slot is children[slot]
+    Node *left = inner->children[slot];
+    InnerNode *right = allocateInner();
+    const int middle = INNER_CAPACITY / 2;
+    Key up;
+    if (slot < middle) {
+        // keys[middle - 1] goes up, the new child stays in this node
+        up = inner->keys[middle - 1];
+        for (int ii = middle; ii < INNER_CAPACITY; ii++) {
+            right->keys[ii - middle] = inner->keys[ii];
+        }
+        for (int ii = middle; ii <= INNER_CAPACITY; ii++) {
+            moveChild(inner, ii, right, ii - middle);
+        }
+        right->count = static_cast<uint16_t>(INNER_CAPACITY - middle);
+        inner->count = static_cast<uint16_t>(middle - 1);
+        insertIntoInner(inner, slot, separator, child);
+    } else if (slot == middle) {
+        // the new separator goes up, the new child starts the right node
+        up = separator;
+        right->children[0] = child;
+        right->counts.set(0, subtreeCount(child));
+        child->parent = right;
+        for (int ii = middle; ii < INNER_CAPACITY; ii++) {
+            right->keys[ii - middle] = inner->keys[ii];
+            moveChild(inner, ii + 1, right, ii - middle + 1);
+        }
+        right->count = static_cast<uint16_t>(INNER_CAPACITY - middle);
+        inner->count = static_cast<uint16_t>(middle);
+    } else {
+        // keys[middle] goes up, the new child goes to the right node
+        up = inner->keys[middle];
+        for (int ii = middle + 1; ii < INNER_CAPACITY; ii++) {
+            right->keys[ii - middle - 1] = inner->keys[ii];
+        }
+        for (int ii = middle + 1; ii <= INNER_CAPACITY; ii++) {
+            moveChild(inner, ii, right, ii - middle - 1);
+        }
+        right->count = static_cast<uint16_t>(INNER_CAPACITY - middle - 1);
+        inner->count = static_cast<uint16_t>(middle);
+        insertIntoInner(right, slot - middle - 1, separator, child);
+    }
+    if (hasRank) {
+        // left lost entries to its new sibling since its count was taken
+        left->parent->counts.set(childSlot(left->parent, left), subtreeCount(left));
+    }
+    insertIntoParent(inner, up, right);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::removeFromInner(InnerNode *inner, int slot) {
+    // drops keys[slot] and children[slot + 1]
+    for (int ii = slot; ii < inner->count - 1; ii++) {
+        inner->keys[ii] = inner->keys[ii + 1];
+    }
+    for (int ii = slot + 1; ii < inner->count; ii++) {
+        inner->children[ii] = inner->children[ii + 1];
+        inner->counts.set(ii, inner->counts.get(ii + 1));
+    }
+    inner->count--;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::rebalanceLeaf(LeafNode *leaf) {
+    InnerNode *parent = leaf->parent;
+    const int slot = childSlot(parent, leaf);
+    LeafNode *left = slot > 0 ? asLeaf(parent->children[slot - 1]) : NULL;
+    LeafNode *right = slot < parent->count ? asLeaf(parent->children[slot + 1]) : NULL;
+
+    if (left && left->count > LEAF_MINIMUM) {
+        insertIntoLeaf(leaf, 0, left->keys[left->count - 1], left->values[left->count - 1]);
+        left->count--;
+        parent->keys[slot - 1] = leaf->keys[0];
+        parent->counts.add(slot - 1, -1);
+        parent->counts.add(slot, 1);
+        return;
+    }
+    if (right && right->count > LEAF_MINIMUM) {
+        leaf->keys[leaf->count] = right->keys[0];
+        leaf->values[leaf->count] = right->values[0];
+        leaf->count++;
+        for (int ii = 0; ii < right->count - 1; ii++) {
+            right->keys[ii] = right->keys[ii + 1];
+            right->values[ii] = right->values[ii + 1];
+        }
+        right->count--;
+        parent->keys[slot] = right->keys[0];
+        parent->counts.add(slot, 1);
+        parent->counts.add(slot + 1, -1);
+        return;
+    }
+    if (left) {
+        mergeLeaves(left, leaf, parent, slot - 1);
+    } else {
+        mergeLeaves(leaf, right, parent, slot);
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::mergeLeaves(LeafNode *left, LeafNode *right, InnerNode *parent, int slot) {
+    // right is parent->children[slot + 1]
+    for (int ii = 0; ii < right->count; ii++) {
+        left->keys[left->count + ii] = right->keys[ii];
+        left->values[left->count + ii] = right->values[ii];
+    }
+    left->count = static_cast<uint16_t>(left->count + right->count);
+    left->next = right->next;
+    if (right->next) {
+        right->next->prev = left;
+    } else {
+        m_last = left;
+    }
+    parent->counts.add(slot, parent->counts.get(slot + 1));
+    removeFromInner(parent, slot);
+    m_freed.push_back(right);
+    rebalanceInner(parent);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::rebalanceInner(InnerNode *inner) {
+    if (inner == m_root) {
+        if (inner->count == 0) {
+            m_root = inner->children[0];
+            m_root->parent = NULL;
+            m_freed.push_back(inner);
+        }
+        return;
+    }
+    if (inner->count >= INNER_MINIMUM) {
+        return;
+    }
+    InnerNode *parent = inner->parent;
+    const int slot = childSlot(parent, inner);
+    InnerNode *left = slot > 0 ? asInner(parent->children[slot - 1]) : NULL;
+    InnerNode *right = slot < parent->count ? asInner(parent->children[slot + 1]) : NULL;
+
+    if (left && left->count > INNER_MINIMUM) {
+        // rotate left's last child over through the parent
+        for (int ii = inner->count; ii > 0; ii--) {
+            inner->keys[ii] = inner->keys[ii - 1];
+        }
+        for (int ii = inner->count + 1; ii > 0; ii--) {
+            inner->children[ii] = inner->children[ii - 1];
+            inner->counts.set(ii, inner->counts.get(ii - 1));
+        }
+        inner->keys[0] = parent->keys[slot - 1];
+        moveChild(left, left->count, inner, 0);
+        parent->keys[slot - 1] = left->keys[left->count - 1];
+        left->count--;
+        inner->count++;
+        const int64_t moved = inner->counts.get(0);
+        parent->counts.add(slot - 1, -moved);
+        parent->counts.add(slot, moved);
+        return;
+    }
+    if (right && right->count > INNER_MINIMUM) {
+        // rotate right's first child over through the parent
+        inner->keys[inner->count] = parent->keys[slot];
+        moveChild(right, 0, inner, inner->count + 1);
+        inner->count++;
+        parent->keys[slot] = right->keys[0];
+        for (int ii = 0; ii < right->count - 1; ii++) {
+            right->keys[ii] = right->keys[ii + 1];
+        }
+        for (int ii = 0; ii < right->count; ii++) {
+            right->children[ii] = right->children[ii + 1];
+            right->counts.set(ii, right->counts.get(ii + 1));
+        }
+        right->count--;
+        const int64_t moved = inner->counts.get(inner->count);
+        parent->counts.add(slot, moved);
+        parent->counts.add(slot + 1, -moved);
+        return;
+    }
+    if (left) {
+        mergeInner(left, inner, parent, slot - 1);
+    } else {
+        mergeInner(inner, right, parent, slot);
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::mergeInner(InnerNode *left, InnerNode *right, InnerNode *parent, int slot) {
+    // right is parent->children[slot + 1]; the separator between them comes down
+    left->keys[left->count] = parent->keys[slot];
+    for (int ii = 0; ii < right->count; ii++) {
+        left->keys[left->count + 1 + ii] = right->keys[ii];
+    }
+    for (int ii = 0; ii <= right->count; ii++) {
+        moveChild(right, ii, left, left->count + 1 + ii);
+    }
+    left->count = static_cast<uint16_t>(left->count + right->count + 1);
+    parent->counts.add(slot, parent->counts.get(slot + 1));
+    removeFromInner(parent, slot);
+    m_freed.push_back(right);
+    rebalanceInner(parent);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::releaseFreed() {
+    while (!m_freed.empty()) {
+        Node *hole = m_freed.back();
+        m_freed.pop_back();
+        ContiguousAllocator &allocator = hole->isLeaf ? m_leafAllocator : m_innerAllocator;
+        Node *last = static_cast<Node*>(allocator.last());
+        if (last != hole) {
+            typename std::vector<Node*>::iterator pending = std::find(m_freed.begin(), m_freed.end(), last);
+            if (pending != m_freed.end()) {
+                // the last node is going too; the hole waits its turn
+                *pending = hole;
+            } else {
+                relocate(last, hole);
+            }
+        }
+        destroy(last);
+        allocator.trim();
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::relocate(Node *from, Node *to) {
+    to->parent = from->parent;
+    to->count = from->count;
+    if (from->parent) {
+        from->parent->children[childSlot(from->parent, from)] = to;
+    }
+    if (m_root == from) {
+        m_root = to;
+    }
+    if (from->isLeaf) {
+        LeafNode *source = asLeaf(from);
+        LeafNode *leaf = asLeaf(to);
+        for (int ii = 0; ii < source->count; ii++) {
+            leaf->keys[ii] = source->keys[ii];
+            leaf->values[ii] = source->values[ii];
+        }
+        leaf->prev = source->prev;
+        leaf->next = source->next;
+        if (leaf->prev) {
+            leaf->prev->next = leaf;
+        } else {
+            m_first = leaf;
+        }
+        if (leaf->next) {
+            leaf->next->prev = leaf;
+        } else {
+            m_last = leaf;
+        }
+    } else {
+        InnerNode *source = asInner(from);
+        InnerNode *inner = asInner(to);
+        for (int ii = 0; ii < source->count; ii++) {
+            inner->keys[ii] = source->keys[ii];
+        }
+        for (int ii = 0; ii <= source->count; ii++) {
+            moveChild(source, ii, inner, ii);
+        }
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::destroy(Node *node) {
+    if (node->isLeaf) {
+        asLeaf(node)->~LeafNode();
+    } else {
+        asInner(node)->~InnerNode();
+    }
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingBTree<Key, Data, Compare, hasRank>::destroySubtree(Node *node) {
+    if (!node->isLeaf) {
+        for (int ii = 0; ii <= node->count; ii++) {
+            destroySubtree(asInner(node)->children[ii]);
+        }
+    }
+    destroy(node);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+size_t CompactingBTree<Key, Data, Compare, hasRank>::chunkSize(size_t remaining, size_t capacity, size_t minimum) {
+    if (remaining <= capacity || remaining - capacity >= minimum) {
+        return std::min(remaining, capacity);
+    }
+    // even out the last two nodes of the level so both are at least half full
+    return remaining / 2;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool CompactingBTree<Key, Data, Compare, hasRank>::verify() const {
+    if (m_root == NULL) {
+        return m_count == 0 && m_first == NULL && m_last == NULL;
+    }
+    if (m_root->parent != NULL) return false;
+    int leafDepth = -1;
+    if (verify(m_root, NULL, NULL, 0, leafDepth) != m_count) return false;
+
+    // the leaf chain holds every entry, in order
+    int64_t chained = 0;
+    const LeafNode *prev = NULL;
+    for (const LeafNode *leaf = m_first; leaf != NULL; leaf = leaf->next) {
+        if (leaf->prev != prev) return false;
+        if (prev && m_comper(prev->keys[prev->count - 1], leaf->keys[0]) > (m_unique ? -1 : 0)) return false;
+        chained += leaf->count;
+        prev = leaf;
+    }
+    return prev == m_last && chained == m_count;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+int64_t CompactingBTree<Key, Data, Compare, hasRank>::verify(const Node *node, const Key *low, const Key *high,
+                                                             int depth, int &leafDepth) const {
+    if (node != m_root && node->count < (node->isLeaf ? LEAF_MINIMUM : INNER_MINIMUM)) return -1;
+    if (node->isLeaf) {
+        if (leafDepth == -1) {
+            leafDepth = depth;
+        } else if (leafDepth != depth) {
+            return -1;
+        }
+        const LeafNode *leaf = static_cast<const LeafNode*>(node);
+        for (int ii = 0; ii < leaf->count; ii++) {
+            if (ii > 0 && m_comper(leaf->keys[ii - 1], leaf->keys[ii]) > (m_unique ? -1 : 0)) return -1;
+            if (low && m_comper(leaf->keys[ii], *low) < 0) return -1;
+            if (high && m_comper(leaf->keys[ii], *high) > 0) return -1;
+        }
+        return leaf->count;
+    }
+    const InnerNode *inner = static_cast<const InnerNode*>(node);
+    int64_t count = 0;
+    for (int ii = 0; ii <= inner->count; ii++) {
+        if (ii > 0 && ii < inner->count && m_comper(inner->keys[ii - 1], inner->keys[ii]) > 0) return -1;
+        const Node *child = inner->children[ii];
+        if (child->parent != inner) return -1;
+        const int64_t childCount = verify(child, ii > 0 ? &inner->keys[ii - 1] : low,
+                                          ii < inner->count ? &inner->keys[ii] : high, depth + 1, leafDepth);
+        if (childCount < 0) return -1;
+        if (hasRank && inner->counts.get(ii) != childCount) return -1;
+        count += childCount;
+    }
+    return count;
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+bool CompactingBTree<Key, Data, Compare, hasRank>::verifyRank() {
+    if (!hasRank)
+        return true;
+
+    int64_t position = 0;
+    int64_t firstOfKey = 0;
+    for (iterator iter = begin(); !iter.isEnd(); iter.moveNext()) {
+        position++;
+        iterator prev = iter;
+        prev.movePrev();
+        if (prev.isEnd() || m_comper(prev.key(), iter.key()) != 0) {
+            firstOfKey = position;
+        }
+        if (!findRank(position).equals(iter)) return false;
+        if (rankAsc(iter.key()) != firstOfKey) return false;
+        iterator next = iter;
+        next.moveNext();
+        if ((next.isEnd() || m_comper(iter.key(), next.key()) != 0) && rankUpper(iter.key()) != position) {
+            return false;
+        }
+    }
+    return position == m_count;
+}
+
+} // namespace voltdb
+
+#endif // COMPACTINGBTREE_H_
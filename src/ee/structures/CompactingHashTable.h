@@ -19,6 +19,7 @@
 #define COMPACTINGHASHTABLE_H_
 
 #include <cstdlib>
+#include <stdint.h>
 #include <utility>
 #include <cassert>
 #include <climits>
@@ -62,6 +63,9 @@ namespace voltdb {
         // (new hash will be 30% full)
         static const uint64_t MIN_LOAD_FACTOR = 15; // %
 
+        // keys findBatch() has in flight at once
+        static const size_t PREFETCH_BATCH = 16;
+
         static const uint64_t TABLE_SIZES[];
 
 #ifndef MEMCHECK
@@ -159,6 +163,8 @@ namespace voltdb {
         iterator find(const Key &key) const;
         /** find an exact key/value match (optionaly searching by value first) */
         iterator find(const Key &key, const Data &value) const;
+        /** find() for each of count keys, with their cache misses overlapped */
+        void findBatch(const Key *keys, size_t count, iterator *found) const;
         /** simple insert */
         bool insert(const Key &key, const Data &value);
         /** delete by key (unique only) */
@@ -169,6 +175,8 @@ namespace voltdb {
         bool erase(iterator &iter);
         /** STL-ish size() method */
         size_t size() const { return m_count; }
+        /** grow the bucket array once, up front, to hold count keys */
+        void reserve(uint64_t count);
 
         /** Return bytes used for this index */
         size_t bytesAllocated() const { return m_allocator.bytesAllocated() + TABLE_SIZES[m_sizeIndex] * sizeof(HashNode*); }
@@ -190,8 +198,8 @@ namespace voltdb {
         /** after remove, ensure memory for hashnodes is contiguous */
         void deleteAndFixup(HashNode *node);
 
-        /** see if the hash needs to grow or shrink */
-        void checkLoadFactor();
+        /** see if the hash needs to grow or shrink (inserts only grow it) */
+        void checkLoadFactor(bool mayShrink = true);
         /** grow/shrink the hash table */
         void resize(int newSizeIndex);
     };
@@ -296,6 +304,28 @@ namespace voltdb {
         return iterator(foundNode);
     }
 
+    template<class K, class T, class H, class EK, class ET>
+    void CompactingHashTable<K, T, H, EK, ET>::findBatch(const Key *keys, size_t count, iterator *found) const {
+        // prefetch every bucket of a batch, then the first node of each chain,
+        // so the misses of the whole batch overlap
+        uint64_t offsets[PREFETCH_BATCH];
+        for (size_t base = 0; base < count; base += PREFETCH_BATCH) {
+            const size_t batch = count - base < PREFETCH_BATCH ? count - base : PREFETCH_BATCH;
+            for (size_t i = 0; i < batch; ++i) {
+                offsets[i] = m_hasher(keys[base + i]) % TABLE_SIZES[m_sizeIndex];
+                __builtin_prefetch(&m_buckets[offsets[i]]);
+            }
+            for (size_t i = 0; i < batch; ++i) {
+                if (m_buckets[offsets[i]]) {
+                    __builtin_prefetch(m_buckets[offsets[i]]);
+                }
+            }
+            for (size_t i = 0; i < batch; ++i) {
+                found[base + i] = iterator(find(m_buckets[offsets[i]], keys[base + i]));
+            }
+        }
+    }
+
     template<class K, class T, class H, class EK, class ET>
     bool CompactingHashTable<K, T, H, EK, ET>::insert(const Key &key, const Data &value) {
         uint64_t hash = m_hasher(key);
@@ -421,7 +451,7 @@ namespace voltdb {
             m_uniqueCount++;
         }
 
-        checkLoadFactor();
+        checkLoadFactor(false);
         return true;
     }
 
@@ -588,13 +618,25 @@ namespace voltdb {
     }
 
     template<class K, class T, class H, class EK, class ET>
-    void CompactingHashTable<K, T, H, EK, ET>::checkLoadFactor() {
+    void CompactingHashTable<K, T, H, EK, ET>::reserve(uint64_t count) {
+        const int lastSizeIndex = static_cast<int>(sizeof(TABLE_SIZES) / sizeof(TABLE_SIZES[0])) - 1;
+        int newSizeIndex = m_sizeIndex;
+        while (newSizeIndex < lastSizeIndex && (count * 100) / TABLE_SIZES[newSizeIndex] > MAX_LOAD_FACTOR) {
+            newSizeIndex++;
+        }
+        if (newSizeIndex != m_sizeIndex) {
+            resize(newSizeIndex);
+        }
+    }
+
+    template<class K, class T, class H, class EK, class ET>
+    void CompactingHashTable<K, T, H, EK, ET>::checkLoadFactor(bool mayShrink) {
         uint64_t lf = (m_uniqueCount * 100) / TABLE_SIZES[m_sizeIndex];
         int newSizeIndex = m_sizeIndex;
         if (lf > MAX_LOAD_FACTOR) {
             newSizeIndex++;
         }
-        else if(lf < MIN_LOAD_FACTOR) {
+        else if(mayShrink && lf < MIN_LOAD_FACTOR) {
             // make sure the hash doesn't over-shrink
             if (newSizeIndex != BUCKET_INITIAL_INDEX) {
                 newSizeIndex--;
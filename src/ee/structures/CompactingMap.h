@@ -22,6 +22,8 @@
 #include <stdint.h>
 #include <utility>
 #include <limits>
+#include <algorithm>
+#include <vector>
 #include <cassert>
 #include "ContiguousAllocator.h"
 
@@ -120,9 +122,27 @@ public:
         }
     };
 
+    /** Orders key/value pairs by key, for sorting entries before bulkLoad() */
+    class EntryLess {
+        Compare m_comper;
+    public:
+        EntryLess(const Compare &comper) : m_comper(comper) {}
+        bool operator()(const std::pair<Key, Data> &lhs, const std::pair<Key, Data> &rhs) const {
+            return m_comper(lhs.first, rhs.first) < 0;
+        }
+    };
+
     CompactingMap(bool unique, Compare comper);
     ~CompactingMap();
 
+    /**
+     * Fill an empty map with entries, which must be sorted by key and,
+     * for a unique map, hold no key twice. The tree is built bottom up,
+     * balanced, with no comparisons and no rotations, and its nodes are
+     * laid out in key order.
+     */
+    void bulkLoad(const std::vector<std::pair<Key, Data> > &entries);
+
     bool insert(std::pair<Key, Data> value);
     // A syntactically convenient analog to CompactingHashTable's insert function
     bool insert(const Key &key, const Data &data) { return insert(std::pair<Key, Data>(key, data)); }
@@ -142,6 +162,12 @@ public:
 
     iterator lowerBound(const Key &key);
     iterator upperBound(const Key &key);
+    /**
+     * lowerBound() of each of count keys. The paths of a batch of keys
+     * are walked down together, a node of each in turn, so the cache
+     * misses of different keys overlap.
+     */
+    void lowerBoundBatch(const Key *keys, size_t count, iterator *found);
 
     std::pair<iterator, iterator> equalRange(const Key &key);
 
@@ -176,6 +202,8 @@ protected:
     TreeNode *predecessor(const TreeNode *x) const;
 
     // sub functions to make the magic happen
+    TreeNode *linkSubtree(const std::vector<TreeNode*> &nodes, size_t begin, size_t end,
+                          TreeNode *parent, int depth, int redDepth);
     void leftRotate(TreeNode *x);
     void rightRotate(TreeNode *x);
     void insertFixup(TreeNode *z);
@@ -214,6 +242,52 @@ CompactingMap<Key, Data, Compare, hasRank>::~CompactingMap() {
     }
 }
 
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingMap<Key, Data, Compare, hasRank>::bulkLoad(const std::vector<std::pair<Key, Data> > &entries) {
+    assert(m_count == 0);
+    if (entries.empty()) {
+        return;
+    }
+    std::vector<TreeNode*> nodes(entries.size());
+    for (size_t ii = 0; ii < entries.size(); ii++) {
+        void *memory = m_allocator.alloc();
+        assert(memory);
+        // placement new, without value-initializing: when there is no
+        // rank the allocation stops short of subct
+        TreeNode *z = new(memory) TreeNode;
+        z->key = entries[ii].first;
+        z->value = entries[ii].second;
+        nodes[ii] = z;
+    }
+    // Splitting at the middle fills every level but the deepest. Making
+    // the nodes of that level red gives every path the same black height.
+    int redDepth = 0;
+    while ((static_cast<size_t>(2) << redDepth) - 1 <= entries.size()) {
+        redDepth++;
+    }
+    m_root = linkSubtree(nodes, 0, nodes.size(), &NIL, 0, redDepth);
+    m_count = static_cast<int64_t>(entries.size());
+    assert(m_allocator.count() == m_count);
+}
+
+template<typename Key, typename Data, typename Compare, bool hasRank>
+typename CompactingMap<Key, Data, Compare, hasRank>::TreeNode *CompactingMap<Key, Data, Compare, hasRank>::linkSubtree(
+        const std::vector<TreeNode*> &nodes, size_t begin, size_t end, TreeNode *parent, int depth, int redDepth) {
+    if (begin == end) {
+        return &NIL;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    TreeNode *x = nodes[middle];
+    x->parent = parent;
+    x->left = linkSubtree(nodes, begin, middle, x, depth + 1, redDepth);
+    x->right = linkSubtree(nodes, middle + 1, end, x, depth + 1, redDepth);
+    x->color = depth >= redDepth ? RED : BLACK;
+    if (hasRank) {
+        x->subct = end - begin <= static_cast<size_t>(SUBCTMAX) ? static_cast<NodeCount>(end - begin) : INVALIDCT;
+    }
+    return x;
+}
+
 template<typename Key, typename Data, typename Compare, bool hasRank>
 bool CompactingMap<Key, Data, Compare, hasRank>::erase(const Key &key) {
     TreeNode *node = lookup(key);
@@ -318,6 +392,40 @@ typename CompactingMap<Key, Data, Compare, hasRank>::iterator CompactingMap<Key,
     return iterator(this, y);
 }
 
+template<typename Key, typename Data, typename Compare, bool hasRank>
+void CompactingMap<Key, Data, Compare, hasRank>::lowerBoundBatch(const Key *keys, size_t count, iterator *found) {
+    const size_t PREFETCH_BATCH = 16;
+    TreeNode *x[PREFETCH_BATCH];
+    TreeNode *y[PREFETCH_BATCH];
+    for (size_t base = 0; base < count; base += PREFETCH_BATCH) {
+        const size_t batch = std::min(count - base, PREFETCH_BATCH);
+        for (size_t ii = 0; ii < batch; ii++) {
+            x[ii] = m_root;
+            y[ii] = &NIL;
+        }
+        for (bool descending = true; descending; ) {
+            descending = false;
+            for (size_t ii = 0; ii < batch; ii++) {
+                if (x[ii] == &NIL) continue;
+                if (m_comper(x[ii]->key, keys[base + ii]) < 0) {
+                    x[ii] = x[ii]->right;
+                }
+                else {
+                    y[ii] = x[ii];
+                    x[ii] = x[ii]->left;
+                }
+                if (x[ii] != &NIL) {
+                    __builtin_prefetch(x[ii]);
+                    descending = true;
+                }
+            }
+        }
+        for (size_t ii = 0; ii < batch; ii++) {
+            found[base + ii] = iterator(this, y[ii]);
+        }
+    }
+}
+
 template<typename Key, typename Data, typename Compare, bool hasRank>
 typename CompactingMap<Key, Data, Compare, hasRank>::iterator CompactingMap<Key, Data, Compare, hasRank>::upperBound(const Key &key) {
     TreeNode *x = m_root;
@@ -16,22 +16,57 @@
  */
 
 #include "ContiguousAllocator.h"
+#include "common/LargePages.h"
 
 #include <cassert>
 
 using namespace voltdb;
 
 ContiguousAllocator::ContiguousAllocator(int32_t allocSize, int32_t chunkSize)
-: m_count(0), m_allocSize(allocSize), m_chunkSize(chunkSize), m_tail(NULL), m_blockCount(0) {}
+: m_count(0), m_allocSize(allocSize), m_chunkSize(chunkSizeFor(allocSize, chunkSize)),
+  m_tail(NULL), m_blockCount(0), m_largePages(LargePages::enabled())
+{
+}
+
+int32_t ContiguousAllocator::chunkSizeFor(int32_t allocSize, int32_t chunkSize) {
+    if (!LargePages::enabled()) {
+        return chunkSize;
+    }
+    // as many allocations as the huge pages the buffer needs can hold
+    const size_t pageSize = LargePages::HUGE_PAGE_SIZE;
+    const size_t size = sizeof(Buffer) + static_cast<size_t>(allocSize) * chunkSize;
+    const size_t pages = (size + pageSize - 1) / pageSize;
+    return static_cast<int32_t>((pages * pageSize - sizeof(Buffer)) / allocSize);
+}
 
 ContiguousAllocator::~ContiguousAllocator() {
     while (m_tail) {
         Buffer *buf = m_tail->prev;
-        free(m_tail);
+        freeBuffer(m_tail);
         m_tail = buf;
     }
 }
 
+ContiguousAllocator::Buffer *ContiguousAllocator::allocateBuffer() {
+    const size_t size = sizeof(Buffer) + static_cast<size_t>(m_allocSize) * m_chunkSize;
+    void *memory = NULL;
+    if (m_largePages) {
+        memory = LargePages::allocate(size);
+    } else if (posix_memalign(&memory, __alignof__(Buffer), size) != 0) {
+        memory = NULL;
+    }
+    return reinterpret_cast<Buffer*>(memory);
+}
+
+void ContiguousAllocator::freeBuffer(Buffer *buf) {
+    if (m_largePages) {
+        LargePages::free(reinterpret_cast<char*>(buf),
+                         sizeof(Buffer) + static_cast<size_t>(m_allocSize) * m_chunkSize);
+    } else {
+        free(buf);
+    }
+}
+
 void *ContiguousAllocator::alloc() {
     m_count++;
 
@@ -40,9 +75,7 @@ void *ContiguousAllocator::alloc() {
 
     // if a new block is needed...
     if (blockOffset == 0) {
-        void *memory = malloc(sizeof(Buffer) + m_allocSize * m_chunkSize);
-
-        Buffer *buf = reinterpret_cast<Buffer*>(memory);
+        Buffer *buf = allocateBuffer();
 
         // for debugging
         //memset(buf, 0, sizeof(sizeof(ChainedBuffer) + m_allocSize * m_chunkSize));
@@ -82,7 +115,7 @@ void ContiguousAllocator::trim() {
     // yay! kill a block
     if (blockOffset == 0) {
         Buffer *buf = m_tail->prev;
-        free(m_tail);
+        freeBuffer(m_tail);
         m_tail = buf;
         m_blockCount--;
     }
@@ -30,9 +30,11 @@ namespace voltdb {
  * Note, there are few checks here when running in release mode.
  */
 class ContiguousAllocator {
+    // Allocations start on a cache line boundary as long as allocSize
+    // is a multiple of the cache line size
     struct Buffer {
         Buffer *prev;
-        char data[0];
+        char data[0] __attribute__((aligned(64)));
     };
 
     int64_t m_count;
@@ -40,11 +42,21 @@ class ContiguousAllocator {
     int32_t m_chunkSize;
     Buffer *m_tail;
     int32_t m_blockCount;
+    // Buffers come from LargePages
+    bool m_largePages;
+
+    static int32_t chunkSizeFor(int32_t allocSize, int32_t chunkSize);
+    Buffer *allocateBuffer();
+    void freeBuffer(Buffer *buf);
 
 public:
     /**
      * @param allocSize is the size in bytes of individual allocations.
      * @param chunkSize is the number of allocations per buffer (not bytes).
+     * With LargePages enabled, chunkSize grows until a buffer fills whole
+     * huge pages, and the buffers are backed by them. The index arenas ask
+     * for far less than a huge page, so even a nearly empty index holds
+     * one (2 MB per node size).
      */
     ContiguousAllocator(int32_t allocSize, int32_t chunkSize);
     ~ContiguousAllocator();
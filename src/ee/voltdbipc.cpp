@@ -109,7 +109,7 @@ typedef struct {
 }__attribute__((packed)) get_stats_cmd;
 
 /*
- * Header for a saveTableToDisk request
+ * Header for a saveTableToDisk request, followed by the path of the image
  */
 typedef struct {
     struct ipc_command cmd;
@@ -325,6 +325,12 @@ bool VoltDBIPC::execute(struct ipc_command *cmd) {
           updateHashinator(cmd);
           result = kErrorCode_None;
           break;
+      case 28:
+          result = saveTableToDisk(cmd);
+          break;
+      case 29:
+          result = restoreTableFromDisk(cmd);
+          break;
       default:
         result = stub(cmd);
     }
@@ -430,7 +436,8 @@ int8_t VoltDBIPC::initialize(struct ipc_command *cmd) {
 
     std::string hostname(cs->data + cs->hashinatorConfigLength, cs->hostnameLength);
     try {
-        m_engine = new VoltDBEngine(new voltdb::IPCTopend(this), new voltdb::StdoutLogProxy());
+        // the IPC initialize command carries no Cold Storage settings, so it stays off
+        m_engine = new VoltDBEngine(new voltdb::IPCTopend(this), new voltdb::StdoutLogProxy(), false, 0, 0);
         m_engine->getLogManager()->setLogLevels(cs->logLevels);
         m_reusedResultBuffer = new char[MAX_MSG_SZ];
         m_exceptionBuffer = new char[MAX_MSG_SZ];
@@ -462,10 +469,8 @@ int8_t VoltDBIPC::toggleProfiler(struct ipc_command *cmd) {
     }__attribute__((packed));
     struct toggle * cs = (struct toggle*) cmd;
 
-    printf("toggleProfiler: toggle=%d\n", ntohl(cs->toggle));
-
-    // actually, the engine doesn't implement this now.
-    // m_engine->ProfilerStart();
+    // there is no profiler behind IPC; the toggle only drives the event trace ring
+    m_engine->setTraceEnabled(ntohl(cs->toggle) != 0);
     return kErrorCode_Success;
 }
 
@@ -653,6 +658,35 @@ int8_t VoltDBIPC::loadTable(struct ipc_command *cmd) {
     return kErrorCode_Error;
 }
 
+int8_t VoltDBIPC::saveTableToDisk(struct ipc_command *cmd) {
+    save_table_to_disk_cmd *saveCommand = (save_table_to_disk_cmd*) cmd;
+    const int32_t clusterId = ntohl(saveCommand->clusterId);
+    const int32_t databaseId = ntohl(saveCommand->databaseId);
+    const int32_t tableId = ntohl(saveCommand->tableId);
+    const size_t pathLength = ntohl(cmd->msgsize) - sizeof(save_table_to_disk_cmd);
+    try {
+        if (m_engine->saveTableToDisk(clusterId, databaseId, tableId,
+                                      std::string(saveCommand->data, pathLength))) {
+            return kErrorCode_Success;
+        }
+    } catch (const FatalException &e) {
+        crashVoltDB(e);
+    }
+    return kErrorCode_Error;
+}
+
+int8_t VoltDBIPC::restoreTableFromDisk(struct ipc_command *cmd) {
+    const size_t pathLength = ntohl(cmd->msgsize) - sizeof(struct ipc_command);
+    try {
+        if (m_engine->restoreTableFromDisk(std::string(cmd->data, pathLength))) {
+            return kErrorCode_Success;
+        }
+    } catch (const FatalException &e) {
+        crashVoltDB(e);
+    }
+    return kErrorCode_Error;
+}
+
 int8_t VoltDBIPC::setLogLevels(struct ipc_command *cmd) {
     int64_t logLevels = *((int64_t*)&cmd->data[0]);
     try {
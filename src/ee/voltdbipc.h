@@ -124,6 +124,10 @@ private:
 
     int8_t loadTable(struct ipc_command *cmd);
 
+    int8_t saveTableToDisk(struct ipc_command *cmd);
+
+    int8_t restoreTableFromDisk(struct ipc_command *cmd);
+
     int8_t processRecoveryMessage( struct ipc_command *cmd);
 
     void tableHashCode( struct ipc_command *cmd);
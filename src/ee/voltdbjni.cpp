@@ -188,7 +188,19 @@ void setupSigHandler(void) {
 */
 SHAREDLIB_JNIEXPORT jlong JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeCreate(JNIEnv *env, jobject obj, jboolean isSunJVM,
                                                                                    jboolean CSIsEnabled, jfloat lu, 
-                                                                                   jfloat percentageOfDataToMove)
+                                                                                   jfloat percentageOfDataToMove,
+                                                                                   jint coldStoragePolicy,
+                                                                                   jint compactionBlocksPerTick,
+                                                                                   jlong compactionMicrosPerTick,
+                                                                                   jint coldStorageAgingBlocksPerTick,
+                                                                                   jlong coldStorageAgingMicrosPerTick,
+                                                                                   jbyteArray minipageColumns,
+                                                                                   jbyteArray dictionaryColumns,
+                                                                                   jlong tempTableSpillThreshold,
+                                                                                   jbyteArray tempTableSpillPath,
+                                                                                   jlong tempBlockPoolCapacity,
+                                                                                   jint indexBuildThreads,
+                                                                                   jboolean largePages)
 {
     // obj is the instance pointer of the ExecutionEngineJNI instance
     // that is creating this native EE. Turn this into a global reference
@@ -217,7 +229,27 @@ SHAREDLIB_JNIEXPORT jlong JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeCrea
     try {
         topend = new JNITopend(env, java_ee);
         engine = new VoltDBEngine(topend, JNILogProxy::getJNILogProxy(env, vm), CSIsEnabled != JNI_FALSE, 
-                                  static_cast<float>(lu), static_cast<float>(percentageOfDataToMove));
+                                  static_cast<float>(lu), static_cast<float>(percentageOfDataToMove),
+                                  static_cast<ColdStoragePolicy>(coldStoragePolicy));
+        engine->setCompactionBudget(static_cast<size_t>(compactionBlocksPerTick), compactionMicrosPerTick);
+        engine->setColdStorageAgingBudget(static_cast<size_t>(coldStorageAgingBlocksPerTick),
+                                          coldStorageAgingMicrosPerTick);
+        jbyte *minipageChars = env->GetByteArrayElements(minipageColumns, NULL);
+        engine->setMinipageColumns(std::string(reinterpret_cast<char*>(minipageChars),
+                                               env->GetArrayLength(minipageColumns)));
+        env->ReleaseByteArrayElements(minipageColumns, minipageChars, JNI_ABORT);
+        jbyte *dictionaryChars = env->GetByteArrayElements(dictionaryColumns, NULL);
+        engine->setDictionaryColumns(std::string(reinterpret_cast<char*>(dictionaryChars),
+                                                 env->GetArrayLength(dictionaryColumns)));
+        env->ReleaseByteArrayElements(dictionaryColumns, dictionaryChars, JNI_ABORT);
+        jbyte *spillPathChars = env->GetByteArrayElements(tempTableSpillPath, NULL);
+        engine->setTempTableSpill(tempTableSpillThreshold,
+                                  std::string(reinterpret_cast<char*>(spillPathChars),
+                                              env->GetArrayLength(tempTableSpillPath)));
+        env->ReleaseByteArrayElements(tempTableSpillPath, spillPathChars, JNI_ABORT);
+        engine->setTempBlockPoolCapacity(static_cast<size_t>(tempBlockPoolCapacity));
+        engine->setIndexBuildThreads(indexBuildThreads);
+        engine->setLargePages(largePages != JNI_FALSE);
     } catch (const FatalException &e) {
         if (topend != NULL) {
             topend->crashVoltDB(e);
@@ -866,16 +898,20 @@ Java_org_voltdb_jni_ExecutionEngine_nativeGetStats(JNIEnv *env, jobject obj,
 }
 
 /**
- * Turns on or off profiler.
+ * Turns on or off profiler, and the engine's event trace ring with it.
  * @returns 0 on success.
  */
 SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeToggleProfiler
 (JNIEnv *env, jobject obj, jlong engine_ptr, jint toggle)
 {
     VOLT_DEBUG("nativeToggleProfiler in C++ called");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine) {
+        // the event trace ring follows the profiler toggle
+        engine->setTraceEnabled(toggle != 0);
+    }
 // set on build command line via build.py
 #ifdef PROFILE_ENABLED
-    VoltDBEngine *engine = castToEngine(engine_ptr);
     updateJNILogProxy(engine); //JNIEnv pointer can change between calls, must be updated
     if (engine) {
         if (toggle) {
@@ -888,7 +924,8 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeToggl
         return org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
     }
 #endif
-    return org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    return engine ? org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS
+                  : org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
 }
 
 /**
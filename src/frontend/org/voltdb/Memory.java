@@ -10,6 +10,30 @@ public abstract class Memory
     private static float limitUsagePercentage = 100;
     private static float percentageOfDataToMove = 0;
     private static boolean coldStorageIsEnabled = false;
+    /** Cold storage tracks hotness with a counter per tuple (matches the EE's ColdStoragePolicy) */
+    public static final int COLD_STORAGE_POLICY_TUPLE = 0;
+    /** Cold storage tracks hotness with a reference bit and sampled counter per tuple block */
+    public static final int COLD_STORAGE_POLICY_BLOCK = 1;
+    private static int coldStoragePolicy = COLD_STORAGE_POLICY_TUPLE;
+    /** Bound on the table compaction each EE tick does (the EE's defaults) */
+    private static int compactionBlocksPerTick = 16;
+    private static long compactionMicrosPerTick = 5000;
+    /** Bound on the Cold Storage aging each EE tick does (the EE's defaults) */
+    private static int coldStorageAgingBlocksPerTick = 128;
+    private static long coldStorageAgingMicrosPerTick = 2000;
+    /** Threads building indexes at once, site thread included (the EE's default) */
+    private static int indexBuildThreads = 4;
+    /** The EE backs its storage with huge pages and binds each site to a NUMA node */
+    private static boolean largePagesAreEnabled = false;
+    /** Bytes a fragment's temp tables hold before spilling to tempTableSpillPath, negative never spills */
+    private static long tempTableSpillThreshold = -1;
+    private static String tempTableSpillPath = "/tmp";
+    /** Bytes of dropped temp table blocks each site keeps for reuse (the EE's default) */
+    private static long tempBlockPoolCapacity = 8L * 1024 * 1024;
+    /** Inlined columns the EE mirrors into per-block minipages, as TABLE.COLUMN,TABLE.COLUMN */
+    private static String minipageColumns = "";
+    /** VARCHAR and VARBINARY columns the EE shares through per-column dictionaries, in the same form */
+    private static String dictionaryColumns = "";
     /**
      * Gets the percentage of used random access memory
      *
@@ -85,4 +109,199 @@ public abstract class Memory
     {
         coldStorageIsEnabled = isEnabled;
     }
+    /**
+     * Gets how cold storage tracks which data is hot
+     *
+     * @return COLD_STORAGE_POLICY_TUPLE or COLD_STORAGE_POLICY_BLOCK
+     */
+    public static int getColdStoragePolicy()
+    {
+        return coldStoragePolicy;
+    }
+    /**
+     * Sets how cold storage tracks which data is hot
+     *
+     * @param policy COLD_STORAGE_POLICY_TUPLE or COLD_STORAGE_POLICY_BLOCK
+     */
+    public static void setColdStoragePolicy(final int policy)
+    {
+        coldStoragePolicy = policy;
+    }
+    /**
+     * Gets how many tuple blocks each EE tick may fill up while compacting tables
+     *
+     * @return the number of blocks, 0 if tables are only compacted when badly fragmented
+     */
+    public static int getCompactionBlocksPerTick()
+    {
+        return compactionBlocksPerTick;
+    }
+    /**
+     * Gets after how many microseconds an EE tick stops compacting tables
+     *
+     * @return the number of microseconds
+     */
+    public static long getCompactionMicrosPerTick()
+    {
+        return compactionMicrosPerTick;
+    }
+    /**
+     * Sets how much table compaction each EE tick does
+     *
+     * @param blocksPerTick the number of blocks to fill up, 0 to compact only badly fragmented tables
+     * @param microsPerTick the number of microseconds after which no new block is started
+     */
+    public static void setCompactionBudget(final int blocksPerTick, final long microsPerTick)
+    {
+        compactionBlocksPerTick = blocksPerTick;
+        compactionMicrosPerTick = microsPerTick;
+    }
+    /**
+     * Gets how many tuple blocks each EE tick may age when cold storage counters saturate
+     *
+     * @return the number of blocks
+     */
+    public static int getColdStorageAgingBlocksPerTick()
+    {
+        return coldStorageAgingBlocksPerTick;
+    }
+    /**
+     * Gets after how many microseconds an EE tick stops aging cold storage counters
+     *
+     * @return the number of microseconds
+     */
+    public static long getColdStorageAgingMicrosPerTick()
+    {
+        return coldStorageAgingMicrosPerTick;
+    }
+    /**
+     * Sets how much cold storage aging each EE tick does
+     *
+     * @param blocksPerTick the number of blocks to age
+     * @param microsPerTick the number of microseconds after which no new block is started
+     */
+    public static void setColdStorageAgingBudget(final int blocksPerTick, final long microsPerTick)
+    {
+        coldStorageAgingBlocksPerTick = blocksPerTick;
+        coldStorageAgingMicrosPerTick = microsPerTick;
+    }
+    /**
+     * Gets how many threads build a table's indexes at once
+     *
+     * @return the number of threads, the site thread included
+     */
+    public static int getIndexBuildThreads()
+    {
+        return indexBuildThreads;
+    }
+    /**
+     * Sets how many threads build a table's indexes at once
+     *
+     * @param threads the number of threads, 1 to build on the site thread only
+     */
+    public static void setIndexBuildThreads(final int threads)
+    {
+        indexBuildThreads = threads;
+    }
+    /**
+     * Checks if the EE backs its storage with huge pages
+     *
+     * @return true if huge pages are used and each site is bound to a NUMA node
+     */
+    public static boolean largePagesAreEnabled()
+    {
+        return largePagesAreEnabled;
+    }
+    /**
+     * Sets whether the EE backs its storage with huge pages
+     *
+     * @param isEnabled true to use huge pages and bind each site to a NUMA node
+     */
+    public static void setLargePagesEnabled(final boolean isEnabled)
+    {
+        largePagesAreEnabled = isEnabled;
+    }
+    /**
+     * Gets the columns the EE keeps in per-block minipages for scans
+     *
+     * @return comma separated TABLE.COLUMN names, empty for none
+     */
+    public static String getMinipageColumns()
+    {
+        return minipageColumns;
+    }
+    /**
+     * Sets the columns the EE keeps in per-block minipages for scans
+     *
+     * @param columns comma separated TABLE.COLUMN names, empty for none
+     */
+    public static void setMinipageColumns(final String columns)
+    {
+        minipageColumns = columns;
+    }
+    /**
+     * Gets the columns the EE stores once per distinct value in a dictionary
+     *
+     * @return comma separated TABLE.COLUMN names, empty for none
+     */
+    public static String getDictionaryColumns()
+    {
+        return dictionaryColumns;
+    }
+    /**
+     * Sets the columns the EE stores once per distinct value in a dictionary
+     *
+     * @param columns comma separated TABLE.COLUMN names, empty for none
+     */
+    public static void setDictionaryColumns(final String columns)
+    {
+        dictionaryColumns = columns;
+    }
+    /**
+     * Gets how many bytes a fragment's temp tables hold before they spill to scratch files
+     *
+     * @return the number of bytes, negative if temp tables never spill
+     */
+    public static long getTempTableSpillThreshold()
+    {
+        return tempTableSpillThreshold;
+    }
+    /**
+     * Gets the directory temp tables spill their scratch files to
+     *
+     * @return the path of the directory
+     */
+    public static String getTempTableSpillPath()
+    {
+        return tempTableSpillPath;
+    }
+    /**
+     * Sets when and where temp tables spill to scratch files
+     *
+     * @param threshold the number of bytes, negative if temp tables never spill
+     * @param path the path of the directory for the scratch files
+     */
+    public static void setTempTableSpill(final long threshold, final String path)
+    {
+        tempTableSpillThreshold = threshold;
+        tempTableSpillPath = path;
+    }
+    /**
+     * Gets how many bytes of dropped temp table blocks each site keeps for reuse
+     *
+     * @return the number of bytes, 0 if dropped blocks are freed
+     */
+    public static long getTempBlockPoolCapacity()
+    {
+        return tempBlockPoolCapacity;
+    }
+    /**
+     * Sets how many bytes of dropped temp table blocks each site keeps for reuse
+     *
+     * @param capacity the number of bytes, 0 if dropped blocks are freed
+     */
+    public static void setTempBlockPoolCapacity(final long capacity)
+    {
+        tempBlockPoolCapacity = capacity;
+    }
 }
@@ -80,6 +80,9 @@ import org.voltdb.compiler.ClusterConfig;
 import org.voltdb.compiler.deploymentfile.DeploymentType;
 import org.voltdb.compiler.deploymentfile.HeartbeatType;
 import org.voltdb.compiler.deploymentfile.SecurityType;
+import org.voltdb.compiler.deploymentfile.SystemSettingsType;
+import org.voltdb.compiler.deploymentfile.TableLayoutEntry;
+import org.voltdb.compiler.deploymentfile.TableLayoutType;
 import org.voltdb.compiler.deploymentfile.UsersType;
 import org.voltdb.dtxn.InitiatorStats;
 import org.voltdb.dtxn.LatencyStats;
@@ -386,6 +389,12 @@ public class RealVoltDB implements VoltDBInterface, RestoreAgent.Callback
                 coldStorageIsEnabled = true;
                 Memory.setPercentageOfDataToMove(percentageOfDataToMove);
                 Memory.setLimitUsagePercentage(limitMemoryUsagePercentage);
+                if (coldStorageInfo.getPolicy() == org.voltdb.compiler.deploymentfile.ColdStoragePolicyEnum.BLOCK) {
+                    consoleLog.info("Cold storage tracks data hotness per tuple block.");
+                    Memory.setColdStoragePolicy(Memory.COLD_STORAGE_POLICY_BLOCK);
+                } else {
+                    Memory.setColdStoragePolicy(Memory.COLD_STORAGE_POLICY_TUPLE);
+                }
             }
             else // w przciwnym wypadku, wyświetl, że Cold Storage jest wyłączony
             {
@@ -393,6 +402,46 @@ public class RealVoltDB implements VoltDBInterface, RestoreAgent.Callback
                 coldStorageIsEnabled = false;
             } 
             Memory.setColdStorageEnabled(coldStorageIsEnabled);
+
+            SystemSettingsType systemSettings = m_deployment.getSystemsettings();
+            if (systemSettings != null && systemSettings.getCompaction() != null) {
+                Memory.setCompactionBudget(systemSettings.getCompaction().getBlockspertick(),
+                                           systemSettings.getCompaction().getMicrospertick());
+            }
+            if (systemSettings != null && systemSettings.getColdstorageaging() != null) {
+                Memory.setColdStorageAgingBudget(systemSettings.getColdstorageaging().getBlockspertick(),
+                                                 systemSettings.getColdstorageaging().getMicrospertick());
+            }
+            if (systemSettings != null && systemSettings.getIndexbuild() != null) {
+                Memory.setIndexBuildThreads(systemSettings.getIndexbuild().getThreads());
+            }
+            if (systemSettings != null && systemSettings.getLargepages() != null &&
+                systemSettings.getLargepages().isEnabled()) {
+                consoleLog.info("The EE backs its storage with huge pages.");
+                Memory.setLargePagesEnabled(true);
+            }
+            if (systemSettings != null && systemSettings.getTemptables() != null) {
+                Memory.setTempBlockPoolCapacity(systemSettings.getTemptables().getBlockpoolsize() * 1024L * 1024L);
+            }
+            if (systemSettings != null && systemSettings.getTemptables() != null &&
+                systemSettings.getTemptables().getSpillsize() > 0) {
+                SystemSettingsType.Temptables temptables = systemSettings.getTemptables();
+                consoleLog.info("Temp tables spill to " + temptables.getSpillpath() + " past " +
+                                temptables.getSpillsize() + "MB.");
+                Memory.setTempTableSpill(temptables.getSpillsize() * 1024L * 1024L, temptables.getSpillpath());
+            }
+
+            TableLayoutType tableLayout = m_deployment.getTablelayout();
+            if (tableLayout != null) {
+                StringBuilder minipageColumns = new StringBuilder();
+                StringBuilder dictionaryColumns = new StringBuilder();
+                for (TableLayoutEntry table : tableLayout.getTable()) {
+                    appendTableColumns(minipageColumns, table.getName(), table.getMinipagecolumns());
+                    appendTableColumns(dictionaryColumns, table.getName(), table.getDictionarycolumns());
+                }
+                Memory.setMinipageColumns(minipageColumns.toString());
+                Memory.setDictionaryColumns(dictionaryColumns.toString());
+            }
             
             if (!isRejoin && !m_joining) {
                 m_messenger.waitForGroupJoin(numberOfNodes);
@@ -1525,6 +1574,26 @@ public class RealVoltDB implements VoltDBInterface, RestoreAgent.Callback
     /** Last transaction ID at which the logging config updated.
      * Also, use the intrinsic lock to safeguard access from multiple
      * execution site threads */
+    /**
+     * Appends the comma separated columns of a <tablelayout> entry to sb
+     * as TABLE.COLUMN names, the way the EE takes them.
+     */
+    private static void appendTableColumns(StringBuilder sb, String table, String columns) {
+        if (columns == null) {
+            return;
+        }
+        for (String column : columns.split(",")) {
+            column = column.trim();
+            if (column.isEmpty()) {
+                continue;
+            }
+            if (sb.length() > 0) {
+                sb.append(',');
+            }
+            sb.append(table.trim().toUpperCase()).append('.').append(column.toUpperCase());
+        }
+    }
+
     private static Long lastLogUpdate_txnId = 0L;
     @Override
     synchronized public void logUpdate(String xmlConfig, long currentTxnId)
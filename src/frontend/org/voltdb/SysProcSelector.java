@@ -39,5 +39,11 @@ public enum SysProcSelector {
     DRPARTITION,
     DRNODE,
 
-    TOPO            // return leader and site info for iv2
+    TOPO,           // return leader and site info for iv2
+
+    COLDSTORAGE,    // invoked as @stat coldstorage; must stay in step with the EE's STATISTICS_SELECTOR_TYPE_COLD_STORAGE
+
+    EETRACE,        // dump of the EE event trace ring; must stay in step with STATISTICS_SELECTOR_TYPE_TRACE
+
+    TEMPBLOCKPOOL   // invoked as @stat tempblockpool; must stay in step with STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL
 }
@@ -479,10 +479,27 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      * Never fail to destroy() for the VoltDBEngine* once you call this method
      * NOTE: Call initialize() separately for initialization.
      * This does strictly nothing so that this method never throws an exception.
+     * @param compactionBlocksPerTick blocks each tick may fill up compacting tables
+     * @param compactionMicrosPerTick microseconds after which a tick stops compacting
+     * @param coldStorageAgingBlocksPerTick blocks each tick may age when access counters saturate
+     * @param coldStorageAgingMicrosPerTick microseconds after which a tick stops aging
+     * @param minipageColumns TABLE.COLUMN names of the columns kept in minipages
+     * @param dictionaryColumns TABLE.COLUMN names of the dictionary encoded columns
+     * @param tempTableSpillThreshold bytes of temp tables past which they spill, negative never
+     * @param tempTableSpillPath directory for the scratch files temp tables spill to
+     * @param tempBlockPoolCapacity bytes of dropped temp table blocks kept for reuse
+     * @param indexBuildThreads threads building indexes at once, site thread included
+     * @param largePages back storage with huge pages and bind the site to a NUMA node
      * @return the created VoltDBEngine pointer casted to jlong.
      */
     protected native long nativeCreate(boolean isSunJVM, boolean coldStorageIsEnabled, float limitUsagePercentage,
-                                       float percentageOfDataToMove);
+                                       float percentageOfDataToMove, int coldStoragePolicy,
+                                       int compactionBlocksPerTick, long compactionMicrosPerTick,
+                                       int coldStorageAgingBlocksPerTick, long coldStorageAgingMicrosPerTick,
+                                       byte minipageColumns[], byte dictionaryColumns[],
+                                       long tempTableSpillThreshold, byte tempTableSpillPath[],
+                                       long tempBlockPoolCapacity, int indexBuildThreads,
+                                       boolean largePages);
     /**
      * Releases all resources held in the execution engine.
      * @param pointer the VoltDBEngine pointer to be destroyed
@@ -111,7 +111,14 @@ public class ExecutionEngineJNI extends ExecutionEngine {
          */
         pointer = nativeCreate(System.getProperty("java.vm.vendor")
                                .toLowerCase().contains("sun microsystems"), Memory.coldStorageIsEnabled(), Memory.getLimitUsagePercentage(),
-                               Memory.getPercentageOfDataToMove()); //z dodatkowym wartościami z konfiguracji Cold Storage
+                               Memory.getPercentageOfDataToMove(), Memory.getColdStoragePolicy(), //z dodatkowym wartościami z konfiguracji Cold Storage
+                               Memory.getCompactionBlocksPerTick(), Memory.getCompactionMicrosPerTick(),
+                               Memory.getColdStorageAgingBlocksPerTick(), Memory.getColdStorageAgingMicrosPerTick(),
+                               getStringBytes(Memory.getMinipageColumns()),
+                               getStringBytes(Memory.getDictionaryColumns()),
+                               Memory.getTempTableSpillThreshold(), getStringBytes(Memory.getTempTableSpillPath()),
+                               Memory.getTempBlockPoolCapacity(), Memory.getIndexBuildThreads(),
+                               Memory.largePagesAreEnabled());
         nativeSetLogLevels(pointer, EELoggers.getLogLevels());
         int errorCode =
             nativeInitialize(
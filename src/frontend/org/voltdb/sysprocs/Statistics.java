@@ -66,6 +66,14 @@ public class Statistics extends VoltSystemProcedure {
         SysProcFragmentId.PF_indexData | DtxnConstants.MULTIPARTITION_DEPENDENCY;
     static final int DEP_indexAggregator = (int) SysProcFragmentId.PF_indexAggregator;
 
+    static final int DEP_coldStorageData = (int)
+        SysProcFragmentId.PF_coldStorageData | DtxnConstants.MULTIPARTITION_DEPENDENCY;
+    static final int DEP_coldStorageAggregator = (int) SysProcFragmentId.PF_coldStorageAggregator;
+
+    static final int DEP_tempBlockPoolData = (int)
+        SysProcFragmentId.PF_tempBlockPoolData | DtxnConstants.MULTIPARTITION_DEPENDENCY;
+    static final int DEP_tempBlockPoolAggregator = (int) SysProcFragmentId.PF_tempBlockPoolAggregator;
+
     static final int DEP_procedureData = (int)
         SysProcFragmentId.PF_procedureData | DtxnConstants.MULTIPARTITION_DEPENDENCY;
     static final int DEP_procedureAggregator = (int)
@@ -107,6 +115,10 @@ public class Statistics extends VoltSystemProcedure {
         registerPlanFragment(SysProcFragmentId.PF_tableAggregator);
         registerPlanFragment(SysProcFragmentId.PF_indexData);
         registerPlanFragment(SysProcFragmentId.PF_indexAggregator);
+        registerPlanFragment(SysProcFragmentId.PF_coldStorageData);
+        registerPlanFragment(SysProcFragmentId.PF_coldStorageAggregator);
+        registerPlanFragment(SysProcFragmentId.PF_tempBlockPoolData);
+        registerPlanFragment(SysProcFragmentId.PF_tempBlockPoolAggregator);
         registerPlanFragment(SysProcFragmentId.PF_nodeMemory);
         registerPlanFragment(SysProcFragmentId.PF_nodeMemoryAggregator);
         registerPlanFragment(SysProcFragmentId.PF_procedureData);
@@ -184,6 +196,52 @@ public class Statistics extends VoltSystemProcedure {
             return new DependencyPair(DEP_indexAggregator, result);
         }
 
+        //  COLDSTORAGE statistics
+        else if (fragmentId == SysProcFragmentId.PF_coldStorageData) {
+            assert(params.toArray().length == 2);
+            final boolean interval =
+                ((Byte)params.toArray()[0]).byteValue() == 0 ? false : true;
+            final Long now = (Long)params.toArray()[1];
+            // cold storage statistics are kept per table, like table statistics
+            CatalogMap<Table> tables = context.getDatabase().getTables();
+            int[] tableGuids = new int[tables.size()];
+            int ii = 0;
+            for (Table table : tables) {
+                tableGuids[ii++] = table.getRelativeIndex();
+            }
+            VoltTable result =
+                context.getSiteProcedureConnection().getStats(
+                        SysProcSelector.COLDSTORAGE,
+                        tableGuids,
+                        interval,
+                        now)[0];
+            return new DependencyPair(DEP_coldStorageData, result);
+        }
+        else if (fragmentId == SysProcFragmentId.PF_coldStorageAggregator) {
+            VoltTable result = VoltTableUtil.unionTables(dependencies.get(DEP_coldStorageData));
+            return new DependencyPair(DEP_coldStorageAggregator, result);
+        }
+
+        //  TEMPBLOCKPOOL statistics
+        else if (fragmentId == SysProcFragmentId.PF_tempBlockPoolData) {
+            assert(params.toArray().length == 2);
+            final boolean interval =
+                ((Byte)params.toArray()[0]).byteValue() == 0 ? false : true;
+            final Long now = (Long)params.toArray()[1];
+            // each site has one pool, registered with the EE under locator 0
+            VoltTable result =
+                context.getSiteProcedureConnection().getStats(
+                        SysProcSelector.TEMPBLOCKPOOL,
+                        new int[] { 0 },
+                        interval,
+                        now)[0];
+            return new DependencyPair(DEP_tempBlockPoolData, result);
+        }
+        else if (fragmentId == SysProcFragmentId.PF_tempBlockPoolAggregator) {
+            VoltTable result = VoltTableUtil.unionTables(dependencies.get(DEP_tempBlockPoolData));
+            return new DependencyPair(DEP_tempBlockPoolAggregator, result);
+        }
+
         //  PROCEDURE statistics
         else if (fragmentId == SysProcFragmentId.PF_procedureData) {
             // procedure stats are registered to VoltDB's statsagent with the site's catalog id.
@@ -431,6 +489,12 @@ public class Statistics extends VoltSystemProcedure {
         else if (selector.toUpperCase().equals(SysProcSelector.INDEX.name())) {
             results = getIndexData(interval, now);
         }
+        else if (selector.toUpperCase().equals(SysProcSelector.COLDSTORAGE.name())) {
+            results = getColdStorageData(interval, now);
+        }
+        else if (selector.toUpperCase().equals(SysProcSelector.TEMPBLOCKPOOL.name())) {
+            results = getTempBlockPoolData(interval, now);
+        }
         else if (selector.toUpperCase().equals(SysProcSelector.PROCEDURE.name())) {
             /*
              * For IV2, MP procedure stats are stored at the MPI, which is the
@@ -722,6 +786,52 @@ public class Statistics extends VoltSystemProcedure {
         return results;
     }
 
+    private VoltTable[] getColdStorageData(long interval, final long now) {
+        VoltTable[] results;
+        SynthesizedPlanFragment pfs[] = new SynthesizedPlanFragment[2];
+        // create a work fragment to gather cold storage data from each of the sites.
+        pfs[1] = new SynthesizedPlanFragment();
+        pfs[1].fragmentId = SysProcFragmentId.PF_coldStorageData;
+        pfs[1].outputDepId = DEP_coldStorageData;
+        pfs[1].inputDepIds = new int[]{};
+        pfs[1].multipartition = true;
+        pfs[1].parameters = ParameterSet.fromArrayNoCopy((byte)interval, now);
+
+        // create a work fragment to aggregate the results.
+        pfs[0] = new SynthesizedPlanFragment();
+        pfs[0].fragmentId = SysProcFragmentId.PF_coldStorageAggregator;
+        pfs[0].outputDepId = DEP_coldStorageAggregator;
+        pfs[0].inputDepIds = new int[]{DEP_coldStorageData};
+        pfs[0].multipartition = false;
+        pfs[0].parameters = ParameterSet.emptyParameterSet();
+
+        results = executeSysProcPlanFragments(pfs, DEP_coldStorageAggregator);
+        return results;
+    }
+
+    private VoltTable[] getTempBlockPoolData(long interval, final long now) {
+        VoltTable[] results;
+        SynthesizedPlanFragment pfs[] = new SynthesizedPlanFragment[2];
+        // create a work fragment to gather temp block pool data from each of the sites.
+        pfs[1] = new SynthesizedPlanFragment();
+        pfs[1].fragmentId = SysProcFragmentId.PF_tempBlockPoolData;
+        pfs[1].outputDepId = DEP_tempBlockPoolData;
+        pfs[1].inputDepIds = new int[]{};
+        pfs[1].multipartition = true;
+        pfs[1].parameters = ParameterSet.fromArrayNoCopy((byte)interval, now);
+
+        // create a work fragment to aggregate the results.
+        pfs[0] = new SynthesizedPlanFragment();
+        pfs[0].fragmentId = SysProcFragmentId.PF_tempBlockPoolAggregator;
+        pfs[0].outputDepId = DEP_tempBlockPoolAggregator;
+        pfs[0].inputDepIds = new int[]{DEP_tempBlockPoolData};
+        pfs[0].multipartition = false;
+        pfs[0].parameters = ParameterSet.emptyParameterSet();
+
+        results = executeSysProcPlanFragments(pfs, DEP_tempBlockPoolAggregator);
+        return results;
+    }
+
     private VoltTable[] getLiveClientData(long interval, final long now) {
         VoltTable[] results;
         SynthesizedPlanFragment pfs[] = new SynthesizedPlanFragment[2];
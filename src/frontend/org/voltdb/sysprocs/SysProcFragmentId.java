@@ -48,6 +48,10 @@ public class SysProcFragmentId
     public static final long PF_liveClientDataAggregator = 21;
     public static final long PF_plannerData = 22;
     public static final long PF_plannerAggregator = 23;
+    public static final long PF_coldStorageData = 24;
+    public static final long PF_coldStorageAggregator = 25;
+    public static final long PF_tempBlockPoolData = 26;
+    public static final long PF_tempBlockPoolAggregator = 27;
 
     // @Shutdown
     public static final long PF_shutdownCommand = 28;
@@ -96,6 +96,8 @@ import org.voltdb.compiler.deploymentfile.ServerExportEnum;
 import org.voltdb.compiler.deploymentfile.SnapshotType;
 import org.voltdb.compiler.deploymentfile.SystemSettingsType;
 import org.voltdb.compiler.deploymentfile.SystemSettingsType.Temptables;
+import org.voltdb.compiler.deploymentfile.TableLayoutEntry;
+import org.voltdb.compiler.deploymentfile.TableLayoutType;
 import org.voltdb.compiler.deploymentfile.UsersType;
 import org.voltdb.compiler.deploymentfile.UsersType.User;
 import org.voltdb.export.processors.GuestProcessor;
@@ -724,7 +726,48 @@ public abstract class CatalogUtil {
             Temptables ttt = sst.getTemptables();
             if (ttt != null)
             {
-                sb.append(ttt.getMaxsize()).append("\n");
+                sb.append(ttt.getMaxsize()).append(",");
+                sb.append(ttt.getSpillsize()).append(",");
+                sb.append(ttt.getSpillpath()).append(",");
+                sb.append(ttt.getBlockpoolsize()).append("\n");
+            }
+            SystemSettingsType.Compaction ct = sst.getCompaction();
+            if (ct != null)
+            {
+                sb.append(" COMPACTION ");
+                sb.append(ct.getBlockspertick()).append(",");
+                sb.append(ct.getMicrospertick()).append("\n");
+            }
+            SystemSettingsType.Coldstorageaging cat = sst.getColdstorageaging();
+            if (cat != null)
+            {
+                sb.append(" COLDSTORAGEAGING ");
+                sb.append(cat.getBlockspertick()).append(",");
+                sb.append(cat.getMicrospertick()).append("\n");
+            }
+            SystemSettingsType.Indexbuild ibt = sst.getIndexbuild();
+            if (ibt != null)
+            {
+                sb.append(" INDEXBUILD ");
+                sb.append(ibt.getThreads()).append("\n");
+            }
+            SystemSettingsType.Largepages lpt = sst.getLargepages();
+            if (lpt != null)
+            {
+                sb.append(" LARGEPAGES ");
+                sb.append(lpt.isEnabled()).append("\n");
+            }
+        }
+
+        sb.append(" TABLELAYOUT ");
+        TableLayoutType tlt = deployment.getTablelayout();
+        if (tlt != null)
+        {
+            for (TableLayoutEntry table : tlt.getTable())
+            {
+                sb.append(table.getName()).append(",");
+                sb.append(table.getMinipagecolumns()).append(",");
+                sb.append(table.getDictionarycolumns()).append("\n");
             }
         }
 
@@ -0,0 +1,657 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Cold Storage benchmark. Drives a VoltDBEngine directly, without Java:
+ * loads a key/value table bigger than the Cold Storage memory limit,
+ * then runs single-row reads and updates on keys drawn from a Zipf
+ * distribution, and prints throughput, latency percentiles, memory and
+ * anti-cache traffic once per report interval.
+ *
+ * The reads and updates are real plan fragments (the single-partition
+ * plans the planner produces for the voltkv Get and Put statements),
+ * handed to the engine by BenchTopend, so index lookups, access
+ * tracking, tombstones and fetch-backs all take their production paths.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <getopt.h>
+#include <arpa/inet.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "common/Topend.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/tabletuple.h"
+#include "common/types.h"
+#include "common/valuevector.h"
+#include "execution/VoltDBEngine.h"
+#include "logging/StdoutLogProxy.h"
+#include "storage/ColdStorageStats.h"
+#include "storage/persistenttable.h"
+
+using namespace std;
+using namespace voltdb;
+
+const int64_t READ_FRAGMENT_ID = 1;
+const int64_t UPDATE_FRAGMENT_ID = 2;
+
+const char *TABLE_NAME = "KV";
+const char *INDEX_NAME = "SYS_IDX_SYS_PK_KV";
+
+const int RESULT_BUFFER_SIZE = 10 * 1024 * 1024;
+
+struct BenchConfig {
+    int64_t rows;
+    int payloadSize;
+    int64_t memoryLimitMB;
+    float percentageOfDataToMove;
+    ColdStoragePolicy policy;
+    double theta;
+    bool scatter;
+    double updateFraction;
+    int64_t durationSeconds;
+    int64_t reportIntervalMillis;
+    int64_t tickIntervalMillis;
+    uint64_t seed;
+};
+
+int64_t nowMicroSeconds() {
+    timeval t;
+    gettimeofday(&t, NULL);
+    return static_cast<int64_t>(t.tv_sec) * 1000000 + t.tv_usec;
+}
+
+int64_t nowNanoSeconds() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<int64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+int64_t physicalMemory() {
+    return static_cast<int64_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<int64_t>(sysconf(_SC_PAGE_SIZE));
+}
+
+int64_t residentMemory() {
+    long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL) {
+        return 0;
+    }
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+    return static_cast<int64_t>(resident) * sysconf(_SC_PAGE_SIZE);
+}
+
+/** xorshift64*, so runs with the same seed draw the same keys */
+class Random {
+public:
+    Random(uint64_t seed) : m_state(seed != 0 ? seed : 88172645463325252ULL) {}
+
+    uint64_t next() {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 2685821657736338717ULL;
+    }
+
+    /** Uniform in [0, 1) */
+    double nextDouble() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    uint64_t m_state;
+};
+
+/**
+ * Zipf-distributed ranks in [0, n), rank 0 the most popular, after Gray
+ * et al., "Quickly Generating Billion-Record Synthetic Databases".
+ * theta 0 is uniform; the skew grows as theta approaches 1.
+ */
+class ZipfGenerator {
+public:
+    ZipfGenerator(int64_t n, double theta) : m_n(n), m_theta(theta) {
+        double zeta2 = 0;
+        m_zetan = 0;
+        for (int64_t ii = 1; ii <= n; ++ii) {
+            m_zetan += 1.0 / pow(static_cast<double>(ii), theta);
+            if (ii == 2) {
+                zeta2 = m_zetan;
+            }
+        }
+        m_alpha = 1.0 / (1.0 - theta);
+        m_eta = (1.0 - pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / m_zetan);
+    }
+
+    int64_t next(Random &random) const {
+        const double u = random.nextDouble();
+        const double uz = u * m_zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + pow(0.5, m_theta)) {
+            return 1;
+        }
+        const int64_t rank = static_cast<int64_t>(m_n * pow(m_eta * u - m_eta + 1.0, m_alpha));
+        return rank < m_n ? rank : m_n - 1;
+    }
+
+private:
+    int64_t m_n;
+    double m_theta;
+    double m_zetan;
+    double m_alpha;
+    double m_eta;
+};
+
+/*
+ * Plans, in the JSON the planner sends down for
+ *   SELECT ID, PAYLOAD FROM KV WHERE ID = ?;
+ *   UPDATE KV SET PAYLOAD = ? WHERE ID = ?;
+ */
+string tupleValueExpression(int index, const string &column, const string &type, int size) {
+    ostringstream json;
+    json << "{\"TYPE\":\"VALUE_TUPLE\",\"VALUE_TYPE\":\"" << type << "\",\"VALUE_SIZE\":" << size
+         << ",\"COLUMN_IDX\":" << index << ",\"TABLE_NAME\":\"" << TABLE_NAME
+         << "\",\"COLUMN_NAME\":\"" << column << "\",\"COLUMN_ALIAS\":\"" << column << "\"}";
+    return json.str();
+}
+
+string parameterExpression(int index, const string &type, int size) {
+    ostringstream json;
+    json << "{\"TYPE\":\"VALUE_PARAMETER\",\"VALUE_TYPE\":\"" << type << "\",\"VALUE_SIZE\":" << size
+         << ",\"PARAM_IDX\":" << index << "}";
+    return json.str();
+}
+
+string schemaColumn(const string &table, const string &column, const string &expression,
+                    const string &type, int size) {
+    ostringstream json;
+    json << "{\"TABLE_NAME\":\"" << table << "\",\"COLUMN_NAME\":\"" << column
+         << "\",\"COLUMN_ALIAS\":\"" << column << "\",\"EXPRESSION\":" << expression
+         << ",\"TYPE\":\"" << type << "\",\"SIZE\":" << size << "}";
+    return json.str();
+}
+
+/** An equality index scan on ID = ?keyParameter */
+string primaryKeyScan(int id, int parentId, const string &outputSchema, int keyParameter) {
+    const string key = tupleValueExpression(0, "ID", "INTEGER", 4);
+    const string parameter = parameterExpression(keyParameter, "INTEGER", 4);
+    const string equality = "{\"TYPE\":\"COMPARE_EQUAL\",\"VALUE_TYPE\":\"BIGINT\",\"VALUE_SIZE\":8,\"LEFT\":"
+        + key + ",\"RIGHT\":" + parameter + "}";
+    ostringstream json;
+    json << "{\"ID\":" << id << ",\"PLAN_NODE_TYPE\":\"INDEXSCAN\","
+         << "\"INLINE_NODES\":[{\"ID\":0,\"PLAN_NODE_TYPE\":\"PROJECTION\",\"INLINE_NODES\":[],"
+         << "\"CHILDREN_IDS\":[],\"PARENT_IDS\":[],\"OUTPUT_SCHEMA\":" << outputSchema << "}],"
+         << "\"CHILDREN_IDS\":[],\"PARENT_IDS\":[" << parentId << "],\"OUTPUT_SCHEMA\":" << outputSchema
+         << ",\"PREDICATE\":null,\"TARGET_TABLE_NAME\":\"" << TABLE_NAME << "\",\"KEY_ITERATE\":false,"
+         << "\"LOOKUP_TYPE\":\"EQ\",\"SORT_DIRECTION\":\"INVALID\",\"TARGET_INDEX_NAME\":\"" << INDEX_NAME
+         << "\",\"END_EXPRESSION\":" << equality << ",\"SEARCHKEY_EXPRESSIONS\":[" << parameter << "]}";
+    return json.str();
+}
+
+string readPlan(int payloadSize) {
+    const string outputSchema = "["
+        + schemaColumn(TABLE_NAME, "ID", tupleValueExpression(0, "ID", "INTEGER", 4), "INTEGER", 4) + ","
+        + schemaColumn(TABLE_NAME, "PAYLOAD", tupleValueExpression(1, "PAYLOAD", "STRING", payloadSize),
+                       "STRING", payloadSize)
+        + "]";
+    ostringstream json;
+    json << "{\"PLAN_NODES\":["
+         << "{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"INLINE_NODES\":[],\"CHILDREN_IDS\":[2],"
+         << "\"PARENT_IDS\":[],\"OUTPUT_SCHEMA\":" << outputSchema << "},"
+         << primaryKeyScan(2, 1, outputSchema, 0)
+         << "],\"EXECUTE_LIST\":[2,1],\"PARAMETERS\":[]}";
+    return json.str();
+}
+
+string updatePlan(int payloadSize) {
+    const string modified = "["
+        + schemaColumn("VOLT_TEMP_TABLE", "modified_tuples",
+                       "{\"TYPE\":\"VALUE_TUPLE\",\"VALUE_TYPE\":\"BIGINT\",\"VALUE_SIZE\":8,\"COLUMN_IDX\":0,"
+                       "\"TABLE_NAME\":\"VOLT_TEMP_TABLE\",\"COLUMN_NAME\":\"modified_tuples\","
+                       "\"COLUMN_ALIAS\":\"modified_tuples\"}",
+                       "BIGINT", 8)
+        + "]";
+    const string scanSchema = "["
+        + schemaColumn("VOLT_TEMP_TABLE", "tuple_address",
+                       "{\"TYPE\":\"VALUE_TUPLE_ADDRESS\",\"VALUE_TYPE\":\"BIGINT\",\"VALUE_SIZE\":8}",
+                       "BIGINT", 8) + ","
+        + schemaColumn("VOLT_TEMP_TABLE", "PAYLOAD", parameterExpression(0, "STRING", payloadSize),
+                       "STRING", payloadSize)
+        + "]";
+    ostringstream json;
+    json << "{\"PLAN_NODES\":["
+         << "{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"INLINE_NODES\":[],\"CHILDREN_IDS\":[2],"
+         << "\"PARENT_IDS\":[],\"OUTPUT_SCHEMA\":" << modified << "},"
+         << "{\"ID\":2,\"PLAN_NODE_TYPE\":\"UPDATE\",\"INLINE_NODES\":[],\"CHILDREN_IDS\":[3],"
+         << "\"PARENT_IDS\":[1],\"OUTPUT_SCHEMA\":" << modified << ",\"TARGET_TABLE_NAME\":\"" << TABLE_NAME
+         << "\",\"UPDATES_INDEXES\":false},"
+         << primaryKeyScan(3, 2, scanSchema, 1)
+         << "],\"EXECUTE_LIST\":[3,2,1],\"PARAMETERS\":[]}";
+    return json.str();
+}
+
+/** One partitioned table KV (ID INTEGER PRIMARY KEY, PAYLOAD VARCHAR) */
+string catalogPayload(int payloadSize) {
+    const string db = "/clusters[cluster]/databases[database]";
+    const string table = db + "/tables[KV]";
+    const string index = table + "/indexes[" + INDEX_NAME + "]";
+    ostringstream catalog;
+    catalog << "add / clusters cluster"
+            << "\nadd /clusters[cluster] databases database"
+            << "\nadd " << db << " programs program"
+            << "\nadd " << db << " tables KV"
+            << "\nset " << table << " type 0"
+            << "\nset " << table << " isreplicated false"
+            << "\nset " << table << " partitioncolumn " << table << "/columns[ID]"
+            << "\nset " << table << " estimatedtuplecount 0"
+            << "\nset " << table << " materializer null"
+            << "\nadd " << table << " columns ID"
+            << "\nset " << table << "/columns[ID] index 0"
+            << "\nset " << table << "/columns[ID] type 5"
+            << "\nset " << table << "/columns[ID] size 4"
+            << "\nset " << table << "/columns[ID] nullable false"
+            << "\nset " << table << "/columns[ID] name \"ID\""
+            << "\nadd " << table << " columns PAYLOAD"
+            << "\nset " << table << "/columns[PAYLOAD] index 1"
+            << "\nset " << table << "/columns[PAYLOAD] type 9"
+            << "\nset " << table << "/columns[PAYLOAD] size " << payloadSize
+            << "\nset " << table << "/columns[PAYLOAD] nullable false"
+            << "\nset " << table << "/columns[PAYLOAD] name \"PAYLOAD\""
+            << "\nadd " << table << " indexes " << INDEX_NAME
+            << "\nset " << index << " unique true"
+            << "\nset " << index << " type 1"
+            << "\nadd " << index << " columns ID"
+            << "\nset " << index << "/columns[ID] index 0"
+            << "\nset " << index << "/columns[ID] column " << table << "/columns[ID]"
+            << "\nadd " << table << " constraints SYS_PK_KV"
+            << "\nset " << table << "/constraints[SYS_PK_KV] type 4"
+            << "\nset " << table << "/constraints[SYS_PK_KV] oncommit \"\""
+            << "\nset " << table << "/constraints[SYS_PK_KV] index " << index
+            << "\nset " << table << "/constraints[SYS_PK_KV] foreignkeytable null"
+            << "\n";
+    return catalog.str();
+}
+
+/** Hands the engine the two plans above; nothing is ever exported */
+class BenchTopend : public Topend {
+public:
+    BenchTopend(int payloadSize)
+        : m_readPlan(readPlan(payloadSize)), m_updatePlan(updatePlan(payloadSize)) {
+    }
+
+    int loadNextDependency(int32_t dependencyId, Pool *pool, Table* destination) {
+        return 0;
+    }
+
+    std::string planForFragmentId(int64_t fragmentId) {
+        if (fragmentId == READ_FRAGMENT_ID) {
+            return m_readPlan;
+        }
+        if (fragmentId == UPDATE_FRAGMENT_ID) {
+            return m_updatePlan;
+        }
+        return "";
+    }
+
+    void crashVoltDB(FatalException e) {
+        fprintf(stderr, "EE crashed: %s\n", e.m_reason.c_str());
+        exit(-1);
+    }
+
+    int64_t getQueuedExportBytes(int32_t partitionId, std::string signature) {
+        return 0;
+    }
+
+    void pushExportBuffer(int64_t exportGeneration, int32_t partitionId, std::string signature,
+                          StreamBlock *block, bool sync, bool endOfStream) {
+    }
+
+    void fallbackToEEAllocatedBuffer(char *buffer, size_t length) {}
+
+private:
+    const std::string m_readPlan;
+    const std::string m_updatePlan;
+};
+
+/** Latencies of one report interval, in nanoseconds */
+class LatencyRecorder {
+public:
+    void record(int64_t nanos) {
+        m_samples.push_back(nanos);
+    }
+
+    size_t count() const {
+        return m_samples.size();
+    }
+
+    /** The q-quantile in microseconds; reorders the samples */
+    double quantileMicros(double q) {
+        if (m_samples.empty()) {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(q * static_cast<double>(m_samples.size()));
+        if (rank >= m_samples.size()) {
+            rank = m_samples.size() - 1;
+        }
+        nth_element(m_samples.begin(), m_samples.begin() + rank, m_samples.end());
+        return static_cast<double>(m_samples[rank]) / 1000.0;
+    }
+
+    void clear() {
+        m_samples.clear();
+    }
+
+private:
+    vector<int64_t> m_samples;
+};
+
+class ColdStorageBench {
+public:
+    ColdStorageBench(const BenchConfig &config)
+        : m_config(config), m_zipf(config.rows, config.theta), m_random(config.seed),
+          m_txnId(1), m_table(NULL)
+    {
+        const float limitPercentage = static_cast<float>(
+            100.0 * static_cast<double>(config.memoryLimitMB) * 1024 * 1024 / physicalMemory());
+        m_engine = new VoltDBEngine(new BenchTopend(config.payloadSize), new StdoutLogProxy(),
+                                    true, limitPercentage, config.percentageOfDataToMove, config.policy);
+        m_resultBuffer = new char[RESULT_BUFFER_SIZE];
+        m_exceptionBuffer = new char[RESULT_BUFFER_SIZE];
+        m_engine->setBuffers(NULL, 0, m_resultBuffer, RESULT_BUFFER_SIZE,
+                             m_exceptionBuffer, RESULT_BUFFER_SIZE);
+        // the hashinator config is serialized, so the count is in network order
+        int partitionCount = htonl(1);
+        m_engine->initialize(0, 0, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY,
+                             reinterpret_cast<char*>(&partitionCount));
+        if (!m_engine->loadCatalog(-2, catalogPayload(config.payloadSize))) {
+            fprintf(stderr, "failed to load the benchmark catalog\n");
+            exit(-1);
+        }
+        m_table = dynamic_cast<PersistentTable*>(m_engine->getTable(TABLE_NAME));
+        m_lastTick = nowMicroSeconds();
+    }
+
+    ~ColdStorageBench() {
+        delete m_engine;
+        delete[] m_resultBuffer;
+        delete[] m_exceptionBuffer;
+    }
+
+    /** Insert every row, ticking as we go so eviction keeps up with the load */
+    void load() {
+        printf("loading %jd rows of %d byte payloads; Cold Storage limit %jd MB, policy %s\n",
+               (intmax_t)m_config.rows, m_config.payloadSize, (intmax_t)m_config.memoryLimitMB,
+               m_config.policy == COLD_STORAGE_POLICY_BLOCK ? "block" : "tuple");
+        const int64_t start = nowMicroSeconds();
+        TableTuple &tuple = m_table->tempTuple();
+        for (int64_t key = 0; key < m_config.rows; ++key) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(static_cast<int32_t>(key)));
+            NValue payload = ValueFactory::getStringValue(payloadFor(key, 0));
+            tuple.setNValue(1, payload);
+            m_table->insertTuple(tuple);
+            payload.free();
+            maybeTick(nowMicroSeconds());
+        }
+        const int64_t elapsed = nowMicroSeconds() - start;
+        printf("loaded in %.2f s; table memory %.1f MB, %jd tuples evicted, RSS %.1f MB\n",
+               static_cast<double>(elapsed) / 1000000.0, tableMemoryMB(),
+               (intmax_t)m_table->evictedTupleCount(),
+               static_cast<double>(residentMemory()) / (1024 * 1024));
+        // don't charge the load's evictions to the first interval
+        m_table->getColdStorageStats()->getStatsTuple(true, 0);
+    }
+
+    void run() {
+        printf("running for %jd s: theta %.2f%s, %.0f%% updates\n",
+               (intmax_t)m_config.durationSeconds, m_config.theta, m_config.scatter ? " (scattered)" : "",
+               m_config.updateFraction * 100);
+        printf("TIME_S,TXN_PER_S,P50_US,P99_US,P999_US,RSS_MB,TABLE_MB,EVICTED_TUPLES,"
+               "TUPLES_EVICTED_PER_S,FETCHES_PER_S,TUPLES_FETCHED_PER_S\n");
+        const int64_t start = nowMicroSeconds();
+        const int64_t end = start + m_config.durationSeconds * 1000000;
+        int64_t intervalStart = start;
+        int64_t now = start;
+        while (now < end) {
+            const int64_t key = nextKey();
+            const bool update = m_random.nextDouble() < m_config.updateFraction;
+            const int64_t before = nowNanoSeconds();
+            if (update) {
+                runUpdate(key);
+            } else {
+                runRead(key);
+            }
+            m_latencies.record(nowNanoSeconds() - before);
+
+            now = nowMicroSeconds();
+            maybeTick(now);
+            if (now - intervalStart >= m_config.reportIntervalMillis * 1000) {
+                report(now - start, now - intervalStart);
+                intervalStart = now;
+            }
+        }
+    }
+
+private:
+    int64_t nextKey() {
+        const int64_t rank = m_zipf.next(m_random);
+        if (!m_config.scatter) {
+            return rank;
+        }
+        // spread the hot keys over the whole table instead of its first blocks
+        uint64_t hash = 14695981039346656037ULL;
+        for (int ii = 0; ii < 8; ++ii) {
+            hash ^= (static_cast<uint64_t>(rank) >> (ii * 8)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<int64_t>(hash % static_cast<uint64_t>(m_config.rows));
+    }
+
+    /** The row's payload, padded to the configured size so loads and updates write the same bytes */
+    string payloadFor(int64_t key, int64_t version) const {
+        ostringstream payload;
+        payload << "row " << key << " version " << version << " ";
+        string value = payload.str();
+        value.resize(m_config.payloadSize, 'x');
+        return value;
+    }
+
+    void runRead(int64_t key) {
+        NValueArray &params = m_engine->getParameterContainer();
+        params[0] = ValueFactory::getIntegerValue(static_cast<int32_t>(key));
+        execute(READ_FRAGMENT_ID, 1);
+    }
+
+    void runUpdate(int64_t key) {
+        NValue payload = ValueFactory::getStringValue(payloadFor(key, m_txnId));
+        NValueArray &params = m_engine->getParameterContainer();
+        params[0] = payload;
+        params[1] = ValueFactory::getIntegerValue(static_cast<int32_t>(key));
+        execute(UPDATE_FRAGMENT_ID, 2);
+        payload.free();
+    }
+
+    /** One single-fragment, single-partition transaction, committed at once */
+    void execute(int64_t fragmentId, int paramCount) {
+        m_engine->resetReusedResultOutputBuffer();
+        m_engine->setUndoToken(m_txnId);
+        m_engine->setUsedParamcnt(paramCount);
+        const int result = m_engine->executeQuery(fragmentId, 1, -1, m_engine->getParameterContainer(),
+                                                  m_txnId, m_txnId - 1, m_txnId, true, true);
+        if (result != ENGINE_ERRORCODE_SUCCESS) {
+            fprintf(stderr, "fragment %jd failed in transaction %jd\n", (intmax_t)fragmentId, (intmax_t)m_txnId);
+            exit(-1);
+        }
+        m_engine->releaseUndoToken(m_txnId);
+        ++m_txnId;
+    }
+
+    void maybeTick(int64_t now) {
+        if (now - m_lastTick >= m_config.tickIntervalMillis * 1000) {
+            m_engine->tick(now / 1000, m_txnId - 1);
+            m_lastTick = now;
+        }
+    }
+
+    double tableMemoryMB() const {
+        return static_cast<double>(m_table->allocatedTupleMemory() + m_table->nonInlinedMemorySize())
+            / (1024 * 1024);
+    }
+
+    int64_t statValue(TableTuple *row, const string &column) const {
+        const vector<string> columns = ColdStorageStats::generateColdStorageStatsColumnNames();
+        const int index = static_cast<int>(find(columns.begin(), columns.end(), column) - columns.begin());
+        return ValuePeeker::peekAsBigInt(row->getNValue(index));
+    }
+
+    void report(int64_t sinceStart, int64_t interval) {
+        const double seconds = static_cast<double>(interval) / 1000000.0;
+        TableTuple *row = m_table->getColdStorageStats()->getStatsTuple(true, sinceStart / 1000);
+        const double txns = static_cast<double>(m_latencies.count());
+        const double p50 = m_latencies.quantileMicros(0.50);
+        const double p99 = m_latencies.quantileMicros(0.99);
+        const double p999 = m_latencies.quantileMicros(0.999);
+        printf("%.1f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%jd,%.0f,%.1f,%.0f\n",
+               static_cast<double>(sinceStart) / 1000000.0, txns / seconds, p50, p99, p999,
+               static_cast<double>(residentMemory()) / (1024 * 1024), tableMemoryMB(),
+               (intmax_t)statValue(row, "EVICTED_TUPLES"),
+               static_cast<double>(statValue(row, "TUPLES_EVICTED")) / seconds,
+               static_cast<double>(statValue(row, "FETCHES")) / seconds,
+               static_cast<double>(statValue(row, "TUPLES_FETCHED")) / seconds);
+        fflush(stdout);
+        m_latencies.clear();
+    }
+
+    const BenchConfig m_config;
+    const ZipfGenerator m_zipf;
+    Random m_random;
+    VoltDBEngine *m_engine;
+    char *m_resultBuffer;
+    char *m_exceptionBuffer;
+    int64_t m_txnId;
+    int64_t m_lastTick;
+    PersistentTable *m_table;
+    LatencyRecorder m_latencies;
+};
+
+void usage() {
+    fprintf(stderr,
+            "usage: coldstorage [options]\n"
+            "  --rows N              rows to load (default 2000000)\n"
+            "  --payload BYTES       VARCHAR payload size (default 256)\n"
+            "  --memory-limit MB     table memory at which Cold Storage evicts (default 256)\n"
+            "  --move PERCENT        percentage of each table evicted per pass (default 10)\n"
+            "  --policy tuple|block  Cold Storage policy (default tuple)\n"
+            "  --theta T             Zipf skew in [0, 1), 0 is uniform (default 0.99)\n"
+            "  --scatter             spread hot keys over the table instead of its first rows\n"
+            "  --updates FRACTION    fraction of transactions that update (default 0.05)\n"
+            "  --duration S          measured run length (default 60)\n"
+            "  --report MS           report interval (default 1000)\n"
+            "  --tick MS             engine tick interval (default 100)\n"
+            "  --seed N              random seed (default 1)\n");
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config;
+    config.rows = 2000000;
+    config.payloadSize = 256;
+    config.memoryLimitMB = 256;
+    config.percentageOfDataToMove = 10;
+    config.policy = COLD_STORAGE_POLICY_TUPLE;
+    config.theta = 0.99;
+    config.scatter = false;
+    config.updateFraction = 0.05;
+    config.durationSeconds = 60;
+    config.reportIntervalMillis = 1000;
+    config.tickIntervalMillis = 100;
+    config.seed = 1;
+
+    static struct option options[] = {
+        { "rows", required_argument, NULL, 'r' },
+        { "payload", required_argument, NULL, 'p' },
+        { "memory-limit", required_argument, NULL, 'm' },
+        { "move", required_argument, NULL, 'v' },
+        { "policy", required_argument, NULL, 'P' },
+        { "theta", required_argument, NULL, 't' },
+        { "scatter", no_argument, NULL, 's' },
+        { "updates", required_argument, NULL, 'u' },
+        { "duration", required_argument, NULL, 'd' },
+        { "report", required_argument, NULL, 'R' },
+        { "tick", required_argument, NULL, 'T' },
+        { "seed", required_argument, NULL, 'S' },
+        { NULL, 0, NULL, 0 }
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (option) {
+        case 'r': config.rows = atoll(optarg); break;
+        case 'p': config.payloadSize = atoi(optarg); break;
+        case 'm': config.memoryLimitMB = atoll(optarg); break;
+        case 'v': config.percentageOfDataToMove = static_cast<float>(atof(optarg)); break;
+        case 'P':
+            if (strcmp(optarg, "block") == 0) {
+                config.policy = COLD_STORAGE_POLICY_BLOCK;
+            } else if (strcmp(optarg, "tuple") == 0) {
+                config.policy = COLD_STORAGE_POLICY_TUPLE;
+            } else {
+                usage();
+                return -1;
+            }
+            break;
+        case 't': config.theta = atof(optarg); break;
+        case 's': config.scatter = true; break;
+        case 'u': config.updateFraction = atof(optarg); break;
+        case 'd': config.durationSeconds = atoll(optarg); break;
+        case 'R': config.reportIntervalMillis = atoll(optarg); break;
+        case 'T': config.tickIntervalMillis = atoll(optarg); break;
+        case 'S': config.seed = strtoull(optarg, NULL, 10); break;
+        default:
+            usage();
+            return -1;
+        }
+    }
+    if (config.rows < 2 || config.rows > INT32_MAX || config.theta < 0 || config.theta >= 1
+        || config.payloadSize < 64 || config.reportIntervalMillis <= 0) {
+        usage();
+        return -1;
+    }
+
+    ColdStorageBench bench(config);
+    bench.load();
+    bench.run();
+    return 0;
+}
@@ -0,0 +1,50 @@
+#!/usr/bin/env python
+
+# This file is part of VoltDB.
+# Copyright (C) 2008-2013 VoltDB Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+
+from subprocess import *
+
+# Sweep skew for both Cold Storage policies and print the steady state
+# of each run: the average of its report lines after the first quarter.
+def run(policy, theta, extra = []):
+    args = ['./coldstorage', '--policy', policy, '--theta', str(theta)] + extra
+    output = Popen(args, stdout=PIPE).communicate()[0]
+
+    header = None
+    rows = []
+    for line in output.split('\n'):
+        if line.startswith('TIME_S'):
+            header = line.split(',')
+        elif header is not None and line != '':
+            rows += [[float(x) for x in line.split(',')]]
+
+    steady = rows[len(rows) / 4:]
+    averages = [sum(column) / len(steady) for column in zip(*steady)]
+    print "%s theta=%.2f %s" % (policy, theta, ' '.join(extra))
+    for name, value in zip(header[1:], averages[1:]):
+        print "    %-22s %.1f" % (name, value)
+
+for policy in ['tuple', 'block']:
+    for theta in [0.5, 0.8, 0.99]:
+        run(policy, theta)
+        run(policy, theta, ['--scatter'])
@@ -0,0 +1,161 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/LargePages.h"
+#include "common/NValue.hpp"
+#include "common/Pool.hpp"
+#include "common/TupleSchema.h"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "structures/ContiguousAllocator.h"
+
+#include <sched.h>
+#include <vector>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <string.h>
+#include <stdint.h>
+
+using namespace voltdb;
+
+class LargePagesTest : public Test {
+public:
+    ~LargePagesTest() {
+        LargePages::setEnabled(false);
+    }
+};
+
+TEST_F(LargePagesTest, OffByDefault) {
+    ASSERT_FALSE(LargePages::enabled());
+    ASSERT_FALSE(LargePages::useFor(LargePages::HUGE_PAGE_SIZE * 4));
+    LargePages::setEnabled(true);
+    ASSERT_TRUE(LargePages::useFor(LargePages::HUGE_PAGE_SIZE));
+    ASSERT_FALSE(LargePages::useFor(LargePages::HUGE_PAGE_SIZE - 1));
+}
+
+TEST_F(LargePagesTest, AllocationsAreAlignedAndRounded) {
+    const int64_t before = LargePages::mappedBytes();
+    const size_t alignment = LargePages::HUGE_PAGE_SIZE * 2;
+    char *memory = LargePages::allocate(LargePages::HUGE_PAGE_SIZE + 1, alignment);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(memory) % alignment);
+    ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE * 2), LargePages::mappedBytes());
+    ::memset(memory, 0x5a, LargePages::HUGE_PAGE_SIZE * 2);
+    LargePages::free(memory, LargePages::HUGE_PAGE_SIZE + 1);
+    ASSERT_EQ(before, LargePages::mappedBytes());
+}
+
+TEST_F(LargePagesTest, PoolChunksAndAllocatorBuffers) {
+    LargePages::setEnabled(true);
+    const int64_t before = LargePages::mappedBytes();
+    {
+        Pool pool(LargePages::HUGE_PAGE_SIZE * 2, 1);
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE * 2), LargePages::mappedBytes());
+        ::memset(pool.allocate(1000), 1, 1000);
+        // chunks below a huge page keep coming from the heap
+        Pool small(65536, 1);
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE * 2), LargePages::mappedBytes());
+    }
+    ASSERT_EQ(before, LargePages::mappedBytes());
+
+    {
+        // 10000 48 byte nodes need less than a huge page, so a buffer
+        // takes as many as one huge page holds after its cache line header
+        ContiguousAllocator allocator(48, 10000);
+        ::memset(allocator.alloc(), 2, 48);
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE), LargePages::mappedBytes());
+        const int64_t perBuffer = static_cast<int64_t>(allocator.bytesAllocated()) / 48;
+        ASSERT_EQ((static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE) - 64) / 48, perBuffer);
+        for (int64_t ii = 1; ii < perBuffer; ii++) {
+            ::memset(allocator.alloc(), 2, 48);
+        }
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE), LargePages::mappedBytes());
+        allocator.alloc();
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE * 2), LargePages::mappedBytes());
+        allocator.trim();
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE), LargePages::mappedBytes());
+    }
+    {
+        // A buffer of 50000 48 byte nodes spans two huge pages
+        ContiguousAllocator allocator(48, 50000);
+        for (int ii = 0; ii < 50000; ii++) {
+            ::memset(allocator.alloc(), 2, 48);
+        }
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE * 2), LargePages::mappedBytes());
+    }
+    ASSERT_EQ(before, LargePages::mappedBytes());
+
+    // Without large pages the buffers keep their size, from the heap
+    LargePages::setEnabled(false);
+    ContiguousAllocator allocator(48, 10000);
+    allocator.alloc();
+    ASSERT_EQ(before, LargePages::mappedBytes());
+    ASSERT_EQ(48 * 10000, allocator.bytesAllocated());
+}
+
+TEST_F(LargePagesTest, IndexArenas) {
+    LargePages::setEnabled(true);
+    const int64_t before = LargePages::mappedBytes();
+    std::vector<ValueType> columnTypes(1, VALUE_TYPE_BIGINT);
+    std::vector<int32_t> columnLengths(1, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    std::vector<bool> columnAllowNull(1, false);
+    TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+    std::vector<int> keyColumns(1, 0);
+    TableIndexScheme scheme("TreeIndex", BALANCED_TREE_INDEX, keyColumns,
+                            TableIndex::simplyIndexColumns(), true, true, schema);
+    {
+        boost::scoped_ptr<TableIndex> index(TableIndexFactory::getInstance(scheme));
+        boost::scoped_array<char> data(new char[schema->tupleLength() + TUPLE_HEADER_SIZE]);
+        TableTuple tuple(data.get(), schema);
+        tuple.setNValue(0, ValueFactory::getBigIntValue(1));
+        ASSERT_TRUE(index->addEntry(&tuple));
+        // the node arena of the index takes a whole huge page for its first node
+        ASSERT_EQ(before + static_cast<int64_t>(LargePages::HUGE_PAGE_SIZE), LargePages::mappedBytes());
+        ASSERT_TRUE(index->deleteEntry(&tuple));
+    }
+    ASSERT_EQ(before, LargePages::mappedBytes());
+    TupleSchema::freeTupleSchema(schema);
+}
+
+TEST_F(LargePagesTest, BindToNode) {
+    cpu_set_t previous;
+    ASSERT_EQ(0, ::sched_getaffinity(0, sizeof(previous), &previous));
+    // Kernels without NUMA support refuse the policy, which is fine
+    const int node = LargePages::bindToNode(0);
+    ASSERT_TRUE(node >= -1);
+    if (node >= 0) {
+        // pinned to the CPUs of the node
+        cpu_set_t bound;
+        ASSERT_EQ(0, ::sched_getaffinity(0, sizeof(bound), &bound));
+        ASSERT_TRUE(CPU_COUNT(&bound) > 0);
+        ASSERT_EQ(node, LargePages::bindToNode(0));
+    }
+    ::sched_setaffinity(0, sizeof(previous), &previous);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
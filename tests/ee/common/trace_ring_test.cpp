@@ -0,0 +1,91 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "harness.h"
+#include "common/TraceRing.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace voltdb;
+
+class TraceRingTest : public Test {
+public:
+    TraceRingTest() {}
+};
+
+TEST_F(TraceRingTest, DisabledRingRecordsNothing) {
+    TraceRing ring;
+    VOLT_TRACE_EVENT(ring, TRACE_EVENT_FRAGMENT_BEGIN, 1, 2);
+    EXPECT_EQ(0, ring.recorded());
+
+    std::vector<TraceEvent> events;
+    ring.snapshot(events);
+    EXPECT_EQ(0, events.size());
+}
+
+TEST_F(TraceRingTest, RecordsEventsInOrder) {
+    TraceRing ring;
+    ring.setEnabled(true);
+    VOLT_TRACE_EVENT(ring, TRACE_EVENT_FRAGMENT_BEGIN, 42, 3);
+    VOLT_TRACE_EVENT(ring, TRACE_EVENT_FRAGMENT_END, 42, 7);
+
+    std::vector<TraceEvent> events;
+    ring.snapshot(events);
+    ASSERT_EQ(2, events.size());
+    EXPECT_EQ(1, events[0].m_sequence);
+    EXPECT_EQ(TRACE_EVENT_FRAGMENT_BEGIN, events[0].m_code);
+    EXPECT_EQ(42, events[0].m_arg0);
+    EXPECT_EQ(3, events[0].m_arg1);
+    EXPECT_EQ(2, events[1].m_sequence);
+    EXPECT_EQ(TRACE_EVENT_FRAGMENT_END, events[1].m_code);
+    EXPECT_EQ(7, events[1].m_arg1);
+    EXPECT_TRUE(events[0].m_timestamp <= events[1].m_timestamp);
+    EXPECT_EQ(0, strcmp("FRAGMENT_END", TraceRing::eventName(events[1].m_code)));
+
+    ring.clear();
+    ring.snapshot(events);
+    EXPECT_EQ(0, events.size());
+}
+
+TEST_F(TraceRingTest, WrapKeepsTheNewestEvents) {
+    TraceRing ring;
+    ring.setEnabled(true);
+    const int64_t total = TRACE_RING_CAPACITY * 2 + 5;
+    for (int64_t ii = 0; ii < total; ++ii) {
+        VOLT_TRACE_EVENT(ring, TRACE_EVENT_TICK, ii, 0);
+    }
+    EXPECT_EQ(total, ring.recorded());
+
+    std::vector<TraceEvent> events;
+    ring.snapshot(events);
+    ASSERT_EQ(TRACE_RING_CAPACITY, events.size());
+    EXPECT_EQ(total - TRACE_RING_CAPACITY, events.front().m_arg0);
+    EXPECT_EQ(total - 1, events.back().m_arg0);
+    for (size_t ii = 1; ii < events.size(); ++ii) {
+        EXPECT_EQ(events[ii - 1].m_sequence + 1, events[ii].m_sequence);
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -29,6 +29,8 @@
 #include "catalog/table.h"
 #include "common/common.h"
 #include "execution/VoltDBEngine.h"
+#include "storage/MinipageLayout.h"
+#include "storage/persistenttable.h"
 #include "storage/table.h"
 
 #include <cstdlib>
@@ -116,6 +118,28 @@ class AddDropTableTest : public Test {
           "set /clusters[cluster]/databases[database]/tables[tableB]/columns[A] name \"A\"";
     }
 
+    std::string tableCCmds()
+    {
+        return
+          "add /clusters[cluster]/databases[database] tables tableC\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC] type 0\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC] isreplicated false\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC] partitioncolumn 0\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC] estimatedtuplecount 0\n"
+          "add /clusters[cluster]/databases[database]/tables[tableC] columns A\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[A] index 0\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[A] type 5\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[A] size 0\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[A] nullable false\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[A] name \"A\"\n"
+          "add /clusters[cluster]/databases[database]/tables[tableC] columns B\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[B] index 1\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[B] type 9\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[B] size 200\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[B] nullable true\n"
+          "set /clusters[cluster]/databases[database]/tables[tableC]/columns[B] name \"B\"";
+    }
+
     std::string tableBDeleteCmd()
     {
         return "delete /clusters[cluster]/databases[database] tables tableB";
@@ -306,6 +330,39 @@ TEST_F(AddDropTableTest, AddTable)
     ASSERT_TRUE(table1 == table2);
 }
 
+/*
+ * Test on engine.
+ * An added table gets the minipage columns configured for it.
+ */
+TEST_F(AddDropTableTest, AddTableWithMinipageColumns)
+{
+    m_engine->setMinipageColumns("tableA.A,tableA.MISSING,tableB.A");
+    bool changeResult = m_engine->updateCatalog( 0, tableACmds());
+    ASSERT_TRUE(changeResult);
+
+    PersistentTable *table = dynamic_cast<PersistentTable*>(m_engine->getTable("tableA"));
+    ASSERT_TRUE(table != NULL);
+    ASSERT_TRUE(table->minipageLayout() != NULL);
+    ASSERT_TRUE(table->minipageLayout()->covers(0));
+}
+
+/*
+ * Test on engine.
+ * An added table gets the dictionary columns configured for it.
+ */
+TEST_F(AddDropTableTest, AddTableWithDictionaryColumns)
+{
+    // A is inlined, so only B can be dictionary encoded
+    m_engine->setDictionaryColumns("tableC.A,tableC.B");
+    bool changeResult = m_engine->updateCatalog( 0, tableCCmds());
+    ASSERT_TRUE(changeResult);
+
+    PersistentTable *table = dynamic_cast<PersistentTable*>(m_engine->getTable("tableC"));
+    ASSERT_TRUE(table != NULL);
+    ASSERT_TRUE(table->columnDictionary(0) == NULL);
+    ASSERT_TRUE(table->columnDictionary(1) != NULL);
+}
+
 /*
  * Test on engine.
  * Add two tables at once!
@@ -457,6 +514,11 @@ TEST_F(AddDropTableTest, StatsWithDropTable)
     // get stats for the tables by relative offset
     statresult = m_engine->getStats(STATISTICS_SELECTOR_TYPE_TABLE, locators12, 2, false, 1L);
     ASSERT_TRUE(statresult == 1);
+
+    // the site's temp block pool is there whatever the catalog did
+    int locators0[] = {0};
+    statresult = m_engine->getStats(STATISTICS_SELECTOR_TYPE_TEMP_BLOCK_POOL, locators0, 1, false, 1L);
+    ASSERT_TRUE(statresult == 1);
 }
 
 /*
@@ -0,0 +1,337 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/PlannerDomValue.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/valuevector.h"
+#include "execution/VoltDBEngine.h"
+#include "executors/nestloopindexexecutor.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "plannodes/abstractplannode.h"
+#include "plannodes/indexscannode.h"
+#include "plannodes/seqscannode.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/temptable.h"
+#include "storage/TempTableLimits.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+
+using namespace voltdb;
+
+// An outer key the INTEGER index key can't hold: its row has no matches
+static const int64_t OVERFLOW_KEY = 1LL << 40;
+
+class NestLoopIndexExecutorTest : public Test {
+public:
+    NestLoopIndexExecutorTest() : m_outer(NULL) {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+
+        // INNER (I_K INTEGER, I_ID INTEGER), with a tree and a hash index on I_K
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("I_K");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("I_ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+        m_inner = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "INNER", schema, columnNames, 0));
+        std::vector<int> keyColumns(1, 0);
+        m_inner->addIndex(TableIndexFactory::getInstance(
+            TableIndexScheme("TREE", BALANCED_TREE_INDEX, keyColumns,
+                             TableIndex::simplyIndexColumns(), false, true, schema)));
+        m_inner->addIndex(TableIndexFactory::getInstance(
+            TableIndexScheme("HASH", HASH_TABLE_INDEX, keyColumns,
+                             TableIndex::simplyIndexColumns(), false, false, schema)));
+
+        // keys 0 to 199 have one to three matches, 200 and up none
+        TableTuple &tuple = m_inner->tempTuple();
+        int id = 0;
+        for (int key = 0; key < 200; key++) {
+            for (int ii = 0; ii <= key % 3; ii++) {
+                tuple.setNValue(0, ValueFactory::getIntegerValue(key));
+                tuple.setNValue(1, ValueFactory::getIntegerValue(id++));
+                m_inner->insertTuple(tuple);
+            }
+        }
+    }
+
+    ~NestLoopIndexExecutorTest() {
+        delete m_outer;
+        delete m_inner;
+        delete m_engine;
+    }
+
+    static std::string nameFor(int id) {
+        std::ostringstream name;
+        name << "outer " << id;
+        return name.str();
+    }
+
+    // OUTER (O_ID INTEGER, O_K BIGINT, O_NAME VARCHAR(24)), a temp table as a child executor would fill
+    void createOuter(int count) {
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("O_ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("O_K");
+        columnTypes.push_back(voltdb::VALUE_TYPE_BIGINT);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_BIGINT));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("O_NAME");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(24);
+        columnAllowNull.push_back(false);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+        m_outer = TableFactory::getTempTable(0, "OUTER", schema, columnNames, &m_outerLimits);
+
+        // matching and unmatched keys, and now and then one that overflows the index key
+        TableTuple &tuple = m_outer->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            const int64_t key = ii % 13 == 5 ? OVERFLOW_KEY : (ii * 7) % 250;
+            tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+            tuple.setNValue(1, ValueFactory::getBigIntValue(key));
+            NValue name = ValueFactory::getStringValue(nameFor(ii));
+            tuple.setNValue(2, name);
+            m_outer->insertTempTuple(tuple);
+            name.free();
+        }
+    }
+
+    static std::string tupleValue(int column, const char *table, const char *type, int size) {
+        std::ostringstream json;
+        json << "{\"TYPE\":\"VALUE_TUPLE\",\"VALUE_TYPE\":\"" << type << "\",\"VALUE_SIZE\":" << size
+             << ",\"COLUMN_IDX\":" << column << ",\"TABLE_NAME\":\"" << table << "\"}";
+        return json.str();
+    }
+
+    static std::string outputColumn(const char *name, int column, const char *table,
+                                    const char *type, int size) {
+        std::ostringstream json;
+        json << "{\"COLUMN_NAME\":\"" << name << "\",\"TYPE\":\"" << type << "\",\"SIZE\":" << size
+             << ",\"EXPRESSION\":" << tupleValue(column, table, type, size) << "}";
+        return json.str();
+    }
+
+    // OUTER joined to INNER on O_K = I_K through the given index
+    static std::string planFor(const char *joinType, const char *indexName) {
+        std::ostringstream json;
+        json << "{\"ID\":1,\"PLAN_NODE_TYPE\":\"NESTLOOPINDEX\",\"JOIN_TYPE\":\"" << joinType << "\","
+             << "\"PARENT_IDS\":[],\"CHILDREN_IDS\":[],"
+             << "\"OUTPUT_SCHEMA\":["
+             << outputColumn("O_ID", 0, "OUTER", "INTEGER", 4) << ","
+             << outputColumn("O_K", 1, "OUTER", "BIGINT", 8) << ","
+             << outputColumn("O_NAME", 2, "OUTER", "STRING", 24) << ","
+             << outputColumn("I_K", 0, "INNER", "INTEGER", 4) << ","
+             << outputColumn("I_ID", 1, "INNER", "INTEGER", 4) << "],"
+             << "\"INLINE_NODES\":[{\"ID\":2,\"PLAN_NODE_TYPE\":\"INDEXSCAN\","
+             << "\"PARENT_IDS\":[],\"CHILDREN_IDS\":[],\"INLINE_NODES\":[],"
+             << "\"TARGET_TABLE_NAME\":\"INNER\",\"TARGET_INDEX_NAME\":\"" << indexName << "\","
+             << "\"KEY_ITERATE\":false,\"LOOKUP_TYPE\":\"EQ\",\"SORT_DIRECTION\":\"INVALID\","
+             << "\"SEARCHKEY_EXPRESSIONS\":[" << tupleValue(1, "OUTER", "BIGINT", 8) << "]}]}";
+        return json.str();
+    }
+
+    static std::string rowFor(int outerId, int64_t key, const std::string &innerValues) {
+        std::ostringstream row;
+        row << outerId << "|" << key << "|" << nameFor(outerId) << "|" << innerValues;
+        return row.str();
+    }
+
+    // The join through the executor, one string per output row in order
+    std::vector<std::string> join(const char *joinType, const char *indexName) {
+        PlannerDomRoot domRoot(planFor(joinType, indexName).c_str());
+        boost::scoped_ptr<AbstractPlanNode> node(AbstractPlanNode::fromJSONObject(domRoot.rootObject()));
+        // the outer table stands in for the output of a child scan
+        SeqScanPlanNode *child = new SeqScanPlanNode(3);
+        child->setOutputTable(m_outer);
+        node->addChild(child);
+        dynamic_cast<IndexScanPlanNode*>(node->getInlinePlanNode(PLAN_NODE_TYPE_INDEXSCAN))->setTargetTable(m_inner);
+
+        TempTableLimits limits;
+        NestLoopIndexExecutor *executor = new NestLoopIndexExecutor(m_engine, node.get());
+        node->setExecutor(executor);
+        std::vector<std::string> rows;
+        if (!executor->init(m_engine, &limits) || !executor->execute(NValueArray(0))) {
+            delete child;
+            return rows;
+        }
+
+        Table *output = node->getOutputTable();
+        TableIterator iterator = output->iterator();
+        TableTuple tuple(output->schema());
+        while (iterator.next(tuple)) {
+            std::ostringstream innerValues;
+            if (tuple.getNValue(3).isNull()) {
+                innerValues << "NULL|NULL";
+            } else {
+                innerValues << ValuePeeker::peekAsInteger(tuple.getNValue(3)) << "|"
+                            << ValuePeeker::peekAsInteger(tuple.getNValue(4));
+            }
+            rows.push_back(rowFor(ValuePeeker::peekAsInteger(tuple.getNValue(0)),
+                                  ValuePeeker::peekAsBigInt(tuple.getNValue(1)),
+                                  innerValues.str()));
+        }
+        delete child;
+        return rows;
+    }
+
+    // The same join with one moveToKey() per outer tuple, as before batching
+    std::vector<std::string> unbatchedJoin(bool left, const char *indexName) {
+        TableIndex *index = m_inner->index(indexName);
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+
+        std::vector<std::string> rows;
+        TableIterator iterator = m_outer->iterator();
+        TableTuple outerTuple(m_outer->schema());
+        while (iterator.next(outerTuple)) {
+            const int outerId = ValuePeeker::peekAsInteger(outerTuple.getNValue(0));
+            const int64_t key = ValuePeeker::peekAsBigInt(outerTuple.getNValue(1));
+            bool match = false;
+            if (key != OVERFLOW_KEY) {
+                searchKey.setNValue(0, ValueFactory::getIntegerValue(static_cast<int32_t>(key)));
+                index->moveToKey(&searchKey);
+                TableTuple innerTuple(m_inner->schema());
+                while (!(innerTuple = index->nextValueAtKey()).isNullTuple()) {
+                    std::ostringstream innerValues;
+                    innerValues << ValuePeeker::peekAsInteger(innerTuple.getNValue(0)) << "|"
+                                << ValuePeeker::peekAsInteger(innerTuple.getNValue(1));
+                    rows.push_back(rowFor(outerId, key, innerValues.str()));
+                    match = true;
+                }
+            }
+            if (!match && left) {
+                rows.push_back(rowFor(outerId, key, "NULL|NULL"));
+            }
+        }
+        return rows;
+    }
+
+    // Both joins, through both indexes, give the same rows in the same order
+    void checkJoins(int outerCount) {
+        createOuter(outerCount);
+        const char *indexNames[] = { "TREE", "HASH" };
+        for (int ii = 0; ii < 2; ii++) {
+            std::vector<std::string> inner = join("INNER", indexNames[ii]);
+            std::vector<std::string> expected = unbatchedJoin(false, indexNames[ii]);
+            ASSERT_FALSE(expected.empty());
+            ASSERT_TRUE(inner == expected);
+
+            std::vector<std::string> left = join("LEFT", indexNames[ii]);
+            expected = unbatchedJoin(true, indexNames[ii]);
+            ASSERT_TRUE(left == expected);
+            ASSERT_EQ(outerCount, countOuterTuples(left));
+        }
+        delete m_outer;
+        m_outer = NULL;
+    }
+
+    // how many outer tuples the rows come from
+    static int countOuterTuples(const std::vector<std::string> &rows) {
+        int count = 0;
+        std::string last;
+        for (size_t ii = 0; ii < rows.size(); ii++) {
+            const std::string outerId = rows[ii].substr(0, rows[ii].find('|'));
+            if (outerId != last) {
+                count++;
+                last = outerId;
+            }
+        }
+        return count;
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_inner;
+    TempTableLimits m_outerLimits;
+    TempTable *m_outer;
+};
+
+TEST_F(NestLoopIndexExecutorTest, BatchBoundaries) {
+    // less than, exactly, and just over one batch of outer tuples, then many
+    checkJoins(31);
+    checkJoins(32);
+    checkJoins(33);
+    checkJoins(1000);
+}
+
+TEST_F(NestLoopIndexExecutorTest, LeftJoinKeepsUnmatchedOuterTuples) {
+    createOuter(100);
+    std::vector<std::string> rows = join("LEFT", "TREE");
+    ASSERT_TRUE(rows == unbatchedJoin(true, "TREE"));
+    // the overflowing keys and those past 199 come out once, with NULLs
+    int unmatched = 0;
+    for (int ii = 0; ii < 100; ii++) {
+        const int64_t key = ii % 13 == 5 ? OVERFLOW_KEY : (ii * 7) % 250;
+        if (key >= 200) {
+            unmatched++;
+            ASSERT_TRUE(std::find(rows.begin(), rows.end(), rowFor(ii, key, "NULL|NULL")) != rows.end());
+        }
+    }
+    ASSERT_TRUE(unmatched > 0);
+    ASSERT_EQ(join("INNER", "TREE").size() + unmatched, rows.size());
+}
+
+TEST_F(NestLoopIndexExecutorTest, SpilledOuterTable) {
+    m_outerLimits.setMemoryLimit(64 * 131072);
+    m_outerLimits.setSpillThreshold(2 * 131072, "/tmp");
+    const int outerCount = 50000;
+    createOuter(outerCount);
+    ASSERT_TRUE(m_outer->spilledTupleCount() > 0);
+
+    std::vector<std::string> rows = join("LEFT", "HASH");
+    ASSERT_EQ(0, m_outer->spilledTupleCount());
+    ASSERT_TRUE(rows == unbatchedJoin(true, "HASH"));
+    ASSERT_EQ(outerCount, countOuterTuples(rows));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
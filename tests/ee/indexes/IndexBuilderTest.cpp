@@ -0,0 +1,185 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "indexes/IndexBuilder.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+#include <boost/foreach.hpp>
+
+using namespace voltdb;
+
+class IndexBuilderTest : public Test {
+public:
+    IndexBuilderTest() {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("GRP");
+        columnTypes.push_back(voltdb::VALUE_TYPE_BIGINT);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_BIGINT));
+        columnAllowNull.push_back(false);
+        m_schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", m_schema, columnNames, 0));
+    }
+
+    ~IndexBuilderTest() {
+        IndexBuilder::setThreadCount(IndexBuilder::DEFAULT_THREAD_COUNT);
+        delete m_table;
+        delete m_engine;
+    }
+
+    void insertTuples(int count) {
+        TableTuple &tuple = m_table->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            // scrambled, so the keys don't arrive sorted
+            const int id = static_cast<int>((static_cast<int64_t>(ii) * 7919) % count);
+            tuple.setNValue(0, ValueFactory::getIntegerValue(id));
+            tuple.setNValue(1, ValueFactory::getBigIntValue(id % 100));
+            m_table->insertTuple(tuple);
+        }
+    }
+
+    TableIndex *createIndex(const char *name, TableIndexType type, int column, bool unique) {
+        return TableIndexFactory::getInstance(
+            TableIndexScheme(name, type, std::vector<int>(1, column),
+                             TableIndex::simplyIndexColumns(), unique, true, m_schema));
+    }
+
+    std::vector<TableIndex*> addAllKindsOfIndexes() {
+        std::vector<TableIndex*> indexes;
+        indexes.push_back(createIndex("TreeUnique", BALANCED_TREE_INDEX, 0, true));
+        indexes.push_back(createIndex("TreeMultimap", BALANCED_TREE_INDEX, 1, false));
+        indexes.push_back(createIndex("HashUnique", HASH_TABLE_INDEX, 0, true));
+        indexes.push_back(createIndex("HashMultimap", HASH_TABLE_INDEX, 1, false));
+        m_table->addIndexes(indexes);
+        return indexes;
+    }
+
+    static int countAtKey(TableIndex *index, const NValue &key) {
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, key);
+        index->moveToKey(&searchKey);
+        int count = 0;
+        for (TableTuple found = index->nextValueAtKey(); !found.isNullTuple();
+             found = index->nextValueAtKey()) {
+            // every key used here, ID or GRP, is in a tuple with GRP equal to key % 100
+            if (ValuePeeker::peekBigInt(found.getNValue(1)) != ValuePeeker::peekAsBigInt(key) % 100) {
+                return -1;
+            }
+            count++;
+        }
+        return count;
+    }
+
+    void verifyIndexes(const std::vector<TableIndex*> &indexes, int tupleCount) {
+        BOOST_FOREACH(TableIndex *index, indexes) {
+            ASSERT_EQ(tupleCount, index->getSize());
+        }
+        for (int id = 0; id < tupleCount; id += 13) {
+            ASSERT_EQ(1, countAtKey(indexes[0], ValueFactory::getIntegerValue(id)));
+            ASSERT_EQ(1, countAtKey(indexes[2], ValueFactory::getIntegerValue(id)));
+        }
+        for (int group = 0; group < 100; group += 7) {
+            ASSERT_EQ(tupleCount / 100, countAtKey(indexes[1], ValueFactory::getBigIntValue(group)));
+            ASSERT_EQ(tupleCount / 100, countAtKey(indexes[3], ValueFactory::getBigIntValue(group)));
+        }
+    }
+
+    VoltDBEngine *m_engine;
+    TupleSchema *m_schema;
+    PersistentTable *m_table;
+};
+
+TEST_F(IndexBuilderTest, IndexesBuildSideBySide) {
+    const int tupleCount = 50000;
+    insertTuples(tupleCount);
+    std::vector<TableIndex*> indexes = addAllKindsOfIndexes();
+    ASSERT_EQ(4, m_table->allIndexes().size());
+    verifyIndexes(indexes, tupleCount);
+
+    // the new indexes are maintained like any others
+    TableTuple &tuple = m_table->tempTuple();
+    tuple.setNValue(0, ValueFactory::getIntegerValue(tupleCount));
+    tuple.setNValue(1, ValueFactory::getBigIntValue(7));
+    m_table->insertTuple(tuple);
+    ASSERT_EQ(tupleCount / 100 + 1, countAtKey(indexes[1], ValueFactory::getBigIntValue(7)));
+    ASSERT_EQ(tupleCount / 100 + 1, countAtKey(indexes[3], ValueFactory::getBigIntValue(7)));
+}
+
+TEST_F(IndexBuilderTest, SiteThreadOnlyBuildsTheSame) {
+    IndexBuilder::setThreadCount(1);
+    const int tupleCount = 50000;
+    insertTuples(tupleCount);
+    verifyIndexes(addAllKindsOfIndexes(), tupleCount);
+}
+
+TEST_F(IndexBuilderTest, UniqueIndexOverDuplicatesKeepsFirstTuples) {
+    const int tupleCount = 20000;
+    insertTuples(tupleCount);
+    std::vector<TableIndex*> indexes;
+    indexes.push_back(createIndex("TreeUnique", BALANCED_TREE_INDEX, 0, true));
+    indexes.push_back(createIndex("TreeUniqueOnGroup", BALANCED_TREE_INDEX, 1, true));
+    indexes.push_back(createIndex("HashUniqueOnGroup", HASH_TABLE_INDEX, 1, true));
+    indexes.push_back(createIndex("TreeMultimap", BALANCED_TREE_INDEX, 1, false));
+    m_table->addIndexes(indexes);
+
+    // as when indexes were filled a tuple at a time, the duplicates are
+    // left out and the indexes after them are filled all the same
+    ASSERT_EQ(tupleCount, indexes[0]->getSize());
+    ASSERT_EQ(100, indexes[1]->getSize());
+    ASSERT_EQ(100, indexes[2]->getSize());
+    ASSERT_EQ(tupleCount, indexes[3]->getSize());
+    ASSERT_EQ(1, countAtKey(indexes[1], ValueFactory::getBigIntValue(42)));
+    ASSERT_EQ(tupleCount / 100, countAtKey(indexes[3], ValueFactory::getBigIntValue(42)));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -21,6 +21,7 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <limits>
 #include "harness.h"
 #include "indexes/indexkey.h"
 #include "common/NValue.hpp"
@@ -443,6 +444,104 @@ TEST_F(IndexKeyTest, Int64Packing2Int32sWithSecondNull) {
     voltdb::TupleSchema::freeTupleSchema(keySchema);
 }
 
+static int sign(int comparison) {
+    return (comparison > 0) - (comparison < 0);
+}
+
+/*
+ * A NormalizedKey must order and match keys just like the GenericKey it
+ * replaces, NULLs, infinities, negative numbers, -0.0 and string prefixes
+ * included. A DOUBLE at or below DOUBLE_NULL, -inf among them, is NULL.
+ */
+TEST_F(IndexKeyTest, NormalizedKeyOrdersLikeGenericKey) {
+    std::vector<voltdb::ValueType> columnTypes;
+    std::vector<int32_t> columnLengths;
+    std::vector<bool> columnAllowNull(4, true);
+
+    columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+    columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+    columnTypes.push_back(voltdb::VALUE_TYPE_DOUBLE);
+    columnTypes.push_back(voltdb::VALUE_TYPE_DECIMAL);
+    columnLengths.push_back(10);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_DOUBLE));
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_DECIMAL));
+
+    voltdb::TupleSchema *keySchema = voltdb::TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+    ASSERT_TRUE(voltdb::NormalizedKey<40>::canNormalize(keySchema));
+
+    std::vector<NValue> strings;
+    strings.push_back(NValue::getNullValue(voltdb::VALUE_TYPE_VARCHAR));
+    strings.push_back(ValueFactory::getStringValue(""));
+    strings.push_back(ValueFactory::getStringValue("a"));
+    strings.push_back(ValueFactory::getStringValue("ab"));
+    strings.push_back(ValueFactory::getStringValue("b"));
+    strings.push_back(ValueFactory::getStringValue("\xc3\xa9t\xc3\xa9"));
+    std::vector<NValue> integers;
+    integers.push_back(NValue::getNullValue(voltdb::VALUE_TYPE_INTEGER));
+    integers.push_back(ValueFactory::getIntegerValue(-5));
+    integers.push_back(ValueFactory::getIntegerValue(0));
+    integers.push_back(ValueFactory::getIntegerValue(70000));
+    std::vector<NValue> doubles;
+    doubles.push_back(NValue::getNullValue(voltdb::VALUE_TYPE_DOUBLE));
+    doubles.push_back(ValueFactory::getDoubleValue(-std::numeric_limits<double>::infinity()));
+    doubles.push_back(ValueFactory::getDoubleValue(-std::numeric_limits<double>::max()));
+    doubles.push_back(ValueFactory::getDoubleValue(-1.5));
+    doubles.push_back(ValueFactory::getDoubleValue(-0.0));
+    doubles.push_back(ValueFactory::getDoubleValue(0.0));
+    doubles.push_back(ValueFactory::getDoubleValue(2.25));
+    doubles.push_back(ValueFactory::getDoubleValue(std::numeric_limits<double>::infinity()));
+    std::vector<NValue> decimals;
+    decimals.push_back(NValue::getNullValue(voltdb::VALUE_TYPE_DECIMAL));
+    decimals.push_back(ValueFactory::getDecimalValueFromString("-1.5"));
+    decimals.push_back(ValueFactory::getDecimalValueFromString("0"));
+    decimals.push_back(ValueFactory::getDecimalValueFromString("3.000000000001"));
+
+    std::vector<voltdb::GenericKey<40> > genericKeys;
+    std::vector<voltdb::NormalizedKey<40> > normalizedKeys;
+    voltdb::TableTuple tuple(keySchema);
+    tuple.move(new char[tuple.tupleLength()]);
+    for (size_t ss = 0; ss < strings.size(); ss++) {
+        for (size_t ii = 0; ii < integers.size(); ii++) {
+            for (size_t dd = 0; dd < doubles.size(); dd++) {
+                for (size_t cc = 0; cc < decimals.size(); cc++) {
+                    tuple.setNValue(0, strings[ss]);
+                    tuple.setNValue(1, integers[ii]);
+                    tuple.setNValue(2, doubles[dd]);
+                    tuple.setNValue(3, decimals[cc]);
+                    genericKeys.push_back(voltdb::GenericKey<40>(&tuple));
+                    normalizedKeys.push_back(voltdb::NormalizedKey<40>(&tuple));
+                }
+            }
+        }
+    }
+
+    voltdb::GenericKey<40>::KeyComparator genericComparator(keySchema);
+    voltdb::NormalizedKey<40>::KeyComparator comparator(keySchema);
+    voltdb::NormalizedKey<40>::KeyEqualityChecker equality(keySchema);
+    voltdb::NormalizedKey<40>::KeyHasher hasher(keySchema);
+    int mismatches = 0;
+    for (size_t ii = 0; ii < normalizedKeys.size(); ii++) {
+        for (size_t jj = 0; jj < normalizedKeys.size(); jj++) {
+            const int expected = sign(genericComparator(genericKeys[ii], genericKeys[jj]));
+            if (comparator(normalizedKeys[ii], normalizedKeys[jj]) != expected ||
+                equality(normalizedKeys[ii], normalizedKeys[jj]) != (expected == 0)) {
+                mismatches++;
+            }
+            if (expected == 0) {
+                EXPECT_EQ(hasher(normalizedKeys[ii]), hasher(normalizedKeys[jj]));
+            }
+        }
+    }
+    EXPECT_EQ(0, mismatches);
+
+    delete [] tuple.address();
+    for (size_t ss = 0; ss < strings.size(); ss++) {
+        strings[ss].free();
+    }
+    voltdb::TupleSchema::freeTupleSchema(keySchema);
+}
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
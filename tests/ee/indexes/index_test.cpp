@@ -380,6 +380,43 @@ public:
                         .op_equals(tuple.getNValue(i)).isTrue());
     }
 
+    // moveToKeys() must find what moveToKey() finds, key by key
+    void checkBatchedLookups(TableIndex *index, int64_t firstKey, int64_t lastKey)
+    {
+        const int count = static_cast<int>(lastKey - firstKey + 1);
+        const int keyLength = index->getKeySchema()->tupleLength();
+        char *keyData = new char[keyLength * count];
+        vector<TableTuple> keys(count, TableTuple(index->getKeySchema()));
+        vector<const TableTuple*> batch;
+        for (int ii = 0; ii < count; ii++) {
+            // out of order, the walks to neighbouring keys shouldn't share anything
+            keys[ii].moveNoHeader(keyData + keyLength * ii);
+            keys[ii].setNValue(0, ValueFactory::getBigIntValue(firstKey + (ii * 7919) % count));
+            batch.push_back(&keys[ii]);
+        }
+
+        int matches = 0;
+        index->moveToKeys(batch);
+        for (int ii = 0; ii < count; ii++) {
+            vector<void*> batched;
+            const bool found = index->moveToBatchedKey(ii);
+            for (TableTuple tuple = index->nextValueAtKey(); !tuple.isNullTuple();
+                 tuple = index->nextValueAtKey()) {
+                batched.push_back(tuple.address());
+            }
+            vector<void*> single;
+            EXPECT_EQ(found, index->moveToKey(&keys[ii]));
+            for (TableTuple tuple = index->nextValueAtKey(); !tuple.isNullTuple();
+                 tuple = index->nextValueAtKey()) {
+                single.push_back(tuple.address());
+            }
+            EXPECT_TRUE(batched == single);
+            matches += static_cast<int>(batched.size());
+        }
+        EXPECT_TRUE(matches > 0);
+        delete[] keyData;
+    }
+
 protected:
     PersistentTable* table;
     char* m_exceptionBuffer;
@@ -813,6 +850,34 @@ TEST_F(IndexTest, TupleKeyUnique) {
     delete[] searchkey.address();
 }
 
+TEST_F(IndexTest, BatchedLookupsTreeUnique) {
+    vector<int> column_indices(1, 3);
+    vector<ValueType> column_types(1, VALUE_TYPE_BIGINT);
+    init("batched", BALANCED_TREE_INDEX, column_indices, column_types, true);
+    checkBatchedLookups(table->index("batched"), 0, 1100);
+}
+
+TEST_F(IndexTest, BatchedLookupsTreeMulti) {
+    vector<int> column_indices(1, 2);
+    vector<ValueType> column_types(1, VALUE_TYPE_BIGINT);
+    init("batched", BALANCED_TREE_INDEX, column_indices, column_types, false);
+    checkBatchedLookups(table->index("batched"), -1, 4);
+}
+
+TEST_F(IndexTest, BatchedLookupsHashUnique) {
+    vector<int> column_indices(1, 4);
+    vector<ValueType> column_types(1, VALUE_TYPE_BIGINT);
+    init("batched", HASH_TABLE_INDEX, column_indices, column_types, true);
+    checkBatchedLookups(table->index("batched"), 0, 300);
+}
+
+TEST_F(IndexTest, BatchedLookupsHashMulti) {
+    vector<int> column_indices(1, 1);
+    vector<ValueType> column_types(1, VALUE_TYPE_BIGINT);
+    init("batched", HASH_TABLE_INDEX, column_indices, column_types, false);
+    checkBatchedLookups(table->index("batched"), -1, 3);
+}
+
 int main()
 {
     return TestSuite::globalInstance()->runAll();
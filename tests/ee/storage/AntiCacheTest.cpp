@@ -0,0 +1,663 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/DefaultTupleSerializer.h"
+#include "common/serializeio.h"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/AntiCacheDB.h"
+#include "storage/ColdStorageStats.h"
+#include "storage/EvictedTupleIterator.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+#include <boost/foreach.hpp>
+
+using namespace voltdb;
+
+class AntiCacheTest : public Test {
+public:
+    AntiCacheTest() {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("PAYLOAD");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(300);
+        columnAllowNull.push_back(false);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+
+        std::vector<int> keyColumns(1, 0);
+        TableIndexScheme pkeyScheme("TreeUniqueIndex", BALANCED_TREE_INDEX, keyColumns,
+                                    TableIndex::simplyIndexColumns(), true, true, schema);
+        std::vector<TableIndexScheme> schemes;
+        schemes.push_back(TableIndexScheme("TreeMultimapIndex", BALANCED_TREE_INDEX, keyColumns,
+                                           TableIndex::simplyIndexColumns(), false, true, schema));
+        schemes.push_back(TableIndexScheme("HashUniqueIndex", HASH_TABLE_INDEX, keyColumns,
+                                           TableIndex::simplyIndexColumns(), true, false, schema));
+        schemes.push_back(TableIndexScheme("HashMultimapIndex", HASH_TABLE_INDEX, keyColumns,
+                                           TableIndex::simplyIndexColumns(), false, false, schema));
+
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", schema, columnNames, 0));
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(pkeyScheme);
+        m_table->addIndex(pkeyIndex);
+        m_table->setPrimaryKeyIndex(pkeyIndex);
+        BOOST_FOREACH(TableIndexScheme &scheme, schemes) {
+            m_table->addIndex(TableIndexFactory::getInstance(scheme));
+        }
+
+        m_antiCacheDB = new AntiCacheDB("/tmp", 0);
+    }
+
+    ~AntiCacheTest() {
+        delete m_table;
+        delete m_antiCacheDB;
+        delete m_engine;
+    }
+
+    void insertTuples(int count) {
+        TableTuple &tuple = m_table->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+            NValue payload = ValueFactory::getStringValue(payloadFor(ii));
+            tuple.setNValue(1, payload);
+            m_table->insertTuple(tuple);
+            payload.free();
+        }
+    }
+
+    static std::string payloadFor(int key) {
+        std::ostringstream payload;
+        payload << "payload of tuple " << key << " long enough to live outside the tuple";
+        return payload.str();
+    }
+
+    TableTuple lookup(TableIndex *index, int key) {
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, ValueFactory::getIntegerValue(key));
+        index->moveToKey(&searchKey);
+        return index->nextValueAtKey();
+    }
+
+    static int64_t statValue(TableTuple *row, const std::string &column) {
+        std::vector<std::string> columns = ColdStorageStats::generateColdStorageStatsColumnNames();
+        int index = static_cast<int>(std::find(columns.begin(), columns.end(), column) - columns.begin());
+        return ValuePeeker::peekAsBigInt(row->getNValue(index));
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+    AntiCacheDB *m_antiCacheDB;
+};
+
+TEST_F(AntiCacheTest, BlockFileRoundTrip) {
+    std::string first(1000, 'a');
+    std::string second(2000, 'b');
+    std::string third(500, 'c');
+    int32_t firstId = m_antiCacheDB->writeBlock(first.data(), static_cast<int32_t>(first.size()));
+    int32_t secondId = m_antiCacheDB->writeBlock(second.data(), static_cast<int32_t>(second.size()));
+    int32_t thirdId = m_antiCacheDB->writeBlock(third.data(), static_cast<int32_t>(third.size()));
+    ASSERT_NE(firstId, secondId);
+    ASSERT_NE(secondId, thirdId);
+    ASSERT_EQ(3, m_antiCacheDB->blockCount());
+    ASSERT_EQ(3500, m_antiCacheDB->bytesStored());
+
+    std::vector<char> buffer;
+    m_antiCacheDB->readBlock(secondId, buffer);
+    ASSERT_EQ(second, std::string(buffer.begin(), buffer.end()));
+    m_antiCacheDB->readBlock(firstId, buffer);
+    ASSERT_EQ(first, std::string(buffer.begin(), buffer.end()));
+
+    // Released space is reused before the file grows
+    m_antiCacheDB->releaseBlock(secondId);
+    ASSERT_EQ(2, m_antiCacheDB->blockCount());
+    const int64_t fileSize = m_antiCacheDB->fileSize();
+    std::string fourth(1500, 'd');
+    int32_t fourthId = m_antiCacheDB->writeBlock(fourth.data(), static_cast<int32_t>(fourth.size()));
+    ASSERT_EQ(fileSize, m_antiCacheDB->fileSize());
+    m_antiCacheDB->readBlock(fourthId, buffer);
+    ASSERT_EQ(fourth, std::string(buffer.begin(), buffer.end()));
+    m_antiCacheDB->readBlock(thirdId, buffer);
+    ASSERT_EQ(third, std::string(buffer.begin(), buffer.end()));
+}
+
+TEST_F(AntiCacheTest, BatchedBlockRead) {
+    std::vector<std::string> contents;
+    std::vector<int32_t> blockIds;
+    for (int ii = 0; ii < 6; ii++) {
+        contents.push_back(std::string(100 * (ii + 1), static_cast<char>('a' + ii)));
+        blockIds.push_back(m_antiCacheDB->writeBlock(contents[ii].data(),
+                                                     static_cast<int32_t>(contents[ii].size())));
+    }
+    // a gap in the file and ids that are not in file order
+    m_antiCacheDB->releaseBlock(blockIds[2]);
+    std::vector<int32_t> wanted;
+    wanted.push_back(blockIds[5]);
+    wanted.push_back(blockIds[0]);
+    wanted.push_back(blockIds[3]);
+    wanted.push_back(blockIds[1]);
+
+    std::vector<std::vector<char> > buffers;
+    m_antiCacheDB->readBlocks(wanted, buffers);
+    ASSERT_EQ(wanted.size(), buffers.size());
+    ASSERT_EQ(contents[5], std::string(buffers[0].begin(), buffers[0].end()));
+    ASSERT_EQ(contents[0], std::string(buffers[1].begin(), buffers[1].end()));
+    ASSERT_EQ(contents[3], std::string(buffers[2].begin(), buffers[2].end()));
+    ASSERT_EQ(contents[1], std::string(buffers[3].begin(), buffers[3].end()));
+}
+
+TEST_F(AntiCacheTest, EvictsColdestTuples) {
+    const int tupleCount = 1000;
+    insertTuples(tupleCount);
+
+    // odd keys are cold
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        tuple.setCSI(ValuePeeker::peekAsInteger(tuple.getNValue(0)) % 2 == 0 ? 50 : 0);
+    }
+    const int64_t stringMemory = m_table->nonInlinedMemorySize();
+
+    ASSERT_TRUE(m_table->canEvict());
+    ASSERT_EQ(tupleCount / 2, m_table->evictColdTuples(m_antiCacheDB, tupleCount / 2));
+    ASSERT_EQ(tupleCount / 2, m_table->activeTupleCount());
+    ASSERT_EQ(tupleCount / 2, m_table->evictedTupleCount());
+    ASSERT_EQ(m_table->evictedBlockCount(), m_antiCacheDB->blockCount());
+    ASSERT_TRUE(m_table->nonInlinedMemorySize() < stringMemory);
+
+    // resident tuples are all hot
+    iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        ASSERT_EQ(50, tuple.getCSI());
+    }
+
+    // every index still has an entry for every tuple, the cold ones lead to tombstones
+    BOOST_FOREACH(TableIndex *index, m_table->allIndexes()) {
+        ASSERT_EQ(tupleCount, index->getSize());
+        for (int key = 0; key < tupleCount; key++) {
+            TableTuple found = lookup(index, key);
+            ASSERT_FALSE(found.isNullTuple());
+            if (key % 2 == 0) {
+                ASSERT_FALSE(found.isEvicted());
+                ASSERT_EQ(key, ValuePeeker::peekAsInteger(found.getNValue(0)));
+                ASSERT_EQ(0, found.getNValue(1).compare(ValueFactory::getStringValue(payloadFor(key))));
+            } else {
+                ASSERT_TRUE(found.isEvicted());
+                ASSERT_TRUE(found.isActive());
+                const EvictedTupleTombstone *tombstone =
+                    reinterpret_cast<const EvictedTupleTombstone*>(found.address());
+                std::vector<char> block;
+                m_antiCacheDB->readBlock(tombstone->m_blockId, block);
+                ASSERT_FALSE(block.empty());
+            }
+        }
+    }
+
+    // evicting more picks up the hot tuples once the cold ones are gone
+    ASSERT_EQ(10, m_table->evictColdTuples(m_antiCacheDB, 10));
+    ASSERT_EQ(tupleCount / 2 + 10, m_table->evictedTupleCount());
+}
+
+TEST_F(AntiCacheTest, UnevictRestoresTuplesAndIndexes) {
+    const int tupleCount = 1000;
+    insertTuples(tupleCount);
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        tuple.setCSI(ValuePeeker::peekAsInteger(tuple.getNValue(0)) % 3 == 0 ? 7 : 3);
+    }
+    const int64_t stringMemory = m_table->nonInlinedMemorySize();
+
+    ASSERT_EQ(600, m_table->evictColdTuples(m_antiCacheDB, 600));
+    TableIndex *pkeyIndex = m_table->primaryKeyIndex();
+    TableTuple tombstone = lookup(pkeyIndex, 1);
+    ASSERT_TRUE(tombstone.isEvicted());
+
+    // bring back only the block the tuple lives in
+    const int32_t blockId = reinterpret_cast<const EvictedTupleTombstone*>(tombstone.address())->m_blockId;
+    std::vector<char> block;
+    m_antiCacheDB->readBlock(blockId, block);
+    const size_t blocksBefore = m_table->evictedBlockCount();
+    m_table->unevictBlock(blockId, block);
+    ASSERT_EQ(blocksBefore - 1, m_table->evictedBlockCount());
+    TableTuple reloaded = lookup(pkeyIndex, 1);
+    ASSERT_FALSE(reloaded.isEvicted());
+    ASSERT_EQ(1, ValuePeeker::peekAsInteger(reloaded.getNValue(0)));
+    ASSERT_EQ(3, reloaded.getCSI());
+
+    // and then everything else
+    m_table->unevictAll();
+    ASSERT_EQ(0, m_table->evictedTupleCount());
+    ASSERT_EQ(0, m_table->evictedBlockCount());
+    ASSERT_EQ(0, m_antiCacheDB->blockCount());
+    ASSERT_EQ(tupleCount, m_table->activeTupleCount());
+    ASSERT_EQ(stringMemory, m_table->nonInlinedMemorySize());
+    BOOST_FOREACH(TableIndex *index, m_table->allIndexes()) {
+        ASSERT_EQ(tupleCount, index->getSize());
+        for (int key = 0; key < tupleCount; key++) {
+            TableTuple found = lookup(index, key);
+            ASSERT_FALSE(found.isNullTuple());
+            ASSERT_FALSE(found.isEvicted());
+            ASSERT_EQ(key, ValuePeeker::peekAsInteger(found.getNValue(0)));
+            ASSERT_EQ(0, found.getNValue(1).compare(ValueFactory::getStringValue(payloadFor(key))));
+            ASSERT_EQ(key % 3 == 0 ? 7 : 3, found.getCSI());
+        }
+    }
+}
+
+TEST_F(AntiCacheTest, EvictedTupleIteratorReadsWithoutFetching) {
+    const int tupleCount = 200;
+    insertTuples(tupleCount);
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        tuple.setCSI(ValuePeeker::peekAsInteger(tuple.getNValue(0)) % 3 == 0 ? 7 : 3);
+    }
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+    const size_t blockCount = m_antiCacheDB->blockCount();
+
+    std::set<int> keys;
+    EvictedTupleIterator evicted(m_table);
+    while (evicted.next(tuple)) {
+        const int key = ValuePeeker::peekAsInteger(tuple.getNValue(0));
+        ASSERT_TRUE(keys.insert(key).second);
+        ASSERT_EQ(0, tuple.getNValue(1).compare(ValueFactory::getStringValue(payloadFor(key))));
+        ASSERT_EQ(key % 3 == 0 ? 7 : 3, tuple.getCSI());
+        // the index entry for the key is the tombstone the iterator names
+        TableTuple found = lookup(m_table->primaryKeyIndex(), key);
+        ASSERT_TRUE(found.isEvicted());
+        ASSERT_EQ(found.address(), reinterpret_cast<char*>(evicted.tombstone()));
+    }
+    ASSERT_EQ(100, keys.size());
+    ASSERT_EQ(100, m_table->evictedTupleCount());
+    ASSERT_EQ(tupleCount - 100, m_table->activeTupleCount());
+    ASSERT_EQ(blockCount, m_antiCacheDB->blockCount());
+}
+
+TEST_F(AntiCacheTest, DeleteAllTuplesIncludesEvicted) {
+    insertTuples(200);
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+    m_table->deleteAllTuples(true);
+    ASSERT_EQ(0, m_table->activeTupleCount());
+    ASSERT_EQ(0, m_table->evictedTupleCount());
+    ASSERT_EQ(0, m_table->evictedBlockCount());
+    ASSERT_EQ(0, m_table->evictedByteCount());
+    ASSERT_EQ(0, m_antiCacheDB->blockCount());
+    BOOST_FOREACH(TableIndex *index, m_table->allIndexes()) {
+        ASSERT_EQ(0, index->getSize());
+    }
+}
+
+TEST_F(AntiCacheTest, UndoDeleteAllTuplesRestoresEvicted) {
+    const int tupleCount = 200;
+    insertTuples(tupleCount);
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+    const int64_t evictedBytes = m_table->evictedByteCount();
+    const size_t blockCount = m_antiCacheDB->blockCount();
+
+    m_engine->setUndoToken(1);
+    m_table->deleteAllTuples(true);
+    ASSERT_EQ(0, m_table->evictedTupleCount());
+    ASSERT_EQ(0, m_table->evictedBlockCount());
+    // the blocks are kept until the delete is released
+    ASSERT_EQ(blockCount, m_antiCacheDB->blockCount());
+
+    m_engine->undoUndoToken(1);
+    ASSERT_EQ(tupleCount - 100, m_table->activeTupleCount());
+    ASSERT_EQ(100, m_table->evictedTupleCount());
+    ASSERT_EQ(evictedBytes, m_table->evictedByteCount());
+    BOOST_FOREACH(TableIndex *index, m_table->allIndexes()) {
+        ASSERT_EQ(tupleCount, index->getSize());
+    }
+    int evictedKeys = 0;
+    for (int key = 0; key < tupleCount; key++) {
+        if (lookup(m_table->primaryKeyIndex(), key).isEvicted()) {
+            ++evictedKeys;
+        }
+    }
+    ASSERT_EQ(100, evictedKeys);
+
+    // the tombstones still lead back to the tuples
+    m_table->unevictAll();
+    ASSERT_EQ(tupleCount, m_table->activeTupleCount());
+    for (int key = 0; key < tupleCount; key++) {
+        TableTuple found = lookup(m_table->primaryKeyIndex(), key);
+        ASSERT_EQ(0, found.getNValue(1).compare(ValueFactory::getStringValue(payloadFor(key))));
+    }
+
+    // and a released delete frees the blocks
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+    m_engine->setUndoToken(2);
+    m_table->deleteAllTuples(true);
+    m_engine->releaseUndoToken(2);
+    ASSERT_EQ(0, m_antiCacheDB->blockCount());
+    BOOST_FOREACH(TableIndex *index, m_table->allIndexes()) {
+        ASSERT_EQ(0, index->getSize());
+    }
+}
+
+TEST_F(AntiCacheTest, AddedIndexCoversEvictedTuples) {
+    const int tupleCount = 200;
+    insertTuples(tupleCount);
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+
+    std::vector<int> keyColumns(1, 0);
+    TableIndex *added = TableIndexFactory::getInstance(
+        TableIndexScheme("AddedIndex", BALANCED_TREE_INDEX, keyColumns,
+                         TableIndex::simplyIndexColumns(), true, false, m_table->schema()));
+    m_table->addIndex(added);
+    // the evicted tuples are read from the anti-cache, not fetched back
+    ASSERT_EQ(100, m_table->evictedTupleCount());
+    ASSERT_EQ(tupleCount, added->getSize());
+    for (int key = 0; key < tupleCount; key++) {
+        TableTuple found = lookup(added, key);
+        ASSERT_FALSE(found.isNullTuple());
+        TableTuple expected = lookup(m_table->primaryKeyIndex(), key);
+        ASSERT_EQ(expected.address(), found.address());
+        if ( ! found.isEvicted()) {
+            ASSERT_EQ(key, ValuePeeker::peekAsInteger(found.getNValue(0)));
+        }
+    }
+
+    // fetching back swaps the new index's tombstones too
+    m_table->unevictAll();
+    for (int key = 0; key < tupleCount; key++) {
+        TableTuple found = lookup(added, key);
+        ASSERT_FALSE(found.isEvicted());
+        ASSERT_EQ(key, ValuePeeker::peekAsInteger(found.getNValue(0)));
+    }
+
+    // and the table can evict and fetch back through it
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+    m_table->unevictAll();
+    ASSERT_EQ(tupleCount, m_table->activeTupleCount());
+}
+
+TEST_F(AntiCacheTest, HashCodeCoversEvictedTuples) {
+    insertTuples(200);
+    const size_t hashCode = m_table->hashCode();
+    ASSERT_NE(0, hashCode);
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+    ASSERT_EQ(hashCode, m_table->hashCode());
+    ASSERT_EQ(100, m_table->evictedTupleCount());
+}
+
+// Read a snapshot, fetching back some evicted tuples before its evicted
+// scan starts and deleting the rest part way through it. Every tuple is
+// in it exactly once.
+TEST_F(AntiCacheTest, SnapshotIncludesEvictedTuples) {
+    const int tupleCount = 1000;
+    insertTuples(tupleCount);
+    ASSERT_EQ(600, m_table->evictColdTuples(m_antiCacheDB, 600));
+    const int32_t blockId = reinterpret_cast<const EvictedTupleTombstone*>(
+        lookup(m_table->primaryKeyIndex(), 1).address())->m_blockId;
+
+    DefaultTupleSerializer serializer;
+    ASSERT_FALSE(m_table->activateCopyOnWrite(&serializer, 0));
+
+    std::multiset<int> keys;
+    char serializationBuffer[8192];
+    int batches = 0;
+    while (true) {
+        ReferenceSerializeOutput out(serializationBuffer, sizeof(serializationBuffer));
+        m_table->serializeMore(&out);
+        if (out.position() == 0) {
+            break;
+        }
+        ReferenceSerializeInput in(serializationBuffer, out.position());
+        in.readInt(); // partition id
+        const int32_t rowCount = in.readInt();
+        for (int32_t ii = 0; ii < rowCount; ii++) {
+            const int32_t length = in.readInt();
+            keys.insert(in.readInt());
+            in.getRawPointer(length - sizeof(int32_t));
+        }
+
+        if (++batches == 1) {
+            std::vector<char> block;
+            m_antiCacheDB->readBlock(blockId, block);
+            m_table->unevictBlock(blockId, block);
+            // an undone delete leaves the snapshot as it was
+            m_engine->setUndoToken(1);
+            m_table->deleteAllTuples(true);
+            m_engine->undoUndoToken(1);
+        } else if (m_table->evictedTupleCount() != 0 && static_cast<int>(keys.size()) > 600) {
+            m_engine->setUndoToken(2);
+            m_table->deleteAllTuples(true);
+            m_engine->releaseUndoToken(2);
+        }
+    }
+    ASSERT_EQ(0, m_table->evictedTupleCount());
+    ASSERT_EQ(tupleCount, keys.size());
+    for (int key = 0; key < tupleCount; key++) {
+        ASSERT_EQ(1, keys.count(key));
+    }
+}
+
+TEST_F(AntiCacheTest, NoEvictionWithIndexOverOutOfLineColumn) {
+    const int tupleCount = 200;
+    insertTuples(tupleCount);
+
+    // The keys of an index over PAYLOAD point at the tuples' strings
+    std::vector<int> keyColumns(1, 1);
+    TableIndex *treeIndex = TableIndexFactory::getInstance(
+        TableIndexScheme("PayloadTreeIndex", BALANCED_TREE_INDEX, keyColumns,
+                         TableIndex::simplyIndexColumns(), false, true, m_table->schema()));
+    TableIndex *hashIndex = TableIndexFactory::getInstance(
+        TableIndexScheme("PayloadHashIndex", HASH_TABLE_INDEX, keyColumns,
+                         TableIndex::simplyIndexColumns(), true, false, m_table->schema()));
+    m_table->addIndex(treeIndex);
+    m_table->addIndex(hashIndex);
+    ASSERT_FALSE(m_table->canEvict());
+    ASSERT_EQ(0, m_table->evictColdTuples(m_antiCacheDB, 100));
+    ASSERT_EQ(0, m_table->evictColdBlocks(m_antiCacheDB, 100));
+    ASSERT_EQ(tupleCount, m_table->activeTupleCount());
+    ASSERT_EQ(0, m_table->evictedTupleCount());
+
+    // every key still compares against live strings
+    BOOST_FOREACH(TableIndex *index, m_table->allIndexes()) {
+        if (index != treeIndex && index != hashIndex) {
+            continue;
+        }
+        ASSERT_EQ(tupleCount, index->getSize());
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        for (int key = 0; key < tupleCount; key++) {
+            NValue payload = ValueFactory::getStringValue(payloadFor(key));
+            searchKey.setNValue(0, payload);
+            index->moveToKey(&searchKey);
+            TableTuple found = index->nextValueAtKey();
+            payload.free();
+            ASSERT_FALSE(found.isNullTuple());
+            ASSERT_EQ(key, ValuePeeker::peekAsInteger(found.getNValue(0)));
+        }
+    }
+
+    // without them the table evicts again
+    m_table->removeIndex(treeIndex);
+    m_table->removeIndex(hashIndex);
+    ASSERT_TRUE(m_table->canEvict());
+    ASSERT_EQ(100, m_table->evictColdTuples(m_antiCacheDB, 100));
+}
+
+TEST_F(AntiCacheTest, NoEvictionWhileUndoPinsTuples) {
+    insertTuples(100);
+    m_engine->setUndoToken(1);
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    ASSERT_TRUE(iterator.next(tuple));
+    m_table->deleteTuple(tuple, true);
+    ASSERT_FALSE(m_table->canEvict());
+    ASSERT_EQ(0, m_table->evictColdTuples(m_antiCacheDB, 50));
+
+    m_engine->releaseUndoToken(1);
+    ASSERT_TRUE(m_table->canEvict());
+    ASSERT_EQ(50, m_table->evictColdTuples(m_antiCacheDB, 50));
+    ASSERT_EQ(49, m_table->activeTupleCount());
+}
+
+TEST_F(AntiCacheTest, BlockPolicyEvictsWholeUnreferencedBlocks) {
+    insertTuples(100);
+
+    // A new block is referenced, so the first pass of the hand only ages it
+    ASSERT_EQ(0, m_table->evictColdBlocks(m_antiCacheDB, 10));
+
+    // A sampled access keeps the block in memory until its counter decays
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    ASSERT_TRUE(iterator.next(tuple));
+    m_table->recordBlockAccess(tuple);
+    ASSERT_EQ(0, m_table->evictColdBlocks(m_antiCacheDB, 10));
+    ASSERT_EQ(100, m_table->activeTupleCount());
+
+    // Cold now: every tuple of the block goes, not just the 10 asked for
+    ASSERT_EQ(100, m_table->evictColdBlocks(m_antiCacheDB, 10));
+    ASSERT_EQ(0, m_table->activeTupleCount());
+    ASSERT_EQ(100, m_table->evictedTupleCount());
+    ASSERT_EQ(0, m_table->allocatedBlockCount());
+
+    TableTuple found = lookup(m_table->primaryKeyIndex(), 42);
+    ASSERT_TRUE(found.isEvicted());
+
+    // the hand went around twice, which is not an aging pass
+    TableTuple *row = m_table->getColdStorageStats()->getStatsTuple(true, 0);
+    ASSERT_EQ(2, statValue(row, "EVICTION_REVOLUTIONS"));
+    ASSERT_EQ(0, statValue(row, "AGING_PASSES"));
+}
+
+TEST_F(AntiCacheTest, ColdStorageStatsReportEvictionAndFetch) {
+    insertTuples(100);
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        tuple.setCSI(ValuePeeker::peekAsInteger(tuple.getNValue(0)) < 50 ? 3 : 20);
+    }
+    ASSERT_EQ(50, m_table->evictColdTuples(m_antiCacheDB, 50));
+
+    ColdStorageStats *stats = m_table->getColdStorageStats();
+    TableTuple *row = stats->getStatsTuple(true, 0);
+    ASSERT_EQ(50, statValue(row, "EVICTED_TUPLES"));
+    ASSERT_TRUE(statValue(row, "EVICTED_BYTES") > 0);
+    ASSERT_EQ(50, statValue(row, "TUPLES_EVICTED"));
+    ASSERT_EQ(0, statValue(row, "CSI_0_15"));
+    ASSERT_EQ(50, statValue(row, "CSI_16_31"));
+
+    m_table->unevictAll();
+    row = stats->getStatsTuple(true, 0);
+    ASSERT_EQ(0, statValue(row, "EVICTED_TUPLES"));
+    ASSERT_EQ(0, statValue(row, "EVICTED_BYTES"));
+    // interval counters start over
+    ASSERT_EQ(0, statValue(row, "TUPLES_EVICTED"));
+    ASSERT_EQ(50, statValue(row, "TUPLES_FETCHED"));
+    ASSERT_EQ(1, statValue(row, "FETCHES"));
+    ASSERT_EQ(50, statValue(row, "CSI_0_15"));
+}
+
+TEST_F(AntiCacheTest, AccessCounterSaturates) {
+    insertTuples(1);
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    ASSERT_TRUE(iterator.next(tuple));
+
+    tuple.setCSI(TUPLE_CSI_MAX - 1);
+    ASSERT_FALSE(tuple.incrementCSI());
+    ASSERT_EQ(TUPLE_CSI_MAX, tuple.getCSI());
+    // Further accesses keep asking for aging without wrapping the counter
+    ASSERT_TRUE(tuple.incrementCSI());
+    ASSERT_TRUE(tuple.incrementCSI());
+    ASSERT_EQ(TUPLE_CSI_MAX, tuple.getCSI());
+}
+
+TEST_F(AntiCacheTest, AgingAdvancesABoundedNumberOfBlocks) {
+    insertTuples(100);
+    TableTuple tuple(m_table->schema());
+    TableIterator setter = m_table->iterator();
+    while (setter.next(tuple)) {
+        tuple.setCSI(ValuePeeker::peekAsInteger(tuple.getNValue(0)) == 0 ? TUPLE_CSI_MAX : 50);
+    }
+    const int64_t farAway = ColdStorageStats::nowMicros() + 60 * 1000 * 1000;
+
+    // Nothing to do until aging is requested
+    ASSERT_FALSE(m_table->coldStorageAgingPending());
+    ASSERT_EQ(0, m_table->ageColdStorageBlocks(20, 100, 1, farAway));
+
+    m_table->requestColdStorageAging();
+    ASSERT_TRUE(m_table->coldStorageAgingPending());
+    ASSERT_EQ(1, m_table->ageColdStorageBlocks(20, 100, 1, farAway));
+
+    // A request in the middle of a revolution queues another one
+    m_table->requestColdStorageAging();
+    ASSERT_EQ(1, m_table->ageColdStorageBlocks(20, 100, 1, farAway));
+    ASSERT_TRUE(m_table->coldStorageAgingPending());
+    ASSERT_EQ(0, m_table->ageColdStorageBlocks(20, 100, 1, farAway));
+    ASSERT_FALSE(m_table->coldStorageAgingPending());
+
+    // A deadline that already passed still lets one block through, but
+    // the pass stops there instead of running on to its end
+    m_table->requestColdStorageAging();
+    ASSERT_EQ(1, m_table->ageColdStorageBlocks(0, 80, 5, 0));
+    ASSERT_TRUE(m_table->coldStorageAgingPending());
+    ASSERT_EQ(0, m_table->ageColdStorageBlocks(0, 80, 5, farAway));
+    ASSERT_FALSE(m_table->coldStorageAgingPending());
+
+    TableIterator checker = m_table->iterator();
+    while (checker.next(tuple)) {
+        if (ValuePeeker::peekAsInteger(tuple.getNValue(0)) == 0) {
+            // clamped on the first revolution, cut on the second
+            ASSERT_EQ(80, tuple.getCSI());
+        } else {
+            ASSERT_EQ(10, tuple.getCSI());
+        }
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
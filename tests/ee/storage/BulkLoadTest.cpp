@@ -0,0 +1,240 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/SQLException.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/serializeio.h"
+#include "execution/VoltDBEngine.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+#include <boost/foreach.hpp>
+
+using namespace voltdb;
+
+class BulkLoadTest : public Test {
+public:
+    BulkLoadTest() {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+        m_source = createTable();
+        m_loaded = createTable();
+    }
+
+    ~BulkLoadTest() {
+        delete m_source;
+        delete m_loaded;
+        delete m_engine;
+    }
+
+    static PersistentTable *createTable(bool indexed = true) {
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("GRP");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+
+        std::vector<int> idColumn(1, 0);
+        std::vector<int> groupColumn(1, 1);
+        TableIndexScheme pkeyScheme("TreeUniqueIndex", BALANCED_TREE_INDEX, idColumn,
+                                    TableIndex::simplyIndexColumns(), true, true, schema);
+        std::vector<TableIndexScheme> schemes;
+        schemes.push_back(TableIndexScheme("TreeMultimapIndex", BALANCED_TREE_INDEX, groupColumn,
+                                           TableIndex::simplyIndexColumns(), false, true, schema));
+        schemes.push_back(TableIndexScheme("HashUniqueIndex", HASH_TABLE_INDEX, idColumn,
+                                           TableIndex::simplyIndexColumns(), true, false, schema));
+        schemes.push_back(TableIndexScheme("HashMultimapIndex", HASH_TABLE_INDEX, groupColumn,
+                                           TableIndex::simplyIndexColumns(), false, false, schema));
+
+        PersistentTable *table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", schema, columnNames, 0));
+        if (!indexed) {
+            return table;
+        }
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(pkeyScheme);
+        table->addIndex(pkeyIndex);
+        table->setPrimaryKeyIndex(pkeyIndex);
+        BOOST_FOREACH(TableIndexScheme &scheme, schemes) {
+            table->addIndex(TableIndexFactory::getInstance(scheme));
+        }
+        return table;
+    }
+
+    // ids in a scrambled order, so the loaded keys don't arrive sorted
+    static int idAt(int ii, int count) {
+        return static_cast<int>((static_cast<int64_t>(ii) * 7919) % count);
+    }
+
+    void insertTuples(PersistentTable *table, int count) {
+        TableTuple &tuple = table->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            const int id = idAt(ii, count);
+            tuple.setNValue(0, ValueFactory::getIntegerValue(id));
+            tuple.setNValue(1, ValueFactory::getIntegerValue(id % 100));
+            table->insertTuple(tuple);
+        }
+    }
+
+    static void load(PersistentTable *source, PersistentTable *destination) {
+        CopySerializeOutput serialized;
+        source->serializeTo(serialized);
+        ReferenceSerializeInput serializedIn(serialized.data() + sizeof(int32_t),
+                                             serialized.size() - sizeof(int32_t));
+        destination->loadTuplesFrom(serializedIn);
+    }
+
+    static TableTuple lookup(TableIndex *index, int key) {
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, ValueFactory::getIntegerValue(key));
+        index->moveToKey(&searchKey);
+        return index->nextValueAtKey();
+    }
+
+    static int countAtKey(TableIndex *index, int key) {
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, ValueFactory::getIntegerValue(key));
+        index->moveToKey(&searchKey);
+        int count = 0;
+        while (!index->nextValueAtKey().isNullTuple()) {
+            count++;
+        }
+        return count;
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_source;
+    PersistentTable *m_loaded;
+};
+
+TEST_F(BulkLoadTest, EmptyTableIsIndexedInOneGo) {
+    const int tupleCount = 30000;
+    insertTuples(m_source, tupleCount);
+    load(m_source, m_loaded);
+
+    ASSERT_EQ(tupleCount, m_loaded->activeTupleCount());
+    std::vector<TableIndex*> indexes = m_loaded->allIndexes();
+    BOOST_FOREACH(TableIndex *index, indexes) {
+        ASSERT_EQ(tupleCount, index->getSize());
+    }
+    TableIndex *pkey = m_loaded->primaryKeyIndex();
+    for (int id = 0; id < tupleCount; id += 7) {
+        TableTuple found = lookup(pkey, id);
+        ASSERT_FALSE(found.isNullTuple());
+        ASSERT_EQ(id, ValuePeeker::peekAsInteger(found.getNValue(0)));
+        ASSERT_EQ(found.address(), lookup(indexes[2], id).address());
+    }
+    for (int group = 0; group < 100; group += 9) {
+        ASSERT_EQ(tupleCount / 100, countAtKey(indexes[1], group));
+        ASSERT_EQ(tupleCount / 100, countAtKey(indexes[3], group));
+    }
+
+    // and it goes on like any other table
+    TableTuple doomed = lookup(pkey, 5);
+    m_loaded->deleteTuple(doomed, true);
+    TableTuple &tuple = m_loaded->tempTuple();
+    tuple.setNValue(0, ValueFactory::getIntegerValue(tupleCount));
+    tuple.setNValue(1, ValueFactory::getIntegerValue(5));
+    m_loaded->insertTuple(tuple);
+    ASSERT_TRUE(lookup(pkey, 5).isNullTuple());
+    ASSERT_FALSE(lookup(pkey, tupleCount).isNullTuple());
+    ASSERT_EQ(tupleCount / 100, countAtKey(indexes[1], 5));
+}
+
+TEST_F(BulkLoadTest, LoadIntoNonEmptyTableIndexesEachTuple) {
+    insertTuples(m_source, 1000);
+    TableTuple &tuple = m_loaded->tempTuple();
+    tuple.setNValue(0, ValueFactory::getIntegerValue(5000));
+    tuple.setNValue(1, ValueFactory::getIntegerValue(0));
+    m_loaded->insertTuple(tuple);
+
+    load(m_source, m_loaded);
+    ASSERT_EQ(1001, m_loaded->activeTupleCount());
+    BOOST_FOREACH(TableIndex *index, m_loaded->allIndexes()) {
+        ASSERT_EQ(1001, index->getSize());
+    }
+    ASSERT_EQ(11, countAtKey(m_loaded->allIndexes()[1], 0));
+}
+
+TEST_F(BulkLoadTest, DuplicateKeysFailTheLoad) {
+    PersistentTable *unindexed = createTable(false);
+    insertTuples(unindexed, 1000);
+    TableTuple &tuple = unindexed->tempTuple();
+    tuple.setNValue(0, ValueFactory::getIntegerValue(500));
+    tuple.setNValue(1, ValueFactory::getIntegerValue(0));
+    unindexed->insertTuple(tuple);
+
+    bool failed = false;
+    try {
+        load(unindexed, m_loaded);
+    } catch (const SQLException &e) {
+        failed = true;
+    }
+    delete unindexed;
+    ASSERT_TRUE(failed);
+
+    // nothing of the failed load is left behind
+    ASSERT_EQ(0, m_loaded->activeTupleCount());
+    ASSERT_EQ(0, m_loaded->allocatedTupleCount());
+    BOOST_FOREACH(TableIndex *index, m_loaded->allIndexes()) {
+        ASSERT_EQ(0, index->getSize());
+    }
+
+    // and the next load starts from an empty table
+    insertTuples(m_source, 1000);
+    load(m_source, m_loaded);
+    ASSERT_EQ(1000, m_loaded->activeTupleCount());
+    BOOST_FOREACH(TableIndex *index, m_loaded->allIndexes()) {
+        ASSERT_EQ(1000, index->getSize());
+    }
+    ASSERT_FALSE(lookup(m_loaded->primaryKeyIndex(), 500).isNullTuple());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -115,6 +115,11 @@ public:
         delete m_table;
     }
 
+    // Tuples in one 2MB block (TABLE_BLOCKSIZE in persistenttable.cpp)
+    int tuplesPerBlock() const {
+        return (2097152 - TUPLE_BLOCK_HEADER_SIZE) / (m_tableSchema->tupleLength() + TUPLE_HEADER_SIZE);
+    }
+
     void initTable(bool allowInlineStrings) {
         m_tableSchema = voltdb::TupleSchema::createTupleSchema(m_tableSchemaTypes,
                                                                m_tableSchemaColumnSizes,
@@ -276,7 +281,7 @@ TEST_F(CompactionTest, BasicCompaction) {
 #ifdef MEMCHECK
     int tupleCount = 1000;
 #else
-    int tupleCount = 645260;
+    int tupleCount = tuplesPerBlock() * 20;
 #endif
     addRandomUniqueTuples( m_table, tupleCount);
 
@@ -362,7 +367,7 @@ TEST_F(CompactionTest, CompactionWithCopyOnWrite) {
 #ifdef MEMCHECK
     int tupleCount = 1000;
 #else
-    int tupleCount = 645260;
+    int tupleCount = tuplesPerBlock() * 20;
 #endif
     addRandomUniqueTuples( m_table, tupleCount);
 
@@ -504,14 +509,14 @@ TEST_F(CompactionTest, CompactionWithCopyOnWrite) {
 #ifndef MEMCHECK
 TEST_F(CompactionTest, TestENG897) {
     initTable(true);
-    addRandomUniqueTuples( m_table, 32263 * 5);
+    addRandomUniqueTuples( m_table, tuplesPerBlock() * 5);
 
     //Delete stuff to put everything in a bucket
     voltdb::TableIndex *pkeyIndex = m_table->primaryKeyIndex();
     TableTuple key(pkeyIndex->getKeySchema());
     boost::scoped_array<char> backingStore(new char[pkeyIndex->getKeySchema()->tupleLength()]);
     key.moveNoHeader(backingStore.get());
-    for (int ii = 0; ii < 32263 * 5; ii++) {
+    for (int ii = 0; ii < tuplesPerBlock() * 5; ii++) {
         if (ii % 2 == 0) {
             key.setNValue(0, ValueFactory::getIntegerValue(ii));
             ASSERT_TRUE(pkeyIndex->moveToKey(&key));
@@ -527,7 +532,7 @@ TEST_F(CompactionTest, TestENG897) {
     DefaultTupleSerializer serializer;
 
     m_table->activateCopyOnWrite(&serializer, 0);
-    for (int ii = 0; ii < 16130; ii++) {
+    for (int ii = 0; ii < tuplesPerBlock() / 2; ii++) {
         if (ii % 2 == 0) {
             continue;
         }
@@ -552,7 +557,7 @@ TEST_F(CompactionTest, TestENG897) {
 
     //std::cout << "Finished snapshot serialization" << std::endl;
 
-    for (int ii = 16130; ii < 32261; ii++) {
+    for (int ii = tuplesPerBlock() / 2; ii < tuplesPerBlock() - 2; ii++) {
         if (ii % 2 == 0) {
             continue;
         }
@@ -571,6 +576,109 @@ TEST_F(CompactionTest, TestENG897) {
     //m_table->printBucketInfo();
 }
 #endif
+
+/*
+ * Deleted slots are tracked in a per-block bitmap. Inserts fill the lowest
+ * hole first, whatever order the holes were made in, and scans skip the
+ * remaining holes.
+ */
+#ifndef MEMCHECK
+TEST_F(CompactionTest, FreeSlotsReusedInAddressOrder) {
+    initTable(true);
+    addRandomUniqueTuples( m_table, 1000);
+
+    voltdb::TableIndex *pkeyIndex = m_table->primaryKeyIndex();
+    TableTuple key(pkeyIndex->getKeySchema());
+    boost::scoped_array<char> backingStore(new char[pkeyIndex->getKeySchema()->tupleLength()]);
+    key.moveNoHeader(backingStore.get());
+    key.setNValue(0, ValueFactory::getIntegerValue(0));
+    ASSERT_TRUE(pkeyIndex->moveToKey(&key));
+    char *base = pkeyIndex->nextValueAtKey().address();
+    const int tupleLength = m_tableSchema->tupleLength() + TUPLE_HEADER_SIZE;
+
+    const int deleted[] = { 700, 100, 400, 130, 131 };
+    for (int ii = 0; ii < 5; ii++) {
+        key.setNValue(0, ValueFactory::getIntegerValue(deleted[ii]));
+        ASSERT_TRUE(pkeyIndex->moveToKey(&key));
+        TableTuple tuple = pkeyIndex->nextValueAtKey();
+        m_table->deleteTuple(tuple, true);
+    }
+
+    // The remaining tuples are all found, in address order
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    char *last = NULL;
+    int found = 0;
+    while (iterator.next(tuple)) {
+        ASSERT_TRUE(tuple.address() > last);
+        last = tuple.address();
+        found++;
+    }
+    ASSERT_EQ(995, found);
+
+    addRandomUniqueTuples( m_table, 6);
+    const int expectedSlots[] = { 100, 130, 131, 400, 700, 1000 };
+    for (int ii = 0; ii < 6; ii++) {
+        key.setNValue(0, ValueFactory::getIntegerValue(1000 + ii));
+        ASSERT_TRUE(pkeyIndex->moveToKey(&key));
+        ASSERT_TRUE(pkeyIndex->nextValueAtKey().address() == base + expectedSlots[ii] * tupleLength);
+    }
+}
+#endif
+
+/*
+ * Compaction done a bounded number of steps at a time ends up in the same
+ * place as a forced compaction, with the indexes following the moved tuples.
+ */
+#ifndef MEMCHECK
+TEST_F(CompactionTest, IncrementalCompaction) {
+    initTable(true);
+    int tupleCount = tuplesPerBlock() * 20;
+    addRandomUniqueTuples( m_table, tupleCount);
+
+    voltdb::TableIndex *pkeyIndex = m_table->primaryKeyIndex();
+    TableTuple key(pkeyIndex->getKeySchema());
+    boost::scoped_array<char> backingStore(new char[pkeyIndex->getKeySchema()->tupleLength()]);
+    key.moveNoHeader(backingStore.get());
+    for (int ii = 0; ii < tupleCount; ii += 2) {
+        key.setNValue(0, ValueFactory::getIntegerValue(ii));
+        ASSERT_TRUE(pkeyIndex->moveToKey(&key));
+        TableTuple tuple = pkeyIndex->nextValueAtKey();
+        m_table->deleteTuple(tuple, true);
+    }
+    ASSERT_EQ(20, m_table->m_data.size());
+
+    const int64_t farAway = ColdStorageStats::nowMicros() + 60 * 1000 * 1000;
+    // A deadline that already passed still lets one step through
+    ASSERT_EQ(1, m_table->doIncrementalCompaction(5, 0));
+    ASSERT_EQ(2, m_table->doIncrementalCompaction(2, farAway));
+    ASSERT_TRUE(m_table->m_data.size() > 13);
+    ASSERT_TRUE(m_table->compactedBlockCount() > 0);
+    ASSERT_TRUE(m_table->compactedTupleCount() > 0);
+
+    while (m_table->doIncrementalCompaction(1, farAway) > 0) {
+    }
+    ASSERT_EQ(13, m_table->m_data.size());
+    ASSERT_EQ(0, m_table->forcedCompactionCount());
+    ASSERT_EQ(0, m_table->doIncrementalCompaction(1, farAway));
+
+    int found = 0;
+    TableIterator& iter = m_table->iterator();
+    TableTuple tuple(m_table->schema());
+    while (iter.next(tuple)) {
+        int32_t pkey = ValuePeeker::peekAsInteger(tuple.getNValue(0));
+        ASSERT_EQ(1, pkey % 2);
+        key.setNValue(0, ValueFactory::getIntegerValue(pkey));
+        for (int ii = 0; ii < 4; ii++) {
+            ASSERT_TRUE(m_table->m_indexes[ii]->moveToKey(&key));
+            ASSERT_EQ(m_table->m_indexes[ii]->nextValueAtKey().address(), tuple.address());
+        }
+        found++;
+    }
+    ASSERT_EQ(tupleCount / 2, found);
+}
+#endif
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
@@ -145,7 +145,7 @@ public:
 
     void addRandomUniqueTuples(Table *table, int numTuples) {
         TableTuple tuple = table->tempTuple();
-        ::memset(tuple.address() + 1, 0, tuple.tupleLength() - 1);
+        ::memset(tuple.address() + TUPLE_HEADER_SIZE, 0, tuple.tupleLength() - TUPLE_HEADER_SIZE);
         for (int ii = 0; ii < numTuples; ii++) {
             tuple.setNValue(0, ValueFactory::getIntegerValue(m_primaryKeyIndex++));
             tuple.setNValue(1, ValueFactory::getIntegerValue(rand()));
@@ -323,7 +323,7 @@ TEST_F(CopyOnWriteTest, BigTest) {
         TableTuple tuple(m_table->schema());
         while (iterator.next(tuple)) {
             const std::pair<stx::btree_set<int64_t>::iterator, bool> p =
-                    originalTuples.insert(*reinterpret_cast<int64_t*>(tuple.address() + 1));
+                    originalTuples.insert(*reinterpret_cast<int64_t*>(tuple.address() + TUPLE_HEADER_SIZE));
             const bool inserted = p.second;
             if (!inserted) {
                     int32_t primaryKey = ValuePeeker::peekAsInteger(tuple.getNValue(0));
@@ -413,7 +413,7 @@ TEST_F(CopyOnWriteTest, BigTestWithUndo) {
         TableTuple tuple(m_table->schema());
         while (iterator.next(tuple)) {
             const std::pair<stx::btree_set<int64_t>::iterator, bool> p =
-                    originalTuples.insert(*reinterpret_cast<int64_t*>(tuple.address() + 1));
+                    originalTuples.insert(*reinterpret_cast<int64_t*>(tuple.address() + TUPLE_HEADER_SIZE));
             const bool inserted = p.second;
             if (!inserted) {
                     int32_t primaryKey = ValuePeeker::peekAsInteger(tuple.getNValue(0));
@@ -507,7 +507,7 @@ TEST_F(CopyOnWriteTest, BigTestUndoEverything) {
         TableTuple tuple(m_table->schema());
         while (iterator.next(tuple)) {
             const std::pair<stx::btree_set<int64_t>::iterator, bool> p =
-                    originalTuples.insert(*reinterpret_cast<int64_t*>(tuple.address() + 1));
+                    originalTuples.insert(*reinterpret_cast<int64_t*>(tuple.address() + TUPLE_HEADER_SIZE));
             const bool inserted = p.second;
             if (!inserted) {
                     int32_t primaryKey = ValuePeeker::peekAsInteger(tuple.getNValue(0));
@@ -0,0 +1,273 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/SerializableEEException.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "expressions/expressions.h"
+#include "expressions/expressionutil.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/MinipageLayout.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+
+using namespace voltdb;
+
+class MinipageTest : public Test {
+public:
+    MinipageTest() : m_undoToken(0) {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("V");
+        columnTypes.push_back(voltdb::VALUE_TYPE_BIGINT);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_BIGINT));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("FILLER");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(60);
+        columnAllowNull.push_back(true);
+        columnNames.push_back("NOTES");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(300);
+        columnAllowNull.push_back(true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+
+        std::vector<int> keyColumns(1, 0);
+        TableIndexScheme pkeyScheme("TreeUniqueIndex", BALANCED_TREE_INDEX, keyColumns,
+                                    TableIndex::simplyIndexColumns(), true, true, schema);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", schema, columnNames, 0));
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(pkeyScheme);
+        m_table->addIndex(pkeyIndex);
+        m_table->setPrimaryKeyIndex(pkeyIndex);
+
+        m_engine->setUndoToken(m_undoToken);
+        m_engine->getExecutorContext()->setupForPlanFragments(m_engine->getCurrentUndoQuantum(), 0, 0, 0);
+    }
+
+    ~MinipageTest() {
+        m_engine->releaseUndoToken(m_undoToken);
+        delete m_table;
+        delete m_engine;
+    }
+
+    void nextQuantum(bool undo) {
+        if (undo) {
+            m_engine->undoUndoToken(m_undoToken);
+        } else {
+            m_engine->releaseUndoToken(m_undoToken);
+        }
+        m_engine->setUndoToken(++m_undoToken);
+        m_engine->getExecutorContext()->setupForPlanFragments(m_engine->getCurrentUndoQuantum(), 0, 0, 0);
+    }
+
+    void insertTuples(int count) {
+        TableTuple &tuple = m_table->tempTuple();
+        NValue filler = ValueFactory::getStringValue("filler the scan should not have to read");
+        for (int ii = 0; ii < count; ii++) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+            tuple.setNValue(1, ValueFactory::getBigIntValue((ii * 7919) % 1000));
+            tuple.setNValue(2, filler);
+            tuple.setNValue(3, ValueFactory::getNullStringValue());
+            m_table->insertTuple(tuple);
+        }
+        filler.free();
+    }
+
+    TableTuple lookup(int key) {
+        TableIndex *index = m_table->primaryKeyIndex();
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, ValueFactory::getIntegerValue(key));
+        index->moveToKey(&searchKey);
+        return index->nextValueAtKey();
+    }
+
+    void setV(int key, int64_t v) {
+        TableTuple tuple = lookup(key);
+        TableTuple &newValues = m_table->tempTuple();
+        newValues.copy(tuple);
+        newValues.setNValue(1, ValueFactory::getBigIntValue(v));
+        m_table->updateTuple(tuple, newValues);
+    }
+
+    // V > bound
+    static AbstractExpression *greaterThan(int column, int64_t bound) {
+        return ExpressionUtil::comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHAN,
+                                                 new TupleValueExpression(column, "Foo", "V"),
+                                                 new ConstantValueExpression(ValueFactory::getBigIntValue(bound)));
+    }
+
+    std::set<int> plainScan(AbstractExpression *predicate) {
+        std::set<int> ids;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator = m_table->iterator();
+        while (iterator.next(tuple)) {
+            if (predicate->eval(&tuple, NULL).isTrue()) {
+                ids.insert(ValuePeeker::peekAsInteger(tuple.getNValue(0)));
+            }
+        }
+        return ids;
+    }
+
+    std::set<int> minipageScan(AbstractExpression *predicate) {
+        std::set<int> ids;
+        MinipageFilter filter(*m_table->minipageLayout(), m_table->schema(), predicate);
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator = m_table->iterator();
+        iterator.setMinipageFilter(&filter);
+        while (iterator.next(tuple)) {
+            ids.insert(ValuePeeker::peekAsInteger(tuple.getNValue(0)));
+        }
+        return ids;
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+    int64_t m_undoToken;
+};
+
+TEST_F(MinipageTest, FilteredScanMatchesPlainScan) {
+    m_table->setMinipageColumns(std::vector<int>(1, 1));
+    boost::scoped_ptr<AbstractExpression> predicate(greaterThan(1, 500));
+    ASSERT_TRUE(m_table->minipageLayout()->covers(predicate.get()));
+
+    const int tupleCount = 100000;
+    insertTuples(tupleCount);
+    nextQuantum(false);
+    ASSERT_TRUE(plainScan(predicate.get()) == minipageScan(predicate.get()));
+
+    // updates, some of them rolled back
+    for (int ii = 0; ii < tupleCount; ii += 3) {
+        setV(ii, 1000 - (ii % 1000));
+    }
+    nextQuantum(false);
+    for (int ii = 1; ii < tupleCount; ii += 3) {
+        setV(ii, 1000 - (ii % 1000));
+    }
+    nextQuantum(true);
+    ASSERT_TRUE(plainScan(predicate.get()) == minipageScan(predicate.get()));
+
+    // deletes that leave most blocks sparse, then compaction moves tuples
+    for (int ii = 0; ii < tupleCount; ii++) {
+        if (ii % 8 != 0) {
+            TableTuple tuple = lookup(ii);
+            m_table->deleteTuple(tuple, true);
+        }
+    }
+    const size_t blocksBefore = m_table->allocatedBlockCount();
+    // releasing the deletes leaves the table sparse enough to be compacted at once
+    nextQuantum(false);
+    ASSERT_TRUE(m_table->allocatedBlockCount() < blocksBefore);
+    ASSERT_TRUE(m_table->compactedTupleCount() > 0);
+    ASSERT_TRUE(plainScan(predicate.get()) == minipageScan(predicate.get()));
+
+    // refill the holes
+    TableTuple &tuple = m_table->tempTuple();
+    for (int ii = tupleCount; ii < tupleCount + 5000; ii++) {
+        tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+        tuple.setNValue(1, ValueFactory::getBigIntValue(ii % 1000));
+        m_table->insertTuple(tuple);
+    }
+    nextQuantum(false);
+    std::set<int> ids = minipageScan(predicate.get());
+    ASSERT_TRUE(plainScan(predicate.get()) == ids);
+    ASSERT_FALSE(ids.empty());
+}
+
+TEST_F(MinipageTest, CoversOnlyMirroredColumns) {
+    m_table->setMinipageColumns(std::vector<int>(1, 1));
+    const MinipageLayout *layout = m_table->minipageLayout();
+    ASSERT_TRUE(layout != NULL);
+    ASSERT_TRUE(layout->covers(1));
+    ASSERT_FALSE(layout->covers(0));
+
+    boost::scoped_ptr<AbstractExpression> onV(greaterThan(1, 5));
+    boost::scoped_ptr<AbstractExpression> onId(greaterThan(0, 5));
+    ASSERT_TRUE(layout->covers(onV.get()));
+    ASSERT_FALSE(layout->covers(onId.get()));
+    boost::scoped_ptr<AbstractExpression> both(
+        ExpressionUtil::conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_AND, greaterThan(1, 5), greaterThan(0, 5)));
+    ASSERT_FALSE(layout->covers(both.get()));
+
+    m_table->setMinipageColumns(std::vector<int>());
+    ASSERT_TRUE(m_table->minipageLayout() == NULL);
+}
+
+TEST_F(MinipageTest, RejectsBadColumnsAndNonEmptyTable) {
+    bool threw = false;
+    try {
+        m_table->setMinipageColumns(std::vector<int>(1, 3)); // NOTES is not inlined
+    } catch (const SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    threw = false;
+    try {
+        m_table->setMinipageColumns(std::vector<int>(1, 4));
+    } catch (const SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    insertTuples(10);
+    threw = false;
+    try {
+        m_table->setMinipageColumns(std::vector<int>(1, 1));
+    } catch (const SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_TRUE(m_table->minipageLayout() == NULL);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,337 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/SerializableEEException.h"
+#include "common/StringDictionary.h"
+#include "common/StringRef.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/TableImage.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+
+#include <unistd.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+
+using namespace voltdb;
+
+static const int32_t STATUS_LENGTH = 100;
+
+class StringDictionaryTest : public Test {
+public:
+    StringDictionaryTest() : m_undoToken(0) {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+        m_table = createTable();
+
+        m_engine->setUndoToken(m_undoToken);
+        m_engine->getExecutorContext()->setupForPlanFragments(m_engine->getCurrentUndoQuantum(), 0, 0, 0);
+    }
+
+    ~StringDictionaryTest() {
+        m_engine->releaseUndoToken(m_undoToken);
+        delete m_table;
+        delete m_engine;
+    }
+
+    static PersistentTable *createTable() {
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("STATUS");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(STATUS_LENGTH);
+        columnAllowNull.push_back(true);
+        columnNames.push_back("CODE");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(8);
+        columnAllowNull.push_back(true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+
+        std::vector<int> keyColumns(1, 0);
+        TableIndexScheme pkeyScheme("TreeUniqueIndex", BALANCED_TREE_INDEX, keyColumns,
+                                    TableIndex::simplyIndexColumns(), true, true, schema);
+        PersistentTable *table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", schema, columnNames, 0));
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(pkeyScheme);
+        table->addIndex(pkeyIndex);
+        table->setPrimaryKeyIndex(pkeyIndex);
+        return table;
+    }
+
+    void nextQuantum(bool undo) {
+        if (undo) {
+            m_engine->undoUndoToken(m_undoToken);
+        } else {
+            m_engine->releaseUndoToken(m_undoToken);
+        }
+        m_engine->setUndoToken(++m_undoToken);
+        m_engine->getExecutorContext()->setupForPlanFragments(m_engine->getCurrentUndoQuantum(), 0, 0, 0);
+    }
+
+    // every status has the same length, so they all cost the same
+    static std::string statusFor(int value) {
+        std::ostringstream status;
+        status << "status " << value % 1000 << " long enough to live outside the tuple";
+        std::string padded = status.str();
+        padded.resize(60, '.');
+        return padded;
+    }
+
+    static size_t statusMemory() {
+        return StringRef::computeStringMemoryUsed(statusFor(0).size());
+    }
+
+    void insertTuples(PersistentTable *table, int count, int distinctStatuses) {
+        TableTuple &tuple = table->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+            if (ii % 10 == 9) {
+                tuple.setNValue(1, ValueFactory::getNullStringValue());
+                tuple.setNValue(2, ValueFactory::getNullStringValue());
+                table->insertTuple(tuple);
+                continue;
+            }
+            NValue status = ValueFactory::getStringValue(statusFor(ii % distinctStatuses));
+            tuple.setNValue(1, status);
+            tuple.setNValue(2, ValueFactory::getNullStringValue());
+            table->insertTuple(tuple);
+            status.free();
+        }
+    }
+
+    TableTuple lookup(int key) {
+        TableIndex *index = m_table->primaryKeyIndex();
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, ValueFactory::getIntegerValue(key));
+        index->moveToKey(&searchKey);
+        return index->nextValueAtKey();
+    }
+
+    const StringRef *statusRef(const TableTuple &tuple) {
+        const char *slot = tuple.address() + TUPLE_HEADER_SIZE + m_table->schema()->columnOffset(1);
+        return *reinterpret_cast<const StringRef* const*>(slot);
+    }
+
+    void setStatus(int key, const std::string &value) {
+        TableTuple tuple = lookup(key);
+        TableTuple &newValues = m_table->tempTuple();
+        newValues.copy(tuple);
+        NValue status = ValueFactory::getStringValue(value);
+        newValues.setNValue(1, status);
+        m_table->updateTuple(tuple, newValues);
+        status.free();
+    }
+
+    void deleteTuples(int count) {
+        for (int ii = 0; ii < count; ii++) {
+            TableTuple tuple = lookup(ii);
+            if (!tuple.isNullTuple()) {
+                m_table->deleteTuple(tuple, true);
+            }
+        }
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+    int64_t m_undoToken;
+};
+
+TEST_F(StringDictionaryTest, EqualValuesShareOneCopy) {
+    m_table->setDictionaryColumns(std::vector<int>(1, 1));
+    const StringDictionary *dictionary = m_table->columnDictionary(1);
+    ASSERT_TRUE(dictionary != NULL);
+    ASSERT_TRUE(m_table->columnDictionary(0) == NULL);
+
+    const int tupleCount = 10000;
+    insertTuples(m_table, tupleCount, 7);
+    nextQuantum(false);
+    ASSERT_EQ(7, dictionary->entryCount());
+    ASSERT_EQ(7 * statusMemory(), m_table->nonInlinedMemorySize());
+
+    for (int ii = 0; ii < tupleCount; ii++) {
+        TableTuple tuple = lookup(ii);
+        if (ii % 10 == 9) {
+            ASSERT_TRUE(tuple.isNull(1));
+            continue;
+        }
+        ASSERT_TRUE(statusRef(tuple)->isShared());
+        ASSERT_EQ(statusFor(ii % 7), ValuePeeker::peekStringCopy(tuple.getNValue(1)));
+        TableTuple same = lookup(ii % 7);
+        ASSERT_TRUE(statusRef(tuple) == statusRef(same));
+        ASSERT_EQ(0, tuple.getNValue(1).compare(same.getNValue(1)));
+    }
+    ASSERT_NE(0, lookup(1).getNValue(1).compare(lookup(2).getNValue(1)));
+}
+
+TEST_F(StringDictionaryTest, UpdatesUndoAndDeletesKeepTheAccountsStraight) {
+    m_table->setDictionaryColumns(std::vector<int>(1, 1));
+    const StringDictionary *dictionary = m_table->columnDictionary(1);
+    insertTuples(m_table, 1000, 3);
+    nextQuantum(false);
+    const int64_t memoryBefore = m_table->nonInlinedMemorySize();
+
+    // an undone update leaves everything as it was
+    for (int ii = 0; ii < 100; ii++) {
+        setStatus(ii, statusFor(500));
+    }
+    ASSERT_EQ(4, dictionary->entryCount());
+    nextQuantum(true);
+    ASSERT_EQ(memoryBefore + static_cast<int64_t>(statusMemory()), m_table->nonInlinedMemorySize());
+    ASSERT_EQ(statusFor(0), ValuePeeker::peekStringCopy(lookup(0).getNValue(1)));
+
+    // a released one moves the tuples to another shared copy
+    for (int ii = 0; ii < 100; ii++) {
+        setStatus(ii, statusFor(500));
+    }
+    nextQuantum(false);
+    ASSERT_EQ(memoryBefore + static_cast<int64_t>(statusMemory()), m_table->nonInlinedMemorySize());
+    ASSERT_TRUE(statusRef(lookup(0)) == statusRef(lookup(50)));
+    ASSERT_EQ(statusFor(500), ValuePeeker::peekStringCopy(lookup(0).getNValue(1)));
+
+    // the entries outlive the tuples until the dictionary is dropped
+    deleteTuples(1000);
+    nextQuantum(false);
+    ASSERT_EQ(0, m_table->activeTupleCount());
+    ASSERT_EQ(4 * statusMemory(), m_table->nonInlinedMemorySize());
+    m_table->setDictionaryColumns(std::vector<int>());
+    ASSERT_TRUE(m_table->columnDictionary(1) == NULL);
+    ASSERT_EQ(0, m_table->nonInlinedMemorySize());
+}
+
+TEST_F(StringDictionaryTest, FullDictionaryFallsBackToUnsharedStrings) {
+    m_table->setDictionaryColumns(std::vector<int>(1, 1), 4);
+    const StringDictionary *dictionary = m_table->columnDictionary(1);
+    insertTuples(m_table, 9, 8);
+    nextQuantum(false);
+    ASSERT_EQ(4, dictionary->entryCount());
+    ASSERT_EQ(8 * statusMemory(), m_table->nonInlinedMemorySize());
+    ASSERT_TRUE(statusRef(lookup(0))->isShared());
+    ASSERT_FALSE(statusRef(lookup(7))->isShared());
+
+    // once nothing refers to an entry a new value can take its place
+    TableTuple tuple = lookup(1);
+    m_table->deleteTuple(tuple, true);
+    nextQuantum(false);
+    setStatus(7, statusFor(600));
+    nextQuantum(false);
+    ASSERT_EQ(4, dictionary->entryCount());
+    ASSERT_TRUE(statusRef(lookup(7))->isShared());
+    ASSERT_EQ(7 * statusMemory(), m_table->nonInlinedMemorySize());
+
+    deleteTuples(9);
+    nextQuantum(false);
+    m_table->setDictionaryColumns(std::vector<int>());
+    ASSERT_EQ(0, m_table->nonInlinedMemorySize());
+}
+
+TEST_F(StringDictionaryTest, RestoredTuplesShareTheirStrings) {
+    insertTuples(m_table, 5000, 11);
+    nextQuantum(false);
+    ASSERT_TRUE(m_table->columnDictionary(1) == NULL);
+
+    std::ostringstream path;
+    path << "/tmp/voltdb-string-dictionary-test-" << getpid();
+    {
+        TableImage image(path.str(), true);
+        image.writeHeader(1, 1, 0, m_table->name(), m_table->schema());
+        image.finish(m_table->saveImage(image));
+    }
+    PersistentTable *restored = createTable();
+    restored->setDictionaryColumns(std::vector<int>(1, 1));
+    {
+        TableImage image(path.str(), false);
+        image.readHeader();
+        restored->restoreImage(image);
+    }
+    ::unlink(path.str().c_str());
+
+    ASSERT_EQ(5000, restored->activeTupleCount());
+    ASSERT_EQ(11, restored->columnDictionary(1)->entryCount());
+    ASSERT_EQ(11 * statusMemory(), restored->nonInlinedMemorySize());
+    TableTuple tuple(restored->schema());
+    TableIterator iterator = restored->iterator();
+    while (iterator.next(tuple)) {
+        const int id = ValuePeeker::peekAsInteger(tuple.getNValue(0));
+        if (id % 10 == 9) {
+            ASSERT_TRUE(tuple.isNull(1));
+        } else {
+            ASSERT_EQ(statusFor(id % 11), ValuePeeker::peekStringCopy(tuple.getNValue(1)));
+        }
+    }
+    delete restored;
+}
+
+TEST_F(StringDictionaryTest, RejectsBadColumnsAndNonEmptyTables) {
+    bool threw = false;
+    try {
+        m_table->setDictionaryColumns(std::vector<int>(1, 0));
+    } catch (const SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    // CODE is short enough to be inlined
+    threw = false;
+    try {
+        m_table->setDictionaryColumns(std::vector<int>(1, 2));
+    } catch (const SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    insertTuples(m_table, 10, 2);
+    threw = false;
+    try {
+        m_table->setDictionaryColumns(std::vector<int>(1, 1));
+    } catch (const SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_TRUE(m_table->columnDictionary(1) == NULL);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
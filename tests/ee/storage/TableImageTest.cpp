@@ -0,0 +1,259 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/SerializableEEException.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/TableImage.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_array.hpp>
+#include <boost/foreach.hpp>
+
+using namespace voltdb;
+
+class TableImageTest : public Test {
+public:
+    TableImageTest() {
+        m_engine = new voltdb::VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY, HASHINATOR_LEGACY, (char*)&partitionCount);
+
+        std::ostringstream path;
+        path << "/tmp/voltdb-table-image-test-" << getpid();
+        m_path = path.str();
+
+        m_table = createTable(300);
+        m_restored = createTable(300);
+    }
+
+    ~TableImageTest() {
+        delete m_table;
+        delete m_restored;
+        delete m_engine;
+        ::unlink(m_path.c_str());
+    }
+
+    static PersistentTable *createTable(int32_t payloadLength) {
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("PAYLOAD");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(payloadLength);
+        columnAllowNull.push_back(true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+
+        std::vector<int> keyColumns(1, 0);
+        TableIndexScheme pkeyScheme("TreeUniqueIndex", BALANCED_TREE_INDEX, keyColumns,
+                                    TableIndex::simplyIndexColumns(), true, true, schema);
+        std::vector<TableIndexScheme> schemes;
+        schemes.push_back(TableIndexScheme("TreeMultimapIndex", BALANCED_TREE_INDEX, keyColumns,
+                                           TableIndex::simplyIndexColumns(), false, true, schema));
+        schemes.push_back(TableIndexScheme("HashUniqueIndex", HASH_TABLE_INDEX, keyColumns,
+                                           TableIndex::simplyIndexColumns(), true, false, schema));
+
+        PersistentTable *table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", schema, columnNames, 0));
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(pkeyScheme);
+        table->addIndex(pkeyIndex);
+        table->setPrimaryKeyIndex(pkeyIndex);
+        BOOST_FOREACH(TableIndexScheme &scheme, schemes) {
+            table->addIndex(TableIndexFactory::getInstance(scheme));
+        }
+        return table;
+    }
+
+    void insertTuples(int count) {
+        TableTuple &tuple = m_table->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+            if (ii % 7 == 0) {
+                tuple.setNValue(1, ValueFactory::getNullStringValue());
+                m_table->insertTuple(tuple);
+                continue;
+            }
+            NValue payload = ValueFactory::getStringValue(payloadFor(ii));
+            tuple.setNValue(1, payload);
+            m_table->insertTuple(tuple);
+            payload.free();
+        }
+    }
+
+    static std::string payloadFor(int key) {
+        std::ostringstream payload;
+        payload << "payload of tuple " << key << " long enough to live outside the tuple";
+        return payload.str();
+    }
+
+    TableTuple lookup(TableIndex *index, int key) {
+        boost::scoped_array<char> keyData(new char[index->getKeySchema()->tupleLength()]);
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.moveNoHeader(keyData.get());
+        searchKey.setNValue(0, ValueFactory::getIntegerValue(key));
+        index->moveToKey(&searchKey);
+        return index->nextValueAtKey();
+    }
+
+    int64_t save(PersistentTable *table) {
+        TableImage image(m_path, true);
+        image.writeHeader(1, 1, 0, table->name(), table->schema());
+        int64_t tupleCount = table->saveImage(image);
+        image.finish(tupleCount);
+        return tupleCount;
+    }
+
+    bool restore(PersistentTable *table) {
+        try {
+            TableImage image(m_path, false);
+            image.readHeader();
+            table->restoreImage(image);
+        } catch (const SerializableEEException &e) {
+            return false;
+        }
+        return true;
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+    PersistentTable *m_restored;
+    std::string m_path;
+};
+
+TEST_F(TableImageTest, RoundTrip) {
+    const int tupleCount = 20000;
+    insertTuples(tupleCount);
+    // leave holes in the blocks
+    for (int ii = 0; ii < tupleCount; ii += 5) {
+        TableTuple tuple = lookup(m_table->primaryKeyIndex(), ii);
+        m_table->deleteTuple(tuple, true);
+    }
+    TableTuple tuple(m_table->schema());
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        tuple.setCSI(ValuePeeker::peekAsInteger(tuple.getNValue(0)) % 100);
+    }
+
+    const int64_t liveTuples = m_table->activeTupleCount();
+    ASSERT_EQ(liveTuples, save(m_table));
+    ASSERT_TRUE(restore(m_restored));
+
+    ASSERT_EQ(liveTuples, m_restored->activeTupleCount());
+    ASSERT_EQ(m_table->nonInlinedMemorySize(), m_restored->nonInlinedMemorySize());
+    ASSERT_TRUE(m_restored->allocatedBlockCount() <= m_table->allocatedBlockCount());
+    BOOST_FOREACH(TableIndex *index, m_restored->allIndexes()) {
+        ASSERT_EQ(liveTuples, index->getSize());
+    }
+    for (int ii = 0; ii < tupleCount; ii++) {
+        BOOST_FOREACH(TableIndex *index, m_restored->allIndexes()) {
+            TableTuple found = lookup(index, ii);
+            if (ii % 5 == 0) {
+                ASSERT_TRUE(found.isNullTuple());
+                continue;
+            }
+            ASSERT_FALSE(found.isNullTuple());
+            ASSERT_EQ(ii % 100, found.getCSI());
+            if (ii % 7 == 0) {
+                ASSERT_TRUE(found.isNull(1));
+            } else {
+                ASSERT_EQ(payloadFor(ii), ValuePeeker::peekStringCopy(found.getNValue(1)));
+            }
+        }
+    }
+}
+
+TEST_F(TableImageTest, DamagedImageLeavesTableEmpty) {
+    insertTuples(5000);
+    save(m_table);
+
+    // flip a byte somewhere in the tuple data
+    FILE *file = fopen(m_path.c_str(), "r+b");
+    ASSERT_TRUE(file != NULL);
+    fseek(file, 0, SEEK_END);
+    const long length = ftell(file);
+    fseek(file, length / 2, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, length / 2, SEEK_SET);
+    fputc(byte ^ 0x20, file);
+    fclose(file);
+
+    ASSERT_FALSE(restore(m_restored));
+    ASSERT_EQ(0, m_restored->activeTupleCount());
+    ASSERT_EQ(0, m_restored->allocatedBlockCount());
+    ASSERT_EQ(0, m_restored->nonInlinedMemorySize());
+    BOOST_FOREACH(TableIndex *index, m_restored->allIndexes()) {
+        ASSERT_EQ(0, index->getSize());
+    }
+}
+
+TEST_F(TableImageTest, TruncatedImageLeavesTableEmpty) {
+    insertTuples(5000);
+    save(m_table);
+    FILE *file = fopen(m_path.c_str(), "r+b");
+    ASSERT_TRUE(file != NULL);
+    fseek(file, 0, SEEK_END);
+    const long length = ftell(file);
+    fclose(file);
+    ASSERT_EQ(0, truncate(m_path.c_str(), length / 3));
+
+    ASSERT_FALSE(restore(m_restored));
+    ASSERT_EQ(0, m_restored->activeTupleCount());
+    ASSERT_EQ(0, m_restored->allocatedBlockCount());
+}
+
+TEST_F(TableImageTest, RejectsChangedSchemaAndNonEmptyTable) {
+    insertTuples(100);
+    save(m_table);
+
+    PersistentTable *wider = createTable(400);
+    ASSERT_FALSE(restore(wider));
+    ASSERT_EQ(0, wider->activeTupleCount());
+    delete wider;
+
+    ASSERT_FALSE(restore(m_table));
+    ASSERT_EQ(100, m_table->activeTupleCount());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
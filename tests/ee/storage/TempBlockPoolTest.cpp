@@ -0,0 +1,218 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/ThreadLocalPool.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/executorcontext.hpp"
+#include "storage/TempBlockPool.h"
+#include "storage/TempBlockPoolStats.h"
+#include "storage/TempTableLimits.h"
+#include "storage/TupleBlock.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/temptable.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+static const size_t BLOCK_SIZE = 131072;
+
+class TempBlockPoolTest : public Test {
+public:
+    TempBlockPoolTest() {
+        m_blocks = ThreadLocalPool::getTempBlockPool();
+        m_blocks->clear();
+    }
+
+    ~TempBlockPoolTest() {
+        m_blocks->setCapacity(TempBlockPool::DEFAULT_CAPACITY);
+        m_blocks->clear();
+    }
+
+    TempTable *createTable(int32_t nameLength) {
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_BIGINT);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_BIGINT));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("NAME");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(nameLength);
+        columnAllowNull.push_back(true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+        return TableFactory::getTempTable(0, "temp", schema, columnNames, &m_limits);
+    }
+
+    static void insertTuples(TempTable *table, int count) {
+        TableTuple &tuple = table->tempTuple();
+        tuple.setNValue(1, ValueFactory::getNullStringValue());
+        for (int ii = 0; ii < count; ii++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(ii));
+            table->insertTempTuple(tuple);
+        }
+    }
+
+    static size_t blockCount(TempTable *table) {
+        return static_cast<size_t>(table->allocatedTupleMemory()) / BLOCK_SIZE;
+    }
+
+    static int64_t sumIds(TempTable *table) {
+        int64_t sum = 0;
+        TableTuple tuple(table->schema());
+        TableIterator iterator = table->iterator();
+        while (iterator.next(tuple)) {
+            sum += ValuePeeker::peekAsBigInt(tuple.getNValue(0));
+        }
+        return sum;
+    }
+
+    static NValue statValue(TableTuple *row, const std::string &column) {
+        std::vector<std::string> columns = TempBlockPoolStats::generateTempBlockPoolStatsColumnNames();
+        return row->getNValue(static_cast<int>(std::find(columns.begin(), columns.end(), column) - columns.begin()));
+    }
+
+    ThreadLocalPool m_pool;
+    TempBlockPool *m_blocks;
+    TempTableLimits m_limits;
+};
+
+TEST_F(TempBlockPoolTest, SizeClassesAndCapacity) {
+    TempBlockPool pool(3 * BLOCK_SIZE);
+    bool largePages = true;
+    ASSERT_TRUE(pool.acquire(BLOCK_SIZE, largePages) == NULL);
+    ASSERT_EQ(1, pool.misses());
+
+    char *small = TupleBlock::allocateStorage(BLOCK_SIZE, false);
+    char *large = TupleBlock::allocateStorage(2 * BLOCK_SIZE, false);
+    char *extra = TupleBlock::allocateStorage(BLOCK_SIZE, false);
+    ASSERT_TRUE(pool.release(small, BLOCK_SIZE, false));
+    ASSERT_TRUE(pool.release(large, 2 * BLOCK_SIZE, false));
+    // would go over the capacity
+    ASSERT_FALSE(pool.release(extra, BLOCK_SIZE, false));
+    TupleBlock::freeStorage(extra, BLOCK_SIZE, false);
+    ASSERT_EQ(3 * BLOCK_SIZE, pool.retainedBytes());
+
+    // sizes don't mix
+    ASSERT_TRUE(pool.acquire(4 * BLOCK_SIZE, largePages) == NULL);
+    ASSERT_TRUE(pool.acquire(BLOCK_SIZE, largePages) == small);
+    ASSERT_FALSE(largePages);
+    ASSERT_TRUE(pool.acquire(BLOCK_SIZE, largePages) == NULL);
+    ASSERT_EQ(1, pool.hits());
+    ASSERT_EQ(3, pool.misses());
+    ASSERT_EQ(2 * BLOCK_SIZE, pool.retainedBytes());
+    TupleBlock::freeStorage(small, BLOCK_SIZE, false);
+
+    pool.setCapacity(BLOCK_SIZE);
+    ASSERT_EQ(0, pool.retainedBytes());
+    ASSERT_TRUE(pool.acquire(2 * BLOCK_SIZE, largePages) == NULL);
+}
+
+TEST_F(TempBlockPoolTest, DroppedBlocksAreReusedByOtherTables) {
+    TempTable *first = createTable(16);
+    insertTuples(first, 20000);
+    const size_t blocks = blockCount(first);
+    ASSERT_TRUE(blocks > 2);
+    ASSERT_EQ(0, m_blocks->hits());
+
+    // all but the first block go back to the pool
+    first->deleteAllTuples(true);
+    ASSERT_EQ((blocks - 1) * BLOCK_SIZE, m_blocks->retainedBytes());
+
+    // another fragment's table of the same block size takes them
+    TempTable *second = createTable(24);
+    insertTuples(second, 20000);
+    const size_t secondBlocks = blockCount(second);
+    ASSERT_TRUE(secondBlocks >= blocks);
+    ASSERT_EQ(static_cast<int64_t>(blocks - 1), m_blocks->hits());
+    ASSERT_EQ(0, m_blocks->retainedBytes());
+    ASSERT_EQ(static_cast<int64_t>(19999) * 20000 / 2, sumIds(second));
+
+    delete second;
+    delete first;
+    ASSERT_EQ((secondBlocks + 1) * BLOCK_SIZE, m_blocks->retainedBytes());
+    ASSERT_TRUE(m_blocks->hitRate() > 0.0);
+}
+
+TEST_F(TempBlockPoolTest, NothingIsRetainedPastTheCapacity) {
+    m_blocks->setCapacity(2 * BLOCK_SIZE);
+    TempTable *table = createTable(16);
+    insertTuples(table, 20000);
+    ASSERT_TRUE(blockCount(table) > 3);
+    delete table;
+    ASSERT_EQ(2 * BLOCK_SIZE, m_blocks->retainedBytes());
+
+    m_blocks->setCapacity(0);
+    ASSERT_EQ(0, m_blocks->retainedBytes());
+    table = createTable(16);
+    insertTuples(table, 100);
+    delete table;
+    ASSERT_EQ(0, m_blocks->retainedBytes());
+}
+
+TEST_F(TempBlockPoolTest, StatsReportTheSitePool) {
+    ExecutorContext context(0, 0, NULL, NULL, NULL, false, "", 0);
+    TempBlockPoolStats stats;
+    stats.configure("Temp block pool stats", 1);
+    // start the interval after the stats table took its own block
+    stats.getStatsTuple(true, 0);
+
+    TempTable *table = createTable(16);
+    insertTuples(table, 20000);
+    const int64_t blocks = static_cast<int64_t>(blockCount(table));
+    table->deleteAllTuples(true);
+    insertTuples(table, 20000);
+    delete table;
+
+    TableTuple *row = stats.getStatsTuple(true, 0);
+    ASSERT_EQ(blocks - 1, ValuePeeker::peekAsBigInt(statValue(row, "HITS")));
+    ASSERT_EQ(blocks, ValuePeeker::peekAsBigInt(statValue(row, "MISSES")));
+    ASSERT_EQ(static_cast<int64_t>(m_blocks->retainedBytes() / 1024),
+              ValuePeeker::peekAsBigInt(statValue(row, "RETAINED_MEMORY")));
+    ASSERT_EQ(static_cast<int64_t>(TempBlockPool::DEFAULT_CAPACITY / 1024),
+              ValuePeeker::peekAsBigInt(statValue(row, "CAPACITY")));
+    const double hitRate = ValuePeeker::peekDouble(statValue(row, "HIT_RATE"));
+    ASSERT_TRUE(hitRate > 40.0 && hitRate < 50.0);
+
+    // nothing happened since
+    row = stats.getStatsTuple(true, 0);
+    ASSERT_EQ(0, ValuePeeker::peekAsBigInt(statValue(row, "HITS")));
+    ASSERT_EQ(0, ValuePeeker::peekAsBigInt(statValue(row, "MISSES")));
+    ASSERT_EQ(0.0, ValuePeeker::peekDouble(statValue(row, "HIT_RATE")));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,211 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "harness.h"
+#include "common/SQLException.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/temptable.h"
+#include "storage/TempTableLimits.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+class TempTableSpillTest : public Test {
+public:
+    TempTableSpillTest() {
+        std::vector<std::string> columnNames;
+        std::vector<voltdb::ValueType> columnTypes;
+        std::vector<int32_t> columnLengths;
+        std::vector<bool> columnAllowNull;
+        columnNames.push_back("ID");
+        columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+        columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+        columnAllowNull.push_back(false);
+        columnNames.push_back("NAME");
+        columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+        columnLengths.push_back(16);
+        columnAllowNull.push_back(true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+        m_table = TableFactory::getTempTable(0, "temp", schema, columnNames, &m_limits);
+    }
+
+    ~TempTableSpillTest() {
+        delete m_table;
+    }
+
+    static std::string nameFor(int id) {
+        std::ostringstream name;
+        name << "name " << id;
+        return name.str();
+    }
+
+    void insertTuples(int count) {
+        TableTuple &tuple = m_table->tempTuple();
+        for (int ii = 0; ii < count; ii++) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+            NValue name = ValueFactory::getStringValue(nameFor(ii));
+            tuple.setNValue(1, name);
+            m_table->insertTempTuple(tuple);
+            name.free();
+        }
+    }
+
+    // every tuple, in insertion order, and the one before it still intact
+    bool checkTuples(int count) {
+        TableIterator iterator = m_table->iterator();
+        TableTuple tuple(m_table->schema());
+        TableTuple previous(m_table->schema());
+        int expected = 0;
+        while (iterator.next(tuple)) {
+            if (ValuePeeker::peekAsInteger(tuple.getNValue(0)) != expected ||
+                ValuePeeker::peekStringCopy(tuple.getNValue(1)) != nameFor(expected)) {
+                return false;
+            }
+            if (expected > 0 &&
+                ValuePeeker::peekStringCopy(previous.getNValue(1)) != nameFor(expected - 1)) {
+                return false;
+            }
+            previous.move(tuple.address());
+            ++expected;
+        }
+        return expected == count;
+    }
+
+    TempTableLimits m_limits;
+    TempTable *m_table;
+};
+
+TEST_F(TempTableSpillTest, SpillsFullBlocksAndStreamsThemBack) {
+    const int64_t threshold = 4 * 131072;
+    m_limits.setMemoryLimit(8 * 131072);
+    m_limits.setSpillThreshold(threshold, "/tmp");
+
+    // far more than the memory limit would allow
+    const int tupleCount = 200000;
+    insertTuples(tupleCount);
+    ASSERT_EQ(tupleCount, m_table->activeTupleCount());
+    ASSERT_TRUE(m_table->spilledTupleCount() > 0);
+    ASSERT_TRUE(m_limits.getAllocated() <= threshold);
+    ASSERT_TRUE(m_limits.getSpilledBytes() > 0);
+
+    ASSERT_TRUE(checkTuples(tupleCount));
+    // a second scan reads the scratch file again
+    ASSERT_TRUE(checkTuples(tupleCount));
+
+    m_table->deleteAllTuples(false);
+    ASSERT_EQ(0, m_table->activeTupleCount());
+    ASSERT_EQ(0, m_table->spilledTupleCount());
+    ASSERT_TRUE(checkTuples(0));
+    insertTuples(1000);
+    ASSERT_TRUE(checkTuples(1000));
+}
+
+TEST_F(TempTableSpillTest, LoadedBlocksStayPut) {
+    m_limits.setMemoryLimit(64 * 131072);
+    m_limits.setSpillThreshold(2 * 131072, "/tmp");
+    const int tupleCount = 100000;
+    insertTuples(tupleCount);
+    const int64_t spilled = m_table->spilledTupleCount();
+    ASSERT_TRUE(spilled > 0);
+    const int64_t allocatedBefore = m_limits.getAllocated();
+
+    m_table->loadSpilledBlocks();
+    ASSERT_EQ(0, m_table->spilledTupleCount());
+    ASSERT_TRUE(m_limits.getAllocated() > allocatedBefore);
+
+    // every tuple can be held on to now
+    std::vector<char*> addresses;
+    TableIterator iterator = m_table->iterator();
+    TableTuple tuple(m_table->schema());
+    while (iterator.next(tuple)) {
+        addresses.push_back(tuple.address());
+    }
+    ASSERT_EQ(tupleCount, addresses.size());
+    for (int ii = 0; ii < tupleCount; ii++) {
+        tuple.move(addresses[ii]);
+        ASSERT_EQ(ii, ValuePeeker::peekAsInteger(tuple.getNValue(0)));
+        ASSERT_EQ(nameFor(ii), ValuePeeker::peekStringCopy(tuple.getNValue(1)));
+    }
+}
+
+TEST_F(TempTableSpillTest, DeleteAllFreesStringsOfSpilledTuples) {
+    std::vector<std::string> columnNames;
+    std::vector<voltdb::ValueType> columnTypes;
+    std::vector<int32_t> columnLengths;
+    std::vector<bool> columnAllowNull;
+    columnNames.push_back("ID");
+    columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+    columnAllowNull.push_back(false);
+    columnNames.push_back("NOTES");
+    columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+    columnLengths.push_back(300);
+    columnAllowNull.push_back(true);
+    TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, columnLengths, columnAllowNull, true);
+    ASSERT_EQ(1, schema->getUninlinedObjectColumnCount());
+    TempTable *table = TableFactory::getTempTable(0, "notes", schema, columnNames, &m_limits);
+
+    m_limits.setMemoryLimit(64 * 131072);
+    m_limits.setSpillThreshold(2 * 131072, "/tmp");
+    // the table takes over the strings, which deleteAllTuples(true) frees
+    const int tupleCount = 50000;
+    TableTuple &tuple = table->tempTuple();
+    for (int ii = 0; ii < tupleCount; ii++) {
+        tuple.setNValue(0, ValueFactory::getIntegerValue(ii));
+        tuple.setNValue(1, ValueFactory::getStringValue(nameFor(ii)));
+        table->insertTempTuple(tuple);
+    }
+    ASSERT_TRUE(table->spilledTupleCount() > 0);
+
+    table->deleteAllTuples(true);
+    ASSERT_EQ(0, table->activeTupleCount());
+    ASSERT_EQ(0, table->spilledTupleCount());
+    delete table;
+}
+
+TEST_F(TempTableSpillTest, WithoutSpillingTheLimitThrows) {
+    m_limits.setMemoryLimit(8 * 131072);
+    bool threw = false;
+    try {
+        insertTuples(200000);
+    } catch (const SQLException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_EQ(0, m_table->spilledTupleCount());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,291 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include <stdint.h>
+#include "harness.h"
+#include "structures/AdaptiveRadixTree.h"
+
+using namespace voltdb;
+
+// Two words, so keys share and differ in both
+struct TwoWordKey {
+    enum { RADIX_LENGTH = 16 };
+
+    TwoWordKey() : high(0), low(0) {}
+    TwoWordKey(uint64_t h, uint64_t l) : high(h), low(l) {}
+
+    void toRadix(uint8_t *bytes) const {
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            *bytes++ = static_cast<uint8_t>(high >> shift);
+        }
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            *bytes++ = static_cast<uint8_t>(low >> shift);
+        }
+    }
+
+    bool operator<(const TwoWordKey &other) const {
+        return high < other.high || (high == other.high && low < other.low);
+    }
+
+    uint64_t high;
+    uint64_t low;
+};
+
+class TwoWordComparator {
+public:
+    inline int operator()(const TwoWordKey &lhs, const TwoWordKey &rhs) const {
+        if (lhs < rhs) return -1;
+        if (rhs < lhs) return 1;
+        return 0;
+    }
+};
+
+typedef AdaptiveRadixTree<TwoWordKey, int, TwoWordComparator> Tree;
+
+static uint64_t random64() {
+    return (static_cast<uint64_t>(rand()) << 42) ^ (static_cast<uint64_t>(rand()) << 21) ^ rand();
+}
+
+// Mostly dense runs that fill the wide nodes, with some keys from all over
+static TwoWordKey randomKey() {
+    switch (rand() % 4) {
+    case 0:
+        return TwoWordKey(random64(), random64());
+    case 1:
+        return TwoWordKey(7, rand() % 2000);
+    case 2:
+        return TwoWordKey(rand() % 3, (static_cast<uint64_t>(rand() % 40) << 32) | (rand() % 40));
+    default:
+        return TwoWordKey(9, static_cast<uint64_t>(rand() % 300) << 8);
+    }
+}
+
+class AdaptiveRadixTreeTest : public Test {
+public:
+    AdaptiveRadixTreeTest() {
+    }
+
+    ~AdaptiveRadixTreeTest() {
+    }
+
+    // Same keys and values in the same order, both ways
+    template <typename STLMap>
+    bool sameEntries(STLMap &stl, Tree &tree) {
+        if (static_cast<int64_t>(stl.size()) != tree.size()) {
+            return false;
+        }
+        Tree::iterator volti = tree.begin();
+        for (typename STLMap::iterator stli = stl.begin(); stli != stl.end(); stli++) {
+            if (volti.isEnd() || volti.key() < stli->first || stli->first < volti.key() ||
+                volti.value() != stli->second) {
+                return false;
+            }
+            volti.moveNext();
+        }
+        if (!volti.isEnd()) {
+            return false;
+        }
+        volti = tree.rbegin();
+        for (typename STLMap::reverse_iterator stli = stl.rbegin(); stli != stl.rend(); stli++) {
+            if (volti.isEnd() || volti.value() != stli->second) {
+                return false;
+            }
+            volti.movePrev();
+        }
+        return volti.isEnd();
+    }
+};
+
+TEST_F(AdaptiveRadixTreeTest, RandomUnique) {
+    const int ITERATIONS = 200000;
+
+    std::map<TwoWordKey, int> stl;
+    Tree volt(true, TwoWordComparator());
+    ASSERT_TRUE(volt.verify());
+
+    srand(0);
+    for (int i = 0; i < ITERATIONS; i++) {
+        if ((i % 10000) == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+        // grow the tree for the first half, shrink it for the second
+        const bool insert = rand() % 100 < (i < ITERATIONS / 2 ? 70 : 30);
+        const TwoWordKey key = randomKey();
+        const bool present = stl.find(key) != stl.end();
+        ASSERT_EQ(present, !volt.find(key).isEnd());
+        if (insert) {
+            ASSERT_EQ(!present, volt.insert(key, i));
+            stl.insert(std::pair<TwoWordKey, int>(key, i));
+        } else {
+            ASSERT_EQ(present, volt.erase(key));
+            stl.erase(key);
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(sameEntries(stl, volt));
+
+    for (int i = 0; i < 20000; i++) {
+        const TwoWordKey key = randomKey();
+        std::map<TwoWordKey, int>::iterator stli = stl.lower_bound(key);
+        Tree::iterator volti = volt.lowerBound(key);
+        ASSERT_EQ(stli == stl.end(), volti.isEnd());
+        if (stli != stl.end()) {
+            ASSERT_EQ(stli->second, volti.value());
+        }
+        stli = stl.upper_bound(key);
+        volti = volt.upperBound(key);
+        ASSERT_EQ(stli == stl.end(), volti.isEnd());
+        if (stli != stl.end()) {
+            ASSERT_EQ(stli->second, volti.value());
+        }
+    }
+
+    // emptying the tree gives back every node
+    for (std::map<TwoWordKey, int>::iterator stli = stl.begin(); stli != stl.end(); stli++) {
+        ASSERT_TRUE(volt.erase(stli->first));
+    }
+    ASSERT_EQ(0, volt.size());
+    ASSERT_EQ(0, volt.bytesAllocated());
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(volt.begin().isEnd());
+}
+
+TEST_F(AdaptiveRadixTreeTest, RandomMulti) {
+    const int ITERATIONS = 100000;
+
+    std::multimap<TwoWordKey, int> stl;
+    Tree volt(false, TwoWordComparator());
+
+    srand(1);
+    for (int i = 0; i < ITERATIONS; i++) {
+        if ((i % 5000) == 0) {
+            ASSERT_TRUE(volt.verify());
+            ASSERT_TRUE(sameEntries(stl, volt));
+        }
+        const int op = rand() % 100;
+        const TwoWordKey key(rand() % 2, rand() % 600);
+        if (op < (i < ITERATIONS / 2 ? 60 : 35)) {
+            ASSERT_TRUE(volt.insert(key, i));
+            stl.insert(std::pair<TwoWordKey, int>(key, i));
+            continue;
+        }
+        // erase one particular entry among the equal keys
+        std::pair<std::multimap<TwoWordKey, int>::iterator,
+                  std::multimap<TwoWordKey, int>::iterator> stlRange = stl.equal_range(key);
+        std::pair<Tree::iterator, Tree::iterator> range = volt.equalRange(key);
+        const int matches = static_cast<int>(std::distance(stlRange.first, stlRange.second));
+        if (matches == 0) {
+            ASSERT_TRUE(range.first.equals(range.second));
+            ASSERT_FALSE(volt.erase(key));
+            continue;
+        }
+        std::multimap<TwoWordKey, int>::iterator victim = stlRange.first;
+        std::advance(victim, rand() % matches);
+        bool found = false;
+        for (; !range.first.equals(range.second); range.first.moveNext()) {
+            if (range.first.value() == victim->second) {
+                ASSERT_TRUE(volt.erase(range.first));
+                found = true;
+                break;
+            }
+        }
+        ASSERT_TRUE(found);
+        stl.erase(victim);
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(sameEntries(stl, volt));
+}
+
+TEST_F(AdaptiveRadixTreeTest, IncreasingKeys) {
+    // IDs and timestamps: every key lands right after the last one
+    std::vector<std::pair<TwoWordKey, int> > entries;
+    for (int i = 0; i < 100000; i++) {
+        entries.push_back(std::pair<TwoWordKey, int>(TwoWordKey(1, 1000000 + i * 3), i));
+    }
+    Tree volt(true, TwoWordComparator());
+    volt.bulkLoad(entries);
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(100000, volt.size());
+    Tree::iterator iter = volt.begin();
+    for (int i = 0; i < 100000; i++, iter.moveNext()) {
+        ASSERT_EQ(i, iter.value());
+    }
+    ASSERT_TRUE(iter.isEnd());
+
+    ASSERT_EQ(0, volt.lowerBound(TwoWordKey(0, 5)).value());
+    ASSERT_EQ(1, volt.lowerBound(TwoWordKey(1, 1000001)).value());
+    ASSERT_EQ(1, volt.upperBound(TwoWordKey(1, 1000000)).value());
+    ASSERT_TRUE(volt.lowerBound(TwoWordKey(1, 1000000 + 99999 * 3 + 1)).isEnd());
+    ASSERT_TRUE(volt.upperBound(TwoWordKey(2, 0)).isEnd());
+    ASSERT_EQ(99999, volt.rbegin().value());
+
+    for (int i = 0; i < 100000; i += 2) {
+        ASSERT_TRUE(volt.erase(entries[i].first));
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(1, volt.begin().value());
+}
+
+TEST_F(AdaptiveRadixTreeTest, EraseCompacts) {
+    std::multimap<TwoWordKey, int> stl;
+    std::vector<TwoWordKey> keys;
+    Tree volt(false, TwoWordComparator());
+
+    // a quarter of the entries pile up on few keys, so value arrays grow too
+    srand(2);
+    for (int i = 0; i < 100000; i++) {
+        const TwoWordKey key = i % 4 ? randomKey() : TwoWordKey(5, rand() % 500);
+        ASSERT_TRUE(volt.insert(key, i));
+        stl.insert(std::pair<TwoWordKey, int>(key, i));
+        keys.push_back(key);
+    }
+    ASSERT_TRUE(volt.verify());
+    const size_t full = volt.bytesAllocated();
+
+    // erasing nine entries in ten gives back the memory of the nodes they leave
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i % 10) {
+            ASSERT_TRUE(volt.erase(keys[i]));
+            stl.erase(stl.lower_bound(keys[i]));
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(sameEntries(stl, volt));
+    // every node left is in use (see verify()), but many keys keep some of their entries
+    ASSERT_TRUE(volt.bytesAllocated() < full / 2);
+
+    for (size_t i = 0; i < keys.size(); i += 10) {
+        ASSERT_TRUE(volt.erase(keys[i]));
+    }
+    ASSERT_EQ(0, volt.size());
+    ASSERT_EQ(0, volt.bytesAllocated());
+    ASSERT_TRUE(volt.verify());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,261 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2013 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include "harness.h"
+#include "structures/CompactingBTree.h"
+
+using namespace voltdb;
+
+class IntComparator {
+public:
+    inline int operator()(const int &lhs, const int &rhs) const {
+        if (lhs > rhs) return 1;
+        else if (lhs < rhs) return -1;
+        else return 0;
+    }
+};
+
+class StringComparator {
+public:
+    inline int operator()(const std::string &lhs, const std::string &rhs) const {
+        return lhs.compare(rhs);
+    }
+};
+
+typedef CompactingBTree<int, int, IntComparator, true> IntTree;
+// Few strings fit in a node, so small trees are already several levels deep
+typedef CompactingBTree<std::string, int, StringComparator, true> StringTree;
+
+static std::string keyFor(int key) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%06d", key);
+    return std::string(buffer);
+}
+
+class CompactingBTreeTest : public Test {
+public:
+    CompactingBTreeTest() {
+    }
+
+    ~CompactingBTreeTest() {
+    }
+
+    // Everything in stl is in tree, in the same order
+    bool sameEntries(std::multimap<std::string, int> &stl, StringTree &tree) {
+        if (static_cast<int64_t>(stl.size()) != tree.size()) {
+            return false;
+        }
+        StringTree::iterator volti = tree.begin();
+        for (std::multimap<std::string, int>::iterator stli = stl.begin(); stli != stl.end(); stli++) {
+            if (volti.isEnd() || volti.key() != stli->first) {
+                return false;
+            }
+            volti.moveNext();
+        }
+        return volti.isEnd();
+    }
+};
+
+TEST_F(CompactingBTreeTest, RandomUnique) {
+    const int ITERATIONS = 200000;
+    const int BIGGEST_VAL = 20000;
+
+    std::map<int, int> stl;
+    IntTree volt(true, IntComparator());
+    ASSERT_TRUE(volt.verify());
+
+    srand(0);
+    for (int i = 0; i < ITERATIONS; i++) {
+        if ((i % 10000) == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+        // grow the tree for the first half, shrink it for the second
+        const bool insert = rand() % 100 < (i < ITERATIONS / 2 ? 70 : 30);
+        const int val = rand() % BIGGEST_VAL;
+        const bool present = stl.find(val) != stl.end();
+        ASSERT_EQ(present, !volt.find(val).isEnd());
+        if (insert) {
+            ASSERT_EQ(!present, volt.insert(val, i));
+            stl.insert(std::pair<int, int>(val, i));
+        } else {
+            ASSERT_EQ(present, volt.erase(val));
+            stl.erase(val);
+        }
+        ASSERT_EQ(static_cast<int64_t>(stl.size()), volt.size());
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(volt.verifyRank());
+
+    for (int val = -1; val <= BIGGEST_VAL; val += 7) {
+        std::map<int, int>::iterator stli = stl.lower_bound(val);
+        IntTree::iterator volti = volt.lowerBound(val);
+        ASSERT_EQ(stli == stl.end(), volti.isEnd());
+        if (stli != stl.end()) {
+            ASSERT_EQ(stli->first, volti.key());
+            ASSERT_EQ(stli->second, volti.value());
+        }
+        stli = stl.upper_bound(val);
+        volti = volt.upperBound(val);
+        ASSERT_EQ(stli == stl.end(), volti.isEnd());
+        if (stli != stl.end()) {
+            ASSERT_EQ(stli->first, volti.key());
+        }
+    }
+
+    // walk backwards
+    IntTree::iterator volti = volt.rbegin();
+    for (std::map<int, int>::reverse_iterator stli = stl.rbegin(); stli != stl.rend(); stli++) {
+        ASSERT_FALSE(volti.isEnd());
+        ASSERT_EQ(stli->first, volti.key());
+        volti.movePrev();
+    }
+    ASSERT_TRUE(volti.isEnd());
+
+    // emptying the tree gives back every node
+    for (std::map<int, int>::iterator stli = stl.begin(); stli != stl.end(); stli++) {
+        ASSERT_TRUE(volt.erase(stli->first));
+    }
+    ASSERT_EQ(0, volt.size());
+    ASSERT_EQ(0, volt.bytesAllocated());
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(volt.begin().isEnd());
+}
+
+TEST_F(CompactingBTreeTest, RandomMulti) {
+    const int ITERATIONS = 50000;
+    const int BIGGEST_VAL = 500;
+
+    std::multimap<std::string, int> stl;
+    StringTree volt(false, StringComparator());
+
+    srand(1);
+    for (int i = 0; i < ITERATIONS; i++) {
+        if ((i % 5000) == 0) {
+            ASSERT_TRUE(volt.verify());
+            ASSERT_TRUE(sameEntries(stl, volt));
+        }
+        const int op = rand() % 100;
+        const std::string key = keyFor(rand() % BIGGEST_VAL);
+        if (op < (i < ITERATIONS / 2 ? 60 : 35)) {
+            ASSERT_TRUE(volt.insert(key, i));
+            stl.insert(std::pair<std::string, int>(key, i));
+        } else if (op < 80) {
+            // erase one particular entry among the equal keys
+            std::pair<std::multimap<std::string, int>::iterator,
+                      std::multimap<std::string, int>::iterator> stlRange = stl.equal_range(key);
+            std::pair<StringTree::iterator, StringTree::iterator> range = volt.equalRange(key);
+            int matches = 0;
+            for (std::multimap<std::string, int>::iterator stli = stlRange.first; stli != stlRange.second; stli++) {
+                matches++;
+            }
+            if (matches == 0) {
+                ASSERT_TRUE(range.first.equals(range.second));
+                continue;
+            }
+            std::multimap<std::string, int>::iterator victim = stlRange.first;
+            std::advance(victim, rand() % matches);
+            bool found = false;
+            for (; !range.first.equals(range.second); range.first.moveNext()) {
+                ASSERT_EQ(key, range.first.key());
+                if (range.first.value() == victim->second) {
+                    ASSERT_TRUE(volt.erase(range.first));
+                    found = true;
+                    break;
+                }
+            }
+            ASSERT_TRUE(found);
+            stl.erase(victim);
+        } else {
+            ASSERT_EQ(stl.find(key) != stl.end(), volt.erase(key));
+            std::multimap<std::string, int>::iterator stli = stl.find(key);
+            if (stli != stl.end()) {
+                stl.erase(stli);
+            }
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(volt.verifyRank());
+    ASSERT_TRUE(sameEntries(stl, volt));
+}
+
+TEST_F(CompactingBTreeTest, Rank) {
+    IntTree volt(false, IntComparator());
+    ASSERT_TRUE(volt.findRank(1).isEnd());
+    ASSERT_EQ(-1, volt.rankAsc(0));
+    // key i / 3 three times over, inserted out of order
+    for (int i = 0; i < 30000; i++) {
+        const int shuffled = static_cast<int>((static_cast<int64_t>(i) * 7919) % 30000);
+        ASSERT_TRUE(volt.insert(shuffled / 3, shuffled));
+    }
+    ASSERT_TRUE(volt.verify());
+    for (int key = 0; key < 10000; key += 17) {
+        ASSERT_EQ(key * 3 + 1, volt.rankAsc(key));
+        ASSERT_EQ(key * 3 + 3, volt.rankUpper(key));
+        ASSERT_EQ(key, volt.findRank(key * 3 + 2).key());
+    }
+    ASSERT_EQ(-1, volt.rankAsc(10000));
+    ASSERT_EQ(-1, volt.rankUpper(-1));
+    ASSERT_TRUE(volt.findRank(30001).isEnd());
+    ASSERT_TRUE(volt.verifyRank());
+}
+
+TEST_F(CompactingBTreeTest, BulkLoad) {
+    for (int count = 0; count < 2000; count += (count < 100 ? 1 : 37)) {
+        std::vector<std::pair<std::string, int> > entries;
+        for (int i = 0; i < count; i++) {
+            entries.push_back(std::pair<std::string, int>(keyFor(i * 2), i));
+        }
+        StringTree volt(true, StringComparator());
+        volt.bulkLoad(entries);
+        ASSERT_TRUE(volt.verify());
+        ASSERT_TRUE(volt.verifyRank());
+        ASSERT_EQ(count, volt.size());
+        StringTree::iterator iter = volt.begin();
+        for (int i = 0; i < count; i++, iter.moveNext()) {
+            ASSERT_EQ(keyFor(i * 2), iter.key());
+            ASSERT_EQ(i + 1, volt.rankAsc(keyFor(i * 2)));
+        }
+        ASSERT_TRUE(iter.isEnd());
+
+        // the tree keeps working as one built by inserts
+        for (int i = 0; i < count; i += 3) {
+            ASSERT_TRUE(volt.erase(keyFor(i * 2)));
+            ASSERT_TRUE(volt.insert(keyFor(i * 2 + 1), i));
+        }
+        if (count > 1) {
+            ASSERT_FALSE(volt.insert(keyFor(2), 0));
+        }
+        ASSERT_TRUE(volt.verify());
+        ASSERT_TRUE(volt.verifyRank());
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -300,6 +300,41 @@ TEST_F(CompactingHashTest, ShrinkAndGrowMulti) {
     volt.verify();
 }
 
+TEST_F(CompactingHashTest, FindBatch) {
+    const uint64_t ITERATIONS = 50000;
+    const size_t BATCH = 100;
+
+    voltdb::CompactingHashTable<uint64_t,uint64_t> volt(false);
+
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        uint64_t key = static_cast<uint64_t>(rand()) % ITERATIONS;
+        ASSERT_TRUE(volt.insert(key, i));
+        if (coinFlip()) {
+            key = static_cast<uint64_t>(rand()) % ITERATIONS;
+            volt.erase(key, i - 1);
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+
+    // half the keys are past the largest one inserted
+    uint64_t keys[BATCH];
+    voltdb::CompactingHashTable<uint64_t,uint64_t>::iterator found[BATCH];
+    for (uint64_t base = 0; base < ITERATIONS * 2; base += BATCH) {
+        for (size_t i = 0; i < BATCH; i++) {
+            keys[i] = base + i;
+        }
+        volt.findBatch(keys, BATCH, found);
+        for (size_t i = 0; i < BATCH; i++) {
+            voltdb::CompactingHashTable<uint64_t,uint64_t>::iterator iter = volt.find(keys[i]);
+            for (; !iter.isEnd(); iter.moveNext(), found[i].moveNext()) {
+                ASSERT_FALSE(found[i].isEnd());
+                ASSERT_EQ(iter.value(), found[i].value());
+            }
+            ASSERT_TRUE(found[i].isEnd());
+        }
+    }
+}
+
 TEST_F(CompactingHashTest, Benchmark) {
     const int ITERATIONS = 10000;
 
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <map>
+#include <vector>
 #include <algorithm>
 #include <cstdlib>
 #include <cstdio>
@@ -481,6 +482,62 @@ TEST_F(CompactingMapTest, Trivial) {
     ASSERT_TRUE(m.verify());
 }
 
+TEST_F(CompactingMapTest, BulkLoad) {
+    for (int count = 0; count < 300; count++) {
+        std::vector<std::pair<int, int> > entries;
+        for (int i = 0; i < count; i++) {
+            entries.push_back(std::pair<int, int>(i * 2, i));
+        }
+        voltdb::CompactingMap<int, int, IntComparator, true> volt(true, IntComparator());
+        volt.bulkLoad(entries);
+        ASSERT_TRUE(volt.verify());
+        ASSERT_TRUE(volt.verifyRank());
+        ASSERT_EQ(count, volt.size());
+        voltdb::CompactingMap<int, int, IntComparator, true>::iterator iter = volt.begin();
+        for (int i = 0; i < count; i++, iter.moveNext()) {
+            ASSERT_EQ(i * 2, iter.key());
+            ASSERT_EQ(i + 1, volt.rankAsc(i * 2));
+        }
+        ASSERT_TRUE(iter.isEnd());
+
+        // the tree keeps working as one built by inserts
+        for (int i = 0; i < count; i += 3) {
+            ASSERT_TRUE(volt.erase(i * 2));
+            ASSERT_TRUE(volt.insert(std::pair<int, int>(i * 2 + 1, i)));
+        }
+        if (count > 1) {
+            ASSERT_FALSE(volt.insert(std::pair<int, int>(2, 0)));
+        }
+        ASSERT_TRUE(volt.verify());
+        ASSERT_TRUE(volt.verifyRank());
+    }
+
+    std::vector<std::pair<int, int> > entries;
+    std::multimap<int, int> stl;
+    for (int i = 0; i < 10000; i++) {
+        entries.push_back(std::pair<int, int>(i / 7, i));
+        stl.insert(entries.back());
+    }
+    voltdb::CompactingMap<int, int, IntComparator> volt(false, IntComparator());
+    volt.bulkLoad(entries);
+    ASSERT_TRUE(volt.verify());
+    for (int key = 0; key <= 10000 / 7; key += 13) {
+        std::pair<voltdb::CompactingMap<int, int, IntComparator>::iterator,
+                  voltdb::CompactingMap<int, int, IntComparator>::iterator> range = volt.equalRange(key);
+        int matches = 0;
+        for (; !range.first.equals(range.second); range.first.moveNext()) {
+            ASSERT_EQ(key, range.first.key());
+            matches++;
+        }
+        ASSERT_EQ(static_cast<int>(stl.count(key)), matches);
+    }
+    for (int i = 0; i < 10000; i += 2) {
+        ASSERT_TRUE(volt.erase(i / 7));
+    }
+    ASSERT_EQ(5000, volt.size());
+    ASSERT_TRUE(volt.verify());
+}
+
 TEST_F(CompactingMapTest, RandomUnique) {
     const int ITERATIONS = 1001;
     const int BIGGEST_VAL = 100;
@@ -247,7 +247,7 @@ public class TestStatisticsSuite extends SaveRestoreBase {
         System.out.println("\n\nTESTING TABLE STATS\n\n\n");
         Client client  = getFullyConnectedClient();
 
-        ColumnInfo[] expectedSchema = new ColumnInfo[11];
+        ColumnInfo[] expectedSchema = new ColumnInfo[15];
         expectedSchema[0] = new ColumnInfo("TIMESTAMP", VoltType.BIGINT);
         expectedSchema[1] = new ColumnInfo("HOST_ID", VoltType.BIGINT);
         expectedSchema[2] = new ColumnInfo("HOSTNAME", VoltType.STRING);
@@ -259,6 +259,10 @@ public class TestStatisticsSuite extends SaveRestoreBase {
         expectedSchema[8] = new ColumnInfo("TUPLE_ALLOCATED_MEMORY", VoltType.INTEGER);
         expectedSchema[9] = new ColumnInfo("TUPLE_DATA_MEMORY", VoltType.INTEGER);
         expectedSchema[10] = new ColumnInfo("STRING_DATA_MEMORY", VoltType.INTEGER);
+        expectedSchema[11] = new ColumnInfo("COMPACTED_BLOCKS", VoltType.BIGINT);
+        expectedSchema[12] = new ColumnInfo("COMPACTED_TUPLES", VoltType.BIGINT);
+        expectedSchema[13] = new ColumnInfo("FORCED_COMPACTIONS", VoltType.BIGINT);
+        expectedSchema[14] = new ColumnInfo("COMPACTION_TIME", VoltType.BIGINT);
         VoltTable expectedTable = new VoltTable(expectedSchema);
 
         VoltTable[] results = null;